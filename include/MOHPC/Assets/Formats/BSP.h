@@ -6,10 +6,13 @@
 #include "../../Common/str.h"
 #include "../../Common/Vector.h"
 #include "../../Utility/SharedPtr.h"
+#include "../../Utility/ThreadPool.h"
 
 #include "BSP_Terrain.h"
+#include "BSP_Cache.h"
 
 #include <vector>
+#include <memory>
 #include <exception>
 #include <cstdint>
 
@@ -21,6 +24,7 @@ namespace MOHPC
 	class File;
 	class Shader;
 	class CollisionWorld;
+	class BSPCacheImage;
 	struct patchWork_t;
 
 	namespace BSPFile
@@ -51,6 +55,20 @@ namespace MOHPC
 		static constexpr float lightmapTerrainLength = 16.f / lightmapSize;
 
 		struct PatchCollide;
+		struct TerrainCollide;
+
+		/**
+		 * Content of a lump, as stored in the file.
+		 * When the file is memory-mapped, it references the mapping and it's only read from disk when accessed.
+		 */
+		struct RawLump
+		{
+			const uint8_t* data;
+			size_t length;
+
+		public:
+			RawLump();
+		};
 
 		struct Shader
 		{
@@ -108,7 +126,7 @@ namespace MOHPC
 		{
 
 		public:
-			Vertice();
+			MOHPC_ASSETS_EXPORTS Vertice();
 
 		public:
 			vec3_t xyz;
@@ -144,8 +162,8 @@ namespace MOHPC
 			friend BSP;
 
 		public:
-			Surface();
-			~Surface();
+			MOHPC_ASSETS_EXPORTS Surface();
+			MOHPC_ASSETS_EXPORTS ~Surface();
 
 			MOHPC_ASSETS_EXPORTS const Shader* GetShader() const;
 
@@ -419,6 +437,9 @@ namespace MOHPC
 	{
 		MOHPC_ASSET_OBJECT_DECLARATION(BSP);
 
+		/** Builds levels in memory for tests. */
+		friend class BSPTestBuilder;
+
 	public:
 		MOHPC_ASSETS_EXPORTS BSP(const fs::path& path);
 		~BSP();
@@ -435,6 +456,18 @@ namespace MOHPC
 		/** Returns the lightmap at the specified number. */
 		MOHPC_ASSETS_EXPORTS const BSPData::Lightmap* GetLightmap(size_t lightmapNum) const;
 
+		/** Returns the palette of the light grid. */
+		MOHPC_ASSETS_EXPORTS const BSPData::RawLump& GetLightGridPalette() const;
+
+		/** Returns the offsets of the light grid. */
+		MOHPC_ASSETS_EXPORTS const BSPData::RawLump& GetLightGridOffsets() const;
+
+		/** Returns the data of the light grid. */
+		MOHPC_ASSETS_EXPORTS const BSPData::RawLump& GetLightGridData() const;
+
+		/** Returns the visibility of sphere lights. */
+		MOHPC_ASSETS_EXPORTS const BSPData::RawLump& GetSphereLightVis() const;
+
 		/** Returns the number of surfaces. */
 		MOHPC_ASSETS_EXPORTS size_t GetNumSurfaces() const;
 
@@ -528,6 +561,9 @@ namespace MOHPC
 		/** Returns the terrain surface at the specified number. */
 		MOHPC_ASSETS_EXPORTS const BSPData::Surface *GetTerrainSurface(size_t terrainSurfaceNum) const;
 
+		/** Returns the collision of the terrain patch at the specified number, or NULL if it was not generated when loading. */
+		MOHPC_ASSETS_EXPORTS const BSPData::TerrainCollide* GetTerrainCollide(size_t terrainPatchNum) const;
+
 		/** Returns the number of entities in this level (static models are not counted). */
 		MOHPC_ASSETS_EXPORTS size_t GetNumEntities() const;
 
@@ -544,7 +580,6 @@ namespace MOHPC
 		MOHPC_ASSETS_EXPORTS uintptr_t PointLeafNum(const vec3r_t p);
 
 		std::vector<BSPData::Shader>& getShaders();
-		std::vector<BSPData::Lightmap>& getLightmaps();
 		std::vector<BSPData::Surface>& getSurfaces();
 		std::vector<BSPData::Plane>& getPlanes();
 		std::vector<BSPData::SideEquation>& getSideEquations();
@@ -562,6 +597,7 @@ namespace MOHPC
 		std::vector<BSPData::StaticModel>& getStaticModels();
 		std::vector<BSPData::TerrainPatch>& getTerrainPatches();
 		std::vector<BSPData::Surface>& getTerrainSurfaces();
+		std::vector<BSPData::TerrainCollide>& getTerrainCollides();
 		std::vector<class LevelEntity*>& getEntities();
 		std::unordered_map<str, std::vector<class LevelEntity*>>& getTargetList();
 		std::vector<uint8_t>& getVisibility();
@@ -569,12 +605,27 @@ namespace MOHPC
 		void setNumClusters(uint32_t numClustersValue);
 		void setNumAreas(uint32_t numAreasValue);
 
+		/**
+		 * Set lumps that are kept as stored in the file.
+		 *
+		 * @param file The file, kept open if lumps reference its mapped data. NULL to copy lumps instead.
+		 */
+		void setRawLumps(const IFilePtr& file, const BSPData::RawLump& lightmapsLump, const BSPData::RawLump& lightGridPaletteLump, const BSPData::RawLump& lightGridOffsetsLump, const BSPData::RawLump& lightGridDataLump, const BSPData::RawLump& sphereLightVisLump);
+
 	private:
 		uintptr_t PointLeafNum_r(const vec3r_t p, intptr_t num);
 
 	private:
 		std::vector<BSPData::Shader> shaders;
-		std::vector<BSPData::Lightmap> lightmaps;
+		/** Mapped file referenced by raw lumps. */
+		IFilePtr mappedFile;
+		/** Copy of raw lumps, when the file isn't mapped. */
+		std::unique_ptr<uint8_t[]> rawLumpStorage;
+		BSPData::RawLump lightmaps;
+		BSPData::RawLump lightGridPalette;
+		BSPData::RawLump lightGridOffsets;
+		BSPData::RawLump lightGridData;
+		BSPData::RawLump sphereLightVis;
 		std::vector<BSPData::Surface> surfaces;
 		std::vector<BSPData::Plane> planes;
 		std::vector<BSPData::SideEquation> sideEquations;
@@ -592,6 +643,7 @@ namespace MOHPC
 		std::vector<BSPData::StaticModel> staticModels;
 		std::vector<BSPData::TerrainPatch> terrainPatches;
 		std::vector<BSPData::Surface> terrainSurfaces;
+		std::vector<BSPData::TerrainCollide> terrainCollides;
 		std::vector<class LevelEntity*> entities;
 		std::unordered_map<str, std::vector<class LevelEntity*>> targetList;
 		std::vector<uint8_t> visibility;
@@ -617,7 +669,13 @@ namespace MOHPC
 		using AssetType = BSP;
 
 	public:
-		MOHPC_ASSETS_EXPORTS BSPReader();
+		/**
+		 * @param threadPool Pool used to convert lumps in parallel, it can be shared between readers.
+		 *  If NULL, lumps are converted one after another on the reading thread.
+		 * @param cache Cache of the data generated from maps, the data is read from it instead of generated when possible.
+		 *  Terrain collides are also generated when loading, to be cached. If NULL, data is always generated.
+		 */
+		MOHPC_ASSETS_EXPORTS BSPReader(const ThreadPoolPtr& threadPool = nullptr, const BSPCachePtr& cache = nullptr);
 		MOHPC_ASSETS_EXPORTS ~BSPReader();
 
 		MOHPC_ASSETS_EXPORTS AssetPtr read(const IFilePtr& file) override;
@@ -627,19 +685,20 @@ namespace MOHPC
 	private:
 		//void PreAllocateLevelData(const File_Header *Header);
 		void LoadShaders(const BSPFile::GameLump* GameLump, std::vector<BSPData::Shader>& shaders);
-		void LoadLightmaps(const BSPFile::GameLump* GameLump, std::vector<BSPData::Lightmap>& lightmaps);
+		void LoadLightmaps(const BSPFile::GameLump* GameLump, BSPData::RawLump& lightmaps);
 
 		BSPData::PatchCollide* GeneratePatchCollide(int32_t width, int32_t height, const BSPData::Vertice* points, float subdivisions);
 		void CreateSurfaceGridMesh(int32_t width, int32_t height, BSPData::Vertice* ctrl, int32_t numIndexes, int32_t* indexes, BSPData::Surface* grid);
 		void SubdividePatchToGrid(int32_t Width, int32_t Height, const BSPData::Vertice* Points, BSPData::Surface* Out);
-		void ParseMesh(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const std::vector<BSPData::Shader>& shaders, BSPData::Surface* Out);
+		void ParseMesh(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const std::vector<BSPData::Shader>& shaders, const BSPCacheImage* cacheImage, size_t surfaceNum, BSPData::Surface* Out);
 		void ParseFace(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const int32_t* InIndices, const std::vector<BSPData::Shader>& shaders, BSPData::Surface* Out);
 		void ParseTriSurf(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const int32_t* InIndices, const std::vector<BSPData::Shader>& shaders, BSPData::Surface* Out);
 		void LoadSurfaces(
 			const BSPFile::GameLump* SurfacesLump,
 			const BSPFile::GameLump* Vertices,
-			BSPFile::GameLump* Indices,
+			const BSPFile::GameLump* Indices,
 			const std::vector<BSPData::Shader>& shaders,
+			const BSPCacheImage* cacheImage,
 			std::vector<BSPData::Surface>& surfaces
 		);
 
@@ -738,9 +797,11 @@ namespace MOHPC
 			std::unordered_map<str, std::vector<class LevelEntity*>>& targetList
 		);
 
-		uint32_t LoadLump(const IFilePtr& file, BSPFile::flump_t* lump, BSPFile::GameLump* gameLump, size_t size = 0);
+		void GetLump(const uint8_t* fileData, uint64_t fileSize, uint32_t lumpNum, const BSPFile::flump_t* lump, BSPFile::GameLump* gameLump);
 
 	private:
+		ThreadPoolPtr threadPool;
+		BSPCachePtr cache;
 		std::vector<BSPData::TerrainVert> trVerts;
 		std::vector<BSPData::TerrainTri> trTris;
 		BSPData::PoolInfo trpiTri;
@@ -805,6 +866,23 @@ namespace MOHPC
 			const char* lumpName;
 		};
 
+		/**
+		 * Lump is outside of the file.
+		 */
+		class LumpOutOfBounds : public Base
+		{
+		public:
+			LumpOutOfBounds(uint32_t inLumpNum);
+
+			MOHPC_ASSETS_EXPORTS uint32_t getLumpNum() const;
+
+		public:
+			const char* what() const noexcept override;
+
+		private:
+			uint32_t lumpNum;
+		};
+
 		/**
 		 * Bad mesh size for patch.
 		 */
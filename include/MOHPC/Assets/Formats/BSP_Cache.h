@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../AssetsGlobal.h"
+#include "../AssetBase.h"
+#include "../../Files/FileDefs.h"
+#include "../../Utility/SharedPtr.h"
+
+#include <cstdint>
+
+namespace MOHPC
+{
+	/**
+	 * Directory storing data that BSPReader derives from maps: patch collides, terrain surfaces and terrain collides.
+	 *
+	 * The data of a map is written the first time the map is loaded, in a file named after the map checksum.
+	 * Further loads of the same map map the file and copy the data instead of generating it again,
+	 * so processes don't redo the work for maps they already loaded once.
+	 * Files are written with the layout of the architecture,
+	 * a file written by another architecture or version of the library is written again.
+	 * Patch collides depend on the subdivisions of shaders which are not part of the map,
+	 * they're generated again and the file is rewritten when shader subdivisions changed.
+	 */
+	class BSPCache
+	{
+		MOHPC_ASSET_OBJECT_DECLARATION(BSPCache);
+
+	public:
+		/**
+		 * @param directory Directory on the system where files are stored, it's created when writing the first file.
+		 */
+		MOHPC_ASSETS_EXPORTS BSPCache(const fs::path& directory);
+		MOHPC_ASSETS_EXPORTS ~BSPCache();
+
+		/** Return the directory where files are stored. */
+		MOHPC_ASSETS_EXPORTS const fs::path& getDirectory() const;
+
+		/**
+		 * Return the path of the file storing the data of a map.
+		 *
+		 * @param checksum Checksum in the header of the map.
+		 * @param mapSize Size of the map file, in case two maps have the same checksum.
+		 */
+		MOHPC_ASSETS_EXPORTS fs::path getFilePath(uint32_t checksum, uint64_t mapSize) const;
+
+	private:
+		fs::path directory;
+	};
+	using BSPCachePtr = SharedPtr<BSPCache>;
+}
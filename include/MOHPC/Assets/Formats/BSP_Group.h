@@ -73,8 +73,8 @@ namespace MOHPC
 		MOHPC_ASSETS_EXPORTS const BSPData::BrushGroupData* getBrushData(size_t brushDataNum) const;
 
 	private:
-		void connectBrushes(const BSP& bsp, std::vector<BSPData::BrushGroupData>& list);
-		bool isParented(const BSPData::BrushGroupData& b1, const BSPData::BrushGroupData& b2) const;
+		/** Connect brushes together, rootBrushes is set to the root of each brush. */
+		void connectBrushes(const BSP& bsp, std::vector<BSPData::BrushGroupData>& list, std::vector<size_t>& rootBrushes);
 
 		void mapBrushes(
 			const BSP& bsp,
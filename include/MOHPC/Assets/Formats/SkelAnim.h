@@ -60,6 +60,8 @@ namespace MOHPC
 	struct SkanChannelHdr
 	{
 		std::vector<SkanGameFrame> ary_frames;
+		/** Index in ary_frames of the value used by each frame of the animation. */
+		std::vector<uint32_t> frameKeys;
 	};
 
 	class SkeletonAnimation : public Asset
@@ -126,6 +128,8 @@ namespace MOHPC
 		void setTotalAngleDelta(float newAngle);
 		void setFrameTime(float newFrametime);
 		void setBounds(const_vec3r_t mins, const_vec3r_t maxs);
+		/** Build the frame keys of all channels, once channels are loaded. */
+		void buildFrameKeys();
 
 	private:
 		int32_t flags;
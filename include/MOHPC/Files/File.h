@@ -95,6 +95,17 @@ namespace MOHPC
 		 */
 		virtual uint64_t ReadBuffer(void** Out) = 0;
 
+		/**
+		 * Return the content of the file if it can be accessed in place without reading or copying it,
+		 * like a memory-mapped file. Pages are only read when accessed.
+		 * The data is read-only, and valid as long as the file exists.
+		 * Like allocated memory, it is aligned for any type (alignof(std::max_align_t)).
+		 *
+		 * @param size Set to the size of the file.
+		 * @return the data, or NULL if the file must be read with GetStream() or ReadBuffer().
+		 */
+		MOHPC_FILES_EXPORTS virtual const uint8_t* getMappedData(uint64_t& size);
+
 	private:
 		fs::path name;
 	};
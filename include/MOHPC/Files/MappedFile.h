@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FilesGlobal.h"
+#include "FilesObject.h"
+#include "FileDefs.h"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+	/**
+	 * Read-only memory mapping of a file from the system.
+	 *
+	 * Pages are only read when accessed, and they are shared with other processes mapping the same file.
+	 */
+	class MappedFile
+	{
+		MOHPC_FILES_OBJECT_DECLARATION(MappedFile);
+
+	public:
+		MOHPC_FILES_EXPORTS MappedFile();
+		MOHPC_FILES_EXPORTS ~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		 * Map the whole file, closing the previous mapping.
+		 *
+		 * @param path	Path of the file on the system.
+		 * @return false if the file could not be opened or mapped.
+		 */
+		MOHPC_FILES_EXPORTS bool open(const fs::path& path);
+
+		/** Unmap the file. Pointers to its data become invalid. */
+		MOHPC_FILES_EXPORTS void close();
+
+		/** Return the start of the mapped data, aligned to the page size. */
+		MOHPC_FILES_EXPORTS const uint8_t* getData() const;
+
+		/** Return the size of the file. */
+		MOHPC_FILES_EXPORTS size_t getSize() const;
+
+	private:
+		const uint8_t* data;
+		size_t size;
+#ifdef _WIN32
+		void* mappingHandle;
+#endif
+	};
+	using MappedFilePtr = SharedPtr<MappedFile>;
+}
@@ -71,7 +71,6 @@ namespace Network
 			MOHPC_NET_EXPORTS void buildSolidList(const SnapshotProcessor& snapshotProcessor);
 
 		private:
-			CollisionWorldPtr boxHull;
 			size_t numSolidEntities;
 			size_t numTriggerEntities;
 			const EntityInfo* solidEntities[MAX_ENTITIES_IN_SNAPSHOT];
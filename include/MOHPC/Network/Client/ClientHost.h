@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "../NetObject.h"
+#include "../Remote/Socket.h"
+#include "ServerConnection.h"
+#include "../../Utility/Tick.h"
+#include "../../Utility/ThreadPool.h"
+#include "../../Utility/Communicator.h"
+
+#include <vector>
+#include <mutex>
+
+namespace MOHPC
+{
+namespace Network
+{
+	class ClientHostSocket;
+
+	/**
+	 * Host running many server connections in parallel.
+	 *
+	 * Connections share UDP sockets: packets are received by batch on the thread ticking the host,
+	 * then dispatched to the connection matching the source address.
+	 * Each tick, connections are split into shards that are ticked by the thread pool,
+	 * a connection is always ticked by only one thread at a time.
+	 *
+	 * Handlers of connections are called from the pool threads.
+	 *
+	 * Usage:
+	 * - Create the communicator for a server with createCommunicator(), and use it with EngineServer::connect().
+	 * - Add the resulting connection with addConnection().
+	 * - Tick the host, connections are removed once they are disconnected.
+	 */
+	class ClientHost : public ITickable
+	{
+		MOHPC_NET_OBJECT_DECLARATION(ClientHost);
+
+	public:
+		/**
+		 * @param numThreads Number of threads ticking connections, 0 to use the number of hardware threads.
+		 * @param bindAddress Local address of created sockets, or NULL to use any address.
+		 *  The port is ignored, each socket uses its own port.
+		 */
+		MOHPC_NET_EXPORTS ClientHost(size_t numThreads = 0, const NetAddr4* bindAddress = nullptr);
+		MOHPC_NET_EXPORTS ~ClientHost();
+
+		/**
+		 * Return a communicator for the specified server.
+		 * The communicator shares a socket with communicators of other servers.
+		 *
+		 * @param serverId Address of the server, must be an IP address.
+		 * @return the communicator, or NULL if the address is not supported.
+		 */
+		MOHPC_NET_EXPORTS ICommunicatorPtr createCommunicator(const IRemoteIdentifierPtr& serverId);
+
+		/**
+		 * Add a connection to tick. Its channel must use a communicator created by this host.
+		 * This can be called from any thread.
+		 */
+		MOHPC_NET_EXPORTS void addConnection(const ServerConnectionPtr& connection);
+
+		/** Stop ticking a connection. This can be called from any thread except the pool threads. */
+		MOHPC_NET_EXPORTS void removeConnection(const ServerConnectionPtr& connection);
+
+		/** Return the number of connections being ticked. */
+		MOHPC_NET_EXPORTS size_t getNumConnections() const;
+
+		/** Return the number of sockets used by connections. */
+		MOHPC_NET_EXPORTS size_t getNumSockets() const;
+
+		/** Receive pending packets and tick all connections. */
+		void tick(deltaTime_t deltaTime, tickTime_t currentTime) override;
+
+	private:
+		void addPendingConnections();
+		void removeDisconnected();
+
+	private:
+		ThreadPool pool;
+		NetAddr4Ptr bindAddress;
+		mutable std::mutex socketsMutex;
+		std::vector<SharedPtr<ClientHostSocket>> sockets;
+		/** Copy of sockets used while ticking. */
+		std::vector<SharedPtr<ClientHostSocket>> tickSockets;
+		/** Locked while connections are ticked. */
+		mutable std::mutex connectionsMutex;
+		std::vector<ServerConnectionPtr> connections;
+		mutable std::mutex pendingMutex;
+		/** Connections added since the last tick. */
+		std::vector<ServerConnectionPtr> pendingConnections;
+	};
+	using ClientHostPtr = SharedPtr<ClientHost>;
+}
+}
@@ -57,12 +57,21 @@ namespace MOHPC
 			MOHPC_NET_EXPORTS void setCDKey(const char* value);
 			MOHPC_NET_EXPORTS const char* getCDKey() const;
 
+			/**
+			 * Receive packets of the connection from a dedicated thread (see ThreadedNetchan),
+			 * so the connection doesn't wait on the socket while ticking. Disabled by default.
+			 * The connection then uses a socket of its own instead of the communicator of the server.
+			 */
+			MOHPC_NET_EXPORTS void setThreadedChannel(bool value);
+			MOHPC_NET_EXPORTS bool isThreadedChannel() const;
+
 		private:
 			const char* version;
 			const char* cdKey;
 			size_t deferredConnectTime;
 			size_t deferredChallengeTime;
 			uint16_t qport;
+			bool threadedChannel;
 		};
 		using ConnectSettingsPtr = SharedPtr<ConnectSettings>;
 
@@ -327,7 +336,7 @@ namespace MOHPC
 			void sendRequest(IEngineRequestPtr&& req, Callbacks::ServerTimeout&& timeoutResult = Callbacks::ServerTimeout(), uint64_t timeoutTime = 10000);
 
 		private:
-			void onConnect(const Callbacks::Connect result, uint16_t qport, uint32_t challengeResponse, const protocolType_c& protoType, const UserInfoPtr& cInfo, const char* errorMessage);
+			void onConnect(const Callbacks::Connect result, const ConnectSettingsPtr& settings, uint16_t qport, uint32_t challengeResponse, const protocolType_c& protoType, const UserInfoPtr& cInfo, const char* errorMessage);
 		};
 		using EngineServerPtr = SharedPtr<EngineServer>;
 	}
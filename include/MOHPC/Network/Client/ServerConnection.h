@@ -8,6 +8,7 @@
 #include "../Remote/Encoding.h"
 #include "../Remote/Ops.h"
 #include "../Remote/Chain.h"
+#include "../Remote/Metrics.h"
 #include "../Configstring.h"
 #include "../Parsing/String.h"
 #include "../Parsing/Hash.h"
@@ -159,6 +160,8 @@ namespace MOHPC
 		private:
 			INetchanPtr netchan;
 			IRemoteIdentifierPtr adr;
+			/** Reused for each received packet. */
+			DynamicDataMessageStream receiveStream;
 			uint32_t maxPacketsAtOnce;
 		};
 
@@ -265,6 +268,9 @@ namespace MOHPC
 			MOHPC_NET_EXPORTS ServerSnapshotManager& getSnapshotManager();
 			MOHPC_NET_EXPORTS const ServerSnapshotManager& getSnapshotManager() const;
 
+			/** Return counters of packets and parsing of this connection. */
+			MOHPC_NET_EXPORTS const NetMetricsPtr& getMetrics() const;
+
 			/** Return the current server message sequence (the latest packet number). */
 			MOHPC_NET_EXPORTS uint32_t getCurrentServerMessageSequence() const;
 
@@ -325,6 +331,7 @@ namespace MOHPC
 			IReliableSequence* reliableCommands;
 			ICommandSequence* serverCommands;
 			IChainPtr chain;
+			NetMetricsPtr metrics;
 			ClientTime clientTime;
 			TimeoutTimer timeout;
 			ServerGameStatePtr clGameState;
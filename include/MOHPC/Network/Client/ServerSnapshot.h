@@ -4,6 +4,8 @@
 #include "../../Utility/TickTypes.h"
 #include "../Types/Snapshot.h"
 #include "../Types/Protocol.h"
+#include "../Types/EntityTable.h"
+#include "../Types/EntityStateRing.h"
 
 #include "../Parsing/Entity.h"
 #include "../Parsing/PlayerState.h"
@@ -14,6 +16,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 
 namespace MOHPC
 {
@@ -85,6 +88,7 @@ namespace Network
 		};
 
 		ServerSnapshotManager(protocolType_c protocol);
+		~ServerSnapshotManager();
 
 		MOHPC_NET_EXPORTS HandlerList& getHandlers();
 		MOHPC_NET_EXPORTS const HandlerList& getHandlers() const;
@@ -115,7 +119,29 @@ namespace Network
 		MOHPC_NET_EXPORTS bool isSnapshotValid() const;
 		MOHPC_NET_EXPORTS bool hasNewSnapshots() const;
 
-		void setNewSnap(rawSnapshot_t& newSnap);
+		/**
+		 * Enable or disable filling the structure-of-arrays entity table when parsing snapshots.
+		 * The table is opt-in: the library doesn't read it, it's only filled for callers
+		 * that process entities of the current snapshot member by member.
+		 * Disabled by default, the table is only allocated when enabled.
+		 */
+		MOHPC_NET_EXPORTS void setEntityTableEnabled(bool enabled);
+
+		/**
+		 * Return the entity table of the current snapshot.
+		 * Snapshots that are not valid don't replace the table.
+		 *
+		 * @return the table, or nullptr if the entity table is disabled.
+		 */
+		MOHPC_NET_EXPORTS const EntityTable* getEntityTable() const;
+
+		/** Return the number of entities that were read from the message of the last parsed snapshot. */
+		MOHPC_NET_EXPORTS uint32_t getNumDeltaEntities() const;
+
+		/** Return entity states of parsed snapshots. */
+		MOHPC_NET_EXPORTS const EntityStateRing& getParseEntities() const;
+
+		void setNewSnap(rawSnapshot_t* newSnap);
 
 		void parseSnapshot(
 			MSG& msg,
@@ -145,11 +171,24 @@ namespace Network
 
 	private:
 		uint32_t parseEntitiesNum;
+		uint32_t numDeltaEntities;
 		uint32_t lastSnapFlags;
 		HandlerList handlerList;
-		rawSnapshot_t currentSnap;
-		rawSnapshot_t snapshots[PACKET_BACKUP];
-		entityState_t parseEntities[MAX_PARSE_ENTITIES];
+		/**
+		 * Storage of snapshots, one more than the history so a snapshot can be parsed without overwriting the history.
+		 * Snapshots are never copied, only pointers are exchanged.
+		 */
+		rawSnapshot_t snapshotStorage[PACKET_BACKUP + 1];
+		/** Snapshots indexed by message number. */
+		rawSnapshot_t* snapshots[PACKET_BACKUP];
+		/** Storage that is not part of the history, the next snapshot is parsed into it. */
+		rawSnapshot_t* freeSnapshot;
+		rawSnapshot_t* currentSnap;
+		EntityStateRing parseEntities;
+		/** Table of the current snapshot. */
+		std::unique_ptr<EntityTable> entityTable;
+		/** Table filled while parsing, it replaces the current one if the snapshot is valid. */
+		std::unique_ptr<EntityTable> parsedEntityTable;
 		bool snapActive;
 		bool newSnapshots;
 	};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "../NetObject.h"
+#include "../Remote/Socket.h"
+#include "../../Utility/RemoteIdentifier.h"
+#include "Server.h"
+#include "../../Utility/Info.h"
+#include "../../Utility/TimerWheel.h"
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <functional>
+
+namespace MOHPC
+{
+namespace Network
+{
+	namespace Callbacks
+	{
+		/**
+		 * Called when a server replied.
+		 *
+		 * @param server	The server that replied.
+		 * @param info		The server info.
+		 * @param ping		Time in milliseconds between the last query and the reply.
+		 */
+		using SweepResponse = std::function<void(const IRemoteIdentifierPtr& server, const ReadOnlyInfo& info, uint64_t ping)>;
+
+		/** Called when a server didn't reply to any attempt. */
+		using SweepTimeout = std::function<void(const IRemoteIdentifierPtr& server)>;
+	}
+
+	enum class sweepQuery_e : unsigned char
+	{
+		/** GameSpy status query ("\\status\\"), to send to the query port of servers found by the master server. */
+		Gamespy,
+		/** Engine "getstatus" connectionless query, to send to the game port. */
+		EngineStatus,
+		/** Engine "getinfo" connectionless query, to send to the game port. */
+		EngineInfo
+	};
+
+	/**
+	 * Query many servers concurrently from a single socket.
+	 *
+	 * Unlike querying each server through its own request handler, queries are pipelined:
+	 * they are sent as fast as the packet budget allows, without waiting for other servers to reply.
+	 * Replies are matched with servers by their source address.
+	 *
+	 * The timeout of a query is based on the round-trip time measured from previous replies,
+	 * of the same server if it replied before, or of all servers otherwise.
+	 * A server that didn't reply in time is queried again with a doubled timeout, until the number of retries is met.
+	 *
+	 * Usage:
+	 * - Add servers, for example from ServerList::fetch().
+	 * - Call process() until it returns true, callbacks are called from process().
+	 * - Servers can be added again to refresh them, their measured round-trip time is kept.
+	 */
+	class ServerSweep
+	{
+		MOHPC_NET_OBJECT_DECLARATION(ServerSweep);
+
+	public:
+		/**
+		 * @param type		The type of query to send to servers.
+		 * @param socket	Socket to send queries from, or NULL to create one.
+		 */
+		MOHPC_NET_EXPORTS ServerSweep(sweepQuery_e type = sweepQuery_e::Gamespy, const IUdpSocketPtr& socket = nullptr);
+		MOHPC_NET_EXPORTS ~ServerSweep();
+
+		/** Set callbacks for replies and timeouts. */
+		MOHPC_NET_EXPORTS void setCallbacks(Callbacks::SweepResponse&& responseFunc, Callbacks::SweepTimeout&& timeoutFunc = Callbacks::SweepTimeout());
+
+		/** Set the maximum number of packets sent per second, retries included. 0 means no limit. */
+		MOHPC_NET_EXPORTS void setPacketsPerSecond(size_t value);
+		MOHPC_NET_EXPORTS size_t getPacketsPerSecond() const;
+
+		/** Set the number of times a server is queried again after timing out. */
+		MOHPC_NET_EXPORTS void setMaxRetries(uint32_t value);
+		MOHPC_NET_EXPORTS uint32_t getMaxRetries() const;
+
+		/**
+		 * Set timeout bounds, in milliseconds.
+		 *
+		 * @param initialTime	Timeout used before any round-trip time is measured.
+		 * @param minTime		Lowest timeout of a query.
+		 * @param maxTime		Highest timeout of a query, retries included.
+		 */
+		MOHPC_NET_EXPORTS void setTimeouts(uint64_t initialTime, uint64_t minTime, uint64_t maxTime);
+
+		/**
+		 * Add a server to query. If it is already being queried, nothing is done.
+		 *
+		 * @param identifier Address of the server, must be an IP address.
+		 * @return false if the address is not supported.
+		 */
+		MOHPC_NET_EXPORTS bool addServer(const IRemoteIdentifierPtr& identifier);
+		MOHPC_NET_EXPORTS bool addServer(const IServerPtr& server);
+
+		/** Return the number of servers that are waiting to be queried or waiting for a reply. */
+		MOHPC_NET_EXPORTS size_t getNumPending() const;
+
+		/** Return the smoothed round-trip time of all servers in milliseconds, or 0 if nothing was measured. */
+		MOHPC_NET_EXPORTS uint64_t getAverageRtt() const;
+
+		/**
+		 * Send queries, receive replies and handle timeouts.
+		 *
+		 * @param maxProcessTime The maximum time before stopping processing.
+		 * @return True if all servers were processed. False if there are remaining.
+		 */
+		MOHPC_NET_EXPORTS bool process(uint64_t maxProcessTime = InfiniteProcessTime);
+
+	public:
+		static constexpr uint64_t InfiniteProcessTime = ~0U;
+
+	private:
+		struct server_t;
+		struct netadrHash
+		{
+			size_t operator()(const netadr_t& address) const;
+		};
+
+		using clock = std::chrono::steady_clock;
+		using time_point = clock::time_point;
+
+	private:
+		/** Add tokens elapsed since last refill, and return the number of packets that can be sent. */
+		size_t refillTokens(time_point now);
+		void sendQueries(time_point now);
+		void receiveReplies(time_point now);
+		void processTimeouts(time_point now);
+		void handleReply(server_t& server, const uint8_t* data, size_t size, time_point now);
+		void finish(server_t& server);
+		uint64_t getTimeout(const server_t& server) const;
+		void sampleRtt(server_t& server, uint64_t rtt);
+		/** Return the time to wait for something to do, in milliseconds. */
+		uint64_t getWaitTime(time_point now) const;
+		void allocateBuffers();
+
+	private:
+		static constexpr size_t BATCH_SIZE = 64;
+		/**
+		 * Size of a received datagram, larger datagrams are truncated.
+		 * GameSpy replies are split into datagrams of at most 1400 bytes,
+		 * and the info string of engine replies is limited to 1350 bytes, the player list after it is not used.
+		 */
+		static constexpr size_t MAX_RESPONSE_SIZE = 2048;
+
+		IUdpSocketPtr socket;
+		sweepQuery_e queryType;
+		std::vector<uint8_t> queryData;
+		Callbacks::SweepResponse responseCallback;
+		Callbacks::SweepTimeout timeoutCallback;
+		size_t packetsPerSecond;
+		uint32_t maxRetries;
+		uint64_t initialTimeout;
+		uint64_t minTimeout;
+		uint64_t maxTimeout;
+		/** Round-trip time of all servers, in microseconds. */
+		uint64_t smoothedRtt;
+		uint64_t rttVariation;
+		double tokens;
+		time_point lastRefill;
+		size_t numPending;
+		std::vector<std::unique_ptr<server_t>> servers;
+		std::unordered_map<netadr_t, server_t*, netadrHash> serverMap;
+		/** Servers that timed out and must be queried again, sent before new servers. */
+		std::deque<server_t*> retryQueue;
+		std::deque<server_t*> queryQueue;
+		TimerWheel<server_t> timers;
+		std::vector<server_t*> expiredServers;
+		udpMessage_t sendBatch[BATCH_SIZE];
+		udpMessage_t batch[BATCH_SIZE];
+		/** Buffers of received datagrams, allocated on first use. */
+		std::vector<uint8_t> batchBuffer;
+	};
+	using ServerSweepPtr = SharedPtr<ServerSweep>;
+}
+}
@@ -7,6 +7,8 @@
 namespace MOHPC
 {
 class MSG;
+template<typename CodecT> class MSGBufferReader;
+namespace MessageCodecs { class BitPolicy; }
 
 namespace Network
 {
@@ -19,9 +21,11 @@ namespace Network
 		{
 		public:
 			virtual entityNum_t readEntityNum(MSG& msg) const = 0;
+			virtual entityNum_t readEntityNum(MSGBufferReader<MessageCodecs::BitPolicy>& msg) const = 0;
 			virtual void writeEntityNum(MSG& msg, entityNum_t num) const = 0;
 
 			virtual void readDeltaEntity(MSG& msg, const entityState_t* from, entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const = 0;
+			virtual void readDeltaEntity(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const entityState_t* from, entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const = 0;
 			virtual void writeDeltaEntity(MSG& msg, const entityState_t* from, const entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const = 0;
 		};
 	}
@@ -6,6 +6,8 @@
 namespace MOHPC
 {
 class MSG;
+template<typename CodecT> class MSGBufferReader;
+namespace MessageCodecs { class BitPolicy; }
 
 namespace Network
 {
@@ -18,6 +20,7 @@ namespace Network
 		{
 		public:
 			virtual void readDeltaPlayerState(MSG& msg, const playerState_t* from, playerState_t* to) const = 0;
+			virtual void readDeltaPlayerState(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const playerState_t* from, playerState_t* to) const = 0;
 			virtual void writeDeltaPlayerState(MSG& msg, const playerState_t* from, const playerState_t* to) const = 0;
 		};
 	}
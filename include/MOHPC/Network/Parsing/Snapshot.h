@@ -11,6 +11,8 @@ namespace MOHPC
 namespace Network
 {
 	class entityState_t;
+	class EntityTable;
+	class EntityStateRing;
 	struct rawSnapshot_t;
 	struct gameState_t;
 	class ICommandSequence;
@@ -19,14 +21,19 @@ namespace Network
 	{
 		struct snapshotParm_t
 		{
-			const rawSnapshot_t* oldSnapshots;
+			/** Previous snapshots, indexed by message number modulo numOldSnapshots. */
+			const rawSnapshot_t* const* oldSnapshots;
 			const rawSnapshot_t* oldSnap;
-			entityState_t* parseEntities;
+			EntityStateRing* parseEntities;
 			size_t numOldSnapshots;
 			size_t maxParseEntities;
 			size_t maxSnapshotEntities;
 			uint32_t parseEntitiesNum;
+			/** Number of entities read from the message, incremented by the parser. */
+			uint32_t numDeltaEntities;
 			deltaTimeFloat_t deltaTime;
+			/** If not null, entities of the parsed snapshot are also appended to this table. */
+			EntityTable* entityTable;
 		};
 
 		class MOHPC_NET_EXPORTS ISnapshot : public IProtocolSingleton<ISnapshot>
@@ -11,6 +11,11 @@ namespace MOHPC
 {
 namespace Network
 {
+	enum class addressType_e : unsigned char {
+		IPv4,
+		IPv6
+	};
+
 	/**
 	 * Abstract interface for internet address.
 	 */
@@ -89,5 +94,50 @@ namespace Network
 		uint8_t ip[16];
 	};
 	using NetAddr6Ptr = SharedPtr<NetAddr6>;
+
+	/**
+	 * IPv4 or IPv6 address stored by value.
+	 *
+	 * Unlike NetAddr, it doesn't need to be allocated,
+	 * it can be filled for each received packet without any heap allocation.
+	 */
+	struct netadr_t
+	{
+	public:
+		MOHPC_NET_EXPORTS netadr_t();
+		MOHPC_NET_EXPORTS netadr_t(const NetAddr& address);
+
+		/** Return the address type. */
+		MOHPC_NET_EXPORTS addressType_e getType() const;
+		/** Return the address size. */
+		MOHPC_NET_EXPORTS size_t getAddrSize() const;
+		/** Return the address array. */
+		MOHPC_NET_EXPORTS const uint8_t* getAddress() const;
+		/** Return the address port. */
+		MOHPC_NET_EXPORTS uint16_t getPort() const;
+		/** Return the address parsed as a string. */
+		MOHPC_NET_EXPORTS str asString() const;
+
+		/**
+		 * Set the address.
+		 *
+		 * @param type	IPv4 (4 bytes) or IPv6 (16 bytes).
+		 * @param data	The address data.
+		 * @param port	The address port.
+		 */
+		MOHPC_NET_EXPORTS void set(addressType_e type, const uint8_t* data, uint16_t port);
+
+		/** Allocate the equivalent NetAddr, for APIs that keep the address. */
+		MOHPC_NET_EXPORTS NetAddrPtr allocate() const;
+
+		/** Return whether or not the address and the port are the same. */
+		MOHPC_NET_EXPORTS bool operator==(const netadr_t& other) const;
+		MOHPC_NET_EXPORTS bool operator!=(const netadr_t& other) const;
+
+	private:
+		addressType_e type;
+		uint16_t port;
+		uint8_t ip[16];
+	};
 }
 }
\ No newline at end of file
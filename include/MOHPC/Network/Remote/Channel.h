@@ -7,6 +7,7 @@
 #include "../../Utility/Misc/MSG/Stream.h"
 #include "../Exception.h"
 #include "../Remote/Socket.h"
+#include "../Remote/Metrics.h"
 
 #include <cstdint>
 
@@ -28,6 +29,7 @@ namespace MOHPC
 		{
 		private:
 			ICommunicatorPtr socket;
+			NetMetricsPtr metrics;
 
 		public:
 			INetchan(const ICommunicatorPtr& inSocket);
@@ -39,6 +41,9 @@ namespace MOHPC
 			/** Transmit data from stream to the socket. */
 			virtual bool transmit(const IRemoteIdentifier& to, IMessageStream& stream) = 0;
 
+			/** Return true if there is data to receive. */
+			virtual bool hasIncoming();
+
 			/** Return the socket of this channel. */
 			ICommunicatorPtr getSocket() const;
 
@@ -47,6 +52,12 @@ namespace MOHPC
 
 			/** Return the outgoing sequence number */
 			virtual uint16_t getOutgoingSequence() const;
+
+			/** Set metrics where received and transmitted packets are counted, or NULL to stop counting. */
+			virtual void setMetrics(const NetMetricsPtr& metricsPtr);
+
+			/** Return metrics of this channel, or NULL. */
+			NetMetrics* getMetrics() const;
 		};
 
 		using INetchanPtr = SharedPtr<INetchan>;
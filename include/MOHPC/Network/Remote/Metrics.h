@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "../NetObject.h"
+#include "Ops.h"
+#include "../../Utility/SharedPtr.h"
+#include "../../Common/str.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+namespace Network
+{
+	enum class netMetric_e : unsigned char
+	{
+		/** Number of datagrams received by the channel. */
+		PacketsIn,
+		/** Number of bytes received by the channel, headers included. */
+		BytesIn,
+		/** Number of datagrams sent by the channel. */
+		PacketsOut,
+		/** Number of bytes sent by the channel, headers included. */
+		BytesOut,
+		/** Number of received fragments. */
+		FragmentsIn,
+		/** Number of sent fragments. */
+		FragmentsOut,
+		/** Number of sequences that never arrived. */
+		DroppedPackets,
+		/** Number of packets discarded because their sequence was older than the last one. */
+		OutOfOrderPackets,
+		/** Number of parsed server messages. */
+		Messages,
+		/** Number of Huffman-coded bytes decoded from server messages. */
+		HuffmanBytes,
+		/** Number of parsed snapshots. */
+		Snapshots,
+		/** Time spent parsing snapshots, in microseconds. */
+		SnapshotParseTime,
+		/** Number of entities read from snapshots (entities that didn't change are not counted). */
+		DeltaEntities,
+		/** Number of metrics. */
+		Max
+	};
+
+	/** Number of server operations with their own dispatch counters. */
+	static constexpr size_t NUM_SVC_OPS = (size_t)svc_ops_e::Eof + 1;
+
+	/**
+	 * Copy of metrics at some point in time.
+	 */
+	struct MOHPC_NET_EXPORTS netMetricsSnapshot_t
+	{
+		uint64_t values[(size_t)netMetric_e::Max];
+		/** Number of times each server operation was handled. */
+		uint64_t dispatchCount[NUM_SVC_OPS];
+		/** Time spent handling each server operation, in microseconds. */
+		uint64_t dispatchTime[NUM_SVC_OPS];
+
+	public:
+		netMetricsSnapshot_t();
+
+		uint64_t get(netMetric_e metric) const;
+
+		/** Return metrics as a JSON object. */
+		str toJSON() const;
+
+		/**
+		 * Return metrics in the Prometheus text exposition format.
+		 *
+		 * @param prefix	Prefix of each metric name.
+		 * @param labels	Labels added to each metric, without braces (like 'server="127.0.0.1:12203"'), or NULL.
+		 */
+		str toPrometheus(const char* prefix = "mohpc_", const char* labels = nullptr) const;
+	};
+
+	/**
+	 * Counters of a single connection.
+	 *
+	 * Counters are updated with relaxed atomic operations, so they can be updated by the network thread
+	 * and read from any other thread without locking.
+	 * Values of a snapshot are not guaranteed to be consistent between each other.
+	 */
+	class NetMetrics
+	{
+		MOHPC_NET_OBJECT_DECLARATION(NetMetrics);
+
+	public:
+		MOHPC_NET_EXPORTS NetMetrics();
+
+		/** Add a value to a metric. */
+		void add(netMetric_e metric, uint64_t value = 1) noexcept
+		{
+			values[(size_t)metric].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/** Count a handled server operation and the time it took in microseconds. */
+		void addDispatch(svc_ops_e op, uint64_t time) noexcept
+		{
+			const size_t index = (size_t)op < NUM_SVC_OPS ? (size_t)op : 0;
+			dispatchCount[index].fetch_add(1, std::memory_order_relaxed);
+			dispatchTime[index].fetch_add(time, std::memory_order_relaxed);
+		}
+
+		/** Return the current value of a metric. */
+		MOHPC_NET_EXPORTS uint64_t get(netMetric_e metric) const;
+
+		/** Copy all current values. */
+		MOHPC_NET_EXPORTS netMetricsSnapshot_t snapshot() const;
+
+		/** Reset all values to 0. */
+		MOHPC_NET_EXPORTS void reset();
+
+	private:
+		std::atomic<uint64_t> values[(size_t)netMetric_e::Max];
+		std::atomic<uint64_t> dispatchCount[NUM_SVC_OPS];
+		std::atomic<uint64_t> dispatchTime[NUM_SVC_OPS];
+	};
+	using NetMetricsPtr = SharedPtr<NetMetrics>;
+}
+}
@@ -14,11 +14,8 @@ namespace MOHPC
 		struct NetAddr;
 
 		static constexpr unsigned long MAX_UDP_DATA_SIZE = 65507u;
-
-		enum class addressType_e : unsigned char {
-			IPv4,
-			IPv6
-		};
+		/** Largest datagram of the game protocol: a message of up to 49152 bytes with the channel header. */
+		static constexpr unsigned long MAX_GAME_DATAGRAM_SIZE = 49152u + 32u;
 
 		class ISocket
 		{
@@ -42,11 +39,33 @@ namespace MOHPC
 
 			/** Return the underlying socket. */
 			virtual void* getRaw() = 0;
+
+			/**
+			 * Return true if the underlying socket is only read by this socket,
+			 * so it can be polled to know when data is available.
+			 * Proxies reading the underlying socket from another thread should return false.
+			 */
+			virtual bool isPollable() const { return true; }
 		};
 
 		using ISocketPtr = SharedPtr<ISocket>;
 		using ISocketWeakPtr = WeakPtr<ISocket>;
 
+		/**
+		 * Datagram used to send or receive multiple datagrams at once.
+		 */
+		struct udpMessage_t
+		{
+			/** Data to send, or buffer receiving data. */
+			void* data;
+			/** Size of the data to send, or number of bytes that were received. */
+			size_t size;
+			/** Size of the buffer receiving data. */
+			size_t maxSize;
+			/** Destination or source address. */
+			netadr_t address;
+		};
+
 		/**
 		 * Abstract class for UDP socket
 		 */
@@ -72,6 +91,37 @@ namespace MOHPC
 			 * @return	Size of the data that was successfully received
 			 */
 			virtual size_t receive(void* buf, size_t maxsize, NetAddrPtr& from) = 0;
+
+			/**
+			 * Receive data from the socket, without allocating the address.
+			 * The default implementation converts the address received from the function above.
+			 *
+			 * @param	buf			Buffer to receive data to
+			 * @param	maxsize		Size of data to receive
+			 * @param	from		Client that sent the data
+			 * @return	Size of the data that was successfully received
+			 */
+			MOHPC_NET_EXPORTS virtual size_t receive(void* buf, size_t maxsize, netadr_t& from);
+
+			/**
+			 * Send multiple datagrams at once.
+			 * The default implementation sends them one after another.
+			 *
+			 * @param	messages	Datagrams to send, with their destination
+			 * @param	count		Number of datagrams
+			 * @return	Number of datagrams that were sent
+			 */
+			MOHPC_NET_EXPORTS virtual size_t send(const udpMessage_t* messages, size_t count);
+
+			/**
+			 * Receive pending datagrams at once, without waiting if there is none.
+			 * The default implementation receives them one after another.
+			 *
+			 * @param	messages	Datagrams receiving data and their source
+			 * @param	count		Maximum number of datagrams to receive
+			 * @return	Number of datagrams that were received
+			 */
+			MOHPC_NET_EXPORTS virtual size_t receive(udpMessage_t* messages, size_t count);
 		};
 
 		using IUdpSocketPtr = SharedPtr<IUdpSocket>;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "../NetObject.h"
+#include "../../Utility/Communicator.h"
+#include "../../Utility/SharedPtr.h"
+#include "Socket.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace MOHPC
+{
+namespace Network
+{
+	/**
+	 * Poller waiting on the sockets of UDP and TCP communicators at once.
+	 *
+	 * Uses epoll on Linux, so the cost of waiting doesn't depend on the number of sockets,
+	 * and select() on other platforms.
+	 * Sockets that are not pollable (like simulation proxies) are not accepted.
+	 */
+	class SocketPoller : public ICommunicatorPoller
+	{
+		MOHPC_NET_OBJECT_DECLARATION(SocketPoller);
+
+	public:
+		MOHPC_NET_EXPORTS SocketPoller();
+		MOHPC_NET_EXPORTS ~SocketPoller();
+
+		bool add(ICommunicator& comm) override;
+		void remove(ICommunicator& comm) override;
+		size_t wait(ICommunicator* ready[], size_t maxReady, uint64_t timeout) override;
+
+	private:
+		struct watched_t
+		{
+			ICommunicator* comm;
+			ISocketPtr socket;
+		};
+
+		std::vector<watched_t> watched;
+		/** Handle of the platform poller, unused with select(). */
+		intptr_t pollHandle;
+	};
+	using SocketPollerPtr = SharedPtr<SocketPoller>;
+}
+}
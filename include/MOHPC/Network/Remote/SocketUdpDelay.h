@@ -72,6 +72,7 @@ namespace Network
 		bool wait(uint64_t timeout) override;
 		size_t dataCount() override;
 		void* getRaw() override;
+		bool isPollable() const override;
 
 	private:
 		std::chrono::nanoseconds calculatePacketTime() const;
@@ -145,6 +146,7 @@ namespace Network
 		bool wait(uint64_t timeout) override;
 		size_t dataCount() override;
 		void* getRaw() override;
+		bool isPollable() const override;
 
 	private:
 		void dropIncoming();
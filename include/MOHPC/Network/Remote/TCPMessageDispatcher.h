@@ -22,6 +22,7 @@ namespace Network
 		size_t getIncomingSize() override;
 		bool waitIncoming(uint64_t timeout) override;
 		MOHPC_NET_EXPORTS const IRemoteIdentifierPtr& getRemoteIdentifier() const;
+		MOHPC_NET_EXPORTS const ITcpSocketPtr& getSocket() const;
 
 	private:
 		ITcpSocketPtr socket;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "../NetObject.h"
+#include "Channel.h"
+#include "../../Utility/SpscQueue.h"
+#include "../../Utility/Misc/MSG/Stream.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace MOHPC
+{
+namespace Network
+{
+	/**
+	 * Channel receiving packets of another channel from a dedicated I/O thread.
+	 *
+	 * The I/O thread blocks on the socket and reassembles fragments through the wrapped channel,
+	 * complete packets are handed to the thread calling receive() through a lock-free queue.
+	 * Packets are transmitted directly from the thread calling transmit(), as sending doesn't wait.
+	 * Decoding the packet content is still done by the caller, as it depends on the state of the connection.
+	 *
+	 * Only one thread may call receive() and transmit().
+	 * The wrapped channel and its communicator must not be used by anything else,
+	 * for example the communicator must not be polled by a message dispatcher.
+	 */
+	class ThreadedNetchan : public INetchan
+	{
+		MOHPC_NET_OBJECT_DECLARATION(ThreadedNetchan);
+
+	public:
+		/**
+		 * Start the I/O thread.
+		 *
+		 * @param netchan	Channel to receive/transmit packets with, with a communicator of its own.
+		 * @param remote	Address packets are received from.
+		 */
+		MOHPC_NET_EXPORTS ThreadedNetchan(const INetchanPtr& netchan, const IRemoteIdentifierPtr& remote);
+		MOHPC_NET_EXPORTS ~ThreadedNetchan();
+
+		bool receive(IRemoteIdentifierPtr& from, IMessageStream& stream, uint32_t& sequenceNum) override;
+		bool transmit(const IRemoteIdentifier& to, IMessageStream& stream) override;
+		bool hasIncoming() override;
+		uint16_t getOutgoingSequence() const override;
+		void setMetrics(const NetMetricsPtr& metricsPtr) override;
+
+	private:
+		struct packet_t
+		{
+			DynamicDataMessageStream stream;
+			/** Position of the stream once the channel header was read. */
+			size_t position;
+			uint32_t sequenceNum;
+			/** Exception thrown by the channel while receiving, thrown again by receive(). */
+			std::exception_ptr error;
+		};
+
+		void ioThread();
+		/** Return false if received packets couldn't be queued. */
+		bool receivePending();
+		/** Wait until the receiver gives a packet back. */
+		void waitFreePacket();
+
+	private:
+		/** Number of received packets that can be queued. */
+		static constexpr size_t QUEUE_SIZE = 64;
+
+		INetchanPtr netchan;
+		IRemoteIdentifierPtr remote;
+		std::vector<std::unique_ptr<packet_t>> packets;
+		/** Received packets, from the I/O thread. */
+		SpscQueue<packet_t*> incoming;
+		/** Consumed received packets given back to the I/O thread. */
+		SpscQueue<packet_t*> freeIncoming;
+		/** Free packet that was not used by the last receive, only used by the I/O thread. */
+		packet_t* spareIncoming;
+		/** Locked while the wrapped channel is used, as it's used by both threads. */
+		std::mutex channelMutex;
+		std::mutex waitMutex;
+		/** Signaled when a packet is given back while the I/O thread waits for one, or when stopping. */
+		std::condition_variable freeCondition;
+		std::atomic<bool> ioWaiting;
+		std::atomic<bool> stopping;
+		std::thread thread;
+	};
+	using ThreadedNetchanPtr = SharedPtr<ThreadedNetchan>;
+}
+}
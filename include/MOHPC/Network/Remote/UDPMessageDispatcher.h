@@ -5,10 +5,16 @@
 #include "../../Utility/SharedPtr.h"
 #include "Socket.h"
 
+#include <vector>
+
 namespace MOHPC
 {
 namespace Network
 {
+	/**
+	 * Communicator over an UDP socket.
+	 * Pending datagrams are received by batch, so a single system call is used for multiple messages.
+	 */
 	class UDPCommunicator : public ICommunicator
 	{
 		MOHPC_NET_OBJECT_DECLARATION(UDPCommunicator);
@@ -22,8 +28,36 @@ namespace Network
 		bool waitIncoming(uint64_t timeout) override;
 		IUdpSocketPtr getSocket() const;
 
+	private:
+		/**
+		 * Return the identifier of an address.
+		 * Identifiers are immutable, so the one of a recent address is reused instead of being allocated again.
+		 */
+		const IRemoteIdentifierPtr& getIdentifier(const netadr_t& address);
+
+		/** Receive pending datagrams if all received ones were consumed. Return true if there is one to read. */
+		bool fetchBatch();
+
 	protected:
 		IUdpSocketPtr socket;
+
+	private:
+		struct cachedIdentifier_t
+		{
+			netadr_t address;
+			IRemoteIdentifierPtr identifier;
+		};
+
+		static constexpr size_t NUM_CACHED_IDENTIFIERS = 16;
+		cachedIdentifier_t cachedIdentifiers[NUM_CACHED_IDENTIFIERS];
+
+		static constexpr size_t BATCH_SIZE = 8;
+		/** Datagrams received by the last batch. */
+		udpMessage_t batch[BATCH_SIZE];
+		/** Buffers of the batch, allocated on first use. */
+		std::vector<uint8_t> batchBuffer;
+		size_t batchCount;
+		size_t batchIndex;
 	};
 	using UDPCommunicatorPtr = SharedPtr<UDPCommunicator>;
 
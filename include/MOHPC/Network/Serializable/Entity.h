@@ -2,6 +2,7 @@
 
 #include "../NetGlobal.h"
 #include "../../Utility/Misc/MSG/Serializable.h"
+#include "../../Utility/Misc/MSG/MSGBuffer.h"
 #include "../../Utility/TickTypes.h"
 #include "../Types/Entity.h"
 
@@ -20,7 +21,13 @@ namespace Network
 
 		void SaveDelta(MSG& msg, const ISerializableMessage* from) override;
 		void LoadDelta(MSG& msg, const ISerializableMessage* from) override;
+		/** Same as LoadDelta(MSG&), reading directly from a message buffer. */
+		virtual void LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from);
 		entityState_t* GetState() const { return &state; }
+
+	private:
+		template<typename Reader>
+		void LoadDeltaInternal(Reader& msg, const ISerializableMessage* from);
 	};
 
 	class SerializableEntityState_ver15 : public SerializableEntityState
@@ -30,6 +37,11 @@ namespace Network
 
 		void SaveDelta(MSG& msg, const ISerializableMessage* from) override;
 		void LoadDelta(MSG& msg, const ISerializableMessage* from) override;
+		void LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from) override;
+
+	private:
+		template<typename Reader>
+		void LoadDeltaInternal(Reader& msg, const ISerializableMessage* from);
 
 	private:
 		deltaTimeFloat_t timeDelta;
@@ -15,18 +15,27 @@ namespace Network
 
 	namespace EntityField
 	{
-		void ReadNumberPlayerStateField(MSG& msg, intptr_t bits, void* toF, size_t size);
+		/**
+		 * Field readers are templated on the message reader, either MSG or MSGBufferReader.
+		 * They are instantiated for both in EntityField.cpp.
+		 */
+		template<typename Reader>
+		void ReadNumberPlayerStateField(Reader& msg, intptr_t bits, void* toF, size_t size);
 		void WriteNumberPlayerStateField(MSG& msg, intptr_t bits, const void* toF, size_t size);
 
-		void ReadRegular(MSG& msg, intptr_t bits, void* toF, size_t size);
+		template<typename Reader>
+		void ReadRegular(Reader& msg, intptr_t bits, void* toF, size_t size);
 		void WriteNumberEntityField(MSG& msg, intptr_t bits, const void* toF, size_t size);
-		void ReadRegular2(MSG& msg, intptr_t bits, void* toF, size_t size);
+		template<typename Reader>
+		void ReadRegular2(Reader& msg, intptr_t bits, void* toF, size_t size);
 		void WriteRegular2(MSG& msg, intptr_t bits, const void* toF, size_t size);
 
-		void ReadSimple(MSG& msg, intptr_t bits, void* toF, size_t size);
+		template<typename Reader>
+		void ReadSimple(Reader& msg, intptr_t bits, void* toF, size_t size);
 		void WriteSimple(MSG& msg, intptr_t bits, const void* toF, size_t size);
 
-		float ReadAngleField(MSG& msg, size_t bits);
+		template<typename Reader>
+		float ReadAngleField(Reader& msg, size_t bits);
 		void WriteAngleField(MSG& msg, size_t bits, float angle);
 
 		float ReadTimeField(MSG& msg, size_t bits);
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cassert>
 #include <cstring>
+#include <utility>
 
 namespace MOHPC
 {
@@ -83,19 +84,19 @@ namespace Network
 
 	public:
 		/** Return the name of the field. */
-		const char* getName() const;
+		constexpr const char* getName() const { return name; }
 
 		/** Return the offset that the field is in. */
-		uint16_t getOffset() const;
+		constexpr uint16_t getOffset() const { return offset; }
 
 		/** Return the field size. */
-		uint8_t getSize() const;
+		constexpr uint8_t getSize() const { return size; }
 
 		/** Return the number of bits that this field take in transmission. */
-		int8_t getBits() const;
+		constexpr int8_t getBits() const { return bits; }
 
 		/** Return the field type (version specific). */
-		uint8_t getType() const;
+		constexpr uint8_t getType() const { return type; }
 
 	private:
 		const char* name;
@@ -113,13 +114,27 @@ namespace Network
 	template<typename fieldType>
 	struct netField_template_t : public netField_t
 	{
-		using fieldType_e = fieldType_ver6_e;
+		using fieldType_e = fieldType;
 
 		constexpr netField_template_t(const char* nameVal, uint16_t offsetVal, uint8_t sizeVal, int8_t bitsVal, fieldType typeVal)
 			: netField_t(nameVal, offsetVal, sizeVal, bitsVal, (uint8_t)typeVal)
 		{}
+
+		/** Return the version specific field type. */
+		constexpr fieldType getFieldType() const { return fieldType(getType()); }
 	};
 
+	/**
+	 * Call the functor for each field index below count, stopping at the first index that is out of range.
+	 * The index is passed as an std::integral_constant so the functor can fetch the field
+	 * from a constexpr table and have its type, bits, size and offset folded at compile-time.
+	 */
+	template<typename Func, size_t... I>
+	void UnrollFields(std::index_sequence<I...>, size_t count, Func&& func)
+	{
+		(void)((I < count && (func(std::integral_constant<size_t, I>()), true)) && ...);
+	}
+
 	template<typename T>
 	void CopyFields(const T* other, T* target, size_t from, size_t to, const netField_t* fieldlist)
 	{
@@ -2,6 +2,7 @@
 
 #include "../NetGlobal.h"
 #include "../../Utility/Misc/MSG/Serializable.h"
+#include "../../Utility/Misc/MSG/MSGBuffer.h"
 
 namespace MOHPC
 {
@@ -28,10 +29,16 @@ namespace Network
 
 		void SaveDelta(MSG& msg, const ISerializableMessage* from) override;
 		void LoadDelta(MSG& msg, const ISerializableMessage* from) override;
+		/** Same as LoadDelta(MSG&), reading directly from a message buffer. */
+		void LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from);
 		void NormalizePlayerState(playerState_t* ps) const;
 		void UnNormalizePlayerState(playerState_t* ps) const;
 
 		playerState_t* GetState() const { return &state; }
+
+	private:
+		template<typename Reader>
+		void LoadDeltaInternal(Reader& msg, const ISerializableMessage* from);
 	};
 
 	class MOHPC_NET_EXPORTS SerializablePlayerState_ver15 : public SerializablePlayerStateBase
@@ -41,6 +48,12 @@ namespace Network
 
 		void SaveDelta(MSG& msg, const ISerializableMessage* from) override;
 		void LoadDelta(MSG& msg, const ISerializableMessage* from) override;
+		/** Same as LoadDelta(MSG&), reading directly from a message buffer. */
+		void LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from);
+
+	private:
+		template<typename Reader>
+		void LoadDeltaInternal(Reader& msg, const ISerializableMessage* from);
 	};
 }
 }
\ No newline at end of file
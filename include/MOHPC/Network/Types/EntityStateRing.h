@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "Entity.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace MOHPC
+{
+namespace Network
+{
+	/**
+	 * Circular buffer of the entity states parsed from snapshots, indexed by parse number.
+	 *
+	 * Slots don't hold states by value, they reference states allocated from an arena.
+	 * Most entities don't change between snapshots, those are shared with the previous snapshot
+	 * instead of being copied, so the arena only holds states that are distinct.
+	 * The arena grows by chunks when needed and states are reused once no slot reference them anymore.
+	 */
+	class EntityStateRing
+	{
+	public:
+		/**
+		 * @param capacity		Number of slots, must be a power of two.
+		 * @param preallocated	Number of states to allocate upfront.
+		 */
+		MOHPC_NET_EXPORTS EntityStateRing(size_t capacity, size_t preallocated = 256);
+		MOHPC_NET_EXPORTS ~EntityStateRing();
+
+		EntityStateRing(const EntityStateRing&) = delete;
+		EntityStateRing& operator=(const EntityStateRing&) = delete;
+
+		/** Return the state at the specified parse number. */
+		const entityState_t& get(uint32_t parseNum) const
+		{
+			return slots[parseNum & mask]->state;
+		}
+
+		/**
+		 * Return a new state to fill. The state is not referenced until store() is called,
+		 * if it's not stored, the same state is returned by the next call.
+		 */
+		MOHPC_NET_EXPORTS entityState_t* acquire();
+
+		/** Store the state returned by acquire() at the specified parse number. */
+		MOHPC_NET_EXPORTS void store(uint32_t parseNum);
+
+		/** Reference the state of an older parse number, for an entity that didn't change. */
+		MOHPC_NET_EXPORTS void share(uint32_t parseNum, uint32_t fromParseNum);
+
+		/** Return the number of slots. */
+		MOHPC_NET_EXPORTS size_t capacity() const;
+
+		/** Return the number of states allocated by the arena. */
+		MOHPC_NET_EXPORTS size_t getNumAllocated() const;
+
+		/** Return the number of allocated states that are not referenced by any slot. */
+		MOHPC_NET_EXPORTS size_t getNumFree() const;
+
+	private:
+		struct pooledState_t
+		{
+			entityState_t state;
+			uint32_t refCount;
+		};
+
+		void release(pooledState_t* pooled);
+		void grow();
+
+	private:
+		static constexpr size_t CHUNK_SIZE = 64;
+
+		std::vector<pooledState_t*> slots;
+		size_t mask;
+		std::vector<std::unique_ptr<pooledState_t[]>> chunks;
+		std::vector<pooledState_t*> freeStates;
+		pooledState_t* pending;
+		/** Default state referenced by slots that were never stored. */
+		pooledState_t nullState;
+	};
+}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../NetGlobal.h"
+#include "Entity.h"
+#include "Snapshot.h"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+namespace Network
+{
+	/**
+	 * Structure-of-arrays table of the entities present in a snapshot.
+	 *
+	 * Each member is stored in its own contiguous array, indexed by the position of the entity in the snapshot.
+	 * Passes that only look at a few members (origins, types, solidity...) touch much less memory
+	 * than iterating over entityState_t, and can be vectorized.
+	 */
+	class EntityTable
+	{
+	public:
+		static constexpr size_t MAX_ENTITIES = MAX_ENTITIES_IN_SNAPSHOT;
+		static constexpr size_t MAX_FRAMEINFOS = entityState_t::MAX_FRAMEINFOS;
+
+	public:
+		MOHPC_NET_EXPORTS EntityTable();
+
+		/** Remove all entities from the table. */
+		MOHPC_NET_EXPORTS void clear();
+
+		/**
+		 * Append an entity at the end of the table.
+		 *
+		 * @param state	The entity state to split into the arrays.
+		 * @return false if the table is full.
+		 */
+		MOHPC_NET_EXPORTS bool add(const entityState_t& state);
+
+		/** Return the number of entities in the table. */
+		MOHPC_NET_EXPORTS size_t size() const;
+
+		/**
+		 * Return the index in the table of the specified entity number.
+		 *
+		 * @param entityNum	The entity number to search for.
+		 * @return the index, or size() if the entity is not in the table.
+		 */
+		MOHPC_NET_EXPORTS size_t find(entityNum_t entityNum) const;
+
+		/**
+		 * Collect the index of entities that are solid and can collide.
+		 * Items and triggers are never solid.
+		 *
+		 * @param out		Array receiving table indexes.
+		 * @param maxOut	Maximum number of indexes to write.
+		 * @return the number of indexes written.
+		 */
+		MOHPC_NET_EXPORTS size_t findSolidEntities(uint16_t* out, size_t maxOut) const;
+
+	public:
+		alignas(16) float originX[MAX_ENTITIES];
+		alignas(16) float originY[MAX_ENTITIES];
+		alignas(16) float originZ[MAX_ENTITIES];
+		alignas(16) float anglesX[MAX_ENTITIES];
+		alignas(16) float anglesY[MAX_ENTITIES];
+		alignas(16) float anglesZ[MAX_ENTITIES];
+		/** Frame infos, one array per frame slot. */
+		alignas(16) uint32_t frameIndex[MAX_FRAMEINFOS][MAX_ENTITIES];
+		alignas(16) float frameTime[MAX_FRAMEINFOS][MAX_ENTITIES];
+		alignas(16) float frameWeight[MAX_FRAMEINFOS][MAX_ENTITIES];
+		alignas(16) uint32_t solid[MAX_ENTITIES];
+		alignas(16) entityNum_t number[MAX_ENTITIES];
+		alignas(16) uint16_t eFlags[MAX_ENTITIES];
+		alignas(16) uint16_t modelindex[MAX_ENTITIES];
+		alignas(16) uint16_t groundEntityNum[MAX_ENTITIES];
+		alignas(16) entityType_e eType[MAX_ENTITIES];
+		size_t count;
+	};
+}
+}
@@ -6,6 +6,7 @@
 #include "../../Common/Vector.h"
 #include "../../Common/str.h"
 #include "../SharedPtr.h"
+#include "CollisionStorage.h"
 
 #include <vector>
 #include <cstdint>
@@ -40,7 +41,7 @@ namespace MOHPC
 
 	struct MOHPC_UTILITY_EXPORTS collisionNode_t
 	{
-		const collisionPlane_t* plane;
+		OffsetPtr<const collisionPlane_t> plane;
 		// negative numbers are leafs
 		int32_t children[2];
 
@@ -113,7 +114,6 @@ namespace MOHPC
 		collisionTerrain_t();
 
 	public:
-		size_t checkcount;
 		int32_t surfaceFlags;
 		int32_t contents;
 		uintptr_t shaderNum;
@@ -152,10 +152,10 @@ namespace MOHPC
 
 	struct collisionBrushSide_t
 	{
-		collisionPlane_t* plane;
+		OffsetPtr<collisionPlane_t> plane;
 		int32_t surfaceFlags;
 		uintptr_t shaderNum;
-		collisionSideEq_t* pEq;
+		OffsetPtr<collisionSideEq_t> pEq;
 
 	public:
 		collisionBrushSide_t();
@@ -172,9 +172,7 @@ namespace MOHPC
 		int32_t contents;
 		vec3_t bounds[2];
 		size_t numsides;
-		collisionBrushSide_t* sides;
-		// to avoid repeated testings
-		size_t checkcount;
+		OffsetPtr<collisionBrushSide_t> sides;
 	};
 
 	struct patchPlane_t
@@ -211,15 +209,13 @@ namespace MOHPC
 		vec3_t bounds[2];
 		// surface planes plus edge planes
 		uint32_t numPlanes;
-		patchPlane_t* planes;
+		OffsetPtr<patchPlane_t> planes;
 		uint32_t numFacets;
-		facet_t* facets;
+		OffsetPtr<facet_t> facets;
 	};
 
 	struct collisionPatch_t
 	{
-		// to avoid repeated testings
-		size_t checkcount;
 		int32_t surfaceFlags;
 		int32_t contents;
 		uintptr_t shaderNum;
@@ -268,6 +264,54 @@ namespace MOHPC
 		sphere_t();
 	};
 
+	/**
+	 * Per-trace state, owned by the caller.
+	 *
+	 * Traces that are given a context never write to the collision world,
+	 * so one world can serve traces from many threads as long as each thread uses its own context.
+	 * A context can be reused for any number of traces and worlds, but not concurrently.
+	 */
+	struct MOHPC_UTILITY_EXPORTS traceContext_t
+	{
+	public:
+		traceContext_t();
+		traceContext_t(const traceContext_t&) = delete;
+		traceContext_t& operator=(const traceContext_t&) = delete;
+
+	public:
+		// incremented on each trace, objects stamped with it were already tested
+		uint32_t checkcount;
+		// one stamp per brush/patch/terrain of the traced world, to avoid repeated testings
+		std::vector<uint32_t> brushChecks;
+		std::vector<uint32_t> patchChecks;
+		std::vector<uint32_t> terrainChecks;
+		// capsule of the current trace
+		sphere_t sphere;
+		// objects touched by the current group of batched traces
+		std::vector<const collisionBrush_t*> batchBrushes;
+		std::vector<const collisionPatch_t*> batchPatches;
+		std::vector<const collisionTerrain_t*> batchTerrains;
+		// box returned by CollisionWorld::TempBoxModel
+		collisionPlane_t boxPlanes[12];
+		collisionBrushSide_t boxSides[6];
+		collisionBrush_t boxBrush;
+		collisionModel_t boxModel;
+		// statistics, may be zeroed
+		size_t c_traces;
+		size_t c_patch_traces;
+		size_t c_brush_traces;
+		size_t c_pointcontents;
+	};
+
+	// one trace of CollisionWorld::BoxTraceBatch
+	struct boxTraceInput_t
+	{
+		vec3_t start;
+		vec3_t end;
+		vec3_t mins;
+		vec3_t maxs;
+	};
+
 	struct traceWork_t
 	{
 		vec3_t start;
@@ -290,6 +334,8 @@ namespace MOHPC
 		trace_t trace;
 		// optimized case
 		bool isPoint;
+		// state of the trace this work belongs to
+		traceContext_t* context;
 
 	public:
 		traceWork_t();
@@ -303,7 +349,8 @@ namespace MOHPC
 		int* list;
 		vec3_t bounds[2];
 		int lastLeaf;		// for overflows where each leaf can't be stored individually
-		void (CollisionWorld::*storeLeafs)(leafList_t* ll, int nodenum);
+		void (CollisionWorld::*storeLeafs)(leafList_t* ll, int nodenum) const;
+		traceContext_t* context;
 
 	public:
 		leafList_t();
@@ -329,6 +376,7 @@ namespace MOHPC
 	class CollisionWorld
 	{
 		MOHPC_UTILITY_OBJECT_DECLARATION(CollisionWorld);
+		friend class CollisionWorldImage;
 
 	public:
 		MOHPC_UTILITY_EXPORTS CollisionWorld();
@@ -407,6 +455,11 @@ namespace MOHPC
 
 	public:
 		MOHPC_UTILITY_EXPORTS void ModelBounds(clipHandle_t model, vec3r_t mins, vec3r_t maxs);
+
+		/**
+		 * @deprecated The temporary box hull is now stored in the trace context
+		 * and doesn't need to be initialized anymore, this does nothing.
+		 */
 		MOHPC_UTILITY_EXPORTS void InitBoxHull();
 		MOHPC_UTILITY_EXPORTS int PointContents(const vec3r_t p, clipHandle_t model);
 		MOHPC_UTILITY_EXPORTS clipHandle_t inlineModel(uint32_t index);
@@ -431,48 +484,100 @@ namespace MOHPC
 			clipHandle_t model, uint32_t brushmask,
 			const vec3r_t origin, const vec3r_t angles, bool cylinder);
 
+	/**
+	 * Reentrant versions of the functions above.
+	 * All the state that changes during the trace is stored in the specified context,
+	 * the world is left untouched so these can be called concurrently with different contexts.
+	 */
+	public:
+		MOHPC_UTILITY_EXPORTS void ModelBounds(const traceContext_t& context, clipHandle_t model, vec3r_t mins, vec3r_t maxs) const;
+		MOHPC_UTILITY_EXPORTS int PointContents(traceContext_t& context, const vec3r_t p, clipHandle_t model) const;
+		MOHPC_UTILITY_EXPORTS clipHandle_t TempBoxModel(traceContext_t& context, const vec3r_t mins, const vec3r_t maxs, int contents) const;
+		MOHPC_UTILITY_EXPORTS int TransformedPointContents(traceContext_t& context, const vec3r_t p, clipHandle_t model, const vec3r_t origin, const vec3r_t angles) const;
+
+		MOHPC_UTILITY_EXPORTS bool BoxSightTrace(traceContext_t& context, const vec3r_t start, const vec3r_t end,
+			const vec3r_t mins, const vec3r_t maxs,
+			clipHandle_t model, uint32_t brushmask, bool cylinder) const;
+
+		MOHPC_UTILITY_EXPORTS bool TransformedBoxSightTrace(traceContext_t& context, const vec3r_t start, const vec3r_t end,
+			const vec3r_t mins, const vec3r_t maxs,
+			clipHandle_t model, uint32_t brushmask, const vec3r_t origin, const vec3r_t angles, bool cylinder) const;
+
+		MOHPC_UTILITY_EXPORTS void BoxTrace(traceContext_t& context, trace_t* results, const vec3r_t start, const vec3r_t end,
+			const vec3r_t mins, const vec3r_t maxs,
+			clipHandle_t model, uint32_t brushmask, bool cylinder) const;
+
+		MOHPC_UTILITY_EXPORTS void TransformedBoxTrace(traceContext_t& context, trace_t* results, const vec3r_t start, const vec3r_t end,
+			const vec3r_t mins, const vec3r_t maxs,
+			clipHandle_t model, uint32_t brushmask,
+			const vec3r_t origin, const vec3r_t angles, bool cylinder) const;
+
+		/**
+		 * Sweep multiple boxes through the same model, same as calling BoxTrace for each of them.
+		 * Consecutive traces with overlapping bounds descend the tree only once,
+		 * so traces that are close to each other should be grouped together in the array.
+		 * A trace hitting two objects at the same fraction descends the tree again,
+		 * so the reported surface is always the one BoxTrace would report.
+		 *
+		 * @param context	Trace state.
+		 * @param traces	Array of start/end/mins/maxs to trace.
+		 * @param results	Array receiving the result of each trace.
+		 * @param count		Number of elements in both arrays.
+		 */
+		MOHPC_UTILITY_EXPORTS void BoxTraceBatch(traceContext_t& context, const boxTraceInput_t* traces, trace_t* results, size_t count,
+			clipHandle_t model, uint32_t brushmask, bool cylinder) const;
+
 	private:
-		size_t BoxBrushes(const vec3r_t mins, const vec3r_t maxs, collisionBrush_t** list, size_t listsize);
+		size_t BoxBrushes(traceContext_t& context, const vec3r_t mins, const vec3r_t maxs, const collisionBrush_t** list, size_t listsize) const;
 
-		void StoreLeafs(leafList_t* ll, int nodenum);
-		void StoreBrushes(leafList_t* ll, int nodenum);
+		void StoreLeafs(leafList_t* ll, int nodenum) const;
+		void StoreBrushes(leafList_t* ll, int nodenum) const;
+		void StoreTraceObjects(leafList_t* ll, int nodenum) const;
 
-		void BoxLeafnums_r(leafList_t* ll, int nodenum);
+		void BoxLeafnums_r(leafList_t* ll, int nodenum) const;
 
-		collisionModel_t* ClipHandleToModel(clipHandle_t handle);
-		bool BoundsIntersect(const vec3r_t mins, const vec3r_t maxs, const vec3r_t mins2, const vec3r_t maxs2);
-		bool BoundsIntersectPoint(const vec3r_t mins, const vec3r_t maxs, const vec3r_t point);
+		const collisionModel_t* ClipHandleToModel(const traceContext_t& context, clipHandle_t handle) const;
+		bool BoundsIntersect(const vec3r_t mins, const vec3r_t maxs, const vec3r_t mins2, const vec3r_t maxs2) const;
+		bool BoundsIntersectPoint(const vec3r_t mins, const vec3r_t maxs, const vec3r_t point) const;
+
+		void BeginTrace(traceContext_t& context) const;
+		bool MarkBrush(traceContext_t& context, const collisionBrush_t* brush) const;
+		bool MarkPatch(traceContext_t& context, const collisionPatch_t* patch) const;
+		bool MarkTerrain(traceContext_t& context, const collisionTerrain_t* terrain) const;
 
 	// Trace
 	private:
-		void ProjectPointOntoVector(vec3_t point, vec3_t vStart, vec3_t vDir, vec3_t vProj);
-		float DistanceFromLineSquared(vec3_t p, vec3_t lp1, vec3_t lp2, vec3_t dir);
-		float VectorDistanceSquared(vec3_t p1, vec3_t p2);
-		void TestBoxInBrush(traceWork_t* tw, collisionBrush_t* brush);
-		void TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf);
-		void TestCapsuleInCapsule(traceWork_t* tw, clipHandle_t model);
-		void TestBoundingBoxInCapsule(traceWork_t* tw, clipHandle_t model);
-		void TraceThroughSphere(traceWork_t* tw, vec3_t origin, float radius, vec3_t start, vec3_t end);
-		void PositionTest(traceWork_t* tw);
-		void TraceThroughPatch(traceWork_t* tw, const collisionPatch_t* patch);
-		void TraceThroughTerrain(traceWork_t* tw, const collisionTerrain_t* terrain);
-		void TraceThroughBrush(traceWork_t* tw, const collisionBrush_t* brush);
-		void TraceThroughVerticalCylinder(traceWork_t* tw, vec3_t origin, float radius, float halfheight, vec3_t start, vec3_t end);
-		void TraceCapsuleThroughCapsule(traceWork_t* tw, clipHandle_t model);
-		void TraceBoundingBoxThroughCapsule(traceWork_t* tw, clipHandle_t model);
-		void TraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf);
-		void TraceThroughTree(traceWork_t* tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2);
-		bool TraceThroughFence(const traceWork_t* tw, const collisionBrush_t* brush, const collisionBrushSide_t* side, float fTraceFraction);
-		bool SightTraceThroughPatch(traceWork_t* tw, collisionPatch_t* patch);
-		bool SightTraceThroughTerrain(traceWork_t* tw, collisionTerrain_t* terrain);
-		bool SightTraceThroughBrush(traceWork_t* tw, collisionBrush_t* brush);
-		bool SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf);
-		bool SightTraceThroughTree(traceWork_t* tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2);
+		void ProjectPointOntoVector(vec3_t point, vec3_t vStart, vec3_t vDir, vec3_t vProj) const;
+		float DistanceFromLineSquared(vec3_t p, vec3_t lp1, vec3_t lp2, vec3_t dir) const;
+		float VectorDistanceSquared(vec3_t p1, vec3_t p2) const;
+		void TestBoxInBrush(traceWork_t* tw, const collisionBrush_t* brush) const;
+		void TestInLeaf(traceWork_t* tw, const collisionLeaf_t* leaf) const;
+		void TestCapsuleInCapsule(traceWork_t* tw, clipHandle_t model) const;
+		void TestBoundingBoxInCapsule(traceWork_t* tw, clipHandle_t model) const;
+		void TraceThroughSphere(traceWork_t* tw, vec3_t origin, float radius, vec3_t start, vec3_t end) const;
+		void PositionTest(traceWork_t* tw) const;
+		void TraceThroughPatch(traceWork_t* tw, const collisionPatch_t* patch) const;
+		void TraceThroughTerrain(traceWork_t* tw, const collisionTerrain_t* terrain) const;
+		void TraceThroughBrush(traceWork_t* tw, const collisionBrush_t* brush) const;
+		void TraceThroughVerticalCylinder(traceWork_t* tw, vec3_t origin, float radius, float halfheight, vec3_t start, vec3_t end) const;
+		void TraceCapsuleThroughCapsule(traceWork_t* tw, clipHandle_t model) const;
+		void TraceBoundingBoxThroughCapsule(traceWork_t* tw, clipHandle_t model) const;
+		void TraceToLeaf(traceWork_t* tw, const collisionLeaf_t* leaf) const;
+		bool TraceThroughObjects(traceWork_t* tw) const;
+		bool InitTraceWork(traceContext_t& context, traceWork_t& tw, const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, uint32_t brushmask) const;
+		void FinishTraceWork(const traceWork_t& tw, const vec3r_t start, const vec3r_t end, trace_t* results) const;
+		void TraceThroughTree(traceWork_t* tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) const;
+		bool TraceThroughFence(const traceWork_t* tw, const collisionBrushSide_t* side, float fTraceFraction) const;
+		bool SightTraceThroughPatch(traceWork_t* tw, const collisionPatch_t* patch) const;
+		bool SightTraceThroughTerrain(traceWork_t* tw, const collisionTerrain_t* terrain) const;
+		bool SightTraceThroughBrush(traceWork_t* tw, const collisionBrush_t* brush) const;
+		bool SightTraceToLeaf(traceWork_t* tw, const collisionLeaf_t* leaf) const;
+		bool SightTraceThroughTree(traceWork_t* tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) const;
 
 	private:
-		int PointLeafnum_r(const vec3r_t p, int num);
-		int PointLeafnum(const vec3r_t p);
-		size_t	BoxLeafnums(const vec3r_t mins, const vec3r_t maxs, int* list, size_t listsize, int* lastLeaf);
+		int PointLeafnum_r(const vec3r_t p, int num) const;
+		int PointLeafnum(const vec3r_t p) const;
+		size_t	BoxLeafnums(const vec3r_t mins, const vec3r_t maxs, int* list, size_t listsize, int* lastLeaf) const;
 		collisionShader_t* ShaderPointer(int iShaderNum);
 		uint8_t* ClusterPVS(int cluster);
 		void FloodArea_r(int areaNum, int floodnum);
@@ -486,58 +591,51 @@ namespace MOHPC
 
 	// Terrain
 	private:
-		void TraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc);
-		bool PositionTestInTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc);
-		bool SightTracePointThroughTerrainCollide(void);
-		bool SightTraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc);
-		float CheckTerrainPlane(const vec4_t plane);
-		float CheckTerrainTriSpherePoint(const vec3_t v);
-		float CheckTerrainTriSphereCorner(const vec4_t plane, float x0, float y0, int i, int j);
-		float CheckTerrainTriSphereEdge(const float* plane, float x0, float y0, int i0, int j0, int i1, int j1);
-		float CheckTerrainTriSphere(float x0, float y0, int iPlane);
-		bool ValidateTerrainCollidePointSquare(float frac);
-		bool ValidateTerrainCollidePointTri(int eMode, float frac);
-		bool TestTerrainCollideSquare(void);
-		bool CheckStartInsideTerrain(int i, int j, float fx, float fy);
-		bool PositionTestPointInTerrainCollide(void);
-		void TracePointThroughTerrainCollide(void);
-		void TraceCylinderThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc);
+		void TraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const;
+		bool PositionTestInTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const;
+		bool SightTracePointThroughTerrainCollide(pointtrace_t& g_trace) const;
+		bool SightTraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const;
+		float CheckTerrainPlane(const pointtrace_t& g_trace, const vec4_t plane) const;
+		float CheckTerrainTriSpherePoint(const pointtrace_t& g_trace, const vec3_t v) const;
+		float CheckTerrainTriSphereCorner(const pointtrace_t& g_trace, const vec4_t plane, float x0, float y0, int i, int j) const;
+		float CheckTerrainTriSphereEdge(const pointtrace_t& g_trace, const float* plane, float x0, float y0, int i0, int j0, int i1, int j1) const;
+		float CheckTerrainTriSphere(pointtrace_t& g_trace, float x0, float y0, int iPlane) const;
+		bool ValidateTerrainCollidePointSquare(const pointtrace_t& g_trace, float frac) const;
+		bool ValidateTerrainCollidePointTri(const pointtrace_t& g_trace, int eMode, float frac) const;
+		bool TestTerrainCollideSquare(const pointtrace_t& g_trace) const;
+		bool CheckStartInsideTerrain(const pointtrace_t& g_trace, int i, int j, float fx, float fy) const;
+		bool PositionTestPointInTerrainCollide(pointtrace_t& g_trace) const;
+		void TracePointThroughTerrainCollide(pointtrace_t& g_trace) const;
+		void TraceCylinderThroughTerrainCollide(pointtrace_t& g_trace, traceWork_t* tw, const terrainCollide_t* tc) const;
 
 	// Patch
 	private:
 		bool PlaneFromPoints(vec4_t plane, vec3r_t a, vec3r_t b, vec3r_t c);
-		void TraceThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc);
-		bool PositionTestInPatchCollide(traceWork_t* tw, const patchCollide_t* pc);
+		void TraceThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const;
+		bool PositionTestInPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const;
 		void ClearLevelPatches(void);
-		void TracePointThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc);
-		int CheckFacetPlane(float* plane, vec3_t start, vec3_t end, float* enterFrac, float* leaveFrac, uint32_t* hit);
+		void TracePointThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const;
+		int CheckFacetPlane(float* plane, vec3_t start, vec3_t end, float* enterFrac, float* leaveFrac, uint32_t* hit) const;
 
 	private:
 		std::vector<collisionFencemask_t> fencemasks;
 		std::vector<collisionShader_t> shaders;
-		std::vector<collisionSideEq_t> sideequations;
-		std::vector<collisionBrushSide_t> brushsides;
-		std::vector<collisionPlane_t> planes;
-		std::vector<collisionNode_t> nodes;
-		std::vector<collisionLeaf_t> leafs;
-		std::vector<intptr_t> leafbrushes;
-		std::vector<intptr_t> leafsurfaces;
-		std::vector<collisionTerrain_t*> leafterrains;
-		std::vector<collisionModel_t> cmodels;
-		std::vector<collisionBrush_t> brushes;
-		std::vector<collisionPatch_t*> surfaces;
-		std::vector<collisionTerrain_t> terrain;
-		std::vector<collisionPatch_t> patchList;
-
-		// incremented on each trace
-		size_t checkcount;
-
-		sphere_t sphere;
-		pointtrace_t g_trace;
-		size_t c_traces;
-		size_t c_patch_traces;
-		size_t c_brush_traces;
-		size_t c_pointcontents;
+		CollisionTable<collisionSideEq_t> sideequations;
+		CollisionTable<collisionBrushSide_t> brushsides;
+		CollisionTable<collisionPlane_t> planes;
+		CollisionTable<collisionNode_t> nodes;
+		CollisionTable<collisionLeaf_t> leafs;
+		CollisionTable<intptr_t> leafbrushes;
+		CollisionTable<intptr_t> leafsurfaces;
+		CollisionTable<OffsetPtr<collisionTerrain_t>> leafterrains;
+		CollisionTable<collisionModel_t> cmodels;
+		CollisionTable<collisionBrush_t> brushes;
+		CollisionTable<OffsetPtr<collisionPatch_t>> surfaces;
+		CollisionTable<collisionTerrain_t> terrain;
+		CollisionTable<collisionPatch_t> patchList;
+
+		// used by the functions that don't take a context
+		traceContext_t defaultContext;
 	};
 
 	using CollisionWorldPtr = SharedPtr<CollisionWorld>;
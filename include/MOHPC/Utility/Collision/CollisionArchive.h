@@ -19,6 +19,39 @@ namespace MOHPC
 		CollisionWorld& cm;
 	};
 
+	/**
+	 * Flat image of a collision world, that can be memory-mapped and used in place.
+	 *
+	 * Tables are written with the same layout they have in memory and reference each other with offsets,
+	 * so loading only validates the header and points the tables of the world to the image.
+	 * Processes mapping the same image file share its pages.
+	 * An image can only be loaded with the same architecture and version it was written with,
+	 * CollisionWorldSerializer remains the portable format.
+	 */
+	class CollisionWorldImage
+	{
+	public:
+		CollisionWorldImage(CollisionWorld& cmValue)
+			: cm(cmValue)
+		{}
+
+		MOHPC_UTILITY_EXPORTS void save(IArchiveWriter& ar);
+
+		/**
+		 * Use the image for the world.
+		 * Only fence masks and shaders are copied, the image must stay valid until the world is cleared or destroyed.
+		 * The world can't be modified afterwards.
+		 *
+		 * @param data	Start of the image, aligned to 16 bytes (like a mapped file).
+		 * @param size	Size of the image.
+		 * @return false if the image is invalid or was written for another architecture.
+		 */
+		MOHPC_UTILITY_EXPORTS bool load(const void* data, size_t size);
+
+	private:
+		CollisionWorld& cm;
+	};
+
 	template<typename T>
 	class CollisionSerializerBase
 	{
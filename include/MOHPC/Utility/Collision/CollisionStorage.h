@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace MOHPC
+{
+	/**
+	 * Pointer stored as an offset from its own address.
+	 *
+	 * The offset stays valid wherever the pointer and its target are moved together,
+	 * which allows collision data to be written to a file and used in place once mapped at any address.
+	 * Copying the pointer keeps the same target.
+	 */
+	template<typename T>
+	class OffsetPtr
+	{
+	public:
+		OffsetPtr()
+			: offset(0)
+		{}
+
+		OffsetPtr(std::nullptr_t)
+			: offset(0)
+		{}
+
+		OffsetPtr(T* ptr)
+		{
+			set(ptr);
+		}
+
+		OffsetPtr(const OffsetPtr& other)
+		{
+			set(other.get());
+		}
+
+		OffsetPtr& operator=(const OffsetPtr& other)
+		{
+			set(other.get());
+			return *this;
+		}
+
+		OffsetPtr& operator=(T* ptr)
+		{
+			set(ptr);
+			return *this;
+		}
+
+		T* get() const
+		{
+			// 0 is used for null as the pointer can't point to itself
+			return offset ? (T*)((const uint8_t*)this + offset) : nullptr;
+		}
+
+		T* operator->() const
+		{
+			return get();
+		}
+
+		T& operator*() const
+		{
+			return *get();
+		}
+
+		T& operator[](size_t index) const
+		{
+			return get()[index];
+		}
+
+		operator T*() const
+		{
+			return get();
+		}
+
+	private:
+		void set(T* ptr)
+		{
+			offset = ptr ? (const uint8_t*)ptr - (const uint8_t*)this : 0;
+		}
+
+	private:
+		int64_t offset;
+	};
+
+	/**
+	 * Array of collision objects, either owned or referencing external memory (like a mapped file).
+	 * External memory is read-only: only const access is allowed while the table is mapped,
+	 * and the table must be cleared before adding elements to it.
+	 */
+	template<typename T>
+	class CollisionTable
+	{
+	public:
+		CollisionTable()
+			: elements(nullptr)
+			, count(0)
+			, external(false)
+		{}
+
+		CollisionTable(const CollisionTable&) = delete;
+		CollisionTable& operator=(const CollisionTable&) = delete;
+
+		/** Reference count elements in external memory. The memory must stay valid until the table is cleared. */
+		void map(const T* data, size_t num)
+		{
+			storage.clear();
+			storage.shrink_to_fit();
+			elements = data;
+			count = num;
+			external = true;
+		}
+
+		bool isMapped() const
+		{
+			return external;
+		}
+
+		template<typename...Args>
+		T& emplace_back(Args&&...args)
+		{
+			assert(!external);
+			T& elem = storage.emplace_back(std::forward<Args>(args)...);
+			update();
+			return elem;
+		}
+
+		void push_back(const T& value)
+		{
+			assert(!external);
+			storage.push_back(value);
+			update();
+		}
+
+		void reserve(size_t num)
+		{
+			assert(!external);
+			storage.reserve(num);
+			update();
+		}
+
+		void clear()
+		{
+			storage.clear();
+			external = false;
+			update();
+		}
+
+		const T& operator[](size_t index) const
+		{
+			return elements[index];
+		}
+
+		T& operator[](size_t index)
+		{
+			assert(!external);
+			return storage[index];
+		}
+
+		const T* data() const
+		{
+			return elements;
+		}
+
+		T* data()
+		{
+			assert(!external);
+			return storage.data();
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+	private:
+		void update()
+		{
+			elements = storage.data();
+			count = storage.size();
+		}
+
+	private:
+		std::vector<T> storage;
+		// either the storage or external memory
+		const T* elements;
+		size_t count;
+		bool external;
+	};
+}
@@ -48,4 +48,39 @@ namespace MOHPC
 		virtual bool waitIncoming(uint64_t timeout) = 0;
 	};
 	using ICommunicatorPtr = SharedPtr<ICommunicator>;
+
+	/**
+	 * Abstract class for waiting on multiple communicators at once.
+	 */
+	class MOHPC_UTILITY_EXPORTS ICommunicatorPoller
+	{
+	public:
+		virtual ~ICommunicatorPoller() = default;
+
+		/**
+		 * Start watching a communicator.
+		 *
+		 * @param comm The communicator to watch. It must stay valid until it is removed.
+		 * @return false if the communicator can't be watched by this poller.
+		 */
+		virtual bool add(ICommunicator& comm) = 0;
+
+		/**
+		 * Stop watching a communicator.
+		 *
+		 * @param comm The communicator to remove.
+		 */
+		virtual void remove(ICommunicator& comm) = 0;
+
+		/**
+		 * Wait until one or more watched communicators have an incoming message.
+		 *
+		 * @param ready Array receiving communicators with an incoming message.
+		 * @param maxReady Maximum number of communicators to return.
+		 * @param timeout Wait timeout, in milliseconds.
+		 * @return the number of communicators in the ready array.
+		 */
+		virtual size_t wait(ICommunicator* ready[], size_t maxReady, uint64_t timeout) = 0;
+	};
+	using ICommunicatorPollerPtr = SharedPtr<ICommunicatorPoller>;
 }
@@ -5,6 +5,7 @@
 #include "SharedPtr.h"
 #include "RemoteIdentifier.h"
 #include "Communicator.h"
+#include "TimerWheel.h"
 
 #include <MOHPC/Common/str.h>
 #include <vector>
@@ -32,6 +33,14 @@ namespace MOHPC
 		 */
 		MOHPC_UTILITY_EXPORTS void addComm(const ICommunicatorPtr& comm);
 
+		/**
+		 * Set the poller used to wait on all communicators at once.
+		 * Communicators that the poller can't watch are still waited one after another.
+		 *
+		 * @param poller The poller, or NULL to wait on each communicator.
+		 */
+		MOHPC_UTILITY_EXPORTS void setPoller(const ICommunicatorPollerPtr& poller);
+
 		/**
 		 * Batch process all incoming messages.
 		 * Will return once there are no more requests to process.
@@ -53,12 +62,26 @@ namespace MOHPC
 		bool needsProcessing() const;
 		void clearHandlers();
 		bool processComm(ICommunicator& comm, uint64_t maxWaitTime);
+		bool processPolledComms(uint64_t maxWaitTime);
+		void receiveMessage(ICommunicator& comm);
+		void processTimers();
 		void addHandler(IncomingMessageHandler* handler);
 		void removeHandler(IncomingMessageHandler* handler);
+		void updateHandler(IncomingMessageHandler* handler);
 		uint64_t getWaitTime() const;
 
 	private:
 		std::vector<ICommunicatorPtr> commList;
+		/** Communicators that are not watched by the poller. */
+		std::vector<ICommunicator*> unpolledComms;
+		std::vector<ICommunicator*> readyComms;
+		ICommunicatorPollerPtr poller;
+		/** Deferred and timeout times of handlers. */
+		TimerWheel<IncomingMessageHandler> timers;
+		std::vector<IncomingMessageHandler*> expiredHandlers;
+		size_t numActiveHandlers;
+		/** Reused for all received messages, it only grows to fit the largest message. */
+		std::vector<uint8_t> receiveBuffer;
 		IncomingMessageHandler* root;
 		IncomingMessageHandler* last;
 	};
@@ -5,6 +5,7 @@
 #include <MOHPC/Common/Math.h>
 #include <cstdint>
 #include <cstddef>
+#include <cassert>
 #include <istream>
 
 namespace MOHPC
@@ -54,7 +55,7 @@ namespace MOHPC
 		uint16_t symbol;
 	};
 
-	class Huff
+	class MOHPC_UTILITY_EXPORTS Huff
 	{
 	public:
 		/* Maximum symbol */
@@ -92,6 +93,8 @@ namespace MOHPC
 		);
 
 		void addRef(uint8_t ch);
+		const node_t* getTree() const;
+		const node_t* getNode(uint16_t symbol) const;
 		uintptr_t receive(const uint8_t* fin, size_t& bloc) const;
 		void transmit(uint8_t ch, uint8_t* fout, size_t& offset) const;
 		uintptr_t offsetReceive(const uint8_t* fin, size_t* offset) const;
@@ -143,6 +146,11 @@ namespace MOHPC
 			}
 		}
 
+		const constNode_t* getNode(uint16_t symbol) const
+		{
+			return loc[symbol];
+		}
+
 		uintptr_t receive(const uint8_t* fin, size_t& bloc) const
 		{
 			const constNode_t* node = tree;
@@ -186,4 +194,202 @@ namespace MOHPC
 			}
 		}
 	};
+
+	/**
+	 * Table-driven decoder built from an existing huffman tree.
+	 * Codes up to lookupBits long are resolved with a single table lookup,
+	 * longer codes continue walking the tree from where the table stopped.
+	 *
+	 * The tree must not be modified after the decoder has been built.
+	 * The input buffer must have at least 2 readable bytes past the current bit position.
+	 */
+	template<typename NodeT, size_t lookupBits = 11>
+	class HuffLookupDecoder
+	{
+		static_assert(lookupBits > 0 && lookupBits <= 16, "lookupBits must be between 1 and 16");
+
+	public:
+		static constexpr size_t NUM_ENTRIES = size_t(1) << lookupBits;
+
+	private:
+		struct entry_t
+		{
+			/* resolved symbol, INTERNAL_NODE if the code is longer than the table */
+			uint16_t symbol;
+			/* number of bits consumed by the lookup */
+			uint16_t length;
+		};
+
+		entry_t table[NUM_ENTRIES];
+		/* node where the walk stopped, only used for long codes */
+		const NodeT* nodes[NUM_ENTRIES];
+
+	public:
+		HuffLookupDecoder(const NodeT* tree)
+		{
+			for (size_t i = 0; i < NUM_ENTRIES; ++i)
+			{
+				const NodeT* node = tree;
+				uint16_t length = 0;
+				// bits are read from the lowest to the highest
+				while (node && node->symbol == Huff::INTERNAL_NODE && length < lookupBits) {
+					node = ((i >> length) & 1) ? node->right : node->left;
+					++length;
+				}
+
+				table[i].symbol = node ? node->symbol : Huff::INTERNAL_NODE;
+				table[i].length = length;
+				nodes[i] = node;
+			}
+		}
+
+		uintptr_t receive(const uint8_t* fin, size_t& bloc) const
+		{
+			const size_t index = peekBits(fin, bloc);
+			const entry_t& entry = table[index];
+			bloc += entry.length;
+			if (entry.symbol != Huff::INTERNAL_NODE) {
+				return entry.symbol;
+			}
+
+			const NodeT* node = walk(nodes[index], fin, bloc);
+			return node ? node->symbol : 0;
+		}
+
+		uint16_t offsetReceive(const uint8_t* fin, size_t* offset) const
+		{
+			const size_t index = peekBits(fin, *offset);
+			const entry_t& entry = table[index];
+			if (entry.symbol != Huff::INTERNAL_NODE)
+			{
+				*offset += entry.length;
+				return entry.symbol;
+			}
+
+			size_t bloc = *offset + entry.length;
+			const NodeT* node = walk(nodes[index], fin, bloc);
+			if (!node) {
+				return 0;
+			}
+			*offset = bloc;
+			return node->symbol;
+		}
+
+		/**
+		 * Decode a symbol from a window of bits, the first bit being the lowest.
+		 *
+		 * @param window Bits to decode, must be at least as long as the longest code.
+		 * @param length Number of bits used by the symbol.
+		 */
+		uint16_t decodeWindow(uint64_t window, size_t& length) const
+		{
+			const size_t index = size_t(window & (NUM_ENTRIES - 1));
+			const entry_t& entry = table[index];
+			length = entry.length;
+			if (entry.symbol != Huff::INTERNAL_NODE) {
+				return entry.symbol;
+			}
+
+			const NodeT* node = nodes[index];
+			while (node && node->symbol == Huff::INTERNAL_NODE && length < 64) {
+				node = ((window >> length) & 1) ? node->right : node->left;
+				++length;
+			}
+			return node ? node->symbol : 0;
+		}
+
+	private:
+		static size_t peekBits(const uint8_t* fin, size_t bloc)
+		{
+			const uint8_t* p = fin + (bloc >> 3);
+			const uint32_t window = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+			return (window >> (bloc & 7)) & (NUM_ENTRIES - 1);
+		}
+
+		static const NodeT* walk(const NodeT* node, const uint8_t* fin, size_t& bloc)
+		{
+			while (node && node->symbol == Huff::INTERNAL_NODE) {
+				node = Huff::getBit(fin, bloc) ? node->right : node->left;
+			}
+			return node;
+		}
+	};
+
+	/**
+	 * Table-driven encoder built from an existing huffman tree.
+	 * Each symbol is written as a whole precomputed code word
+	 * instead of walking the tree from the leaf up to the root.
+	 *
+	 * The tree must not be modified after the encoder has been built.
+	 */
+	class HuffLookupEncoder
+	{
+	public:
+		/* Longest code that can be merged with a partial byte in a 64-bit accumulator */
+		static constexpr size_t MAX_CODE_BITS = 56;
+
+	private:
+		struct codeWord_t
+		{
+			/* bits in emission order, first bit is the lowest */
+			uint64_t code;
+			/* number of bits, 0 if the symbol is not in the tree */
+			uint8_t length;
+		};
+
+		codeWord_t codes[Huff::HMAX];
+
+	public:
+		template<typename HuffT>
+		HuffLookupEncoder(const HuffT& huff)
+		{
+			for (uint16_t i = 0; i < Huff::HMAX; ++i)
+			{
+				codeWord_t& codeWord = codes[i];
+				codeWord.code = 0;
+				codeWord.length = 0;
+
+				// walking up gives the bits in reverse order, the root's bit is emitted first
+				for (auto node = huff.getNode(i); node && node->parent; node = node->parent)
+				{
+					assert(codeWord.length < MAX_CODE_BITS);
+					codeWord.code = (codeWord.code << 1) | (node->parent->right == node);
+					++codeWord.length;
+				}
+			}
+		}
+
+		/** Return the code word of the symbol, first bit being the lowest. */
+		uint64_t getCode(uint8_t ch) const
+		{
+			return codes[ch].code;
+		}
+
+		/** Return the number of bits of the symbol's code word. */
+		size_t getLength(uint8_t ch) const
+		{
+			return codes[ch].length;
+		}
+
+		void transmit(uint8_t ch, uint8_t* fout, size_t& offset) const
+		{
+			const codeWord_t& codeWord = codes[ch];
+			uint8_t* p = fout + (offset >> 3);
+			const size_t shift = offset & 7;
+
+			// keep the bits that were already written in the current byte
+			const uint64_t accumulator = (p[0] & ((1u << shift) - 1)) | (codeWord.code << shift);
+			const size_t numBytes = (shift + codeWord.length + 7) >> 3;
+			for (size_t i = 0; i < numBytes; ++i) {
+				p[i] = uint8_t(accumulator >> (i << 3));
+			}
+
+			offset += codeWord.length;
+		}
+
+		void offsetTransmit(uint8_t ch, uint8_t* fout, size_t* offset) const
+		{
+			transmit(ch, fout, *offset);
+		}
+	};
 };
@@ -220,6 +220,20 @@ namespace MOHPC
 		/** Return the current bit position of the message. */
 		size_t GetBitPosition() const;
 
+		/**
+		 * Return the data left to read, to continue reading with a MSGBufferReader.
+		 * This is the storage of the stream, or the pending bits once the whole stream has been read.
+		 *
+		 * @param data Set to the data to read.
+		 * @param length Set to the length of the data, in bytes.
+		 * @param bitPos Set to the bit of the data where reading continues.
+		 * @return false if the stream is not in memory.
+		 */
+		bool GetReadBuffer(const uint8_t*& data, size_t& length, size_t& bitPos) const;
+
+		/** Continue reading at a bit of the data returned by GetReadBuffer(). */
+		void SetReadBitPosition(size_t bitPos);
+
 		/** Return whether or not this message is for reading. */
 		bool IsReading() noexcept;
 
@@ -0,0 +1,727 @@
+#pragma once
+
+#include "../../UtilityGlobal.h"
+#include "MSG.h"
+#include "Codec.h"
+#include "Stream.h"
+#include "HuffmanTree.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace MOHPC
+{
+	namespace MessageCodecs
+	{
+		/** Return the code words of the static huffman tree used by the bit codec. */
+		MOHPC_UTILITY_EXPORTS const HuffLookupEncoder& GetHuffEncoder();
+
+		/** Return the lookup table of the static huffman tree used by the bit codec. */
+		MOHPC_UTILITY_EXPORTS const HuffLookupDecoder<constNode_t>& GetHuffDecoder();
+	}
+
+	/**
+	 * Read bits from a contiguous buffer through a 64-bit reservoir.
+	 * Bits past the end of the buffer are read as zero.
+	 */
+	class MessageBitReader
+	{
+	public:
+		/* Minimum number of bits in the reservoir after a refill */
+		static constexpr size_t MIN_RESERVOIR_BITS = 56;
+
+	private:
+		const uint8_t* data;
+		size_t length;
+		size_t bytePos;
+		uint64_t reservoir;
+		size_t numBits;
+
+	public:
+		MessageBitReader(const void* inData, size_t inLength, size_t bitPos = 0) noexcept
+			: data((const uint8_t*)inData)
+			, length(inLength)
+			, bytePos(bitPos >> 3)
+			, reservoir(0)
+			, numBits(0)
+		{
+			if (bitPos & 7)
+			{
+				refill();
+				consume(bitPos & 7);
+			}
+		}
+
+		/** Make sure the reservoir contains at least MIN_RESERVOIR_BITS bits. */
+		void refill() noexcept
+		{
+			if (numBits >= MIN_RESERVOIR_BITS) {
+				return;
+			}
+
+			if (bytePos + sizeof(uint64_t) <= length)
+			{
+				// load 8 bytes at once, bytes that don't fit are loaded again on the next refill
+				const uint8_t* p = data + bytePos;
+				uint64_t word = 0;
+				for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+					word |= uint64_t(p[i]) << (i << 3);
+				}
+
+				reservoir |= word << numBits;
+				const size_t numBytes = (63 - numBits) >> 3;
+				bytePos += numBytes;
+				numBits += numBytes << 3;
+			}
+			else
+			{
+				while (numBits < MIN_RESERVOIR_BITS)
+				{
+					if (bytePos < length) {
+						reservoir |= uint64_t(data[bytePos]) << numBits;
+					}
+					++bytePos;
+					numBits += 8;
+				}
+			}
+		}
+
+		/** Return the bits in the reservoir, the next bit being the lowest. */
+		uint64_t peek() const noexcept
+		{
+			return reservoir;
+		}
+
+		/** Discard bits from the reservoir. */
+		void consume(size_t bits) noexcept
+		{
+			reservoir >>= bits;
+			numBits -= bits;
+		}
+
+		/** Read up to MIN_RESERVOIR_BITS raw bits. */
+		uint64_t readBits(size_t bits) noexcept
+		{
+			refill();
+			const uint64_t value = reservoir & ((uint64_t(1) << bits) - 1);
+			consume(bits);
+			return value;
+		}
+
+		/** Return the number of bits that were read. */
+		size_t getBitPosition() const noexcept
+		{
+			return (bytePos << 3) - numBits;
+		}
+
+		/** Return the length of the buffer, in bytes. */
+		size_t getLength() const noexcept
+		{
+			return length;
+		}
+
+		/** Return true if more bits were read than the buffer contains. */
+		bool isOverflowed() const noexcept
+		{
+			return getBitPosition() > (length << 3);
+		}
+	};
+
+	/**
+	 * Write bits into a contiguous buffer through a 64-bit reservoir.
+	 * Whole bytes are written as soon as they are complete.
+	 */
+	class MessageBitWriter
+	{
+	private:
+		uint8_t* data;
+		size_t maxLength;
+		size_t bytePos;
+		uint64_t reservoir;
+		size_t numBits;
+
+	public:
+		MessageBitWriter(void* inData, size_t inMaxLength) noexcept
+			: data((uint8_t*)inData)
+			, maxLength(inMaxLength)
+			, bytePos(0)
+			, reservoir(0)
+			, numBits(0)
+		{
+		}
+
+		/** Write up to 56 bits. The value must not have any bit set above the number of bits. */
+		void writeBits(uint64_t value, size_t bits)
+		{
+			reservoir |= value << numBits;
+			numBits += bits;
+
+			if (numBits < 8) {
+				return;
+			}
+
+			const size_t numBytes = numBits >> 3;
+			if (bytePos + sizeof(uint64_t) <= maxLength)
+			{
+				// store all bytes at once, the ones above are zero and will be overwritten
+				uint8_t* p = data + bytePos;
+				for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+					p[i] = uint8_t(reservoir >> (i << 3));
+				}
+			}
+			else
+			{
+				if (bytePos + numBytes > maxLength) {
+					throw StreamOverflowException(StreamOverflowException::Writing);
+				}
+
+				for (size_t i = 0; i < numBytes; ++i) {
+					data[bytePos + i] = uint8_t(reservoir >> (i << 3));
+				}
+			}
+
+			bytePos += numBytes;
+			reservoir >>= numBytes << 3;
+			numBits &= 7;
+		}
+
+		/** Write the remaining bits, padding the last byte with zeros. */
+		void flush()
+		{
+			if (numBits)
+			{
+				if (bytePos >= maxLength) {
+					throw StreamOverflowException(StreamOverflowException::Writing);
+				}
+
+				data[bytePos++] = uint8_t(reservoir);
+				reservoir = 0;
+				numBits = 0;
+			}
+		}
+
+		/** Return the number of bits that were written. */
+		size_t getBitPosition() const noexcept
+		{
+			return (bytePos << 3) + numBits;
+		}
+	};
+
+	namespace MessageCodecs
+	{
+		/** XOR a value with a key, floating-point values are XORed by their bits. */
+		template<typename T>
+		T XORType(T b, intptr_t key)
+		{
+			if constexpr (std::is_floating_point<T>::value)
+			{
+				using int_t = typename std::conditional<sizeof(T) == sizeof(int32_t), int32_t, int64_t>::type;
+
+				int_t xored;
+				std::memcpy(&xored, &b, sizeof(xored));
+				xored ^= int_t(key);
+				std::memcpy(&b, &xored, sizeof(xored));
+				return b;
+			}
+			else {
+				return T(b ^ key);
+			}
+		}
+
+		/** Return the bits of an arithmetic value, without sign extension. */
+		template<typename T>
+		uint64_t ToBits(T value)
+		{
+			if constexpr (std::is_floating_point<T>::value)
+			{
+				using int_t = typename std::conditional<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>::type;
+
+				int_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+			else if constexpr (std::is_same<T, bool>::value) {
+				return value;
+			}
+			else {
+				return uint64_t(typename std::make_unsigned<T>::type(value));
+			}
+		}
+
+		/** Return the arithmetic value from its bits. */
+		template<typename T>
+		T FromBits(uint64_t bits)
+		{
+			if constexpr (std::is_floating_point<T>::value)
+			{
+				using int_t = typename std::conditional<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>::type;
+
+				const int_t intValue = int_t(bits);
+				T value;
+				std::memcpy(&value, &intValue, sizeof(value));
+				return value;
+			}
+			else {
+				return T(bits);
+			}
+		}
+
+		/**
+		 * Compile-time equivalent of MessageCodecs::Bit.
+		 * Partial bits are written raw, whole bytes are huffman-coded.
+		 */
+		class BitPolicy
+		{
+		private:
+			const HuffLookupEncoder& encoder;
+			const HuffLookupDecoder<constNode_t>& decoder;
+
+		public:
+			BitPolicy()
+				: encoder(GetHuffEncoder())
+				, decoder(GetHuffDecoder())
+			{
+			}
+
+			uint64_t Decode(MessageBitReader& reader, size_t bits) const
+			{
+				const size_t nbits = bits & 7;
+				uint64_t value = nbits ? reader.readBits(nbits) : 0;
+
+				for (size_t shift = nbits; shift < bits; shift += 8)
+				{
+					reader.refill();
+
+					size_t length;
+					const uint16_t symbol = decoder.decodeWindow(reader.peek(), length);
+					reader.consume(length);
+
+					value |= uint64_t(symbol & 0xFF) << shift;
+				}
+
+				return value;
+			}
+
+			void Encode(MessageBitWriter& writer, uint64_t value, size_t bits) const
+			{
+				const size_t nbits = bits & 7;
+				if (nbits) {
+					writer.writeBits(value & ((1u << nbits) - 1), nbits);
+				}
+
+				for (size_t shift = nbits; shift < bits; shift += 8)
+				{
+					const uint8_t ch = uint8_t(value >> shift);
+					writer.writeBits(encoder.getCode(ch), encoder.getLength(ch));
+				}
+			}
+		};
+
+		/**
+		 * Compile-time equivalent of MessageCodecs::OOB.
+		 * Values are read and written as raw bytes, bits must be 8, 16, 32 or 64.
+		 */
+		class OOBPolicy
+		{
+		public:
+			uint64_t Decode(MessageBitReader& reader, size_t bits) const
+			{
+				if (bits == 64)
+				{
+					const uint64_t low = reader.readBits(32);
+					return low | (reader.readBits(32) << 32);
+				}
+				else if (bits == 8 || bits == 16 || bits == 32) {
+					return reader.readBits(bits);
+				}
+
+				throw BadBitsException(bits);
+			}
+
+			void Encode(MessageBitWriter& writer, uint64_t value, size_t bits) const
+			{
+				if (bits == 64)
+				{
+					writer.writeBits(value & 0xFFFFFFFF, 32);
+					writer.writeBits(value >> 32, 32);
+				}
+				else if (bits == 8 || bits == 16 || bits == 32) {
+					writer.writeBits(value & ((uint64_t(1) << bits) - 1), bits);
+				}
+				else {
+					throw BadBitsException(bits);
+				}
+			}
+		};
+	}
+
+	/**
+	 * Message reader over a contiguous buffer, with the codec known at compile time.
+	 * Same bit layout as MSG, but every read can be inlined by the compiler.
+	 *
+	 * @tparam CodecT Codec policy, see MessageCodecs::BitPolicy and MessageCodecs::OOBPolicy.
+	 */
+	template<typename CodecT = MessageCodecs::BitPolicy>
+	class MSGBufferReader
+	{
+	private:
+		MessageBitReader reader;
+		CodecT codec;
+
+	public:
+		MSGBufferReader(const void* data, size_t length, size_t bitPos = 0)
+			: reader(data, length, bitPos)
+		{
+		}
+
+		/** Continue reading where another reader stopped, useful to switch codec. */
+		MSGBufferReader(const MessageBitReader& inReader)
+			: reader(inReader)
+		{
+		}
+
+		/** Return the underlying bit reader. */
+		const MessageBitReader& bitReader() const noexcept
+		{
+			return reader;
+		}
+
+		/** Return the size of this message. */
+		size_t Size() const noexcept
+		{
+			return reader.getLength();
+		}
+
+		/** Return the actual position of the message. */
+		size_t GetPosition() const noexcept
+		{
+			return reader.getBitPosition() >> 3;
+		}
+
+		/** Return the current bit position of the message. */
+		size_t GetBitPosition() const noexcept
+		{
+			return reader.getBitPosition();
+		}
+
+		/** Return whether or not this message is for reading. */
+		bool IsReading() const noexcept
+		{
+			return true;
+		}
+
+		/** Read specified bits. */
+		void ReadBits(void* value, intptr_t bits)
+		{
+			if (bits < 0) bits = -bits;
+
+			uint8_t* buf = (uint8_t*)value;
+			if (bits <= 64)
+			{
+				const uint64_t decoded = codec.Decode(reader, bits);
+				const size_t numBytes = (bits + 7) >> 3;
+				for (size_t i = 0; i < numBytes; ++i) {
+					buf[i] = uint8_t(decoded >> (i << 3));
+				}
+			}
+			else
+			{
+				// partial bits come first, then each byte is shifted by them
+				const size_t nbits = bits & 7;
+				std::memset(buf, 0, (bits + 7) >> 3);
+				if (nbits) {
+					buf[0] = uint8_t(codec.Decode(reader, nbits));
+				}
+
+				for (size_t bitNum = nbits; bitNum < size_t(bits); bitNum += 8)
+				{
+					const uint16_t decoded = uint16_t(codec.Decode(reader, 8) << (bitNum & 7));
+					buf[bitNum >> 3] |= uint8_t(decoded);
+					if (decoded >> 8) {
+						buf[(bitNum >> 3) + 1] |= uint8_t(decoded >> 8);
+					}
+				}
+			}
+
+			checkOverflow();
+		}
+
+		/** Read data from message. */
+		void ReadData(void* data, size_t length)
+		{
+			for (size_t i = 0; i < length; i++) {
+				((uint8_t*)data)[i] = ReadByte();
+			}
+		}
+
+		template<typename T>
+		T ReadNumber(size_t bits = sizeof(T) << 3)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Type must be an arithmetic type");
+
+			// like MSG, negative bits passed as size_t read the same number of bits
+			if (intptr_t(bits) < 0) bits = size_t(-intptr_t(bits));
+
+			const uint64_t decoded = codec.Decode(reader, bits);
+			checkOverflow();
+
+			return MessageCodecs::FromBits<T>(decoded);
+		}
+
+		/** Read a boolean value with 1 bit. */
+		bool ReadBool() { return ReadNumber<uint8_t>(1) != 0; }
+
+		/** Read a boolean value, byte-sized. */
+		bool ReadByteBool() { return ReadNumber<uint8_t>() != 0; }
+
+		/** Read a char value. */
+		char ReadChar() { return ReadNumber<char>(); }
+
+		/** Read a byte value. */
+		unsigned char ReadByte() { return ReadNumber<unsigned char>(); }
+
+		/** Read a short value. */
+		short ReadShort() { return ReadNumber<short>(); }
+
+		/** Read an unsigned short value. */
+		unsigned short ReadUShort() { return ReadNumber<unsigned short>(); }
+
+		/** Read an integer value. */
+		int ReadInteger() { return ReadNumber<int>(); }
+
+		/** Read an unsigned integer value. */
+		unsigned int ReadUInteger() { return ReadNumber<unsigned int>(); }
+
+		/** Read a float value. */
+		float ReadFloat() { return ReadNumber<float>(); }
+
+		/** Read a string value. */
+		StringMessage ReadString()
+		{
+			// calculate the length of the string without moving
+			MessageBitReader measure = reader;
+			size_t len = 0;
+			while (uint8_t(codec.Decode(measure, 8)))
+			{
+				if (measure.isOverflowed()) {
+					throw StreamOverflowException(StreamOverflowException::Reading);
+				}
+				++len;
+			}
+
+			StringMessage s;
+			s.preAlloc(len + 1);
+			for (size_t i = 0; i < len; ++i) {
+				s.writeChar(ReadChar(), i);
+			}
+
+			// null-terminating character
+			ReadByte();
+
+			return s;
+		}
+
+		template<typename T>
+		T ReadDeltaType(const T& a, size_t bits = sizeof(T) << 3)
+		{
+			if (ReadBool()) {
+				return ReadNumber<T>(bits);
+			}
+
+			return a;
+		}
+
+		template<typename T>
+		T ReadDeltaTypeKey(const T& a, intptr_t key, size_t bits = sizeof(T) << 3)
+		{
+			if (ReadBool()) {
+				return MessageCodecs::XORType(ReadNumber<T>(bits), key);
+			}
+
+			return a;
+		}
+
+	private:
+		void checkOverflow() const
+		{
+			if (reader.isOverflowed()) {
+				throw StreamOverflowException(StreamOverflowException::Reading);
+			}
+		}
+	};
+
+	/**
+	 * Message writer into a contiguous buffer, with the codec known at compile time.
+	 * Produces the same output as MSG with the equivalent codec.
+	 * Flush() must be called once everything has been written.
+	 *
+	 * @tparam CodecT Codec policy, see MessageCodecs::BitPolicy and MessageCodecs::OOBPolicy.
+	 */
+	template<typename CodecT = MessageCodecs::BitPolicy>
+	class MSGBufferWriter
+	{
+	private:
+		MessageBitWriter writer;
+		CodecT codec;
+
+	public:
+		MSGBufferWriter(void* data, size_t maxLength)
+			: writer(data, maxLength)
+		{
+		}
+
+		/** Continue writing where another writer stopped, useful to switch codec. */
+		MSGBufferWriter(const MessageBitWriter& inWriter)
+			: writer(inWriter)
+		{
+		}
+
+		/** Return the underlying bit writer. */
+		const MessageBitWriter& bitWriter() const noexcept
+		{
+			return writer;
+		}
+
+		/** Write the last partial byte. */
+		void Flush()
+		{
+			writer.flush();
+		}
+
+		/** Return the number of bytes that were written, including the last partial byte. */
+		size_t GetPosition() const noexcept
+		{
+			return (writer.getBitPosition() + 7) >> 3;
+		}
+
+		/** Return the current bit position of the message. */
+		size_t GetBitPosition() const noexcept
+		{
+			return writer.getBitPosition();
+		}
+
+		/** Return whether or not this message is for writing. */
+		bool IsWriting() const noexcept
+		{
+			return true;
+		}
+
+		/** Write specified bits. */
+		MSGBufferWriter& WriteBits(const void* value, intptr_t bits)
+		{
+			if (bits < 0) bits = -bits;
+
+			const uint8_t* buf = (const uint8_t*)value;
+			if (bits <= 64)
+			{
+				const size_t numBytes = (bits + 7) >> 3;
+				uint64_t encoded = 0;
+				for (size_t i = 0; i < numBytes; ++i) {
+					encoded |= uint64_t(buf[i]) << (i << 3);
+				}
+
+				codec.Encode(writer, encoded, bits);
+			}
+			else
+			{
+				// partial bits come first, then each byte is shifted by them
+				const size_t nbits = bits & 7;
+				if (nbits) {
+					codec.Encode(writer, buf[0] & ((1u << nbits) - 1), nbits);
+				}
+
+				for (size_t bitNum = nbits; bitNum < size_t(bits); bitNum += 8)
+				{
+					const size_t index = bitNum >> 3;
+					const size_t subBitNum = bitNum & 7;
+					const uint8_t byte = subBitNum
+						? uint8_t((buf[index] >> subBitNum) | (buf[index + 1] << (8 - subBitNum)))
+						: buf[index];
+					codec.Encode(writer, byte, 8);
+				}
+			}
+
+			return *this;
+		}
+
+		/** Write data to message. */
+		MSGBufferWriter& WriteData(const void* data, size_t size)
+		{
+			for (size_t i = 0; i < size; i++) {
+				WriteByte(((const uint8_t*)data)[i]);
+			}
+			return *this;
+		}
+
+		template<typename T>
+		MSGBufferWriter& WriteNumber(T value, size_t bits = sizeof(T) << 3)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Type must be an arithmetic type");
+
+			uint64_t encoded = MessageCodecs::ToBits(value);
+			if (bits < 64) {
+				encoded &= (uint64_t(1) << bits) - 1;
+			}
+
+			codec.Encode(writer, encoded, bits);
+			return *this;
+		}
+
+		/** Write a boolean value with 1 bit. */
+		MSGBufferWriter& WriteBool(bool value) { return WriteNumber<uint8_t>(value, 1); }
+
+		/** Write a boolean value, byte-sized. */
+		MSGBufferWriter& WriteByteBool(bool value) { return WriteNumber<uint8_t>(value); }
+
+		/** Write a char value. */
+		MSGBufferWriter& WriteChar(char value) { return WriteNumber<char>(value); }
+
+		/** Write a byte value. */
+		MSGBufferWriter& WriteByte(unsigned char value) { return WriteNumber<unsigned char>(value); }
+
+		/** Write a short value. */
+		MSGBufferWriter& WriteShort(short value) { return WriteNumber<short>(value); }
+
+		/** Write an unsigned short value. */
+		MSGBufferWriter& WriteUShort(unsigned short value) { return WriteNumber<unsigned short>(value); }
+
+		/** Write an integer value. */
+		MSGBufferWriter& WriteInteger(int value) { return WriteNumber<int>(value); }
+
+		/** Write an unsigned integer value. */
+		MSGBufferWriter& WriteUInteger(unsigned int value) { return WriteNumber<unsigned int>(value); }
+
+		/** Write a float value. */
+		MSGBufferWriter& WriteFloat(float value) { return WriteNumber<float>(value); }
+
+		/** Write a string value. */
+		MSGBufferWriter& WriteString(const StringMessage& s)
+		{
+			if (s) {
+				WriteData(s.getData(), strlen(s));
+			}
+
+			return WriteByte(0);
+		}
+
+		template<typename T>
+		MSGBufferWriter& WriteDeltaType(const T& a, const T& b, size_t bits = sizeof(T) << 3)
+		{
+			const bool isDiff = a != b;
+			WriteBool(isDiff);
+			if (isDiff) WriteNumber(b, bits);
+			return *this;
+		}
+
+		template<typename T>
+		MSGBufferWriter& WriteDeltaTypeKey(const T& a, const T& b, intptr_t key, size_t bits = sizeof(T) << 3)
+		{
+			const bool isDiff = a != b;
+			WriteBool(isDiff);
+			if (isDiff) WriteNumber(MessageCodecs::XORType(b, key), bits);
+			return *this;
+		}
+	};
+}
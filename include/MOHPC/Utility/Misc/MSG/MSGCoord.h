@@ -6,6 +6,113 @@
 
 namespace MOHPC
 {
+	/**
+	 * Read coordinates from any message reader, MSG or MSGBufferReader.
+	 */
+	template<typename Reader>
+	class MsgCoordReader
+	{
+	public:
+		MsgCoordReader(Reader& inMsg)
+			: msg(inMsg)
+		{
+		}
+
+		/** Read a coordinate value. */
+		float ReadCoord()
+		{
+			uint32_t read = msg.template ReadNumber<uint32_t>(19);
+
+			float sign = 1.0f;
+			if (read & 262144)
+			{
+				// the 19th bit is the sign
+				sign = -1.0f;
+			}
+
+			read &= ~262144; //  uint=4294705151
+			return sign * (read / 16.f);
+		}
+
+		/** Read a coordinate value. */
+		float ReadCoordSmall()
+		{
+			uint32_t read = msg.template ReadNumber<uint32_t>(17);
+
+			float sign = 1.0f;
+			if (read & 65536)
+			{
+				// the 17th bit is the sign
+				sign = -1.0f;
+			}
+
+			read &= ~65536; //  uint=4294705151
+			return sign * (read / 8.f);
+		}
+
+		/** Read a coordinate value. */
+		int32_t ReadDeltaCoord(uint32_t offset)
+		{
+			int32_t result = 0;
+
+			const bool isSmall = msg.ReadBool();
+			if (isSmall)
+			{
+				const uint8_t byteValue = msg.template ReadNumber<uint8_t>(8);
+				result = (byteValue >> 1) + 1;
+				if (byteValue & 1) result = -result;
+
+				result += offset;
+
+			}
+			else {
+				result = msg.template ReadNumber<uint16_t>(16);
+			}
+
+			return result;
+		}
+
+		/** Read a coordinate value. */
+		int32_t ReadDeltaCoordExtra(uint32_t offset)
+		{
+			int32_t result = 0;
+
+			const bool isSmall = msg.ReadBool();
+			if (isSmall)
+			{
+				const uint16_t shortValue = msg.template ReadNumber<uint16_t>(10);
+				result = (shortValue >> 1) + 1;
+				if (shortValue & 1) result = -result;
+
+				result += offset;
+			}
+			else {
+				result = msg.template ReadNumber<uint32_t>(18);
+			}
+
+			return result;
+		}
+
+		/** Read a coordinate value. */
+		void ReadVectorCoord(vec3_t& out)
+		{
+			out[0] = ReadCoord();
+			out[1] = ReadCoord();
+			out[2] = ReadCoord();
+		}
+
+		/** Read a coordinate value. */
+		void ReadVectorFloat(vec3_t& out)
+		{
+			out[0] = msg.ReadFloat();
+			out[1] = msg.ReadFloat();
+			out[2] = msg.ReadFloat();
+		}
+
+	private:
+		Reader& msg;
+	};
+
 	class MOHPC_UTILITY_EXPORTS MsgCoordHelper : public MsgBaseHelper
 	{
 	public:
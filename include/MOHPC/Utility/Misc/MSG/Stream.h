@@ -100,6 +100,9 @@ namespace MOHPC
 		virtual void Seek(size_t offset, SeekPos from = IMessageStream::SeekPos::Begin) noexcept override;
 		virtual size_t GetPosition() const noexcept override;
 		virtual size_t GetLength() const noexcept override;
+
+		uint8_t* getStorage();
+		const uint8_t* getStorage() const;
 	};
 
 	class MOHPC_UTILITY_EXPORTS DynamicDataMessageStream : public IMessageStream
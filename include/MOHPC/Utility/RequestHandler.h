@@ -116,6 +116,8 @@ namespace MOHPC
 		const IRequestPtr& currentRequest() const;
 		bool processTimeOut();
 		bool expect(InputRequest& input);
+		bool getNextTime(time_point<steady_clock>& time) const;
+		void updateDispatcher();
 
 	private:
 		friend MessageDispatcher;
@@ -126,6 +128,8 @@ namespace MOHPC
 		IncomingMessageHandler* prev;
 
 		IRemoteIdentifierPtr remoteId;
+		/** Whether the handler is counted as requesting by the dispatcher. */
+		bool active;
 
 	private:
 		struct PendingRequest
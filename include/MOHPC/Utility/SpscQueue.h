@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+namespace MOHPC
+{
+	/**
+	 * Bounded lock-free queue between a single producer thread and a single consumer thread.
+	 *
+	 * push() must only be called by the producer, and pop() only by the consumer.
+	 * Each side keeps a copy of the index of the other side, so the shared indexes are only read when the copy says the queue is full/empty.
+	 */
+	template<typename T>
+	class SpscQueue
+	{
+	public:
+		/**
+		 * @param minCapacity Minimum number of elements that can be queued, rounded up to a power of two.
+		 */
+		SpscQueue(size_t minCapacity)
+			: head(0)
+			, tail(0)
+			, cachedHead(0)
+			, cachedTail(0)
+		{
+			size_t capacity = 1;
+			while (capacity < minCapacity) capacity <<= 1;
+
+			buffer.resize(capacity);
+			mask = capacity - 1;
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/**
+		 * Add an element at the end of the queue.
+		 *
+		 * @return false if the queue is full.
+		 */
+		bool push(T value)
+		{
+			const size_t currentTail = tail.load(std::memory_order_relaxed);
+			if (currentTail - cachedHead > mask)
+			{
+				// may be full, check what the consumer has popped since
+				cachedHead = head.load(std::memory_order_acquire);
+				if (currentTail - cachedHead > mask) {
+					return false;
+				}
+			}
+
+			buffer[currentTail & mask] = std::move(value);
+			tail.store(currentTail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * Remove the first element of the queue.
+		 *
+		 * @return false if the queue is empty.
+		 */
+		bool pop(T& value)
+		{
+			const size_t currentHead = head.load(std::memory_order_relaxed);
+			if (currentHead == cachedTail)
+			{
+				// may be empty, check what the producer has pushed since
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (currentHead == cachedTail) {
+					return false;
+				}
+			}
+
+			value = std::move(buffer[currentHead & mask]);
+			head.store(currentHead + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Return true if there is nothing to pop. Can be called from any of both threads. */
+		bool empty() const
+		{
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+		/** Return the maximum number of elements. */
+		size_t capacity() const
+		{
+			return mask + 1;
+		}
+
+	private:
+		std::vector<T> buffer;
+		size_t mask;
+		// indexes are on separate cache lines so both threads don't invalidate each other
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+		/** Copy of head, only used by the producer. */
+		alignas(64) size_t cachedHead;
+		/** Copy of tail, only used by the consumer. */
+		alignas(64) size_t cachedTail;
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "UtilityGlobal.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <cstddef>
+
+namespace MOHPC
+{
+	class ThreadPool;
+
+	/**
+	 * List of tasks with dependencies between them.
+	 *
+	 * When running the graph on a thread pool, a task starts as soon as all of its dependencies are done,
+	 * so independent tasks run in parallel. Tasks can use the same thread pool themselves.
+	 */
+	class TaskGraph
+	{
+	public:
+		using TaskFunction = std::function<void()>;
+
+	public:
+		MOHPC_UTILITY_EXPORTS TaskGraph();
+		MOHPC_UTILITY_EXPORTS ~TaskGraph();
+
+		/**
+		 * Add a task to the graph.
+		 *
+		 * @param func Function to call.
+		 * @param dependencies Tasks that must be done before this one, they must have been added before.
+		 * @return the task index, to be used as a dependency.
+		 */
+		MOHPC_UTILITY_EXPORTS size_t addTask(TaskFunction&& func, std::initializer_list<size_t> dependencies = {});
+
+		/** Return the number of tasks. */
+		MOHPC_UTILITY_EXPORTS size_t getNumTasks() const;
+
+		/**
+		 * Run all tasks and wait until they are done.
+		 * If a task throws, remaining tasks are skipped and the first exception is rethrown once running tasks are done.
+		 *
+		 * @param pool Thread pool running the tasks, or NULL to run them one after another in the order they were added.
+		 */
+		MOHPC_UTILITY_EXPORTS void run(ThreadPool* pool = nullptr);
+
+	private:
+		struct task_t
+		{
+			TaskFunction func;
+			std::vector<size_t> dependents;
+			size_t numDependencies;
+		};
+
+	private:
+		void runBatch(ThreadPool& pool, const std::vector<size_t>& batch);
+		void runTask(ThreadPool& pool, size_t taskNum);
+
+	private:
+		std::vector<task_t> tasks;
+		/** Number of dependencies of each task that are not done yet, while running. */
+		std::unique_ptr<std::atomic<size_t>[]> pendingDependencies;
+		std::mutex errorMutex;
+		std::exception_ptr error;
+		std::atomic<bool> failed;
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "UtilityGlobal.h"
+#include "UtilityObject.h"
+#include "SharedPtr.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+namespace MOHPC
+{
+	/**
+	 * Pool of worker threads executing tasks.
+	 *
+	 * Each worker has its own queue of tasks, a worker that has nothing to do
+	 * steals tasks from the queue of other workers, so a long task doesn't hold others.
+	 */
+	class ThreadPool
+	{
+		MOHPC_UTILITY_OBJECT_DECLARATION(ThreadPool);
+
+	public:
+		using TaskFunction = std::function<void(size_t index)>;
+
+	public:
+		/**
+		 * Start the worker threads.
+		 *
+		 * @param numThreads Number of worker threads, 0 to use the number of hardware threads.
+		 */
+		MOHPC_UTILITY_EXPORTS ThreadPool(size_t numThreads = 0);
+		MOHPC_UTILITY_EXPORTS ~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/** Return the number of worker threads. */
+		MOHPC_UTILITY_EXPORTS size_t getNumThreads() const;
+
+		/**
+		 * Call a function for each index in [0, count) from the worker threads, and wait until all calls are done.
+		 * The calling thread also executes tasks while waiting.
+		 *
+		 * @param count Number of calls.
+		 * @param func Function to call, it must not throw.
+		 */
+		MOHPC_UTILITY_EXPORTS void parallelFor(size_t count, const TaskFunction& func);
+
+	private:
+		struct batch_t;
+
+		struct task_t
+		{
+			const TaskFunction* func;
+			batch_t* batch;
+			size_t index;
+		};
+
+		struct worker_t
+		{
+			std::mutex mutex;
+			std::deque<task_t> tasks;
+			std::thread thread;
+		};
+
+	private:
+		void workerThread(size_t workerIndex);
+		bool popTask(size_t workerIndex, task_t& task);
+		void runTask(const task_t& task);
+
+	private:
+		std::vector<std::unique_ptr<worker_t>> workers;
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<size_t> numPending;
+		bool stopping;
+	};
+	using ThreadPoolPtr = SharedPtr<ThreadPool>;
+}
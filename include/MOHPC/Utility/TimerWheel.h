@@ -0,0 +1,221 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+	/**
+	 * Hashed timer wheel, used to find objects that have reached their scheduled time
+	 * without going through all scheduled objects.
+	 *
+	 * Time is split into ticks of the specified resolution, each tick maps to a slot of the wheel.
+	 * Objects scheduled more than one turn ahead stay in their slot until the wheel reaches them.
+	 * An object can only be scheduled once, scheduling it again moves it.
+	 */
+	template<typename T>
+	class TimerWheel
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+		using time_point = clock::time_point;
+
+	public:
+		/**
+		 * @param resolution	Duration of a tick.
+		 * @param numSlots		Number of slots in the wheel.
+		 */
+		TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(8), size_t numSlots = 512)
+			: tickDuration(resolution)
+			, slots(numSlots)
+			, currentTick(toTick(clock::now()))
+		{
+		}
+
+		/**
+		 * Schedule an object at the specified time. The object is moved if it was already scheduled.
+		 *
+		 * @param object	The object to schedule.
+		 * @param time		Time at which the object expires.
+		 */
+		void schedule(T* object, time_point time)
+		{
+			uint64_t tick = toTick(time);
+			if (tick < currentTick)
+			{
+				// already expired, it will be returned on next advance
+				tick = currentTick;
+			}
+
+			const size_t slotIndex = tick % slots.size();
+
+			auto it = objectSlots.find(object);
+			if (it != objectSlots.end())
+			{
+				// rescheduled (usually on each message), keep the map entry to avoid allocating a new one
+				removeFromSlot(object, it->second);
+				it->second = slotIndex;
+			}
+			else {
+				objectSlots.emplace(object, slotIndex);
+			}
+
+			slots[slotIndex].push_back(entry_t{ object, time, tick });
+		}
+
+		/**
+		 * Remove an object from the wheel.
+		 *
+		 * @return true if the object was scheduled.
+		 */
+		bool cancel(T* object)
+		{
+			auto it = objectSlots.find(object);
+			if (it == objectSlots.end()) {
+				return false;
+			}
+
+			removeFromSlot(object, it->second);
+			objectSlots.erase(it);
+			return true;
+		}
+
+		/** Return true if the object is in the wheel. */
+		bool isScheduled(T* object) const
+		{
+			return objectSlots.find(object) != objectSlots.end();
+		}
+
+		/** Return true if there is no scheduled object. */
+		bool empty() const
+		{
+			return objectSlots.empty();
+		}
+
+		/**
+		 * Move the wheel to the specified time and remove all objects that expired.
+		 *
+		 * @param now		The current time.
+		 * @param expired	Receive expired objects.
+		 */
+		void advance(time_point now, std::vector<T*>& expired)
+		{
+			const uint64_t nowTick = toTick(now);
+			if (nowTick < currentTick) {
+				return;
+			}
+
+			// there is no need to visit a slot more than once
+			const uint64_t numTicks = std::min<uint64_t>(nowTick - currentTick + 1, slots.size());
+			for (uint64_t tick = currentTick; tick < currentTick + numTicks; ++tick)
+			{
+				std::vector<entry_t>& slot = slots[tick % slots.size()];
+				for (size_t i = 0; i < slot.size();)
+				{
+					const entry_t& entry = slot[i];
+					if (entry.tick <= nowTick && entry.time <= now)
+					{
+						expired.push_back(entry.object);
+						objectSlots.erase(entry.object);
+
+						slot[i] = slot.back();
+						slot.pop_back();
+					}
+					else {
+						++i;
+					}
+				}
+			}
+
+			// the current tick is not fully elapsed, it is visited again next time
+			currentTick = nowTick;
+		}
+
+		/**
+		 * Get the time of the nearest scheduled object.
+		 *
+		 * @param time	Receive the time.
+		 * @return false if there is no scheduled object.
+		 */
+		bool getNextTime(time_point& time) const
+		{
+			if (objectSlots.empty()) {
+				return false;
+			}
+
+			// look at the slots of the current turn
+			for (uint64_t tick = currentTick; tick < currentTick + slots.size(); ++tick)
+			{
+				const std::vector<entry_t>& slot = slots[tick % slots.size()];
+
+				bool found = false;
+				for (const entry_t& entry : slot)
+				{
+					if (entry.tick <= tick && (!found || entry.time < time))
+					{
+						time = entry.time;
+						found = true;
+					}
+				}
+
+				if (found) {
+					return true;
+				}
+			}
+
+			// all objects are more than one turn ahead
+			bool found = false;
+			for (const std::vector<entry_t>& slot : slots)
+			{
+				for (const entry_t& entry : slot)
+				{
+					if (!found || entry.time < time)
+					{
+						time = entry.time;
+						found = true;
+					}
+				}
+			}
+
+			return found;
+		}
+
+	private:
+		uint64_t toTick(time_point time) const
+		{
+			return (uint64_t)(time.time_since_epoch() / tickDuration);
+		}
+
+		void removeFromSlot(T* object, size_t slotIndex)
+		{
+			std::vector<entry_t>& slot = slots[slotIndex];
+			for (size_t i = 0; i < slot.size(); ++i)
+			{
+				if (slot[i].object == object)
+				{
+					slot[i] = slot.back();
+					slot.pop_back();
+					break;
+				}
+			}
+		}
+
+	private:
+		struct entry_t
+		{
+			T* object;
+			time_point time;
+			uint64_t tick;
+		};
+
+		clock::duration tickDuration;
+		std::vector<std::vector<entry_t>> slots;
+		/** Slot of each scheduled object. */
+		std::unordered_map<T*, size_t> objectSlots;
+		uint64_t currentTick;
+	};
+}
@@ -13,16 +13,24 @@
 #include <MOHPC/Utility/TokenParser.h>
 
 #include "BSP_Curve.h"
+#include "BSP_CacheImage.h"
 
 #include <MOHPC/Common/Math.h>
 
+#include <MOHPC/Utility/TaskGraph.h>
+
 #include <chrono>
 #include <algorithm>
 #include <functional>
+#include <mutex>
+#include <exception>
+#include <cstring>
 
 static constexpr char MOHPC_LOG_NAMESPACE[] = "bsp_asset";
 
 static constexpr unsigned int MIN_MAP_SUBDIVISIONS = 16;
+// number of surfaces converted by each task when using a thread pool
+static constexpr size_t SURFACES_PER_TASK = 64;
 
 static void ProfilableCode(const char *profileName, std::function<void()> Lambda)
 {
@@ -88,14 +96,14 @@ static constexpr float TERRAIN_LIGHTMAP_LENGTH = (16.f / LIGHTMAP_SIZE);
 
 namespace BSPFile
 {
+	/** Range of the file data containing a lump. */
 	struct GameLump
 	{
-		void* buffer;
+		const uint8_t* buffer;
 		size_t length;
 
 	public:
 		GameLump();
-		~GameLump();
 	};
 
 	struct flump_t
@@ -279,11 +287,10 @@ BSPFile::GameLump::GameLump()
 {
 }
 
-BSPFile::GameLump::~GameLump()
+BSPData::RawLump::RawLump()
+	: data(nullptr)
+	, length(0)
 {
-	if (buffer) {
-		delete[] (uint8_t*)buffer;
-	}
 }
 
 const BSPData::Shader* BSPData::Brush::GetShader() const
@@ -581,12 +588,38 @@ const BSPData::Shader *BSP::GetShader(size_t shaderNum) const
 
 size_t BSP::GetNumLightmaps() const
 {
-	return lightmaps.size();
+	return lightmaps.length / lightmapMemSize;
 }
 
 const BSPData::Lightmap *BSP::GetLightmap(size_t lightmapNum) const
 {
-	return &lightmaps.at(lightmapNum);
+	if (lightmapNum >= GetNumLightmaps()) {
+		throw std::out_of_range("invalid lightmap number");
+	}
+
+	// lightmaps have the same layout in the file
+	static_assert(sizeof(BSPData::Lightmap) == lightmapMemSize, "lightmaps must match the file layout");
+	return reinterpret_cast<const BSPData::Lightmap*>(lightmaps.data) + lightmapNum;
+}
+
+const BSPData::RawLump& BSP::GetLightGridPalette() const
+{
+	return lightGridPalette;
+}
+
+const BSPData::RawLump& BSP::GetLightGridOffsets() const
+{
+	return lightGridOffsets;
+}
+
+const BSPData::RawLump& BSP::GetLightGridData() const
+{
+	return lightGridData;
+}
+
+const BSPData::RawLump& BSP::GetSphereLightVis() const
+{
+	return sphereLightVis;
 }
 
 size_t BSP::GetNumSurfaces() const
@@ -756,6 +789,15 @@ const BSPData::Surface *BSP::GetTerrainSurface(size_t terrainSurfaceNum) const
 	return &terrainSurfaces.at(terrainSurfaceNum);
 }
 
+const BSPData::TerrainCollide* BSP::GetTerrainCollide(size_t terrainPatchNum) const
+{
+	if (terrainPatchNum >= terrainCollides.size()) {
+		return nullptr;
+	}
+
+	return &terrainCollides[terrainPatchNum];
+}
+
 size_t BSP::GetNumEntities() const
 {
 	return entities.size();
@@ -813,7 +855,7 @@ void BSPReader::LoadShaders(const BSPFile::GameLump* GameLump, std::vector<BSPDa
 	{
 		shaders.resize(count);
 
-		const BSPFile::fshader_t* in = (BSPFile::fshader_t *)GameLump->buffer;
+		const BSPFile::fshader_t* in = (const BSPFile::fshader_t*)GameLump->buffer;
 		BSPData::Shader* out = shaders.data();
 
 		for (size_t i = 0; i < count; i++, in++, out++)
@@ -827,36 +869,18 @@ void BSPReader::LoadShaders(const BSPFile::GameLump* GameLump, std::vector<BSPDa
 	}
 }
 
-void BSPReader::LoadLightmaps(const BSPFile::GameLump* GameLump, std::vector<BSPData::Lightmap>& lightmaps)
+void BSPReader::LoadLightmaps(const BSPFile::GameLump* GameLump, BSPData::RawLump& lightmaps)
 {
 	if (GameLump->length % lightmapMemSize) {
 		throw BSPError::FunnyLumpSize("lightmaps");
 	}
 
-	const size_t numLightmaps = GameLump->length / lightmapMemSize;
-	if (numLightmaps)
-	{
-		lightmaps.resize(numLightmaps);
-
-		const uint8_t* buf = (uint8_t*)GameLump->buffer;
-		for (size_t i = 0; i < numLightmaps; i++)
-		{
-			Lightmap& lightmap = lightmaps[i];
-
-			const uint8_t* buf_p = buf + i * lightmapMemSize;
-
-			const size_t numPixels = lightmapSize * lightmapSize;
-			for (size_t j = 0; j < numPixels; j++)
-			{
-				lightmap.color[j][0] = buf_p[j * 3 + 0];
-				lightmap.color[j][1] = buf_p[j * 3 + 1];
-				lightmap.color[j][2] = buf_p[j * 3 + 2];
-			}
-		}
-	}
+	// lightmaps are used as stored, they're only read when accessed
+	lightmaps.data = GameLump->buffer;
+	lightmaps.length = GameLump->length;
 }
 
-void BSPReader::ParseMesh(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const std::vector<BSPData::Shader>& shaders, Surface* out)
+void BSPReader::ParseMesh(const BSPFile::fsurface_t* InSurface, const BSPFile::fvertice_t* InVertices, const std::vector<BSPData::Shader>& shaders, const BSPCacheImage* cacheImage, size_t surfaceNum, Surface* out)
 {
 	out->shader = &shaders[Endian.LittleLong(InSurface->shaderNum)];
 
@@ -898,6 +922,10 @@ void BSPReader::ParseMesh(const BSPFile::fsurface_t* InSurface, const BSPFile::f
 	SubdividePatchToGrid(Width, Height, Points, out);
 	out->bIsPatch = true;
 
+	if (cacheImage && cacheImage->createPatchCollide(surfaceNum, out->shader->subdivisions, out->pc)) {
+		return;
+	}
+
 	uint32_t subdivisions = out->shader->subdivisions;
 	if (subdivisions < MIN_MAP_SUBDIVISIONS) {
 		subdivisions = MIN_MAP_SUBDIVISIONS;
@@ -1061,8 +1089,9 @@ void BSPReader::ParseTriSurf(const BSPFile::fsurface_t* InSurface, const BSPFile
 void BSPReader::LoadSurfaces(
 	const BSPFile::GameLump* SurfacesLump,
 	const BSPFile::GameLump* Vertices,
-	BSPFile::GameLump* Indices,
+	const BSPFile::GameLump* Indices,
 	const std::vector<BSPData::Shader>& shaders,
+	const BSPCacheImage* cacheImage,
 	std::vector<BSPData::Surface>& surfaces
 )
 {
@@ -1092,14 +1121,15 @@ void BSPReader::LoadSurfaces(
 	{
 		surfaces.resize(count);
 
-		const BSPFile::fsurface_t* in = (BSPFile::fsurface_t*)SurfacesLump->buffer;
-		Surface* out = surfaces.data();
-
-		const BSPFile::fvertice_t* InVerts = (BSPFile::fvertice_t*)Vertices->buffer;
-		int32_t* InIndexes = (int32_t*)Indices->buffer;
+		const BSPFile::fsurface_t* surfacesIn = (const BSPFile::fsurface_t*)SurfacesLump->buffer;
+		const BSPFile::fvertice_t* InVerts = (const BSPFile::fvertice_t*)Vertices->buffer;
+		const int32_t* InIndexes = (const int32_t*)Indices->buffer;
 
-		for (size_t i = 0; i < count; i++, in++, out++)
+		const auto loadSurface = [&](size_t i)
 		{
+			const BSPFile::fsurface_t* in = &surfacesIn[i];
+			Surface* out = &surfaces[i];
+
 			out->lightmapNum = Endian.LittleLong(in->lightmapNum);
 			out->lightmapX = Endian.LittleLong(in->lightmapX);
 			out->lightmapY = Endian.LittleLong(in->lightmapY);
@@ -1113,7 +1143,7 @@ void BSPReader::LoadSurfaces(
 			switch (Endian.LittleLong(in->surfaceType))
 			{
 			case MST_PATCH:
-				ParseMesh(in, InVerts, shaders, out);
+				ParseMesh(in, InVerts, shaders, cacheImage, i, out);
 				break;
 			case MST_TRIANGLE_SOUP:
 				ParseTriSurf(in, InVerts, InIndexes, shaders, out);
@@ -1124,6 +1154,41 @@ void BSPReader::LoadSurfaces(
 			}
 
 			out->CalculateCentroid();
+		};
+
+		if (!threadPool || count < SURFACES_PER_TASK * 2)
+		{
+			for (size_t i = 0; i < count; i++) {
+				loadSurface(i);
+			}
+			return;
+		}
+
+		// each surface is independent, patch collides take most of the time
+		std::mutex errorMutex;
+		std::exception_ptr error;
+
+		const size_t numTasks = (count + SURFACES_PER_TASK - 1) / SURFACES_PER_TASK;
+		threadPool->parallelFor(numTasks, [&](size_t taskNum)
+		{
+			const size_t start = taskNum * SURFACES_PER_TASK;
+			const size_t end = std::min(start + SURFACES_PER_TASK, count);
+
+			try
+			{
+				for (size_t i = start; i < end; i++) {
+					loadSurface(i);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) error = std::current_exception();
+			}
+		});
+
+		if (error) {
+			std::rethrow_exception(error);
 		}
 	}
 }
@@ -1139,7 +1204,7 @@ void BSPReader::LoadPlanes(const BSPFile::GameLump* GameLump, std::vector<BSPDat
 	{
 		planes.resize(count);
 
-		const BSPFile::fplane_t* in = (BSPFile::fplane_t*)GameLump->buffer;
+		const BSPFile::fplane_t* in = (const BSPFile::fplane_t*)GameLump->buffer;
 		Plane* out = planes.data();
 
 		for (size_t i = 0; i < count; i++, in++, out++)
@@ -1172,7 +1237,7 @@ void BSPReader::LoadSideEquations(const BSPFile::GameLump* GameLump, std::vector
 	{
 		sideEquations.resize(count);
 
-		const BSPFile::fsideequation_t* in = (BSPFile::fsideequation_t*)GameLump->buffer;
+		const BSPFile::fsideequation_t* in = (const BSPFile::fsideequation_t*)GameLump->buffer;
 		SideEquation* out = sideEquations.data();
 
 		for (size_t i = 0; i < count; i++, in++, out++)
@@ -1203,7 +1268,7 @@ void BSPReader::LoadBrushSides(
 	{
 		brushSides.resize(count);
 
-		const BSPFile::fbrushSide_t* in = (BSPFile::fbrushSide_t*)GameLump->buffer;
+		const BSPFile::fbrushSide_t* in = (const BSPFile::fbrushSide_t*)GameLump->buffer;
 		BrushSide* out = brushSides.data();
 
 		for (size_t i = 0; i < count; i++, in++, out++)
@@ -1242,7 +1307,7 @@ void BSPReader::LoadBrushes(
 	{
 		brushes.resize(count);
 
-		const BSPFile::fbrush_t* in = (BSPFile::fbrush_t*)GameLump->buffer;
+		const BSPFile::fbrush_t* in = (const BSPFile::fbrush_t*)GameLump->buffer;
 		Brush* out = brushes.data();
 
 		for (size_t i = 0; i < count; i++, in++, out++)
@@ -1280,7 +1345,7 @@ void BSPReader::LoadLeafs(
 	{
 		leafs.resize(count);
 
-		const BSPFile::fleaf_t* in = (BSPFile::fleaf_t*)GameLump->buffer;
+		const BSPFile::fleaf_t* in = (const BSPFile::fleaf_t*)GameLump->buffer;
 		Leaf* out = leafs.data();
 
 		for (size_t i = 0; i < count; ++i, ++in, ++out)
@@ -1324,7 +1389,7 @@ void BSPReader::LoadLeafsOld(
 	{
 		leafs.resize(count);
 
-		const BSPFile::fleaf_ver17_t* in = (BSPFile::fleaf_ver17_t*)GameLump->buffer;
+		const BSPFile::fleaf_ver17_t* in = (const BSPFile::fleaf_ver17_t*)GameLump->buffer;
 		Leaf* out = leafs.data();
 
 		for (size_t i = 0; i < count; ++i, ++in, ++out)
@@ -1356,7 +1421,7 @@ void BSPReader::LoadLeafsBrushes(const BSPFile::GameLump* GameLump, std::vector<
 	{
 		leafBrushes.resize(count);
 
-		uint32_t* in = (uint32_t*)GameLump->buffer;
+		const uint32_t* in = (const uint32_t*)GameLump->buffer;
 
 		for (size_t i = 0; i < count; ++i) {
 			leafBrushes[i] = Endian.LittleLong(in[i]);
@@ -1375,7 +1440,7 @@ void BSPReader::LoadLeafSurfaces(const BSPFile::GameLump* GameLump, std::vector<
 	{
 		leafSurfaces.reserve(count);
 
-		const uint32_t* in = (uint32_t*)GameLump->buffer;
+		const uint32_t* in = (const uint32_t*)GameLump->buffer;
 
 		for (size_t i = 0; i < count; ++i) {
 			leafSurfaces.push_back(Endian.LittleLong(in[i]));
@@ -1398,7 +1463,7 @@ void BSPReader::LoadNodes(
 	{
 		nodes.resize(count);
 
-		BSPFile::fnode_t* in = (BSPFile::fnode_t*)GameLump->buffer;
+		const BSPFile::fnode_t* in = (const BSPFile::fnode_t*)GameLump->buffer;
 		Node* out = nodes.data();
 
 		for (size_t i = 0; i < count; ++i, ++in, ++out)
@@ -1424,7 +1489,7 @@ void BSPReader::LoadVisibility(const BSPFile::GameLump* GameLump, std::vector<ui
 	visibility.resize(count);
 	numClusters = Endian.LittleLong(((const uint32_t*)GameLump->buffer)[0]);
 	clusterBytes = Endian.LittleLong(((const uint32_t*)GameLump->buffer)[1]);
-	memcpy(visibility.data(), (uint8_t*)GameLump->buffer + VIS_HEADER, count - VIS_HEADER);
+	memcpy(visibility.data(), GameLump->buffer + VIS_HEADER, count - VIS_HEADER);
 }
 
 void BSPReader::LoadSubmodels(
@@ -1444,7 +1509,7 @@ void BSPReader::LoadSubmodels(
 	{
 		brushModels.resize(count);
 
-		const BSPFile::fbmodel_t* in = (BSPFile::fbmodel_t*)GameLump->buffer;
+		const BSPFile::fbmodel_t* in = (const BSPFile::fbmodel_t*)GameLump->buffer;
 		Model* out = brushModels.data();
 
 		size_t numLeafBrushes = 0;
@@ -1540,7 +1605,7 @@ void BSPReader::LoadSphereLights(const BSPFile::GameLump* GameLump, std::vector<
 	{
 		lights.resize(NumLights);
 
-		const BSPFile::fsphereLight_t* in = (BSPFile::fsphereLight_t *)GameLump->buffer;
+		const BSPFile::fsphereLight_t* in = (const BSPFile::fsphereLight_t*)GameLump->buffer;
 		SphereLight* out = lights.data();
 
 		for (size_t i = 0; i < NumLights; in++, out++, i++)
@@ -1568,7 +1633,7 @@ void BSPReader::LoadStaticModelDefs(const BSPFile::GameLump* GameLump, std::vect
 	{
 		staticModels.resize(NumStaticModels);
 
-		const BSPFile::fstaticModel_t* in = (BSPFile::fstaticModel_t *)GameLump->buffer;
+		const BSPFile::fstaticModel_t* in = (const BSPFile::fstaticModel_t*)GameLump->buffer;
 		StaticModel* out = staticModels.data();
 
 		for (size_t i = 0; i < NumStaticModels; in++, out++, i++)
@@ -1667,7 +1732,7 @@ void BSPReader::LoadTerrain(const BSPFile::GameLump* GameLump, const std::vector
 		terrainPatches.resize(count);
 		infoList.resize(count);
 
-		BSPFile::fterrainPatch_t* in = (BSPFile::fterrainPatch_t *)GameLump->buffer;
+		const BSPFile::fterrainPatch_t* in = (const BSPFile::fterrainPatch_t*)GameLump->buffer;
 		TerrainPatch* out = terrainPatches.data();
 		TerrainPatchDrawInfo* outinfo = infoList.data();
 
@@ -1692,7 +1757,7 @@ void BSPReader::LoadTerrainIndexes(
 	{
 		leafTerrains.resize(count);
 
-		const uint16_t* in = (uint16_t*)GameLump->buffer;
+		const uint16_t* in = (const uint16_t*)GameLump->buffer;
 
 		for (size_t i = 0; i < count; ++i) {
 			leafTerrains[i] = &terrainPatches[Endian.LittleShort(in[i])];
@@ -1802,30 +1867,25 @@ void BSPReader::ColorShiftLightingFloats3(vec3_t in, vec3_t out, float scale)
 	out[2] = b;
 }
 
-uint32_t BSPReader::LoadLump(const IFilePtr& file, BSPFile::flump_t* lump, BSPFile::GameLump* gameLump, size_t size)
+void BSPReader::GetLump(const uint8_t* fileData, uint64_t fileSize, uint32_t lumpNum, const BSPFile::flump_t* lump, BSPFile::GameLump* gameLump)
 {
+	const uint32_t fileOffset = Endian.LittleLong(lump->fileOffset);
 	const uint32_t fileLength = Endian.LittleLong(lump->fileLength);
-	gameLump->length = fileLength;
 
-	if (fileLength)
+	if (!fileLength)
 	{
-		gameLump->buffer = new uint8_t[fileLength];
-
-		std::istream* stream = file->GetStream();
-
-		const uint32_t fileOffset = Endian.LittleLong(lump->fileOffset);
-		stream->seekg(fileOffset, stream->beg);
-		stream->read((char*)gameLump->buffer, fileLength);
-
-		if (size) {
-			return (uint32_t)(fileLength / size);
-		}
-	}
-	else {
 		gameLump->buffer = nullptr;
+		gameLump->length = 0;
+		return;
 	}
 
-	return 0;
+	if ((uint64_t)fileOffset + fileLength > fileSize) {
+		throw BSPError::LumpOutOfBounds(lumpNum);
+	}
+
+	// the lump is used in place
+	gameLump->buffer = fileData + fileOffset;
+	gameLump->length = fileLength;
 }
 
 void BSPReader::CreateEntities(
@@ -2039,7 +2099,9 @@ PatchPlane::PatchPlane()
 }
 
 MOHPC_OBJECT_DEFINITION(BSPReader);
-BSPReader::BSPReader()
+BSPReader::BSPReader(const ThreadPoolPtr& threadPoolPtr, const BSPCachePtr& cachePtr)
+	: threadPool(threadPoolPtr)
+	, cache(cachePtr)
 {
 }
 
@@ -2049,10 +2111,28 @@ BSPReader::~BSPReader()
 
 AssetPtr BSPReader::read(const IFilePtr& file)
 {
-	std::istream* stream = file->GetStream();
+	// lumps are used in place, directly from the mapped file if possible, otherwise from the whole file read at once
+	uint64_t fileSize = 0;
+	const uint8_t* fileData = file->getMappedData(fileSize);
+	const bool mapped = fileData != nullptr;
+	if (!mapped)
+	{
+		void* buffer = nullptr;
+		fileSize = file->ReadBuffer(&buffer);
+		fileData = static_cast<const uint8_t*>(buffer);
+	}
 
 	BSPFile::fheader_t Header;
-	stream->read((char*)&Header, sizeof(Header));
+	if (fileSize < sizeof(Header))
+	{
+		uint8_t ident[sizeof(Header.ident)]{};
+		std::memcpy(ident, fileData, std::min<uint64_t>(fileSize, sizeof(ident)));
+
+		MOHPC_LOG(Error, "'%s' is too small to be a BSP", file->getName().generic_string().c_str());
+		throw BSPError::BadHeader(ident);
+	}
+
+	std::memcpy(&Header, fileData, sizeof(Header));
 
 	if (memcmp(Header.ident, BSP_IDENT, sizeof(Header.ident)) && memcmp(Header.ident, BSP_EXPANSIONS_IDENT, sizeof(Header.ident)))
 	{
@@ -2070,206 +2150,263 @@ AssetPtr BSPReader::read(const IFilePtr& file)
 	char* entityString = nullptr;
 	size_t entityStringLength = 0;
 	std::vector<BSPData::TerrainPatchDrawInfo> terrainDrawInfo;
+	uint32_t visNumClusters = 0;
 
 	const BSPPtr bsp = BSPPtr(new BSP(file->getName()));
 
-	ProfilableCode("shaders",
-		[&]()
+	BSPFile::GameLump lumps[HEADER_LUMPS];
+	{
+		const unsigned int usedLumps[] =
 		{
-			BSPFile::GameLump GameLump;
+			LUMP_SHADERS, LUMP_PLANES, LUMP_LIGHTMAPS, LUMP_SURFACES, LUMP_DRAWVERTS, LUMP_DRAWINDEXES,
+			LUMP_LEAFBRUSHES, LUMP_LEAFSURFACES, LUMP_LEAFS, LUMP_NODES, LUMP_SIDEEQUATIONS, LUMP_BRUSHSIDES,
+			LUMP_BRUSHES, LUMP_MODELS, LUMP_ENTITIES, LUMP_VISIBILITY, LUMP_LIGHTGRIDPALETTE, LUMP_LIGHTGRIDOFFSETS,
+			LUMP_LIGHTGRIDDATA, LUMP_SPHERELIGHTS, LUMP_SPHERELIGHTVIS, LUMP_TERRAIN, LUMP_TERRAININDEXES,
+			// must be last, the beta format doesn't have static models
+			LUMP_STATICMODELDEF
+		};
+		constexpr size_t numUsedLumps = sizeof(usedLumps) / sizeof(usedLumps[0]);
+		const size_t numLumps = version > BSP_BETA_VERSION ? numUsedLumps : numUsedLumps - 1;
 
-			LoadLump(file, &Header.lumps[LUMP_SHADERS], &GameLump, sizeof(BSPFile::fshader_t));
-			LoadShaders(&GameLump, bsp->getShaders());
-		});
+		for (size_t i = 0; i < numLumps; ++i) {
+			GetLump(fileData, fileSize, usedLumps[i], &Header.lumps[usedLumps[i]], &lumps[usedLumps[i]]);
+		}
+	}
 
-	ProfilableCode("planes",
-		[&]()
-		{
-			BSPFile::GameLump GameLump;
+	BSPData::RawLump lightmapsLump;
 
-			LoadLump(file, &Header.lumps[LUMP_PLANES], &GameLump, sizeof(BSPFile::fplane_t));
-			LoadPlanes(&GameLump, bsp->getPlanes());
-		});
+	const uint32_t checksum = Endian.LittleLong(Header.checksum);
+	BSPCacheImage cacheImage;
+	if (cache)
+	{
+		const size_t numSurfaces = lumps[LUMP_SURFACES].length / sizeof(BSPFile::fsurface_t);
+		const size_t numTerrainPatches = lumps[LUMP_TERRAIN].length / sizeof(BSPFile::fterrainPatch_t);
+		if (cacheImage.open(cache->getFilePath(checksum, fileSize), checksum, fileSize, numSurfaces, numTerrainPatches)) {
+			MOHPC_LOG(Info, "Using cached data for '%s'", file->getName().generic_string().c_str());
+		}
+	}
 
-	ProfilableCode("lightmaps",
-		[&]()
-		{
-			BSPFile::GameLump GameLump;
+	const BSPCacheImage* const cachedData = cacheImage.isOpen() ? &cacheImage : nullptr;
 
-			LoadLump(file, &Header.lumps[LUMP_LIGHTMAPS], &GameLump, sizeof(uint8_t));
-			LoadLightmaps(&GameLump, bsp->getLightmaps());
-		});
+	// lumps are converted as soon as lumps they depend on are converted
+	TaskGraph graph;
 
-	ProfilableCode("surfaces",
-		[&]()
+	const size_t shadersTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump SurfacesLump;
-			BSPFile::GameLump VerticesLump;
-			BSPFile::GameLump IndexesLump;
-
-			LoadLump(file, &Header.lumps[LUMP_SURFACES], &SurfacesLump, sizeof(BSPFile::fshader_t));
-			LoadLump(file, &Header.lumps[LUMP_DRAWVERTS], &VerticesLump, sizeof(BSPFile::fvertice_t));
-			LoadLump(file, &Header.lumps[LUMP_DRAWINDEXES], &IndexesLump, sizeof(int32_t));
-			LoadSurfaces(&SurfacesLump, &VerticesLump, &IndexesLump, bsp->getShaders(), bsp->getSurfaces());
+			ProfilableCode("shaders", [&]() { LoadShaders(&lumps[LUMP_SHADERS], bsp->getShaders()); });
 		});
 
-	ProfilableCode("side equations",
-		[&]()
+	const size_t planesTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_SIDEEQUATIONS], &GameLump, 0);
-			LoadSideEquations(&GameLump, bsp->getSideEquations());
+			ProfilableCode("planes", [&]() { LoadPlanes(&lumps[LUMP_PLANES], bsp->getPlanes()); });
 		});
 
-	ProfilableCode("brush sides",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_BRUSHSIDES], &GameLump, 0);
-			LoadBrushSides(&GameLump, bsp->getShaders(), bsp->getPlanes(), bsp->getSideEquations(), bsp->getBrushSides());
+			ProfilableCode("lightmaps", [&]() { LoadLightmaps(&lumps[LUMP_LIGHTMAPS], lightmapsLump); });
 		});
 
-	ProfilableCode("brushes",
-		[&]()
+	const size_t surfacesTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_BRUSHES], &GameLump, 0);
-			LoadBrushes(&GameLump, bsp->getShaders(), bsp->getBrushSides(), bsp->getBrushes());
-		});
+			ProfilableCode("surfaces",
+				[&]()
+				{
+					LoadSurfaces(&lumps[LUMP_SURFACES], &lumps[LUMP_DRAWVERTS], &lumps[LUMP_DRAWINDEXES], bsp->getShaders(), cachedData, bsp->getSurfaces());
+				});
+		}, { shadersTask });
 
-	ProfilableCode("leaf brushes",
-		[&]()
+	const size_t sideEquationsTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_LEAFBRUSHES], &GameLump, 0);
-			LoadLeafsBrushes(&GameLump, bsp->getLeafBrushes());
+			ProfilableCode("side equations", [&]() { LoadSideEquations(&lumps[LUMP_SIDEEQUATIONS], bsp->getSideEquations()); });
 		});
 
-	ProfilableCode("leaf surfaces",
-		[&]()
+	const size_t brushSidesTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_LEAFSURFACES], &GameLump, 0);
-			LoadLeafSurfaces(&GameLump, bsp->getLeafSurfaces());
-		});
+			ProfilableCode("brush sides",
+				[&]()
+				{
+					LoadBrushSides(&lumps[LUMP_BRUSHSIDES], bsp->getShaders(), bsp->getPlanes(), bsp->getSideEquations(), bsp->getBrushSides());
+				});
+		}, { shadersTask, planesTask, sideEquationsTask });
 
-	ProfilableCode("leafs",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_LEAFS], &GameLump, 0);
-			uint32_t numClusters = 0;
-			uint32_t numAreas = 0;
-			if (version > BSP_BETA_VERSION) {
-				LoadLeafs(&GameLump, bsp->getLeafs(), bsp->getAreas(), bsp->getAreaPortals(), numClusters, numAreas);
-			}
-			else {
-				LoadLeafsOld(&GameLump, bsp->getLeafs(), bsp->getAreas(), bsp->getAreaPortals(), numClusters, numAreas);
-			}
-
-			bsp->setNumClusters(numClusters);
-			bsp->setNumAreas(numAreas);
-		});
+			ProfilableCode("brushes",
+				[&]()
+				{
+					LoadBrushes(&lumps[LUMP_BRUSHES], bsp->getShaders(), bsp->getBrushSides(), bsp->getBrushes());
+				});
+		}, { brushSidesTask });
 
-	ProfilableCode("nodes",
-		[&]()
+	const size_t leafBrushesTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_NODES], &GameLump, 0);
-			LoadNodes(&GameLump, bsp->getPlanes(), bsp->getNodes());
+			ProfilableCode("leaf brushes", [&]() { LoadLeafsBrushes(&lumps[LUMP_LEAFBRUSHES], bsp->getLeafBrushes()); });
 		});
 
-	ProfilableCode("visibility",
-		[&]()
+	const size_t leafSurfacesTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_VISIBILITY], &GameLump, 0);
-
-
-			uint32_t numClusters = 0;
-			uint32_t clusterBytes = 0;
-			LoadVisibility(&GameLump, bsp->getVisibility(), numClusters, clusterBytes);
-
-			if (numClusters) bsp->setNumClusters(numClusters);
+			ProfilableCode("leaf surfaces", [&]() { LoadLeafSurfaces(&lumps[LUMP_LEAFSURFACES], bsp->getLeafSurfaces()); });
 		});
 
-	ProfilableCode("models",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
+			ProfilableCode("leafs",
+				[&]()
+				{
+					uint32_t numClusters = 0;
+					uint32_t numAreas = 0;
+					if (version > BSP_BETA_VERSION) {
+						LoadLeafs(&lumps[LUMP_LEAFS], bsp->getLeafs(), bsp->getAreas(), bsp->getAreaPortals(), numClusters, numAreas);
+					}
+					else {
+						LoadLeafsOld(&lumps[LUMP_LEAFS], bsp->getLeafs(), bsp->getAreas(), bsp->getAreaPortals(), numClusters, numAreas);
+					}
 
-			LoadLump(file, &Header.lumps[LUMP_MODELS], &GameLump, 0);
-			LoadSubmodels(&GameLump, bsp->getSurfaces(), bsp->getLeafBrushes(), bsp->getLeafSurfaces(), bsp->getBrushModels());
+					bsp->setNumClusters(numClusters);
+					bsp->setNumAreas(numAreas);
+				});
 		});
 
-	ProfilableCode("entities",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
+			ProfilableCode("nodes", [&]() { LoadNodes(&lumps[LUMP_NODES], bsp->getPlanes(), bsp->getNodes()); });
+		}, { planesTask });
 
-			LoadLump(file, &Header.lumps[LUMP_ENTITIES], &GameLump, 0);
-			LoadEntityString(&GameLump, entityString, entityStringLength);
+	graph.addTask([&]()
+		{
+			ProfilableCode("visibility",
+				[&]()
+				{
+					// the number of clusters is set once leafs are loaded
+					uint32_t clusterBytes = 0;
+					LoadVisibility(&lumps[LUMP_VISIBILITY], bsp->getVisibility(), visNumClusters, clusterBytes);
+				});
 		});
 
-	ProfilableCode("sphere lights",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
+			ProfilableCode("models",
+				[&]()
+				{
+					LoadSubmodels(&lumps[LUMP_MODELS], bsp->getSurfaces(), bsp->getLeafBrushes(), bsp->getLeafSurfaces(), bsp->getBrushModels());
+				});
+		}, { surfacesTask, leafBrushesTask, leafSurfacesTask });
 
-			LoadLump(file, &Header.lumps[LUMP_SPHERELIGHTS], &GameLump, 0);
-			LoadSphereLights(&GameLump, bsp->getSphereLights());
+	const size_t entityStringTask = graph.addTask([&]()
+		{
+			ProfilableCode("entities", [&]() { LoadEntityString(&lumps[LUMP_ENTITIES], entityString, entityStringLength); });
 		});
 
-	ProfilableCode("terrains",
-		[&]()
+	graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
-
-			LoadLump(file, &Header.lumps[LUMP_TERRAIN], &GameLump, 0);
-			LoadTerrain(&GameLump, bsp->getShaders(), bsp->getTerrainPatches(), terrainDrawInfo);
+			ProfilableCode("sphere lights", [&]() { LoadSphereLights(&lumps[LUMP_SPHERELIGHTS], bsp->getSphereLights()); });
 		});
 
-	ProfilableCode("terrain indexes",
-		[&]()
+	const size_t terrainTask = graph.addTask([&]()
 		{
-			BSPFile::GameLump GameLump;
+			ProfilableCode("terrains",
+				[&]()
+				{
+					LoadTerrain(&lumps[LUMP_TERRAIN], bsp->getShaders(), bsp->getTerrainPatches(), terrainDrawInfo);
+				});
+		}, { shadersTask });
 
-			LoadLump(file, &Header.lumps[LUMP_TERRAININDEXES], &GameLump, 0);
-			LoadTerrainIndexes(&GameLump, bsp->getTerrainPatches(), bsp->getLeafTerrains());
-		});
+	graph.addTask([&]()
+		{
+			ProfilableCode("terrain indexes",
+				[&]()
+				{
+					LoadTerrainIndexes(&lumps[LUMP_TERRAININDEXES], bsp->getTerrainPatches(), bsp->getLeafTerrains());
+				});
+		}, { terrainTask });
 
-	if (Header.version > BSP_BETA_VERSION)
+	if (version > BSP_BETA_VERSION)
 	{
-		ProfilableCode("static models",
-			[&]()
+		graph.addTask([&]()
 			{
-				BSPFile::GameLump GameLump;
-
-				LoadLump(file, &Header.lumps[LUMP_STATICMODELDEF], &GameLump, 0);
-				LoadStaticModelDefs(&GameLump, bsp->getStaticModels());
+				ProfilableCode("static models", [&]() { LoadStaticModelDefs(&lumps[LUMP_STATICMODELDEF], bsp->getStaticModels()); });
 			});
 	}
 
-	ProfilableCode("generation of terrain surfaces",
-		[&]()
+	graph.addTask([&]()
 		{
-			CreateTerrainSurfaces(bsp->getTerrainPatches(), terrainDrawInfo, bsp->getTerrainSurfaces());
-		});
+			ProfilableCode("generation of terrain surfaces",
+				[&]()
+				{
+					if (cachedData) {
+						cachedData->loadTerrainSurfaces(bsp->getTerrainPatches(), bsp->getTerrainSurfaces());
+					}
+					else {
+						CreateTerrainSurfaces(bsp->getTerrainPatches(), terrainDrawInfo, bsp->getTerrainSurfaces());
+					}
+				});
+		}, { terrainTask });
+
+	if (cache)
+	{
+		// generated here only to be cached, otherwise BSPCollision generates them when filling a collision world
+		graph.addTask([&]()
+			{
+				ProfilableCode("terrain collides",
+					[&]()
+					{
+						std::vector<BSPData::TerrainCollide>& terrainCollides = bsp->getTerrainCollides();
+						if (cachedData)
+						{
+							cachedData->loadTerrainCollides(terrainCollides);
+							return;
+						}
+
+						const std::vector<BSPData::TerrainPatch>& terrainPatches = bsp->getTerrainPatches();
+						terrainCollides.resize(terrainPatches.size());
+
+						BSPCollision collision(bsp);
+						for (size_t i = 0; i < terrainPatches.size(); ++i) {
+							collision.GenerateTerrainCollide(&terrainPatches[i], terrainCollides[i]);
+						}
+					});
+			}, { terrainTask });
+	}
 
 	// FIXME: Should use an external class for creating entities
-	ProfilableCode("creation of entities",
-		[&]()
+	graph.addTask([&]()
 		{
-			CreateEntities(entityString, entityStringLength, bsp->getEntities(), bsp->getTargetList());
-		});
+			ProfilableCode("creation of entities",
+				[&]()
+				{
+					CreateEntities(entityString, entityStringLength, bsp->getEntities(), bsp->getTargetList());
+				});
+		}, { entityStringTask });
+
+	try
+	{
+		graph.run(threadPool.get());
+	}
+	catch (...)
+	{
+		delete[] entityString;
+		throw;
+	}
+
+	if (visNumClusters) bsp->setNumClusters(visNumClusters);
+
+	const auto toRawLump = [](const BSPFile::GameLump& lump)
+	{
+		BSPData::RawLump rawLump;
+		rawLump.data = lump.buffer;
+		rawLump.length = lump.length;
+		return rawLump;
+	};
+
+	// the BSP keeps the file when it's mapped, otherwise raw lumps are copied
+	bsp->setRawLumps(
+		mapped ? file : nullptr,
+		lightmapsLump,
+		toRawLump(lumps[LUMP_LIGHTGRIDPALETTE]),
+		toRawLump(lumps[LUMP_LIGHTGRIDOFFSETS]),
+		toRawLump(lumps[LUMP_LIGHTGRIDDATA]),
+		toRawLump(lumps[LUMP_SPHERELIGHTVIS])
+	);
 
 	if (entityString)
 	{
@@ -2277,6 +2414,18 @@ AssetPtr BSPReader::read(const IFilePtr& file)
 		delete[] entityString;
 	}
 
+	const bool outdatedCache = cachedData && cachedData->isOutdated();
+	// the file may be replaced below
+	cacheImage.close();
+
+	if (cache && (!cachedData || outdatedCache))
+	{
+		const fs::path cachePath = cache->getFilePath(checksum, fileSize);
+		if (!BSPCacheImage::save(cachePath, checksum, fileSize, bsp->getSurfaces(), bsp->getTerrainSurfaces(), bsp->getTerrainCollides())) {
+			MOHPC_LOG(Warn, "Couldn't write cached data of '%s' to '%s'", file->getName().generic_string().c_str(), cachePath.generic_string().c_str());
+		}
+	}
+
 	MOHPC_LOG(Info, "Loaded map '%s', version %d", file->getName().generic_string().c_str(), version);
 
 	return bsp;
@@ -2288,11 +2437,6 @@ std::vector<MOHPC::BSPData::Shader>& BSP::getShaders()
 	return shaders;
 }
 
-std::vector<MOHPC::BSPData::Lightmap>& BSP::getLightmaps()
-{
-	return lightmaps;
-}
-
 std::vector<MOHPC::BSPData::Surface>& BSP::getSurfaces()
 {
 	return surfaces;
@@ -2378,6 +2522,11 @@ std::vector<MOHPC::BSPData::Surface>& BSP::getTerrainSurfaces()
 	return terrainSurfaces;
 }
 
+std::vector<MOHPC::BSPData::TerrainCollide>& BSP::getTerrainCollides()
+{
+	return terrainCollides;
+}
+
 std::vector<class LevelEntity*>& BSP::getEntities()
 {
 	return entities;
@@ -2403,6 +2552,43 @@ void BSP::setNumAreas(uint32_t numAreasValue)
 	numAreas = numAreasValue;
 }
 
+void BSP::setRawLumps(const IFilePtr& file, const BSPData::RawLump& lightmapsLump, const BSPData::RawLump& lightGridPaletteLump, const BSPData::RawLump& lightGridOffsetsLump, const BSPData::RawLump& lightGridDataLump, const BSPData::RawLump& sphereLightVisLump)
+{
+	BSPData::RawLump* const rawLumps[] = { &lightmaps, &lightGridPalette, &lightGridOffsets, &lightGridData, &sphereLightVis };
+	const BSPData::RawLump* const sources[] = { &lightmapsLump, &lightGridPaletteLump, &lightGridOffsetsLump, &lightGridDataLump, &sphereLightVisLump };
+	constexpr size_t numRawLumps = sizeof(rawLumps) / sizeof(rawLumps[0]);
+
+	if (file)
+	{
+		// reference the mapping, pages are read the first time lumps are accessed
+		mappedFile = file;
+		for (size_t i = 0; i < numRawLumps; ++i) {
+			*rawLumps[i] = *sources[i];
+		}
+
+		return;
+	}
+
+	size_t totalLength = 0;
+	for (size_t i = 0; i < numRawLumps; ++i) {
+		totalLength += sources[i]->length;
+	}
+
+	rawLumpStorage = std::make_unique<uint8_t[]>(totalLength);
+
+	uint8_t* storage = rawLumpStorage.get();
+	for (size_t i = 0; i < numRawLumps; ++i)
+	{
+		if (sources[i]->length) {
+			std::memcpy(storage, sources[i]->data, sources[i]->length);
+		}
+
+		rawLumps[i]->data = storage;
+		rawLumps[i]->length = sources[i]->length;
+		storage += sources[i]->length;
+	}
+}
+
 BSPError::BadHeader::BadHeader(const uint8_t inHeader[4])
 	: foundHeader{ inHeader[0], inHeader[1], inHeader[2], inHeader[3] }
 {}
@@ -2447,6 +2633,20 @@ const char* BSPError::FunnyLumpSize::what() const noexcept
 	return "Funny lump size";
 }
 
+BSPError::LumpOutOfBounds::LumpOutOfBounds(uint32_t inLumpNum)
+	: lumpNum(inLumpNum)
+{}
+
+uint32_t BSPError::LumpOutOfBounds::getLumpNum() const
+{
+	return lumpNum;
+}
+
+const char* BSPError::LumpOutOfBounds::what() const noexcept
+{
+	return "Lump is outside of the file";
+}
+
 BSPError::BadMeshSize::BadMeshSize(int32_t inWidth, int32_t inHeight)
 	: width(inWidth)
 	, height(inHeight)
@@ -0,0 +1,509 @@
+#include <MOHPC/Assets/Formats/BSP_Cache.h>
+#include "BSP_CacheImage.h"
+
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+using namespace MOHPC;
+
+namespace MOHPC
+{
+namespace BSPCacheFile
+{
+	enum table_e
+	{
+		TABLE_PATCHES,
+		TABLE_PATCHPLANES,
+		TABLE_FACETS,
+		TABLE_TERRAINSURFACES,
+		TABLE_VERTICES,
+		TABLE_INDEXES,
+		TABLE_TERRAINCOLLIDES,
+		NUM_TABLES
+	};
+
+	struct ftable_t
+	{
+		uint64_t offset;
+		uint64_t count;
+		uint64_t elementSize;
+	};
+
+	struct fheader_t
+	{
+		char ident[4];
+		uint32_t version;
+		// written in native order to detect the endianness
+		uint32_t byteOrder;
+		uint32_t checksum;
+		uint64_t mapSize;
+		uint64_t numSurfaces;
+		uint64_t numTerrainPatches;
+		ftable_t tables[NUM_TABLES];
+	};
+
+	/** Patch collide of a surface, surfaces without patch collide don't have one. */
+	struct fpatch_t
+	{
+		uint32_t surfaceNum;
+		uint32_t firstPlane;
+		uint32_t numPlanes;
+		uint32_t firstFacet;
+		uint32_t numFacets;
+		// subdivisions of the shader when the patch collide was generated
+		uint32_t subdivisions;
+		vec3_t bounds[2];
+	};
+
+	/** Geometry of a terrain surface, one per terrain patch. */
+	struct fterrainSurface_t
+	{
+		uint32_t firstVertice;
+		uint32_t numVertices;
+		uint32_t firstIndex;
+		uint32_t numIndexes;
+	};
+
+	static constexpr char CACHE_IDENT[4] = { 'B', 'S', 'P', 'C' };
+	static constexpr uint32_t CACHE_VERSION = 2;
+	static constexpr uint32_t CACHE_BYTEORDER = 0x01020304;
+	static constexpr size_t CACHE_ALIGNMENT = 16;
+
+	// also acts as a layout check, the file is rejected if a structure has a different size
+	static constexpr size_t elementSizes[NUM_TABLES] =
+	{
+		sizeof(fpatch_t),
+		sizeof(BSPData::PatchPlane),
+		sizeof(BSPData::Facet),
+		sizeof(fterrainSurface_t),
+		sizeof(BSPData::Vertice),
+		sizeof(uint32_t),
+		sizeof(BSPData::TerrainCollide)
+	};
+
+	static size_t alignOffset(size_t offset)
+	{
+		return (offset + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+	}
+
+	static bool isValidBool(const bool* values, size_t count)
+	{
+		// read the bytes, the file may contain anything
+		const unsigned char* bytes = (const unsigned char*)values;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (bytes[i] > 1) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Check that planes of the facet are planes of the patch, they're used without checking them during traces. */
+	static bool isValidFacet(const BSPData::Facet& facet, uint32_t numPlanes)
+	{
+		static constexpr size_t maxBorders = sizeof(facet.borderPlanes) / sizeof(facet.borderPlanes[0]);
+
+		if (facet.surfacePlane < 0 || (uint32_t)facet.surfacePlane >= numPlanes
+			|| facet.numBorders < 0 || (size_t)facet.numBorders > maxBorders
+			|| !isValidBool(facet.borderInward, facet.numBorders)
+			|| !isValidBool(facet.borderNoAdjust, facet.numBorders))
+		{
+			return false;
+		}
+
+		for (int32_t i = 0; i < facet.numBorders; ++i)
+		{
+			if (facet.borderPlanes[i] < 0 || (uint32_t)facet.borderPlanes[i] >= numPlanes) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+}
+
+using namespace BSPCacheFile;
+
+MOHPC_OBJECT_DEFINITION(BSPCache);
+
+BSPCache::BSPCache(const fs::path& directoryValue)
+	: directory(directoryValue)
+{
+}
+
+BSPCache::~BSPCache()
+{
+}
+
+const fs::path& BSPCache::getDirectory() const
+{
+	return directory;
+}
+
+fs::path BSPCache::getFilePath(uint32_t checksum, uint64_t mapSize) const
+{
+	char fileName[48];
+	std::snprintf(fileName, sizeof(fileName), "%08x_%llx.bspc", checksum, (unsigned long long)mapSize);
+
+	return directory / fileName;
+}
+
+BSPCacheImage::BSPCacheImage()
+	: header(nullptr)
+	, outdated(false)
+{
+}
+
+BSPCacheImage::~BSPCacheImage()
+{
+}
+
+template<typename T>
+const T* BSPCacheImage::getTable(size_t tableNum) const
+{
+	return (const T*)(mapping->getData() + header->tables[tableNum].offset);
+}
+
+bool BSPCacheImage::open(const fs::path& path, uint32_t checksum, uint64_t mapSize, size_t numSurfaces, size_t numTerrainPatches)
+{
+	mapping = MappedFile::create();
+	header = nullptr;
+
+	if (!mapping->open(path) || mapping->getSize() < sizeof(fheader_t))
+	{
+		mapping = nullptr;
+		return false;
+	}
+
+	const uint8_t* const data = mapping->getData();
+	const size_t size = mapping->getSize();
+	const fheader_t* const fileHeader = (const fheader_t*)data;
+
+	if (std::memcmp(fileHeader->ident, CACHE_IDENT, sizeof(CACHE_IDENT))
+		|| fileHeader->version != CACHE_VERSION
+		|| fileHeader->byteOrder != CACHE_BYTEORDER
+		|| fileHeader->checksum != checksum
+		|| fileHeader->mapSize != mapSize
+		|| fileHeader->numSurfaces != numSurfaces
+		|| fileHeader->numTerrainPatches != numTerrainPatches)
+	{
+		mapping = nullptr;
+		return false;
+	}
+
+	for (size_t i = 0; i < NUM_TABLES; ++i)
+	{
+		const ftable_t& table = fileHeader->tables[i];
+		if (table.elementSize != elementSizes[i]
+			|| table.offset % CACHE_ALIGNMENT
+			|| table.offset > size
+			|| table.count > (size - table.offset) / table.elementSize)
+		{
+			mapping = nullptr;
+			return false;
+		}
+	}
+
+	header = fileHeader;
+
+	// check ranges once, so they can be used without checking them again
+	const uint64_t numPlanes = header->tables[TABLE_PATCHPLANES].count;
+	const uint64_t numFacets = header->tables[TABLE_FACETS].count;
+	const fpatch_t* patches = getTable<fpatch_t>(TABLE_PATCHES);
+	const BSPData::Facet* facets = getTable<BSPData::Facet>(TABLE_FACETS);
+	for (size_t i = 0; i < header->tables[TABLE_PATCHES].count; ++i)
+	{
+		const fpatch_t& patch = patches[i];
+		if (patch.surfaceNum >= numSurfaces
+			|| (i && patch.surfaceNum <= patches[i - 1].surfaceNum)
+			|| (uint64_t)patch.firstPlane + patch.numPlanes > numPlanes
+			|| (uint64_t)patch.firstFacet + patch.numFacets > numFacets
+			|| patch.numPlanes > INT32_MAX
+			|| patch.numFacets > INT32_MAX)
+		{
+			header = nullptr;
+			mapping = nullptr;
+			return false;
+		}
+
+		for (size_t j = 0; j < patch.numFacets; ++j)
+		{
+			if (!isValidFacet(facets[patch.firstFacet + j], patch.numPlanes))
+			{
+				header = nullptr;
+				mapping = nullptr;
+				return false;
+			}
+		}
+	}
+
+	if (header->tables[TABLE_TERRAINSURFACES].count != numTerrainPatches || header->tables[TABLE_TERRAINCOLLIDES].count != numTerrainPatches)
+	{
+		header = nullptr;
+		mapping = nullptr;
+		return false;
+	}
+
+	const uint64_t numVertices = header->tables[TABLE_VERTICES].count;
+	const uint64_t numIndexes = header->tables[TABLE_INDEXES].count;
+	const fterrainSurface_t* terrainSurfaces = getTable<fterrainSurface_t>(TABLE_TERRAINSURFACES);
+	const uint32_t* indexes = getTable<uint32_t>(TABLE_INDEXES);
+	for (size_t i = 0; i < numTerrainPatches; ++i)
+	{
+		const fterrainSurface_t& terrainSurface = terrainSurfaces[i];
+		if ((uint64_t)terrainSurface.firstVertice + terrainSurface.numVertices > numVertices
+			|| (uint64_t)terrainSurface.firstIndex + terrainSurface.numIndexes > numIndexes)
+		{
+			header = nullptr;
+			mapping = nullptr;
+			return false;
+		}
+
+		for (size_t j = 0; j < terrainSurface.numIndexes; ++j)
+		{
+			if (indexes[terrainSurface.firstIndex + j] >= terrainSurface.numVertices)
+			{
+				header = nullptr;
+				mapping = nullptr;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool BSPCacheImage::isOpen() const
+{
+	return header != nullptr;
+}
+
+void BSPCacheImage::close()
+{
+	header = nullptr;
+	mapping = nullptr;
+}
+
+bool BSPCacheImage::isOutdated() const
+{
+	return outdated.load(std::memory_order_relaxed);
+}
+
+bool BSPCacheImage::createPatchCollide(size_t surfaceNum, uint32_t subdivisions, BSPData::PatchCollide*& pc) const
+{
+	const fpatch_t* const patches = getTable<fpatch_t>(TABLE_PATCHES);
+	const fpatch_t* const patchesEnd = patches + header->tables[TABLE_PATCHES].count;
+
+	const fpatch_t* const patch = std::lower_bound(patches, patchesEnd, surfaceNum,
+		[](const fpatch_t& patchValue, size_t num)
+		{
+			return patchValue.surfaceNum < num;
+		});
+
+	if (patch == patchesEnd || patch->surfaceNum != surfaceNum)
+	{
+		pc = nullptr;
+		return true;
+	}
+
+	if (patch->subdivisions != subdivisions)
+	{
+		// the shader changed since the file was written
+		outdated.store(true, std::memory_order_relaxed);
+		return false;
+	}
+
+	pc = new BSPData::PatchCollide;
+	VectorCopy(patch->bounds[0], pc->bounds[0]);
+	VectorCopy(patch->bounds[1], pc->bounds[1]);
+
+	pc->numPlanes = patch->numPlanes;
+	pc->planes = new BSPData::PatchPlane[patch->numPlanes];
+	std::memcpy(pc->planes, getTable<BSPData::PatchPlane>(TABLE_PATCHPLANES) + patch->firstPlane, patch->numPlanes * sizeof(BSPData::PatchPlane));
+
+	pc->numFacets = patch->numFacets;
+	pc->facets = new BSPData::Facet[patch->numFacets];
+	std::memcpy(pc->facets, getTable<BSPData::Facet>(TABLE_FACETS) + patch->firstFacet, patch->numFacets * sizeof(BSPData::Facet));
+
+	return true;
+}
+
+void BSPCacheImage::loadTerrainSurfaces(const std::vector<BSPData::TerrainPatch>& terrainPatches, std::vector<BSPData::Surface>& terrainSurfaces) const
+{
+	const fterrainSurface_t* const cachedSurfaces = getTable<fterrainSurface_t>(TABLE_TERRAINSURFACES);
+	const BSPData::Vertice* const vertices = getTable<BSPData::Vertice>(TABLE_VERTICES);
+	const uint32_t* const indexes = getTable<uint32_t>(TABLE_INDEXES);
+
+	const size_t numTerrainPatches = terrainPatches.size();
+	terrainSurfaces.resize(numTerrainPatches);
+
+	for (size_t i = 0; i < numTerrainPatches; ++i)
+	{
+		const fterrainSurface_t& cachedSurface = cachedSurfaces[i];
+		BSPData::Surface& surface = terrainSurfaces[i];
+
+		surface.shader = terrainPatches[i].shader;
+		if (!cachedSurface.numVertices)
+		{
+			// like when generating it, a terrain without vertices is left empty
+			continue;
+		}
+
+		surface.vertices.assign(vertices + cachedSurface.firstVertice, vertices + cachedSurface.firstVertice + cachedSurface.numVertices);
+		surface.indexes.assign(indexes + cachedSurface.firstIndex, indexes + cachedSurface.firstIndex + cachedSurface.numIndexes);
+		surface.CalculateCentroid();
+	}
+}
+
+void BSPCacheImage::loadTerrainCollides(std::vector<BSPData::TerrainCollide>& terrainCollides) const
+{
+	const BSPData::TerrainCollide* const cachedCollides = getTable<BSPData::TerrainCollide>(TABLE_TERRAINCOLLIDES);
+	terrainCollides.assign(cachedCollides, cachedCollides + header->tables[TABLE_TERRAINCOLLIDES].count);
+}
+
+bool BSPCacheImage::save(
+	const fs::path& path,
+	uint32_t checksum,
+	uint64_t mapSize,
+	const std::vector<BSPData::Surface>& surfaces,
+	const std::vector<BSPData::Surface>& terrainSurfaces,
+	const std::vector<BSPData::TerrainCollide>& terrainCollides
+)
+{
+	std::vector<fpatch_t> patches;
+	size_t numPlanes = 0;
+	size_t numFacets = 0;
+	for (size_t i = 0; i < surfaces.size(); ++i)
+	{
+		const BSPData::PatchCollide* pc = surfaces[i].pc;
+		if (!pc) {
+			continue;
+		}
+
+		fpatch_t patch;
+		patch.surfaceNum = (uint32_t)i;
+		patch.firstPlane = (uint32_t)numPlanes;
+		patch.numPlanes = pc->numPlanes;
+		patch.firstFacet = (uint32_t)numFacets;
+		patch.numFacets = pc->numFacets;
+		patch.subdivisions = surfaces[i].shader->subdivisions;
+		VectorCopy(pc->bounds[0], patch.bounds[0]);
+		VectorCopy(pc->bounds[1], patch.bounds[1]);
+		patches.push_back(patch);
+
+		numPlanes += pc->numPlanes;
+		numFacets += pc->numFacets;
+	}
+
+	std::vector<fterrainSurface_t> cachedSurfaces(terrainSurfaces.size());
+	size_t numVertices = 0;
+	size_t numIndexes = 0;
+	for (size_t i = 0; i < terrainSurfaces.size(); ++i)
+	{
+		fterrainSurface_t& cachedSurface = cachedSurfaces[i];
+		cachedSurface.firstVertice = (uint32_t)numVertices;
+		cachedSurface.numVertices = (uint32_t)terrainSurfaces[i].vertices.size();
+		cachedSurface.firstIndex = (uint32_t)numIndexes;
+		cachedSurface.numIndexes = (uint32_t)terrainSurfaces[i].indexes.size();
+
+		numVertices += cachedSurface.numVertices;
+		numIndexes += cachedSurface.numIndexes;
+	}
+
+	fheader_t fileHeader;
+	std::memset(&fileHeader, 0, sizeof(fileHeader));
+	std::memcpy(fileHeader.ident, CACHE_IDENT, sizeof(CACHE_IDENT));
+	fileHeader.version = CACHE_VERSION;
+	fileHeader.byteOrder = CACHE_BYTEORDER;
+	fileHeader.checksum = checksum;
+	fileHeader.mapSize = mapSize;
+	fileHeader.numSurfaces = surfaces.size();
+	fileHeader.numTerrainPatches = terrainSurfaces.size();
+
+	const size_t counts[NUM_TABLES] = { patches.size(), numPlanes, numFacets, cachedSurfaces.size(), numVertices, numIndexes, terrainCollides.size() };
+
+	size_t offset = sizeof(fileHeader);
+	for (size_t i = 0; i < NUM_TABLES; ++i)
+	{
+		offset = alignOffset(offset);
+		fileHeader.tables[i].offset = offset;
+		fileHeader.tables[i].count = counts[i];
+		fileHeader.tables[i].elementSize = elementSizes[i];
+		offset += counts[i] * elementSizes[i];
+	}
+
+	std::vector<uint8_t> image(offset);
+	std::memcpy(image.data(), &fileHeader, sizeof(fileHeader));
+
+	const auto getImageTable = [&](table_e table) { return image.data() + fileHeader.tables[table].offset; };
+
+	if (!patches.empty()) {
+		std::memcpy(getImageTable(TABLE_PATCHES), patches.data(), patches.size() * sizeof(fpatch_t));
+	}
+
+	if (!cachedSurfaces.empty()) {
+		std::memcpy(getImageTable(TABLE_TERRAINSURFACES), cachedSurfaces.data(), cachedSurfaces.size() * sizeof(fterrainSurface_t));
+	}
+
+	if (!terrainCollides.empty()) {
+		std::memcpy(getImageTable(TABLE_TERRAINCOLLIDES), terrainCollides.data(), terrainCollides.size() * sizeof(BSPData::TerrainCollide));
+	}
+
+	for (const fpatch_t& patch : patches)
+	{
+		const BSPData::PatchCollide* pc = surfaces[patch.surfaceNum].pc;
+		std::memcpy(getImageTable(TABLE_PATCHPLANES) + patch.firstPlane * sizeof(BSPData::PatchPlane), pc->planes, patch.numPlanes * sizeof(BSPData::PatchPlane));
+		std::memcpy(getImageTable(TABLE_FACETS) + patch.firstFacet * sizeof(BSPData::Facet), pc->facets, patch.numFacets * sizeof(BSPData::Facet));
+	}
+
+	for (size_t i = 0; i < terrainSurfaces.size(); ++i)
+	{
+		const BSPData::Surface& surface = terrainSurfaces[i];
+		const fterrainSurface_t& cachedSurface = cachedSurfaces[i];
+		if (cachedSurface.numVertices) {
+			std::memcpy(getImageTable(TABLE_VERTICES) + cachedSurface.firstVertice * sizeof(BSPData::Vertice), surface.vertices.data(), cachedSurface.numVertices * sizeof(BSPData::Vertice));
+		}
+		if (cachedSurface.numIndexes) {
+			std::memcpy(getImageTable(TABLE_INDEXES) + cachedSurface.firstIndex * sizeof(uint32_t), surface.indexes.data(), cachedSurface.numIndexes * sizeof(uint32_t));
+		}
+	}
+
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+
+	// another process may be writing the same file, each one writes its own
+	std::random_device rd;
+	fs::path tempPath = path;
+	tempPath += "." + std::to_string(rd()) + ".tmp";
+
+	{
+		std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			return false;
+		}
+
+		stream.write((const char*)image.data(), image.size());
+		if (!stream.good())
+		{
+			stream.close();
+			fs::remove(tempPath, ec);
+			return false;
+		}
+	}
+
+	fs::rename(tempPath, path, ec);
+	if (ec)
+	{
+		fs::remove(tempPath, ec);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <MOHPC/Assets/Formats/BSP.h>
+#include <MOHPC/Assets/Formats/BSP_Collision.h>
+#include <MOHPC/Files/MappedFile.h>
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+	namespace BSPCacheFile
+	{
+		struct fheader_t;
+		struct fpatch_t;
+		struct fterrainSurface_t;
+	}
+
+	/**
+	 * File of a BSPCache, containing the data derived from a map.
+	 *
+	 * Tables are stored with their layout in memory, so they're copied as a whole when loading.
+	 */
+	class BSPCacheImage
+	{
+	public:
+		BSPCacheImage();
+		~BSPCacheImage();
+
+		/**
+		 * Map the file and check that it was written for the map.
+		 *
+		 * @return false if the file doesn't exist, is invalid, or was written for another map, architecture or version.
+		 */
+		bool open(const fs::path& path, uint32_t checksum, uint64_t mapSize, size_t numSurfaces, size_t numTerrainPatches);
+
+		/** Return true if the file was opened successfully. */
+		bool isOpen() const;
+
+		/** Unmap the file, data that was loaded from it is kept. */
+		void close();
+
+		/**
+		 * Create the patch collide of a surface from the file, set to NULL if the surface doesn't have one.
+		 * Can be called from multiple threads.
+		 *
+		 * @param subdivisions Subdivisions of the shader of the surface.
+		 * @return false if the patch collide was generated with other subdivisions, it must be generated again.
+		 */
+		bool createPatchCollide(size_t surfaceNum, uint32_t subdivisions, BSPData::PatchCollide*& pc) const;
+
+		/** Return true if some data of the file had to be generated again, so the file should be written again. */
+		bool isOutdated() const;
+
+		/** Fill terrain surfaces from the file. */
+		void loadTerrainSurfaces(const std::vector<BSPData::TerrainPatch>& terrainPatches, std::vector<BSPData::Surface>& terrainSurfaces) const;
+
+		/** Fill terrain collides from the file. */
+		void loadTerrainCollides(std::vector<BSPData::TerrainCollide>& terrainCollides) const;
+
+		/**
+		 * Write the data derived from a map.
+		 * The file is written under another name and then renamed, so processes never see a partial file.
+		 *
+		 * @return false if the file couldn't be written.
+		 */
+		static bool save(
+			const fs::path& path,
+			uint32_t checksum,
+			uint64_t mapSize,
+			const std::vector<BSPData::Surface>& surfaces,
+			const std::vector<BSPData::Surface>& terrainSurfaces,
+			const std::vector<BSPData::TerrainCollide>& terrainCollides
+		);
+
+	private:
+		template<typename T>
+		const T* getTable(size_t tableNum) const;
+
+	private:
+		MappedFilePtr mapping;
+		const BSPCacheFile::fheader_t* header;
+		mutable std::atomic<bool> outdated;
+	};
+}
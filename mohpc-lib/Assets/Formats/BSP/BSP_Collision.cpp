@@ -199,7 +199,13 @@ void BSPCollision::FillCollisionWorld(CollisionWorld& cm)
 		const BSPData::Shader* shader = terrain->shader;
 
 		BSPData::TerrainCollide collision;
-		GenerateTerrainCollide(terrain, collision);
+		const BSPData::TerrainCollide* loadedCollision = bsp->GetTerrainCollide(i);
+		if (loadedCollision) {
+			collision = *loadedCollision;
+		}
+		else {
+			GenerateTerrainCollide(terrain, collision);
+		}
 
 		collisionTerrain_t* colTerrain = cm.createTerrain();
 		VectorCopy(collision.vBounds[0], colTerrain->tc.vBounds[0]);
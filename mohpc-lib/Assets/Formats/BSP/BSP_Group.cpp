@@ -2,6 +2,11 @@
 #include <MOHPC/Assets/Formats/BSP.h>
 #include <MOHPC/Common/Math.h>
 
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <cctype>
+#include <cmath>
 #include <cassert>
 
 using namespace MOHPC;
@@ -18,6 +23,8 @@ struct BSPData::Patch
 		, surface(inSurface)
 		, groupedSurfaces(nullptr)
 	{
+		ClearBounds(bounds[0], bounds[1]);
+
 		const size_t numVerts = surface->GetNumVertices();
 		for (size_t i = 0; i < numVerts; ++i)
 		{
@@ -25,31 +32,6 @@ struct BSPData::Patch
 		}
 	}
 
-	Patch* GetRoot() const
-	{
-		Patch* p = const_cast<Patch*>(this);
-		while (p->parent)
-		{
-			p = p->parent;
-		}
-
-		return p;
-	}
-
-	bool HasParent(const Patch* other) const
-	{
-		Patch* p = parent;
-		for (Patch* p = parent; p; p = p->parent)
-		{
-			if (p == other)
-			{
-				return true;
-			}
-		}
-
-		return false;
-	}
-
 	bool IsTouching(const Patch* other) const
 	{
 		if (other->bounds[0][0] > bounds[1][0])
@@ -111,6 +93,359 @@ static bool BrushIsTouching(const BSPData::Brush* b1, const BSPData::Brush* b2)
 	return true;
 }
 
+namespace
+{
+	// size of cells, in world units
+	constexpr float GRID_CELL_SIZE = 256.f;
+	// bounds covering more cells than this are tested against everything instead
+	constexpr int64_t GRID_MAX_CELLS = 512;
+	constexpr int64_t GRID_MAX_COORD = (1 << 20) - 1;
+
+	/**
+	 * Spatial hash of bounds, to find bounds that may touch other bounds without testing every pair.
+	 * Bounds are referenced by each cell they overlap, cells are stored in a hash map.
+	 */
+	class BoundsGrid
+	{
+	public:
+		BoundsGrid(size_t numElements)
+			: visited(numElements, 0)
+			, stamp(0)
+		{}
+
+		void add(uint32_t num, const_vec3p_t mins, const_vec3p_t maxs)
+		{
+			int64_t range[2][3];
+			if (!getCellRange(mins, maxs, range))
+			{
+				largeElements.push_back(num);
+				return;
+			}
+
+			for (int64_t x = range[0][0]; x <= range[1][0]; ++x)
+			{
+				for (int64_t y = range[0][1]; y <= range[1][1]; ++y)
+				{
+					for (int64_t z = range[0][2]; z <= range[1][2]; ++z) {
+						cells[getCellKey(x, y, z)].push_back(num);
+					}
+				}
+			}
+		}
+
+		/**
+		 * Call the function once with each element which cells overlap the bounds.
+		 * Elements are returned in no particular order, the caller tests bounds exactly.
+		 */
+		template<typename Func>
+		void query(const_vec3p_t mins, const_vec3p_t maxs, Func&& func)
+		{
+			int64_t range[2][3];
+			if (!getCellRange(mins, maxs, range))
+			{
+				// it would be longer to go through cells
+				for (uint32_t num = 0; num < (uint32_t)visited.size(); ++num) {
+					func(num);
+				}
+				return;
+			}
+
+			if (!++stamp)
+			{
+				std::fill(visited.begin(), visited.end(), 0);
+				stamp = 1;
+			}
+
+			for (uint32_t num : largeElements) {
+				visit(num, func);
+			}
+
+			for (int64_t x = range[0][0]; x <= range[1][0]; ++x)
+			{
+				for (int64_t y = range[0][1]; y <= range[1][1]; ++y)
+				{
+					for (int64_t z = range[0][2]; z <= range[1][2]; ++z)
+					{
+						const auto it = cells.find(getCellKey(x, y, z));
+						if (it == cells.end()) {
+							continue;
+						}
+
+						for (uint32_t num : it->second) {
+							visit(num, func);
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		template<typename Func>
+		void visit(uint32_t num, Func& func)
+		{
+			if (visited[num] != stamp)
+			{
+				visited[num] = stamp;
+				func(num);
+			}
+		}
+
+		static int64_t getCellCoord(float value)
+		{
+			const float cell = std::floor(value / GRID_CELL_SIZE);
+			// also catches NaN
+			if (!(cell >= -GRID_MAX_COORD)) return -GRID_MAX_COORD;
+			if (cell > GRID_MAX_COORD) return GRID_MAX_COORD;
+			return (int64_t)cell;
+		}
+
+		static uint64_t getCellKey(int64_t x, int64_t y, int64_t z)
+		{
+			const uint64_t mask = (1 << 21) - 1;
+			return ((uint64_t)x & mask) | (((uint64_t)y & mask) << 21) | (((uint64_t)z & mask) << 42);
+		}
+
+		static bool getCellRange(const_vec3p_t mins, const_vec3p_t maxs, int64_t range[2][3])
+		{
+			int64_t numCells = 1;
+			for (size_t i = 0; i < 3; ++i)
+			{
+				range[0][i] = getCellCoord(mins[i]);
+				range[1][i] = getCellCoord(maxs[i]);
+				if (range[1][i] < range[0][i])
+				{
+					// empty bounds, they can only touch the same cell
+					range[1][i] = range[0][i];
+				}
+
+				numCells *= range[1][i] - range[0][i] + 1;
+				if (numCells > GRID_MAX_CELLS) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+		std::vector<uint32_t> largeElements;
+		std::vector<uint32_t> visited;
+		uint32_t stamp;
+	};
+
+	/**
+	 * Number shaders by name ignoring the case, so comparing names is comparing numbers.
+	 */
+	class ShaderNames
+	{
+	public:
+		ShaderNames(const BSP& bsp)
+			: firstShader(bsp.GetNumShaders() ? bsp.GetShader(0) : nullptr)
+		{
+			const size_t numShaders = bsp.GetNumShaders();
+			shaderIds.resize(numShaders);
+
+			std::unordered_map<std::string, uint32_t> names;
+			for (size_t i = 0; i < numShaders; ++i)
+			{
+				// same as the comparison of strHelpers::icmp
+				std::string name = bsp.GetShader(i)->shaderName.c_str();
+				for (char& c : name) c = std::tolower(c);
+
+				shaderIds[i] = names.emplace(std::move(name), (uint32_t)names.size()).first->second;
+			}
+		}
+
+		uint32_t getId(const BSPData::Shader* shader) const
+		{
+			assert(shader >= firstShader && shader < firstShader + shaderIds.size());
+			return shaderIds[shader - firstShader];
+		}
+
+	private:
+		const BSPData::Shader* firstShader;
+		std::vector<uint32_t> shaderIds;
+	};
+
+	/**
+	 * Sets of brushes connected together, to find the root of a brush without going through all of its parents.
+	 */
+	class BrushTrees
+	{
+	public:
+		BrushTrees(size_t numBrushes)
+			: sets(numBrushes)
+			, roots(numBrushes)
+		{
+			for (size_t i = 0; i < numBrushes; ++i)
+			{
+				sets[i] = i;
+				roots[i] = i;
+			}
+		}
+
+		size_t getRoot(size_t brushNum)
+		{
+			return roots[find(brushNum)];
+		}
+
+		/** Attach a root brush to the tree of the parent brush. */
+		void attach(size_t rootNum, size_t parentNum)
+		{
+			const size_t parentSet = find(parentNum);
+			sets[find(rootNum)] = parentSet;
+		}
+
+	private:
+		size_t find(size_t num)
+		{
+			while (sets[num] != num)
+			{
+				sets[num] = sets[sets[num]];
+				num = sets[num];
+			}
+
+			return num;
+		}
+
+	private:
+		std::vector<size_t> sets;
+		// root brush of each set
+		std::vector<size_t> roots;
+	};
+
+	/**
+	 * Trees of patches where patches can be moved under another parent with their children,
+	 * to find if a patch is a parent of another without walking its parents.
+	 * This is a link-cut tree: paths from the root are kept in splay trees linked together.
+	 */
+	class PatchForest
+	{
+	public:
+		PatchForest(size_t numPatches)
+			: nodes(numPatches)
+		{}
+
+		/** Return true if parentNum is one of the parents of the patch. */
+		bool hasParent(uint32_t num, uint32_t parentNum)
+		{
+			// the splay tree of the patch now has all of its parents
+			access(num);
+			splay(parentNum);
+
+			// the patch was the root of the splay tree, it stays close to the new root
+			uint32_t n = num;
+			while (!isSplayRoot(n)) {
+				n = nodes[n].parent;
+			}
+
+			return n == parentNum && n != num;
+		}
+
+		/** Move a patch and its children under another patch, which must not be one of its children. */
+		void setParent(uint32_t num, uint32_t parentNum)
+		{
+			access(num);
+
+			// detach the parents
+			const uint32_t parents = nodes[num].children[0];
+			if (parents != NONE)
+			{
+				nodes[parents].parent = NONE;
+				nodes[num].children[0] = NONE;
+			}
+
+			nodes[num].parent = parentNum;
+		}
+
+	private:
+		static constexpr uint32_t NONE = UINT32_MAX;
+
+		struct node_t
+		{
+			// parent in the splay tree, or the parent of the top of the path for the root of a splay tree
+			uint32_t parent = NONE;
+			// parents on the left, children on the right
+			uint32_t children[2] = { NONE, NONE };
+		};
+
+		bool isSplayRoot(uint32_t num) const
+		{
+			const uint32_t parent = nodes[num].parent;
+			return parent == NONE || (nodes[parent].children[0] != num && nodes[parent].children[1] != num);
+		}
+
+		void rotate(uint32_t num)
+		{
+			const uint32_t parent = nodes[num].parent;
+			const uint32_t grandParent = nodes[parent].parent;
+			const size_t side = nodes[parent].children[1] == num;
+			const uint32_t child = nodes[num].children[side ^ 1];
+
+			if (!isSplayRoot(parent)) {
+				nodes[grandParent].children[nodes[grandParent].children[1] == parent] = num;
+			}
+			nodes[num].parent = grandParent;
+
+			nodes[num].children[side ^ 1] = parent;
+			nodes[parent].parent = num;
+
+			nodes[parent].children[side] = child;
+			if (child != NONE) {
+				nodes[child].parent = parent;
+			}
+		}
+
+		void splay(uint32_t num)
+		{
+			while (!isSplayRoot(num))
+			{
+				const uint32_t parent = nodes[num].parent;
+				if (!isSplayRoot(parent))
+				{
+					const uint32_t grandParent = nodes[parent].parent;
+					const bool sameSide = (nodes[grandParent].children[1] == parent) == (nodes[parent].children[1] == num);
+					rotate(sameSide ? parent : num);
+				}
+
+				rotate(num);
+			}
+		}
+
+		/** Put the path from the root to the patch in a single splay tree, with the patch at its root. */
+		void access(uint32_t num)
+		{
+			uint32_t last = NONE;
+			for (uint32_t n = num; n != NONE; n = nodes[n].parent)
+			{
+				splay(n);
+				nodes[n].children[1] = last;
+				last = n;
+			}
+
+			splay(num);
+		}
+
+	private:
+		std::vector<node_t> nodes;
+	};
+
+	bool shareShader(const std::vector<uint32_t>& shaders1, const std::vector<uint32_t>& shaders2)
+	{
+		// both are sorted
+		auto it1 = shaders1.begin();
+		auto it2 = shaders2.begin();
+		while (it1 != shaders1.end() && it2 != shaders2.end())
+		{
+			if (*it1 < *it2) ++it1;
+			else if (*it2 < *it1) ++it2;
+			else return true;
+		}
+
+		return false;
+	}
+}
 MOHPC_OBJECT_DEFINITION(BSPGroup);
 
 BSPGroup::BSPGroup()
@@ -150,95 +485,69 @@ void BSPGroup::groupSurfaces(const BSP& bsp)
 	mapBrushes(bsp, groupedSurfaces);
 }
 
-bool BSPGroup::isParented(const BSPData::BrushGroupData& b1, const BSPData::BrushGroupData& b2) const
+void BSPGroup::connectBrushes(const BSP& bsp, std::vector<BSPData::BrushGroupData>& list, std::vector<size_t>& rootBrushes)
 {
-	const BSPData::BrushGroupData* parentData = &b1;
+	const size_t numBrushes = bsp.GetNumBrushes();
+	const size_t startList = brushDataList.size();
+	brushDataList.resize(startList + numBrushes);
+
+	const ShaderNames shaderNames(bsp);
 
-	// Checks for infinite parenting
-	bool bInfiniteParent = false;
-	do
+	// shaders of the sides of each brush that are drawn, and brushes by location
+	std::vector<std::vector<uint32_t>> drawnShaders(numBrushes);
+	BoundsGrid grid(numBrushes);
+	for (size_t b = 0; b < numBrushes; b++)
 	{
-		const BSPData::Brush* const parent = parentData->brush;
-		if (parentData == &b2) {
-			return true;
+		const BSPData::Brush* brush = bsp.GetBrush(b);
+		list[startList + b].brush = brush;
+
+		std::vector<uint32_t>& shaders = drawnShaders[b];
+		for (size_t bs = 0; bs < brush->GetNumSides(); bs++)
+		{
+			const BSPData::BrushSide* brushside = brush->GetSide(bs);
+			if (!(brushside->surfaceFlags & SURF_NODRAW)) {
+				shaders.push_back(shaderNames.getId(brushside->shader));
+			}
 		}
-		parentData = parentData->parentData;
-	} while (parentData);
 
-	return false;
-}
+		std::sort(shaders.begin(), shaders.end());
+		shaders.erase(std::unique(shaders.begin(), shaders.end()), shaders.end());
 
-void BSPGroup::connectBrushes(const BSP& bsp, std::vector<BSPData::BrushGroupData>& list)
-{
-	const size_t numBrushes = bsp.GetNumBrushes();
-	const size_t startList = brushDataList.size();
-	brushDataList.resize(startList + numBrushes);
+		grid.add((uint32_t)b, brush->bounds[0], brush->bounds[1]);
+	}
+
+	BrushTrees trees(numBrushes);
 
-	size_t numParentedBrushes = 0;
-	// Connects brushes by finding touching brushes that share at least one same shader
+	// Connects brushes by finding touching brushes that share at least one same shader.
+	// Each brush becomes the parent of touching brushes that don't have a parent yet,
+	// unless it would cause an infinite loop (the brush is the root of its own tree)
 	for (size_t b = 0; b < numBrushes; b++)
 	{
 		const BSPData::Brush* brush = bsp.GetBrush(b);
 		BSPData::BrushGroupData& brushData = list[startList + b];
-		for (size_t i = 0; i < numBrushes; i++)
+		const size_t rootNum = trees.getRoot(b);
+
+		grid.query(brush->bounds[0], brush->bounds[1], [&](uint32_t i)
 		{
 			const BSPData::Brush* brush2 = bsp.GetBrush(i);
 			BSPData::BrushGroupData& brushData2 = list[startList + i];
-			if (brush2 == brush || brushData2.parentData)
+			if (i == b || brushData2.parentData || i == rootNum)
 			{
 				// ignore parented brushes
-				continue;
+				return;
 			}
 
-			if (isParented(brushData, brushData2))
+			if (BrushIsTouching(brush, brush2) && shareShader(drawnShaders[b], drawnShaders[i]))
 			{
-				// would cause an infinite loop
-				continue;
+				brushData2.parentData = &brushData;
+				trees.attach(i, b);
 			}
+		});
+	}
 
-			// Checks if the two brushes are touching
-			if (BrushIsTouching(brush, brush2))
-			{
-				bool bFound = false;
-
-				// Finds at least one valid brush side that matches the parent's brush sides
-				for (size_t bs = 0; bs < brush->GetNumSides(); bs++)
-				{
-					const BSPData::BrushSide* brushside = brush->GetSide(bs);
-					if (brushside->surfaceFlags & SURF_NODRAW)
-					{
-						// ignore brush that don't draw
-						continue;
-					}
-
-					for (size_t bs2 = 0; bs2 < brush2->GetNumSides(); bs2++)
-					{
-						const BSPData::BrushSide* brushside2 = brush2->GetSide(bs2);
-						if (brushside2->surfaceFlags & SURF_NODRAW) {
-							continue;
-						}
-
-						if (!strHelpers::icmp(brushside2->shader->shaderName.c_str(), brushside->shader->shaderName.c_str()))
-						{
-							// found sides with the same shader
-							bFound = true;
-							break;
-						}
-					}
-
-					if (bFound)
-					{
-						break;
-					}
-				}
-
-				if (bFound)
-				{
-					numParentedBrushes++;
-					brushData2.parentData = &brushData;
-				}
-			}
-		}
+	rootBrushes.resize(numBrushes);
+	for (size_t b = 0; b < numBrushes; b++) {
+		rootBrushes[b] = trees.getRoot(b);
 	}
 }
 
@@ -249,7 +558,8 @@ void BSPGroup::mapBrushes(
 {
 	const size_t startList = brushDataList.size();
 
-	connectBrushes(bsp, brushDataList);
+	std::vector<size_t> rootBrushes;
+	connectBrushes(bsp, brushDataList, rootBrushes);
 
 	assert(bsp.GetNumSubmodels());
 	const BSPData::Model* worldModel = bsp.GetSubmodel(0);
@@ -259,7 +569,6 @@ void BSPGroup::mapBrushes(
 	size_t numUnmappedSurfaces = 0;
 	size_t numValidBrushes = 0;
 	size_t numGroupedSurfaces = 0;
-	bool bBrushHasMappedSurface = false;
 
 	const size_t numSurfaces = worldModel->numSurfaces;
 	const size_t numTerrainSurfaces = bsp.GetNumTerrainSurfaces();
@@ -267,30 +576,42 @@ void BSPGroup::mapBrushes(
 	bool* mappedSurfaces = new bool[numSurfaces]();
 
 	const size_t numBrushes = bsp.GetNumBrushes();
-	std::unordered_map<const BSPData::Brush*, BSPData::GroupedSurfaces*> brushToSurfaces(numBrushes);
+	// group of each root brush
+	std::vector<BSPData::GroupedSurfaces*> rootGroups(numBrushes, nullptr);
 	outGroups.reserve(numTotalSurfaces);
 
+	const ShaderNames shaderNames(bsp);
+
+	// surfaces that can be mapped to brushes, by location of their centroid
+	BoundsGrid surfacesGrid(numSurfaces);
+	for (size_t k = 0; k < numSurfaces; k++)
+	{
+		const BSPData::Surface* surf = &worldModel->surface[k];
+		if (!surf->IsPatch()) {
+			surfacesGrid.add((uint32_t)k, surf->centroid, surf->centroid);
+		}
+	}
+
+	std::vector<uint32_t> brushSurfaces;
+
 	// Group surfaces with brushes
 	for (size_t b = 0; b < numBrushes; b++)
 	{
 		const BSPData::Brush* brush = bsp.GetBrush(b);
 		BSPData::BrushGroupData& brushData = brushDataList[startList + b];
 
-		const BSPData::Brush* rootbrush = brush;
-		const BSPData::BrushGroupData* rootBrushData = &brushData;
-		while (rootBrushData->parentData != nullptr)
-		{
-			rootBrushData = rootBrushData->parentData;
-			rootbrush = rootBrushData->brush;
-		}
-
-		//const str& brushname = rootbrush->name;
 		const_vec3p_t mins = brush->bounds[0];
 		const_vec3p_t maxs = brush->bounds[1];
 
-		auto it = brushToSurfaces.find(rootbrush);
+		// surfaces are mapped in order
+		brushSurfaces.clear();
+		surfacesGrid.query(mins, maxs, [&](uint32_t k) { brushSurfaces.push_back(k); });
+		std::sort(brushSurfaces.begin(), brushSurfaces.end());
 
-		for (size_t k = 0; k < numSurfaces; k++)
+		BSPData::GroupedSurfaces*& rootGroup = rootGroups[rootBrushes[b]];
+		bool bBrushHasMappedSurface = false;
+
+		for (uint32_t k : brushSurfaces)
 		{
 			if (!mappedSurfaces[k])
 			{
@@ -301,36 +622,29 @@ void BSPGroup::mapBrushes(
 					&& surf->centroid[1] >= mins[1] && surf->centroid[1] <= maxs[1]
 					&& surf->centroid[2] >= mins[2] && surf->centroid[2] <= maxs[2])
 				{
+					const uint32_t shaderId = shaderNames.getId(surf->shader);
 					for (size_t s = 0; s < brush->numsides; s++)
 					{
 						const BSPData::BrushSide* side = &brush->sides[s];
-						if (!strHelpers::icmp(side->shader->shaderName.c_str(), surf->shader->shaderName.c_str()))
+						if (shaderNames.getId(side->shader) == shaderId)
 						{
 							brushData.surfaces.push_back(surf);
 
-							BSPData::GroupedSurfaces* sg = nullptr;
-							if (it == brushToSurfaces.end())
+							if (!rootGroup)
 							{
-								sg = new BSPData::GroupedSurfaces;
-								sg->name = "groupedsurf" + std::to_string(numGroupedSurfaces); // std::to_string(numGroupedSurfaces);
-								outGroups.push_back(sg);
-								auto res = brushToSurfaces.emplace(rootbrush, sg);
-								assert(res.second);
-								if (res.second)
-								{
-									it = res.first;
-								}
+								rootGroup = new BSPData::GroupedSurfaces;
+								rootGroup->name = "groupedsurf" + std::to_string(numGroupedSurfaces); // std::to_string(numGroupedSurfaces);
+								outGroups.push_back(rootGroup);
 								numGroupedSurfaces++;
 							}
-							else
-							{
-								sg = it->second;
-							}
+
+							BSPData::GroupedSurfaces* sg = rootGroup;
 
 							sg->surfaces.push_back(surf);
 
-							if (std::find(sg->brushes.begin(), sg->brushes.end(), startList + b) == sg->brushes.end())
+							if (!bBrushHasMappedSurface)
 							{
+								// the brush is only added by the first surface mapped to it
 								sg->brushes.push_back(startList + b);
 							}
 
@@ -346,7 +660,6 @@ void BSPGroup::mapBrushes(
 
 		if (bBrushHasMappedSurface)
 		{
-			bBrushHasMappedSurface = false;
 			numValidBrushes++;
 		}
 	}
@@ -380,37 +693,63 @@ void BSPGroup::mapBrushes(
 		}
 
 		const size_t numPatches = patchList.size();
+
+		BoundsGrid patchesGrid(numPatches);
+		for (size_t k = 0; k < numPatches; k++) {
+			patchesGrid.add((uint32_t)k, patchList[k].bounds[0], patchList[k].bounds[1]);
+		}
+
+		PatchForest forest(numPatches);
+
+		// Each patch becomes the parent of touching patches, unless they're already one of its parents.
+		// Patches that are not touching are never connected so only touching patches are visited
 		for (size_t k = 0; k < numPatches; k++)
 		{
 			BSPData::Patch* patch1 = &patchList[k];
-			for (size_t l = 0; l < numPatches; l++)
+			patchesGrid.query(patch1->bounds[0], patch1->bounds[1], [&](uint32_t l)
 			{
 				if (l != k)
 				{
 					BSPData::Patch* patch2 = &patchList[l];
-					if (!patch1->HasParent(patch2) && patch2->IsTouching(patch1))
+					if (patch2->IsTouching(patch1) && !forest.hasParent((uint32_t)k, l))
 					{
 						patch2->parent = patch1;
+						forest.setParent(l, (uint32_t)k);
 					}
 				}
-			}
+			});
 		}
 
+		// root of each patch, filled as they're found
+		std::vector<BSPData::Patch*> rootPatches(numPatches, nullptr);
+		std::vector<BSPData::Patch*> chain;
+
 		size_t numGroupedPatches = 0;
 		for (size_t k = 0; k < numPatches; k++)
 		{
 			BSPData::Patch* patch = &patchList[k];
-			BSPData::Patch* rootPatch = patch->GetRoot();
+
+			chain.clear();
+			BSPData::Patch* p = patch;
+			for (; !rootPatches[p - patchList.data()]; p = p->parent)
+			{
+				chain.push_back(p);
+				if (!p->parent) {
+					break;
+				}
+			}
+
+			BSPData::Patch* const rootPatch = rootPatches[p - patchList.data()] ? rootPatches[p - patchList.data()] : p;
+			for (BSPData::Patch* chainPatch : chain) {
+				rootPatches[chainPatch - patchList.data()] = rootPatch;
+			}
 
 			// Get the number of surfaces
+			// when a patch is mapped, all of its parents are also mapped, so stop at the first mapped patch
 			size_t numSurfaces = 0;
-			for (BSPData::Patch* p = patch; p; p = p->parent)
+			for (p = patch; p && !mappedSurfaces[p->surface - worldModel->surface]; p = p->parent)
 			{
-				bool& isMappedSurface = mappedSurfaces[p->surface - worldModel->surface];
-				if (!isMappedSurface)
-				{
-					numSurfaces++;
-				}
+				numSurfaces++;
 			}
 
 			if (numSurfaces > 0)
@@ -422,22 +761,16 @@ void BSPGroup::mapBrushes(
 					outGroups.push_back(rootPatch->groupedSurfaces);
 				}
 
+				// no exact reserve here, groups grow one patch at a time along chains
 				BSPData::GroupedSurfaces* sg = rootPatch->groupedSurfaces;
-
-				sg->surfaces.reserve(sg->surfaces.size() + numSurfaces);
-				for (BSPData::Patch* p = patch; p; p = p->parent)
+				for (p = patch; p && !mappedSurfaces[p->surface - worldModel->surface]; p = p->parent)
 				{
-					bool& isMappedSurface = mappedSurfaces[p->surface - worldModel->surface];
-					if (!isMappedSurface)
-					{
-						sg->surfaces.push_back(p->surface);
-						isMappedSurface = true;
-					}
+					sg->surfaces.push_back(p->surface);
+					mappedSurfaces[p->surface - worldModel->surface] = true;
 				}
 			}
 		}
 	}
-
 	// Group unused surfaces
 	for (size_t k = 0; k < numSurfaces; k++)
 	{
@@ -460,6 +793,7 @@ void BSPGroup::mapBrushes(
 		BSPData::GroupedSurfaces* sg = outGroups[i];
 
 		vec3_t avg{ 0 };
+		ClearBounds(sg->bounds[0], sg->bounds[1]);
 
 		size_t numVertices = 0;
 
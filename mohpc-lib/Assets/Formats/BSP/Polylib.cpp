@@ -7,15 +7,16 @@
 #include <string.h>
 #include <assert.h>
 #include <cmath>
+#include <atomic>
 
 namespace MOHPC
 {
-// counters are only bumped when running single threaded,
-// because they are an awful coherence problem
-int	c_active_windings;
-int	c_peak_windings;
-int	c_winding_allocs;
-int	c_winding_points;
+// counters are atomic as windings are allocated
+// while generating patch collides from multiple threads
+std::atomic<int>	c_active_windings;
+std::atomic<int>	c_peak_windings;
+std::atomic<int>	c_winding_allocs;
+std::atomic<int>	c_winding_points;
 
 void pw(winding_t *w)
 {
@@ -35,11 +36,11 @@ winding_t	*AllocWinding (int points)
 	winding_t	*w;
 	int			s;
 
-	c_winding_allocs++;
-	c_winding_points += points;
-	c_active_windings++;
-	if (c_active_windings > c_peak_windings)
-		c_peak_windings = c_active_windings;
+	c_winding_allocs.fetch_add(1, std::memory_order_relaxed);
+	c_winding_points.fetch_add(points, std::memory_order_relaxed);
+	const int active = c_active_windings.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (active > c_peak_windings.load(std::memory_order_relaxed))
+		c_peak_windings.store(active, std::memory_order_relaxed);
 
 	s = sizeof(vec_t)*3*points + sizeof(int);
 	w = (winding_t*)malloc (s);
@@ -57,7 +58,7 @@ void FreeWinding (winding_t *w)
 
 	*(unsigned *)w = 0xdeaddead;
 
-	c_active_windings--;
+	c_active_windings.fetch_sub(1, std::memory_order_relaxed);
 	free (w);
 }
 
@@ -66,7 +67,7 @@ void FreeWinding (winding_t *w)
 RemoveColinearPoints
 ============
 */
-int	c_removed;
+std::atomic<int>	c_removed;
 
 void	RemoveColinearPoints (winding_t *w)
 {
@@ -94,7 +95,7 @@ void	RemoveColinearPoints (winding_t *w)
 	if (nump == w->numpoints)
 		return;
 
-	c_removed += w->numpoints - nump;
+	c_removed.fetch_add(w->numpoints - nump, std::memory_order_relaxed);
 	w->numpoints = nump;
 	memcpy (w->p, p, nump*sizeof(p[0]));
 }
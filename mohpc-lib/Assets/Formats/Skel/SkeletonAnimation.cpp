@@ -8,6 +8,8 @@
 #include "SkelPrivate.h"
 #include "../TIKI/TIKI_Private.h"
 
+#include <algorithm>
+
 using namespace MOHPC;
 
 const tikiFlag_t SKF::LOOP = (1 << 5);
@@ -223,6 +225,7 @@ void SkeletonAnimationReader::ConvertSkelFileToGame(const File_AnimDataHeader *p
 
 	channelList.PackChannels();
 	EncodeFrames(&channelList, channelNameTable, m_frame, ary_channels);
+	skelAnim.buildFrameKeys();
 
 	if (channelList.HasChannel(channelNameTable, "Bip01 pos") &&
 		channelList.HasChannel(channelNameTable, "Bip01 R Foot pos") &&
@@ -451,6 +454,7 @@ SkeletonAnimationPtr SkeletonAnimationReader::LoadProcessedAnim(const fs::path&
 	bounds[1][2] = msg.ReadFloat();
 	skelAnim->setBounds(bounds[0], bounds[1]);
 	ReadEncodedFrames(msg, m_frame, ary_channels);
+	skelAnim->buildFrameKeys();
 
 	const uint32_t numChannels = msg.ReadUInteger();
 
@@ -540,6 +544,7 @@ SkeletonAnimationPtr SkeletonAnimationReader::LoadProcessedAnimEx(const fs::path
 	bounds[1][2] = msg.ReadFloat();
 	skelAnim->setBounds(bounds[0], bounds[1]);
 	ReadEncodedFramesEx(msg, channelList, m_frame, ary_channels);
+	skelAnim->buildFrameKeys();
 
 	return skelAnim;
 }
@@ -622,6 +627,40 @@ void SkeletonAnimation::setBounds(const_vec3r_t mins, const_vec3r_t maxs)
 	bounds[1] = maxs;
 }
 
+void SkeletonAnimation::buildFrameKeys()
+{
+	for (SkanChannelHdr& channel : ary_channels)
+	{
+		const std::vector<SkanGameFrame>& frames = channel.ary_frames;
+		channel.frameKeys.clear();
+		if (frames.empty()) {
+			continue;
+		}
+
+		// keyframes may be past the number of frames
+		const size_t numFrames = std::max(m_frame.size(), frames.back().nFrameNum + 1);
+		channel.frameKeys.resize(numFrames);
+
+		size_t key = 0;
+		for (size_t frameNum = 0; frameNum < numFrames; frameNum++)
+		{
+			// find the first keyframe at or after the frame, keyframes are sorted
+			while (key < frames.size() - 1 && frames[key].nFrameNum < frameNum) {
+				key++;
+			}
+
+			size_t frameKey = key;
+			if (frames[key].nFrameNum > frameNum && frames[key].nPrevFrameIndex < frames.size())
+			{
+				// the frame was compressed, so it uses the value of the previous keyframe
+				frameKey = frames[key].nPrevFrameIndex;
+			}
+
+			channel.frameKeys[frameNum] = (uint32_t)frameKey;
+		}
+	}
+}
+
 float SkeletonAnimation::GetTime() const
 {
 	return flags & TAF::DELTADRIVEN
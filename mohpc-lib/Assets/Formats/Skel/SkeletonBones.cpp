@@ -1,6 +1,8 @@
 #include <Shared.h>
 #include "SkelPrivate.h"
 
+#include <cassert>
+
 using namespace MOHPC;
 
 skelBone_World::skelBone_World()
@@ -148,25 +150,12 @@ void MOHPC::LoadBonesFromBuffer(const SkeletorManagerPtr& skeletorManager, const
 
 const float *DecodeRLEValue( const SkanChannelHdr *channelFrames, size_t desiredFrameNum )
 {
-	const SkanGameFrame *foundFrame = &channelFrames->ary_frames[0];
-
-	size_t nFramesInChannel = channelFrames->ary_frames.size();
-	for(size_t i = 0; i < nFramesInChannel; i++)
-	{
-		if( foundFrame->nFrameNum >= desiredFrameNum )
-		{
-			break;
-		}
-
-		foundFrame++;
-	}
-
-	if (foundFrame->nFrameNum > desiredFrameNum)
-	{
-		foundFrame = &channelFrames->ary_frames[foundFrame->nPrevFrameIndex];
-	}
+	const std::vector<uint32_t>& frameKeys = channelFrames->frameKeys;
+	assert(!frameKeys.empty());
 
-	return foundFrame->pChannelData;
+	// frames past the end use the last value
+	const size_t frameNum = desiredFrameNum < frameKeys.size() ? desiredFrameNum : frameKeys.size() - 1;
+	return channelFrames->ary_frames[frameKeys[frameNum]].pChannelData;
 }
 
 SkelQuat skelAnimStoreFrameList_c::GetSlerpValue(size_t globalChannelNum) const
@@ -3,9 +3,9 @@
 
 using namespace MOHPC;
 
-ArchiveFile::ArchiveFile(const fs::path& nameRef, void* file, const void* pos, uint64_t uncompressedSize)
+ArchiveFile::ArchiveFile(const fs::path& nameRef, const fs::path& zipFileName, uint64_t dataOffset, uint64_t compressedSize, uint64_t uncompressedSize, int method)
 	: IFile(nameRef)
-	, streamBuf(new basic_decompression_buf<char>(file, *(unz_file_pos*)pos, uncompressedSize))
+	, streamBuf(new basic_decompression_buf<char>(zipFileName, dataOffset, compressedSize, uncompressedSize, method))
 	, archiveStream(streamBuf)
 	, buffer(nullptr)
 	, archiveSize(uncompressedSize)
@@ -31,7 +31,7 @@ std::istream* ArchiveFile::GetStream()
 
 uint64_t ArchiveFile::ReadBuffer(void** Out)
 {
-	uint64_t length = 0;
+	uint64_t length = archiveSize;
 
 	if (!buffer)
 	{
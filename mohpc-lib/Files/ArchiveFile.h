@@ -9,7 +9,17 @@ namespace MOHPC
 	class ArchiveFile : public IFile
 	{
 	public:
-		ArchiveFile(const fs::path& nameRef, void* file, const void* pos, uint64_t uncompressedSize);
+		/**
+		 * Open an entry of a zip file, with its own file handle and decompression state.
+		 *
+		 * @param nameRef			Name of the entry.
+		 * @param zipFileName		Path to the zip file containing the entry.
+		 * @param dataOffset		Offset of the entry data in the zip file.
+		 * @param compressedSize	Size of the data in the zip file.
+		 * @param uncompressedSize	Size of the entry once decompressed.
+		 * @param method			Compression method of the entry.
+		 */
+		ArchiveFile(const fs::path& nameRef, const fs::path& zipFileName, uint64_t dataOffset, uint64_t compressedSize, uint64_t uncompressedSize, int method);
 		~ArchiveFile();
 
 		std::istream* GetStream() override;
@@ -92,3 +92,9 @@ const fs::path& IFile::getName() const
 {
 	return name;
 }
+
+const uint8_t* IFile::getMappedData(uint64_t& size)
+{
+	size = 0;
+	return nullptr;
+}
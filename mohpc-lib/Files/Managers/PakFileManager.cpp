@@ -1,19 +1,43 @@
 #include <MOHPC/Files/Managers/PakFileManager.h>
 #include <MOHPC/Files/FileMap.h>
 #include <MOHPC/Files/Category.h>
+#include <MOHPC/Files/MappedFile.h>
 #include <MOHPC/Common/Log.h>
 
 #include "../ArchiveFile.h"
+#include "../MappedArchiveFile.h"
 #include <zlib/contrib/minizip/unzip.h>
 
 #include <fstream>
 #include <cassert>
+#include <mutex>
 #include <unordered_map>
 
 using namespace MOHPC;
 
 static constexpr char MOHPC_LOG_NAMESPACE[] = "pakfileman";
 
+namespace ZipFormat
+{
+	static constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+	static constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+	static constexpr uint32_t END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+	static constexpr size_t LOCAL_HEADER_SIZE = 30;
+	static constexpr size_t CENTRAL_HEADER_SIZE = 46;
+	static constexpr size_t END_OF_CENTRAL_DIR_SIZE = 22;
+	static constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+	static uint16_t readShort(const uint8_t* p)
+	{
+		return (uint16_t)(p[0] | (p[1] << 8));
+	}
+
+	static uint32_t readLong(const uint8_t* p)
+	{
+		return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	}
+}
+
 namespace MOHPC
 {
 	struct FileManagerCategory;
@@ -142,6 +166,8 @@ namespace MOHPC
 		PakFileEntry(PakFile& pakRef, T first, T last)
 			: pak(pakRef)
 			, Name(first, last)
+			, localHeaderOffset(0)
+			, dataOffset(0)
 		{}
 
 	public:
@@ -149,6 +175,12 @@ namespace MOHPC
 		PakFile& pak;
 		unz_file_pos Pos;
 		size_t uncompressedSize;
+		size_t compressedSize;
+		int compressionMethod;
+		/** Offset of the local header, for mapped paks. */
+		uint64_t localHeaderOffset;
+		/** Offset of the data in the pak, resolved when the entry is first opened (0 if not resolved yet). */
+		mutable uint64_t dataOffset;
 	};
 
 	struct PakFile
@@ -168,10 +200,245 @@ namespace MOHPC
 			}
 		}
 
+		/**
+		 * Map the pak and read the entries from its central directory.
+		 *
+		 * @return false if the pak can't be mapped or uses unsupported zip features (like zip64),
+		 * in which case it must be read with minizip.
+		 */
+		bool loadMappedDirectory()
+		{
+			using namespace ZipFormat;
+
+			MappedFilePtr newMapping = MappedFile::create();
+			if (!newMapping->open(fileName)) {
+				return false;
+			}
+
+			const uint8_t* const data = newMapping->getData();
+			const size_t size = newMapping->getSize();
+			if (size < END_OF_CENTRAL_DIR_SIZE) {
+				return false;
+			}
+
+			// the end of central directory record is followed by a variable-length comment
+			const uint8_t* eocd = nullptr;
+			const size_t minPos = size > END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE ? size - END_OF_CENTRAL_DIR_SIZE - MAX_COMMENT_SIZE : 0;
+			for (size_t pos = size - END_OF_CENTRAL_DIR_SIZE + 1; pos-- > minPos;)
+			{
+				if (readLong(data + pos) == END_OF_CENTRAL_DIR_SIGNATURE)
+				{
+					eocd = data + pos;
+					break;
+				}
+			}
+
+			if (!eocd) {
+				return false;
+			}
+
+			const uint16_t numEntries = readShort(eocd + 10);
+			const uint32_t directorySize = readLong(eocd + 12);
+			const uint32_t directoryOffset = readLong(eocd + 16);
+			if (numEntries == 0xFFFF || directoryOffset == 0xFFFFFFFF || (uint64_t)directoryOffset + directorySize > size) {
+				// zip64 or invalid
+				return false;
+			}
+
+			entries.reserve(numEntries);
+
+			const uint8_t* p = data + directoryOffset;
+			const uint8_t* const end = p + directorySize;
+			for (size_t i = 0; i < numEntries; ++i)
+			{
+				if (end - p < (ptrdiff_t)CENTRAL_HEADER_SIZE || readLong(p) != CENTRAL_HEADER_SIGNATURE)
+				{
+					entries.clear();
+					return false;
+				}
+
+				const uint16_t method = readShort(p + 10);
+				const uint32_t compressedSize = readLong(p + 20);
+				const uint32_t uncompressedSize = readLong(p + 24);
+				const uint16_t nameLength = readShort(p + 28);
+				const uint16_t extraLength = readShort(p + 30);
+				const uint16_t commentLength = readShort(p + 32);
+				const uint32_t localHeaderOffset = readLong(p + 42);
+
+				const size_t headerSize = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+				if ((size_t)(end - p) < headerSize
+					|| compressedSize == 0xFFFFFFFF
+					|| uncompressedSize == 0xFFFFFFFF
+					|| localHeaderOffset == 0xFFFFFFFF)
+				{
+					entries.clear();
+					return false;
+				}
+
+				const char* name = (const char*)p + CENTRAL_HEADER_SIZE;
+				PakFileEntry& entry = entries.emplace_back(*this, name, name + nameLength);
+				entry.uncompressedSize = uncompressedSize;
+				entry.compressedSize = compressedSize;
+				entry.compressionMethod = method;
+				entry.localHeaderOffset = localHeaderOffset;
+
+				p += headerSize;
+			}
+
+			mapping = newMapping;
+			return true;
+		}
+
+		/**
+		 * Open the pak with minizip and read the entries.
+		 *
+		 * @return false if the pak is not a valid zip file.
+		 */
+		bool loadZipDirectory()
+		{
+			ZipContext context(fileName);
+			// cheat by giving a custom context, for unicode support
+			zipFile = unzOpen2_64("", &context.def);
+			if (!zipFile) {
+				return false;
+			}
+
+			unz_global_info64 globalInfo;
+			unzGetGlobalInfo64(zipFile, &globalInfo);
+
+			entries.reserve((size_t)globalInfo.number_entry);
+
+			if (globalInfo.number_entry)
+			{
+				uLong preallocatedLength = 128;
+				char* preallocated = new char[preallocatedLength];
+
+				size_t numFiles = 0;
+				for (int res = unzGoToFirstFile(zipFile); res != UNZ_END_OF_LIST_OF_FILE; res = unzGoToNextFile(zipFile))
+				{
+					unz_file_info fileInfo;
+					unzGetCurrentFileInfo(zipFile, &fileInfo, preallocated, preallocatedLength, NULL, 0, NULL, 0);
+
+					if (fileInfo.size_filename > preallocatedLength)
+					{
+						delete[] preallocated;
+						preallocatedLength = fileInfo.size_filename * 2;
+						preallocated = new char[preallocatedLength];
+
+						unzGetCurrentFileInfo(zipFile, NULL, preallocated, preallocatedLength, NULL, 0, NULL, 0);
+					}
+
+					PakFileEntry& entry = entries.emplace_back(*this, preallocated, preallocated + fileInfo.size_filename);
+					unzGetFilePos(zipFile, &entry.Pos);
+					entry.uncompressedSize = fileInfo.uncompressed_size;
+					entry.compressedSize = fileInfo.compressed_size;
+					entry.compressionMethod = fileInfo.compression_method;
+					++numFiles;
+				}
+
+				delete[] preallocated;
+
+				assert(entries.size() == numFiles);
+			}
+
+			return true;
+		}
+
+		/**
+		 * Open an entry of this pak.
+		 *
+		 * @return the file, or null if the entry can't be read.
+		 */
+		IFilePtr openEntry(const PakFileEntry& entry, const fs::path& name)
+		{
+			if (entry.compressionMethod != 0 && entry.compressionMethod != Z_DEFLATED)
+			{
+				MOHPC_LOG(Error, "File %s uses an unsupported compression method (%d).", entry.Name.generic_string().c_str(), entry.compressionMethod);
+				return nullptr;
+			}
+
+			if (mapping)
+			{
+				const uint8_t* entryData = getMappedData(entry);
+				if (!entryData)
+				{
+					MOHPC_LOG(Error, "File %s has an invalid header in pak %s.", entry.Name.generic_string().c_str(), fileName.generic_string().c_str());
+					return nullptr;
+				}
+
+				return SharedPtr<IFile>(new MappedArchiveFile(name, mapping, entryData, entry.compressedSize, entry.uncompressedSize, entry.compressionMethod));
+			}
+
+			const uint64_t dataOffset = getDataOffset(entry);
+			if (!dataOffset)
+			{
+				MOHPC_LOG(Error, "File %s has an invalid header in pak %s.", entry.Name.generic_string().c_str(), fileName.generic_string().c_str());
+				return nullptr;
+			}
+
+			return SharedPtr<IFile>(new ArchiveFile(name, fileName, dataOffset, entry.compressedSize, entry.uncompressedSize, entry.compressionMethod));
+		}
+
+		/**
+		 * Return the entry data in the mapped pak, after the local header.
+		 *
+		 * @return the data, or null if the local header is invalid.
+		 */
+		const uint8_t* getMappedData(const PakFileEntry& entry) const
+		{
+			using namespace ZipFormat;
+
+			const uint8_t* const data = mapping->getData();
+			const size_t size = mapping->getSize();
+			if (entry.localHeaderOffset + LOCAL_HEADER_SIZE > size) {
+				return nullptr;
+			}
+
+			const uint8_t* header = data + entry.localHeaderOffset;
+			if (readLong(header) != LOCAL_HEADER_SIGNATURE) {
+				return nullptr;
+			}
+
+			// the extra field of the local header can differ from the central directory one
+			const uint64_t dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + readShort(header + 26) + readShort(header + 28);
+			if (dataOffset + entry.compressedSize > size) {
+				return nullptr;
+			}
+
+			return data + dataOffset;
+		}
+
+		/**
+		 * Return the offset of the entry data in the pak, after the local header.
+		 * The shared zip handle is only used there, opened files have their own handle.
+		 *
+		 * @return the offset, or 0 if the local header is invalid.
+		 */
+		uint64_t getDataOffset(const PakFileEntry& entry)
+		{
+			std::lock_guard<std::mutex> lock(zipMutex);
+
+			if (!entry.dataOffset)
+			{
+				unz_file_pos pos = entry.Pos;
+				// open as raw, to read and check the local header without initializing zlib
+				if (unzGoToFilePos(zipFile, &pos) == UNZ_OK && unzOpenCurrentFile2(zipFile, nullptr, nullptr, 1) == UNZ_OK)
+				{
+					entry.dataOffset = unzGetCurrentFileZStreamPos64(zipFile);
+					unzCloseCurrentFile(zipFile);
+				}
+			}
+
+			return entry.dataOffset;
+		}
+
 	public:
 		fs::path fileName;
 		const FileCategory* category;
+		/** The mapped pak, null if it is read through minizip. */
+		MappedFilePtr mapping;
 		unzFile zipFile;
+		std::mutex zipMutex;
 		std::vector<PakFileEntry> entries;
 	};
 
@@ -278,11 +545,12 @@ bool PakFileManager::AddPakFile(const fs::path& fileName, const FileCategory* ca
 
 	const char* const categoryName = category ? category->getName() : "";
 
-	ZipContext context(fileName);
-	// cheat by giving a custom context, for unicode support
-	unzFile zipFile = unzOpen2_64("", &context.def);
-	if (!zipFile)
+	PakFile& pak = m_pPak.emplace_back(fileName, category);
+	// the mapped directory is preferred, minizip is only used for unsupported zip files
+	if (!pak.loadMappedDirectory() && !pak.loadZipDirectory())
 	{
+		m_pPak.pop_back();
+
 		MOHPC_LOG(Error, "Pak file %s for %s doesn't exist.", fileName.generic_string().c_str(), categoryName);
 		return false;
 	}
@@ -294,45 +562,6 @@ bool PakFileManager::AddPakFile(const fs::path& fileName, const FileCategory* ca
 		clearData();
 	}
 
-	PakFile& pak = m_pPak.emplace_back(fileName, category);
-	pak.zipFile = zipFile;
-
-	unz_global_info64 globalInfo;
-	unzGetGlobalInfo64(zipFile, &globalInfo);
-
-	pak.entries.reserve((size_t)globalInfo.number_entry);
-
-	if (globalInfo.number_entry)
-	{
-		uLong preallocatedLength = 128;
-		char* preallocated = new char[preallocatedLength];
-
-		size_t numFiles = 0;
-		for (int res = unzGoToFirstFile(zipFile); res != UNZ_END_OF_LIST_OF_FILE; res = unzGoToNextFile(zipFile))
-		{
-			unz_file_info fileInfo;
-			unzGetCurrentFileInfo(zipFile, &fileInfo, preallocated, preallocatedLength, NULL, 0, NULL, 0);
-
-			if (fileInfo.size_filename > preallocatedLength)
-			{
-				delete[] preallocated;
-				preallocatedLength = fileInfo.size_filename * 2;
-				preallocated = new char[preallocatedLength];
-
-				unzGetCurrentFileInfo(zipFile, NULL, preallocated, preallocatedLength, NULL, 0, NULL, 0);
-			}
-
-			PakFileEntry& entry = pak.entries.emplace_back(pak, preallocated, preallocated + fileInfo.size_filename);
-			unzGetFilePos(zipFile, &entry.Pos);
-			entry.uncompressedSize = fileInfo.uncompressed_size;
-			++numFiles;
-		}
-
-		delete[] preallocated;
-
-		assert(pak.entries.size() == numFiles);
-	}
-
 	numPaks++;
 
 	MOHPC_LOG(Info, "Loaded pak %s (for %s).", fileName.generic_string().c_str(), categoryName);
@@ -378,7 +607,7 @@ IFilePtr PakFileManager::OpenFile(const fs::path& fileName, const FileCategory*
 			if (it != current->m_PakFilesMap.end())
 			{
 				const PakFileEntry* entry = it->second;
-				file = SharedPtr<IFile>(new ArchiveFile(it->first, entry->pak.zipFile, &entry->Pos, entry->uncompressedSize));
+				file = entry->pak.openEntry(*entry, it->first);
 
 				return false;
 			}
@@ -306,13 +306,13 @@ bool SystemFileManager::fileExists(const GamePath& path, const std::filesystem::
 
 IFilePtr SystemFileManager::openFile(const GamePath& path, std::filesystem::path&& fileName) const
 {
-	const fs::path fullPath = path.getDirectory() / fileName;
+	fs::path fullPath = path.getDirectory() / fileName;
 
 	std::ifstream ifs;
 	ifs.open(fullPath, std::ios::in | std::ios::binary);
 
 	if (ifs.is_open()) {
-		return SharedPtr<IFile>(new NormalFile(std::move(fileName), std::move(ifs)));
+		return SharedPtr<IFile>(new NormalFile(std::move(fileName), std::move(ifs), std::move(fullPath)));
 	}
 
 	return nullptr;
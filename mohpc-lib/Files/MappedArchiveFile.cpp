@@ -0,0 +1,180 @@
+#include "MappedArchiveFile.h"
+
+#include <zlib/zlib.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace MOHPC;
+
+MemoryStreamBuf::MemoryStreamBuf()
+{
+}
+
+void MemoryStreamBuf::setData(const char* data, size_t size)
+{
+	char* begin = const_cast<char*>(data);
+	setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which)
+{
+	off_type target;
+	switch (dir)
+	{
+	case std::ios::beg:
+		target = off;
+		break;
+	case std::ios::cur:
+		target = (gptr() - eback()) + off;
+		break;
+	case std::ios::end:
+		target = (egptr() - eback()) + off;
+		break;
+	default:
+		return pos_type(off_type(-1));
+	}
+
+	if (target < 0 || target > egptr() - eback()) {
+		return pos_type(off_type(-1));
+	}
+
+	setg(eback(), eback() + target, egptr());
+	return target;
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type pos, std::ios::openmode which)
+{
+	return seekoff(off_type(pos), std::ios::beg, which);
+}
+
+MappedArchiveFile::MappedArchiveFile(const fs::path& nameRef, const MappedFilePtr& mappingPtr, const uint8_t* entryData, uint64_t compressedSizeValue, uint64_t uncompressedSizeValue, int methodValue)
+	: IFile(nameRef)
+	, mapping(mappingPtr)
+	, data(entryData)
+	, compressedSize(compressedSizeValue)
+	, uncompressedSize(uncompressedSizeValue)
+	, method(methodValue)
+	, buffer(nullptr)
+	, archiveStream(&streamBuf)
+{
+	if (method == 0)
+	{
+		// stored entries are read in place
+		streamBuf.setData((const char*)data, (size_t)uncompressedSize);
+	}
+}
+
+MappedArchiveFile::~MappedArchiveFile()
+{
+	if (buffer) {
+		delete[] buffer;
+	}
+}
+
+std::istream* MappedArchiveFile::GetStream()
+{
+	if (method != 0 && !buffer) {
+		inflateData();
+	}
+
+	return &archiveStream;
+}
+
+uint64_t MappedArchiveFile::ReadBuffer(void** Out)
+{
+	// callers own a writable and null-terminated copy, like other files,
+	// in place access is only done through getMappedData()
+	if (!buffer && !(method == 0 ? copyData() : inflateData()))
+	{
+		*Out = nullptr;
+		return 0;
+	}
+
+	*Out = buffer;
+	return uncompressedSize;
+}
+
+const uint8_t* MappedArchiveFile::getMappedData(uint64_t& size)
+{
+	if (!isInPlace())
+	{
+		size = 0;
+		return nullptr;
+	}
+
+	size = uncompressedSize;
+	return data;
+}
+
+bool MappedArchiveFile::isInPlace() const
+{
+	// entries start anywhere in the zip file, callers cast the content to structures
+	// which can't be read from unaligned addresses on all platforms
+	return method == 0 && (uintptr_t)data % alignof(std::max_align_t) == 0;
+}
+
+bool MappedArchiveFile::copyData()
+{
+	char* newBuffer = new char[(size_t)uncompressedSize + 1];
+	std::memcpy(newBuffer, data, (size_t)uncompressedSize);
+	newBuffer[uncompressedSize] = 0;
+
+	buffer = newBuffer;
+	return true;
+}
+
+bool MappedArchiveFile::inflateData()
+{
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+
+	// raw deflate data, there is no zlib header in zip entries
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+
+	char* newBuffer = new char[(size_t)uncompressedSize + 1];
+
+	uint64_t remainingIn = compressedSize;
+	uint64_t remainingOut = uncompressedSize;
+	stream.next_in = const_cast<Bytef*>(data);
+	stream.next_out = (Bytef*)newBuffer;
+
+	int err = Z_OK;
+	while (err == Z_OK)
+	{
+		// zlib sizes are 32-bit
+		if (!stream.avail_in)
+		{
+			stream.avail_in = (uInt)std::min<uint64_t>(remainingIn, UINT32_MAX);
+			remainingIn -= stream.avail_in;
+		}
+
+		if (!stream.avail_out)
+		{
+			stream.avail_out = (uInt)std::min<uint64_t>(remainingOut, UINT32_MAX);
+			remainingOut -= stream.avail_out;
+		}
+
+		err = inflate(&stream, Z_FINISH);
+		if (err == Z_BUF_ERROR && (stream.avail_in || remainingIn) && (stream.avail_out || remainingOut)) {
+			err = Z_OK;
+		}
+	}
+
+	const bool success = err == Z_STREAM_END && stream.total_out == uncompressedSize;
+	inflateEnd(&stream);
+
+	if (!success)
+	{
+		delete[] newBuffer;
+		return false;
+	}
+
+	newBuffer[uncompressedSize] = 0;
+	buffer = newBuffer;
+	streamBuf.setData(buffer, (size_t)uncompressedSize);
+	return true;
+}
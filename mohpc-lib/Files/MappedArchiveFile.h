@@ -0,0 +1,77 @@
+#pragma once
+
+#include <MOHPC/Files/File.h>
+#include <MOHPC/Files/MappedFile.h>
+
+#include <istream>
+#include <streambuf>
+
+namespace MOHPC
+{
+	/**
+	 * Stream buffer reading directly from a memory range.
+	 */
+	class MemoryStreamBuf : public std::streambuf
+	{
+	public:
+		MemoryStreamBuf();
+
+		/** Set the memory range to read from. */
+		void setData(const char* data, size_t size);
+
+	protected:
+		pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which) override;
+		pos_type seekpos(pos_type pos, std::ios::openmode which) override;
+	};
+
+	/**
+	 * Entry of a memory-mapped zip file.
+	 *
+	 * Stored entries are accessed in place with getMappedData() or GetStream() without any copy,
+	 * ReadBuffer() copies them once. Deflated entries are inflated in a single pass directly from the mapped data.
+	 */
+	class MappedArchiveFile : public IFile
+	{
+	public:
+		/**
+		 * @param nameRef			Name of the entry.
+		 * @param mappingPtr		The mapped zip file, kept alive by the file.
+		 * @param entryData			Start of the entry data in the mapping.
+		 * @param compressedSize	Size of the data in the mapping.
+		 * @param uncompressedSize	Size of the entry once decompressed.
+		 * @param method			Compression method of the entry (0 = stored, Z_DEFLATED).
+		 */
+		MappedArchiveFile(const fs::path& nameRef, const MappedFilePtr& mappingPtr, const uint8_t* entryData, uint64_t compressedSize, uint64_t uncompressedSize, int method);
+		~MappedArchiveFile();
+
+		std::istream* GetStream() override;
+
+		/**
+		 * Return a null-terminated copy of the content of the entry, owned by the file.
+		 */
+		uint64_t ReadBuffer(void** Out) override;
+
+		/**
+		 * Return the mapped data of stored entries that are aligned in the zip file.
+		 * Deflated entries and unaligned entries can't be accessed in place.
+		 */
+		const uint8_t* getMappedData(uint64_t& size) override;
+
+	private:
+		/** Return true if the content can be used directly from the mapping. */
+		bool isInPlace() const;
+		/** Copy a stored entry into the buffer. */
+		bool copyData();
+		bool inflateData();
+
+	private:
+		MappedFilePtr mapping;
+		const uint8_t* data;
+		uint64_t compressedSize;
+		uint64_t uncompressedSize;
+		int method;
+		char* buffer;
+		MemoryStreamBuf streamBuf;
+		std::istream archiveStream;
+	};
+}
@@ -0,0 +1,118 @@
+#include <MOHPC/Files/MappedFile.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace MOHPC;
+
+MOHPC_OBJECT_DEFINITION(MappedFile);
+
+MappedFile::MappedFile()
+	: data(nullptr)
+	, size(0)
+#ifdef _WIN32
+	, mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const fs::path& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// the mapping keeps a reference to the file
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping) {
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	mappingHandle = mapping;
+	data = (const uint8_t*)view;
+	size = (size_t)fileSize.QuadPart;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !st.st_size)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// the mapping keeps a reference to the file
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	data = (const uint8_t*)view;
+	size = (size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (!data) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	mappingHandle = nullptr;
+#else
+	munmap((void*)data, size);
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+const uint8_t* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
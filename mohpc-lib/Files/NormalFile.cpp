@@ -2,12 +2,13 @@
 
 using namespace MOHPC;
 
-NormalFile::NormalFile(fs::path&& nameRef, std::ifstream&& fileRef)
+NormalFile::NormalFile(fs::path&& nameRef, std::ifstream&& fileRef, fs::path&& fullPathRef)
 	: IFile(std::move(nameRef))
 	, fileStream(std::move(fileRef))
+	, fullPath(std::move(fullPathRef))
 	, buffer(nullptr)
 	, streamSize(0)
-
+	, mappingFailed(false)
 {
 }
 
@@ -26,7 +27,7 @@ std::istream* NormalFile::GetStream()
 
 uint64_t NormalFile::ReadBuffer(void** Out)
 {
-	uint64_t length = 0;
+	uint64_t length = streamSize;
 
 	if (!buffer)
 	{
@@ -51,3 +52,26 @@ uint64_t NormalFile::ReadBuffer(void** Out)
 	*Out = buffer;
 	return length;
 }
+
+const uint8_t* NormalFile::getMappedData(uint64_t& size)
+{
+	if (!mapping && !mappingFailed)
+	{
+		mapping = MappedFile::create();
+		if (!mapping->open(fullPath))
+		{
+			// empty files can't be mapped either
+			mapping = nullptr;
+			mappingFailed = true;
+		}
+	}
+
+	if (!mapping)
+	{
+		size = 0;
+		return nullptr;
+	}
+
+	size = mapping->getSize();
+	return mapping->getData();
+}
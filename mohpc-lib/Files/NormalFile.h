@@ -1,6 +1,7 @@
 #pragma once
 
 #include <MOHPC/Files/File.h>
+#include <MOHPC/Files/MappedFile.h>
 
 #include <fstream>
 
@@ -9,15 +10,26 @@ namespace MOHPC
 	class NormalFile : public IFile
 	{
 	public:
-		NormalFile(fs::path&& nameRef, std::ifstream&& fileRef);
+		/**
+		 * @param nameRef	Name of the file.
+		 * @param fileRef	The opened file.
+		 * @param fullPathRef	Path of the file on the system, used to map it.
+		 */
+		NormalFile(fs::path&& nameRef, std::ifstream&& fileRef, fs::path&& fullPathRef);
 		~NormalFile();
 
 		std::istream* GetStream() override;
 		uint64_t ReadBuffer(void** Out) override;
 
+		/** Map the file the first time it's called. */
+		const uint8_t* getMappedData(uint64_t& size) override;
+
 	private:
 		std::ifstream fileStream;
+		fs::path fullPath;
 		char* buffer;
 		std::streamoff streamSize;
+		MappedFilePtr mapping;
+		bool mappingFailed;
 	};
 }
@@ -1,16 +1,24 @@
 #pragma once
 
+#include <MOHPC/Files/FileDefs.h>
+
 #include <streambuf>
-#include <zlib/contrib/minizip/unzip.h>
+#include <fstream>
+#include <zlib/zlib.h>
 #include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <cstdint>
 
 #undef min
 
-// function from patched unzip
-extern "C" int ZEXPORT unzseek64(unzFile file, ZPOS64_T offset, int origin);
-
+/**
+ * Stream buffer reading a single entry of a zip file.
+ *
+ * Each instance has its own handle to the zip file and its own zlib stream,
+ * so multiple entries of the same zip can be read at the same time, from any thread.
+ * Only the stored and deflated methods are supported.
+ */
 template<
 	typename char_type,
 	typename traits_type = std::char_traits<char_type>>
@@ -26,32 +34,45 @@ public:
 	typedef typename traits_type::pos_type 		pos_type;
 	typedef typename traits_type::off_type 		off_type;
 
-	basic_decompression_buf(unzFile File, const unz_file_pos& Position, size_t size)
+	/**
+	 * @param zipFileName		Path to the zip file containing the entry.
+	 * @param dataOffset		Offset of the entry data in the zip file (after the local header).
+	 * @param compressedSize	Size of the data in the zip file.
+	 * @param size				Uncompressed size of the entry.
+	 * @param method			Compression method of the entry (0 = stored, Z_DEFLATED).
+	 */
+	basic_decompression_buf(const MOHPC::fs::path& zipFileName, uint64_t dataOffset, uint64_t compressedSize, uint64_t size, int method)
+		: m_file(zipFileName, std::ios::in | std::ios::binary)
+		, m_dataOffset(dataOffset)
+		, m_compressedSize(compressedSize)
+		, m_size(size)
+		, m_compressedRead(0)
+		, m_offset(0)
+		, m_stored(method == 0)
+		, m_streamInit(false)
 	{
-		m_offset = 0;
-		m_roffset = 0;
-		m_file = File;
-		m_pos = Position;
-		m_size = size;
+		std::memset(&m_stream, 0, sizeof(m_stream));
+		if (!m_stored)
+		{
+			// raw deflate data, there is no zlib header in zip entries
+			m_streamInit = inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+		}
+
+		m_file.seekg(m_dataOffset);
 	}
 
 	~basic_decompression_buf()
 	{
+		if (m_streamInit) {
+			inflateEnd(&m_stream);
+		}
 	}
 
 	virtual pos_type seekpos(pos_type pt,
 		std::ios::openmode =
 		(std::ios::openmode)(std::ios::in | std::ios::out))
 	{
-		SetCurrentFile();
-#ifdef __WIN32
-		unzseek64(m_file, pt.seekpos(), (int)(std::streamoff(pt) - pt.seekpos()));
-#else
-		unzseek64(m_file, std::streamoff(pt), 1);
-#endif
-		m_offset = unztell(m_file);
-		this->setg(NULL, NULL, NULL);
-		return pt;
+		return SeekTo(off_type(pt));
 	}
 
 	virtual pos_type seekoff(off_type ot,
@@ -59,42 +80,21 @@ public:
 		std::ios::openmode =
 		(std::ios::openmode)(std::ios::in | std::ios::out))
 	{
-		SetCurrentFile();
+		// position of the next character to be read
+		const off_type current = m_offset - (this->egptr() - this->gptr());
 
-		if (ot == 0 && sd == std::ios::cur)
+		switch (sd)
 		{
-			return unztell64(m_file);
-		}
-		else
-		{
-			off_type realoff;
-			switch (sd)
-			{
-			default:
-			case std::ios::beg:
-				realoff = ot;
-				break;
-			case std::ios::cur:
-				realoff = m_offset + ot;
-				break;
-			case std::ios::end:
-				realoff = m_size;
-				break;
-			}
-
-			if (realoff < m_offset || this->eback() + realoff > this->egptr())
-			{
-				unzseek64(m_file, ot, sd);
-				m_offset = unztell64(m_file);
-				this->setg(NULL, NULL, NULL);
-			}
-			else
-			{
-				//setg(m_readbuffer, m_readbuffer, m_readbuffer + m_offset);
-				this->setg(this->eback(), this->eback() + realoff, this->egptr());
+		default:
+		case std::ios::beg:
+			return SeekTo(ot);
+		case std::ios::cur:
+			if (ot == 0) {
+				return current;
 			}
-
-			return ot;
+			return SeekTo(current + ot);
+		case std::ios::end:
+			return SeekTo(off_type(m_size) + ot);
 		}
 	}
 
@@ -106,24 +106,17 @@ public:
 			const size_t minPutBack = BUFFER_SIZE / 2;
 			putBackSize = std::min(minPutBack, (size_t)(this->gptr() - this->eback()));
 
-			memmove(m_readbuffer, this->gptr() - putBackSize, putBackSize);
+			memmove(m_readbuffer, this->gptr() - putBackSize, putBackSize * sizeof(char_type));
 		}
 
 		char_type* begin = m_readbuffer + putBackSize;
 
-		SetCurrentFile();
-
-		m_roffset = unztell64(m_file);
-		int readBytes = unzReadCurrentFile(m_file, begin, (unsigned int)(BUFFER_SIZE - putBackSize) * sizeof(char_type));
-		m_offset = m_roffset + readBytes;
-
-		if (readBytes > 0)
-		{
-			this->setg(begin, begin, begin + readBytes);
-		}
+		const size_t readBytes = ReadData(begin, (BUFFER_SIZE - putBackSize) * sizeof(char_type));
+		m_offset += readBytes;
 
 		if (readBytes > 0)
 		{
+			this->setg(m_readbuffer, begin, begin + readBytes / sizeof(char_type));
 			return this->sgetc();
 		}
 		else
@@ -133,29 +126,130 @@ public:
 	}
 
 private:
-	void SetCurrentFile()
+	pos_type SeekTo(off_type target)
 	{
-		unz_file_pos pos;
-		unzGetFilePos(m_file, &pos);
+		if (target < 0 || target > off_type(m_size)) {
+			return pos_type(off_type(-1));
+		}
+
+		const off_type bufferStart = m_offset - (this->egptr() - this->eback());
+		if (this->eback() && target >= bufferStart && target <= m_offset)
+		{
+			// the position is in the current buffer
+			this->setg(this->eback(), this->eback() + (target - bufferStart), this->egptr());
+			return target;
+		}
+
+		this->setg(NULL, NULL, NULL);
+
+		if (m_stored)
+		{
+			// uncompressed data can be accessed directly
+			m_offset = target;
+			return target;
+		}
 
-		if (pos.num_of_file != m_pos.num_of_file || pos.pos_in_zip_directory != m_pos.pos_in_zip_directory)
+		if (target < m_offset)
 		{
-			unzGoToFilePos(m_file, &m_pos);
-			unzOpenCurrentFile(m_file);
+			// deflate can't go backward, decompress again from the start
+			Rewind();
+		}
+
+		// skip data until the target
+		while (m_offset < target)
+		{
+			const size_t skipBytes = (size_t)std::min<off_type>(target - m_offset, sizeof(m_readbuffer));
+			const size_t readBytes = ReadData(m_readbuffer, skipBytes);
+			if (!readBytes) {
+				break;
+			}
+
+			m_offset += readBytes;
+		}
+
+		return m_offset;
+	}
+
+	void Rewind()
+	{
+		inflateReset(&m_stream);
+		m_stream.next_in = nullptr;
+		m_stream.avail_in = 0;
+		m_compressedRead = 0;
+		m_offset = 0;
+		m_file.clear();
+		m_file.seekg(m_dataOffset);
+	}
+
+	size_t ReadData(void* out, size_t size)
+	{
+		if (m_stored) {
+			return ReadStored(out, size);
+		}
+		else if (m_streamInit) {
+			return ReadDeflated(out, size);
 		}
 
-		off_type currentOff = unztell64(m_file);
+		return 0;
+	}
 
-		if(currentOff >= 0 && currentOff != m_offset)
+	size_t ReadStored(void* out, size_t size)
+	{
+		const uint64_t remaining = m_size - std::min<uint64_t>(m_offset, m_size);
+		const size_t readSize = (size_t)std::min<uint64_t>(size, remaining);
+		if (!readSize) {
+			return 0;
+		}
+
+		m_file.clear();
+		m_file.seekg(m_dataOffset + m_offset);
+		m_file.read((char*)out, readSize);
+		return (size_t)m_file.gcount();
+	}
+
+	size_t ReadDeflated(void* out, size_t size)
+	{
+		m_stream.next_out = (Bytef*)out;
+		m_stream.avail_out = (uInt)size;
+
+		while (m_stream.avail_out)
 		{
-			unzseek64(m_file, m_offset, 0);
+			if (!m_stream.avail_in && m_compressedRead < m_compressedSize)
+			{
+				const size_t readSize = (size_t)std::min<uint64_t>(sizeof(m_inbuffer), m_compressedSize - m_compressedRead);
+				m_file.read((char*)m_inbuffer, readSize);
+
+				const size_t numRead = (size_t)m_file.gcount();
+				if (!numRead) {
+					break;
+				}
+
+				m_compressedRead += numRead;
+				m_stream.next_in = m_inbuffer;
+				m_stream.avail_in = (uInt)numRead;
+			}
+
+			const int err = inflate(&m_stream, Z_SYNC_FLUSH);
+			if (err != Z_OK) {
+				// end of stream or corrupted data
+				break;
+			}
 		}
+
+		return size - m_stream.avail_out;
 	}
 
-	unzFile m_file;
-	unz_file_pos m_pos;
-	size_t m_size;
-	off_type m_roffset;
+private:
+	std::ifstream m_file;
+	z_stream m_stream;
+	uint64_t m_dataOffset;
+	uint64_t m_compressedSize;
+	uint64_t m_size;
+	uint64_t m_compressedRead;
+	/** Uncompressed offset of the end of the read buffer. */
 	off_type m_offset;
+	bool m_stored;
+	bool m_streamInit;
 	char_type m_readbuffer[BUFFER_SIZE];
+	Bytef m_inbuffer[BUFFER_SIZE];
 };
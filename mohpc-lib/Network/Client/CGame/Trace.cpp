@@ -12,9 +12,6 @@ TraceManager::TraceManager()
 	: numSolidEntities(0)
 	, numTriggerEntities(0)
 {
-	// Create predefined box hull
-	boxHull = CollisionWorld::create();
-	boxHull->InitBoxHull();
 }
 
 TraceManager::~TraceManager()
@@ -33,7 +30,6 @@ void TraceManager::clipMoveToEntities(CollisionWorld& cm, const_vec3r_t start, c
 			continue;
 		}
 
-		CollisionWorld* world = &cm;
 		clipHandle_t cmodel;
 		vec3_t bmins, bmaxs;
 		vec3_t origin, angles;
@@ -50,17 +46,15 @@ void TraceManager::clipMoveToEntities(CollisionWorld& cm, const_vec3r_t start, c
 		{
 			// encoded bbox
 			IntegerToBoundingBox(ent->solid, bmins, bmaxs);
-			cmodel = boxHull->TempBoxModel(bmins, bmaxs, ContentFlags::CONTENTS_BODY);
+			// entities with a boundingbox use a boxhull
+			cmodel = cm.TempBoxModel(bmins, bmaxs, ContentFlags::CONTENTS_BODY);
 			VectorClear(angles);
 			VectorCopy(cent->currentState.netorigin, origin);
-			// trace to the boxhull instead
-			// entities with a boundingbox use a boxhull
-			world = boxHull.get();
 		}
 
 		trace_t trace;
 		// trace through the entity's submodel
-		world->TransformedBoxTrace(&trace, start, end,
+		cm.TransformedBoxTrace(&trace, start, end,
 			mins, maxs, cmodel, mask, origin, angles, cylinder);
 
 		if (trace.allsolid || trace.fraction < tr.fraction) {
@@ -0,0 +1,374 @@
+#include <MOHPC/Network/Client/ClientHost.h>
+#include <MOHPC/Network/Remote/IPRemoteIdentifier.h>
+
+#include <algorithm>
+#include <deque>
+#include <cstring>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+namespace MOHPC
+{
+namespace Network
+{
+	class ClientHostCommunicator;
+
+	/**
+	 * Socket shared by communicators of different servers.
+	 */
+	class ClientHostSocket
+	{
+	public:
+		ClientHostSocket(const IUdpSocketPtr& socket);
+
+		/** Attach the communicator if there is no other communicator for the same server. */
+		bool attach(ClientHostCommunicator* comm);
+		void detach(ClientHostCommunicator* comm);
+
+		/** Receive pending datagrams and dispatch them to the communicator of the source address. */
+		void receive(uint64_t timeout);
+
+		const IUdpSocketPtr& getSocket() const;
+
+	private:
+		static constexpr size_t BATCH_SIZE = 8;
+
+		std::mutex mutex;
+		IUdpSocketPtr socket;
+		std::vector<ClientHostCommunicator*> comms;
+		udpMessage_t batch[BATCH_SIZE];
+		std::vector<uint8_t> batchBuffer;
+	};
+
+	/**
+	 * Communicator for a single server, over a shared socket.
+	 * Datagrams are queued by the shared socket and read from the queue.
+	 */
+	class ClientHostCommunicator : public ICommunicator
+	{
+	public:
+		ClientHostCommunicator(const SharedPtr<ClientHostSocket>& socket, const IRemoteIdentifierPtr& remoteId);
+		~ClientHostCommunicator();
+
+		size_t send(const IRemoteIdentifier& identifier, const uint8_t* data, size_t size) override;
+		size_t receive(IRemoteIdentifierPtr& remoteAddress, uint8_t* data, size_t size) override;
+		size_t getIncomingSize() override;
+		bool waitIncoming(uint64_t timeout) override;
+
+		const netadr_t& getAddress() const;
+		/** Queue a datagram received from the server. */
+		void push(const uint8_t* data, size_t size);
+
+	private:
+		/** Maximum number of queued datagrams, newer datagrams are dropped. */
+		static constexpr size_t MAX_QUEUED = 512;
+
+		SharedPtr<ClientHostSocket> hostSocket;
+		IRemoteIdentifierPtr remoteId;
+		netadr_t address;
+		std::mutex mutex;
+		std::deque<std::vector<uint8_t>> queue;
+		/** Buffers of consumed datagrams, reused for next datagrams. */
+		std::vector<std::vector<uint8_t>> freeBuffers;
+	};
+}
+}
+
+ClientHostSocket::ClientHostSocket(const IUdpSocketPtr& inSocket)
+	: socket(inSocket)
+	, batch()
+{
+}
+
+bool ClientHostSocket::attach(ClientHostCommunicator* comm)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const ClientHostCommunicator* other : comms)
+	{
+		if (other->getAddress() == comm->getAddress())
+		{
+			// datagrams from the server couldn't be told apart
+			return false;
+		}
+	}
+
+	comms.push_back(comm);
+	return true;
+}
+
+void ClientHostSocket::detach(ClientHostCommunicator* comm)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = std::find(comms.begin(), comms.end(), comm);
+	if (it != comms.end()) comms.erase(it);
+}
+
+void ClientHostSocket::receive(uint64_t timeout)
+{
+	// wait without locking, so other threads can use the socket meanwhile
+	if (timeout && !socket->wait(timeout)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (batchBuffer.empty())
+	{
+		// the game never sends datagrams larger than this, larger messages are fragmented
+		batchBuffer.resize(BATCH_SIZE * MAX_GAME_DATAGRAM_SIZE);
+		for (size_t i = 0; i < BATCH_SIZE; ++i)
+		{
+			batch[i].data = batchBuffer.data() + i * MAX_GAME_DATAGRAM_SIZE;
+			batch[i].maxSize = MAX_GAME_DATAGRAM_SIZE;
+		}
+	}
+
+	size_t numReceived;
+	do
+	{
+		numReceived = socket->receive(batch, BATCH_SIZE);
+		for (size_t i = 0; i < numReceived; ++i)
+		{
+			const udpMessage_t& message = batch[i];
+			if (!message.size) {
+				continue;
+			}
+
+			for (ClientHostCommunicator* comm : comms)
+			{
+				if (comm->getAddress() == message.address)
+				{
+					comm->push((const uint8_t*)message.data, message.size);
+					break;
+				}
+			}
+		}
+	} while (numReceived == BATCH_SIZE);
+}
+
+const IUdpSocketPtr& ClientHostSocket::getSocket() const
+{
+	return socket;
+}
+
+ClientHostCommunicator::ClientHostCommunicator(const SharedPtr<ClientHostSocket>& inSocket, const IRemoteIdentifierPtr& inRemoteId)
+	: hostSocket(inSocket)
+	, remoteId(inRemoteId)
+	, address(*static_cast<const IPRemoteIdentifier&>(*inRemoteId).getAddress())
+{
+}
+
+ClientHostCommunicator::~ClientHostCommunicator()
+{
+	hostSocket->detach(this);
+}
+
+size_t ClientHostCommunicator::send(const IRemoteIdentifier& identifier, const uint8_t* data, size_t size)
+{
+	const IPRemoteIdentifier* ipId = dynamic_cast<const IPRemoteIdentifier*>(&identifier);
+	if (ipId) {
+		return hostSocket->getSocket()->send(ipId->getAddress(), data, size);
+	}
+
+	return 0;
+}
+
+size_t ClientHostCommunicator::receive(IRemoteIdentifierPtr& remoteAddress, uint8_t* data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (queue.empty()) {
+		return 0;
+	}
+
+	std::vector<uint8_t>& packet = queue.front();
+	const size_t len = std::min(packet.size(), size);
+	std::memcpy(data, packet.data(), len);
+
+	freeBuffers.push_back(std::move(packet));
+	queue.pop_front();
+
+	// only datagrams from the server are queued
+	remoteAddress = remoteId;
+	return len;
+}
+
+size_t ClientHostCommunicator::getIncomingSize()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return !queue.empty() ? queue.front().size() : 0;
+}
+
+bool ClientHostCommunicator::waitIncoming(uint64_t timeout)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!queue.empty()) {
+			return true;
+		}
+	}
+
+	hostSocket->receive(timeout);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return !queue.empty();
+}
+
+const netadr_t& ClientHostCommunicator::getAddress() const
+{
+	return address;
+}
+
+void ClientHostCommunicator::push(const uint8_t* data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (queue.size() >= MAX_QUEUED)
+	{
+		// the communicator isn't read fast enough
+		return;
+	}
+
+	std::vector<uint8_t> packet;
+	if (!freeBuffers.empty())
+	{
+		packet = std::move(freeBuffers.back());
+		freeBuffers.pop_back();
+	}
+
+	packet.assign(data, data + size);
+	queue.push_back(std::move(packet));
+}
+
+MOHPC_OBJECT_DEFINITION(ClientHost);
+
+ClientHost::ClientHost(size_t numThreads, const NetAddr4* inBindAddress)
+	: pool(numThreads)
+{
+	if (inBindAddress)
+	{
+		bindAddress = NetAddr4::create();
+		std::memcpy(bindAddress->ip, inBindAddress->ip, sizeof(bindAddress->ip));
+		bindAddress->setPort(0);
+	}
+}
+
+ClientHost::~ClientHost()
+{
+}
+
+ICommunicatorPtr ClientHost::createCommunicator(const IRemoteIdentifierPtr& serverId)
+{
+	const IPRemoteIdentifier* ipId = dynamic_cast<const IPRemoteIdentifier*>(serverId.get());
+	if (!ipId || !ipId->getAddress()) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(socketsMutex);
+
+	// use the first socket that is not used for the server
+	for (const SharedPtr<ClientHostSocket>& socket : sockets)
+	{
+		SharedPtr<ClientHostCommunicator> comm = makeShared<ClientHostCommunicator>(socket, serverId);
+		if (socket->attach(comm.get())) {
+			return comm;
+		}
+	}
+
+	const IUdpSocketPtr udpSocket = ISocketFactory::get()->createUdp(bindAddress.get());
+	if (!udpSocket) {
+		return nullptr;
+	}
+
+	const SharedPtr<ClientHostSocket> socket = makeShared<ClientHostSocket>(udpSocket);
+	sockets.push_back(socket);
+
+	SharedPtr<ClientHostCommunicator> comm = makeShared<ClientHostCommunicator>(socket, serverId);
+	socket->attach(comm.get());
+
+	return comm;
+}
+
+void ClientHost::addConnection(const ServerConnectionPtr& connection)
+{
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	pendingConnections.push_back(connection);
+}
+
+void ClientHost::removeConnection(const ServerConnectionPtr& connection)
+{
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		auto it = std::find(pendingConnections.begin(), pendingConnections.end(), connection);
+		if (it != pendingConnections.end()) pendingConnections.erase(it);
+	}
+
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	auto it = std::find(connections.begin(), connections.end(), connection);
+	if (it != connections.end()) connections.erase(it);
+}
+
+size_t ClientHost::getNumConnections() const
+{
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	std::lock_guard<std::mutex> pendingLock(pendingMutex);
+	return connections.size() + pendingConnections.size();
+}
+
+size_t ClientHost::getNumSockets() const
+{
+	std::lock_guard<std::mutex> lock(socketsMutex);
+	return sockets.size();
+}
+
+void ClientHost::tick(deltaTime_t deltaTime, tickTime_t currentTime)
+{
+	{
+		std::lock_guard<std::mutex> lock(socketsMutex);
+		tickSockets = sockets;
+	}
+
+	// dispatch datagrams to connections before ticking them
+	for (const SharedPtr<ClientHostSocket>& socket : tickSockets) {
+		socket->receive(0);
+	}
+
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+
+	addPendingConnections();
+
+	const size_t numConnections = connections.size();
+	// a few shards per thread, so threads with fast shards can steal remaining ones
+	const size_t numShards = std::min(numConnections, pool.getNumThreads() * 4);
+
+	pool.parallelFor(numShards, [&](size_t shard)
+	{
+		for (size_t i = shard; i < numConnections; i += numShards) {
+			connections[i]->tick(deltaTime, currentTime);
+		}
+	});
+
+	removeDisconnected();
+}
+
+void ClientHost::addPendingConnections()
+{
+	std::lock_guard<std::mutex> lock(pendingMutex);
+
+	connections.insert(connections.end(), pendingConnections.begin(), pendingConnections.end());
+	pendingConnections.clear();
+}
+
+void ClientHost::removeDisconnected()
+{
+	connections.erase(
+		std::remove_if(connections.begin(), connections.end(), [](const ServerConnectionPtr& connection)
+		{
+			return !connection->getServerChannel().isChannelValid();
+		}),
+		connections.end()
+	);
+}
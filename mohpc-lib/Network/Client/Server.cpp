@@ -1,5 +1,7 @@
 #include <MOHPC/Network/Client/Server.h>
 #include <MOHPC/Network/Client/ServerConnection.h>
+#include <MOHPC/Network/Remote/ThreadedChannel.h>
+#include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
 #include <MOHPC/Network/Version.h>
 #include <MOHPC/Utility/Misc/MSG/Codec.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
@@ -145,7 +147,7 @@ void EngineServer::connect(const UserInfoPtr& UserInfo, const ConnectSettingsPtr
 	using namespace std::placeholders;
 
 	ConnectionParams connData;
-	connData.response = std::bind(&EngineServer::onConnect, this, std::move(result), _1, _2, _3, _4, _5);
+	connData.response = std::bind(&EngineServer::onConnect, this, std::move(result), connectSettings, _1, _2, _3, _4, _5);
 	connData.info = std::move(UserInfo);
 	connData.settings = std::move(connectSettings);
 
@@ -170,12 +172,26 @@ void EngineServer::sendRequest(IEngineRequestPtr&& req, Callbacks::ServerTimeout
 	handler.sendRequest(std::move(req), timeoutTime);
 }
 
-void EngineServer::onConnect(const Callbacks::Connect result, uint16_t qport, uint32_t challengeResponse, const protocolType_c& protoType, const UserInfoPtr& cInfo, const char* errorMessage)
+void EngineServer::onConnect(const Callbacks::Connect result, const ConnectSettingsPtr& settings, uint16_t qport, uint32_t challengeResponse, const protocolType_c& protoType, const UserInfoPtr& cInfo, const char* errorMessage)
 {
 	if (!errorMessage)
 	{
-		// create a net channel and use the same socket
-		INetchanPtr newChannel = makeShared<Netchan>(handler.getComm(), qport);
+		INetchanPtr newChannel;
+		if (settings && settings->isThreadedChannel())
+		{
+			// receive from another thread, with a socket of its own as the dispatcher still polls this one,
+			// the server recognizes the client by its qport and replies to the new port
+			newChannel = makeShared<ThreadedNetchan>(
+				makeShared<Netchan>(UDPCommunicator::create(), qport),
+				handler.getRemoteId()
+			);
+		}
+		else
+		{
+			// create a net channel and use the same socket
+			newChannel = makeShared<Netchan>(handler.getComm(), qport);
+		}
+
 		// and pass it to the new client game connection
 		// using a shared ptr, to be able to use the deleter from the library itself
 		ServerConnectionPtr connection = ServerConnection::create(
@@ -356,6 +372,7 @@ ConnectSettings::ConnectSettings()
 	, deferredChallengeTime(100)
 	, deferredConnectTime(100)
 	, qport(0)
+	, threadedChannel(false)
 {
 }
 
@@ -409,3 +426,13 @@ size_t ConnectSettings::getDeferredConnectTime() const
 	return deferredConnectTime;
 }
 
+void ConnectSettings::setThreadedChannel(bool value)
+{
+	threadedChannel = value;
+}
+
+bool ConnectSettings::isThreadedChannel() const
+{
+	return threadedChannel;
+}
+
@@ -128,23 +128,23 @@ void ServerChannel::process(const ChannelCallback& callback)
 
 	size_t count = 0;
 
-	ICommunicator* const socket = getNetchan()->getRawSocket();
 	// Loop until there is no valid data
 	// or the max number of processed packets has reached the limit
-	while (isChannelValid() && socket->getIncomingSize() && count++ < maxPacketsAtOnce)
+	while (isChannelValid() && getNetchan()->hasIncoming() && count++ < maxPacketsAtOnce)
 	{
 		// don't process packets from other IPs otherwise the state may get corrupted
 		IRemoteIdentifierPtr receivedFrom = adr;
 
-		DynamicDataMessageStream stream;
+		// keep the memory of the previous packet
+		receiveStream.clear(false);
 		// reserve a minimum amount to reduce the amount of reallocations
-		stream.reserve(MINIMUM_RECEIVE_BUFFER_SIZE);
+		receiveStream.reserve(MINIMUM_RECEIVE_BUFFER_SIZE);
 
 		uint32_t sequenceNum;
-		if (getNetchan()->receive(receivedFrom, stream, sequenceNum))
+		if (getNetchan()->receive(receivedFrom, receiveStream, sequenceNum))
 		{
 			// got the sequence
-			callback(stream, sequenceNum);
+			callback(receiveStream, sequenceNum);
 		}
 	}
 }
@@ -158,6 +158,7 @@ MOHPC_OBJECT_DEFINITION(ServerConnection);
 
 ServerConnection::ServerConnection(const INetchanPtr& inNetchan, const IRemoteIdentifierPtr& inAdr, uint32_t challengeResponse, const protocolType_c& protoType, const UserInfoPtr& cInfo)
 	: serverChannel(inNetchan, inAdr)
+	, metrics(NetMetrics::create())
 	, timeout(std::chrono::milliseconds(60000))
 	, userInfo(cInfo)
 	, clGameState(makeShared<ServerGameState>(protoType, &clientTime))
@@ -173,6 +174,9 @@ ServerConnection::ServerConnection(const INetchanPtr& inNetchan, const IRemoteId
 		userInfo = UserInfo::create();
 	}
 
+	// count packets from the channel
+	inNetchan->setMetrics(metrics);
+
 	const uint32_t protocol = protoType.getProtocolVersionNumber();
 
 	hashParser = Parsing::IHash::get(protocol);
@@ -347,6 +351,11 @@ void ServerConnection::receive(MSG& msg, tickTime_t currentTime, uint32_t sequen
 
 	serverMessageSequence = sequenceNum;
 
+	// the rest of the message is read with the Huffman-coded bit codec
+	const IMessageStream& stream = msg.stream();
+	metrics->add(netMetric_e::Messages);
+	metrics->add(netMetric_e::HuffmanBytes, stream.GetLength() - stream.GetPosition());
+
 	msg.SetCodec(MessageCodecs::Bit);
 
 	// update the last acknowledge command from server
@@ -384,6 +393,8 @@ void ServerConnection::receive(MSG& msg, tickTime_t currentTime, uint32_t sequen
 
 void ServerConnection::parseServerMessage(MSG& msg, tickTime_t currentTime, uint32_t sequenceNum)
 {
+	using namespace std::chrono;
+
 	while(cgameModule)
 	{
 		const svc_ops_e cmd = msg.ReadByteEnum<svc_ops_e>();
@@ -391,6 +402,8 @@ void ServerConnection::parseServerMessage(MSG& msg, tickTime_t currentTime, uint
 			break;
 		}
 
+		const steady_clock::time_point startTime = steady_clock::now();
+
 		switch (cmd)
 		{
 		case svc_ops_e::Nop:
@@ -411,6 +424,9 @@ void ServerConnection::parseServerMessage(MSG& msg, tickTime_t currentTime, uint
 				sequenceNum,
 				getServerChannel().getNetchan()->getOutgoingSequence()
 			);
+			metrics->add(netMetric_e::Snapshots);
+			metrics->add(netMetric_e::SnapshotParseTime, duration_cast<microseconds>(steady_clock::now() - startTime).count());
+			metrics->add(netMetric_e::DeltaEntities, clSnapshotManager.getNumDeltaEntities());
 			break;
 		case svc_ops_e::Download:
 			downloadState.processDownload(msg, *stringParser);
@@ -428,6 +444,8 @@ void ServerConnection::parseServerMessage(MSG& msg, tickTime_t currentTime, uint
 		default:
 			throw ClientError::IllegibleServerMessageException((uint8_t)cmd);
 		}
+
+		metrics->addDispatch(cmd, duration_cast<microseconds>(steady_clock::now() - startTime).count());
 	}
 }
 
@@ -759,6 +777,11 @@ void ServerConnection::setInputModule(const IUserInputModulePtr& inputModulePtr)
 	inputModule = inputModulePtr;
 }
 
+const NetMetricsPtr& ServerConnection::getMetrics() const
+{
+	return metrics;
+}
+
 uint32_t ServerConnection::getCurrentServerMessageSequence() const
 {
 	return serverMessageSequence;
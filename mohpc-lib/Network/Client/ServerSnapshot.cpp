@@ -3,16 +3,25 @@
 #include <MOHPC/Network/Client/GameState.h>
 
 #include <cstring>
+#include <utility>
 
 using namespace MOHPC;
 using namespace Network;
 
 ServerSnapshotManager::ServerSnapshotManager(protocolType_c protocol)
 	: parseEntitiesNum(0)
+	, numDeltaEntities(0)
 	, lastSnapFlags(0)
+	, parseEntities(MAX_PARSE_ENTITIES)
 	, snapActive(false)
 	, newSnapshots(false)
 {
+	for (size_t i = 0; i < PACKET_BACKUP; ++i) {
+		snapshots[i] = &snapshotStorage[i];
+	}
+	freeSnapshot = &snapshotStorage[PACKET_BACKUP];
+	currentSnap = snapshots[0];
+
 	const uint32_t version = protocol.getProtocolVersionNumber();
 
 	entityParser = Parsing::IEntity::get(version);
@@ -21,21 +30,30 @@ ServerSnapshotManager::ServerSnapshotManager(protocolType_c protocol)
 	snapshotParser = Parsing::ISnapshot::get(version);
 }
 
-void ServerSnapshotManager::setNewSnap(rawSnapshot_t& newSnap)
+ServerSnapshotManager::~ServerSnapshotManager()
+{
+}
+
+void ServerSnapshotManager::setNewSnap(rawSnapshot_t* newSnap)
 {
-	uint32_t oldMessageNum = currentSnap.messageNum + 1;
+	uint32_t oldMessageNum = currentSnap->messageNum + 1;
 
-	if (newSnap.messageNum >= PACKET_BACKUP + oldMessageNum) {
-		oldMessageNum = newSnap.messageNum - (PACKET_BACKUP - 1);
+	if (newSnap->messageNum >= PACKET_BACKUP + oldMessageNum) {
+		oldMessageNum = newSnap->messageNum - (PACKET_BACKUP - 1);
 	}
 
-	for (; oldMessageNum < newSnap.messageNum; oldMessageNum++) {
-		snapshots[oldMessageNum & PACKET_MASK].valid = false;
+	for (; oldMessageNum < newSnap->messageNum; oldMessageNum++) {
+		snapshots[oldMessageNum & PACKET_MASK]->valid = false;
 	}
 
-	currentSnap = newSnap;
+	// the replaced snapshot becomes the storage for the next one
+	rawSnapshot_t*& slot = snapshots[newSnap->messageNum & PACKET_MASK];
+	if (newSnap == freeSnapshot) {
+		freeSnapshot = slot;
+	}
 
-	snapshots[currentSnap.messageNum & PACKET_MASK] = currentSnap;
+	slot = newSnap;
+	currentSnap = newSnap;
 	newSnapshots = true;
 }
 
@@ -51,14 +69,22 @@ void ServerSnapshotManager::parseSnapshot(
 {
 	Parsing::snapshotParm_t snapParm;
 	snapParm.deltaTime = clientTime.getDeltaTimeSeconds();
-	snapParm.maxParseEntities = MAX_PARSE_ENTITIES;
 	snapParm.maxSnapshotEntities = 128;
 	snapParm.oldSnapshots = snapshots;
 	snapParm.numOldSnapshots = PACKET_BACKUP;
-	snapParm.parseEntities = parseEntities;
+	snapParm.parseEntities = &parseEntities;
+	snapParm.maxParseEntities = parseEntities.capacity();
 	snapParm.parseEntitiesNum = parseEntitiesNum;
+	snapParm.numDeltaEntities = 0;
+	snapParm.entityTable = parsedEntityTable.get();
 
-	rawSnapshot_t newSnap;
+	// parse into the storage that isn't part of the history,
+	// only reset members that the parser doesn't always write
+	rawSnapshot_t& newSnap = *freeSnapshot;
+	newSnap.valid = false;
+	newSnap.numSounds = 0;
+	std::memset(newSnap.areamask, 0, sizeof(newSnap.areamask));
+	newSnap.ps = playerState_t();
 
 	snapshotParser->parseSnapshot(
 		msg,
@@ -70,6 +96,7 @@ void ServerSnapshotManager::parseSnapshot(
 	);
 
 	parseEntitiesNum = snapParm.parseEntitiesNum;
+	numDeltaEntities = snapParm.numDeltaEntities;
 
 	// notify about the player start
 	const playerState_t* oldps = snapParm.oldSnap ? &snapParm.oldSnap->ps : nullptr;
@@ -79,7 +106,11 @@ void ServerSnapshotManager::parseSnapshot(
 		return;
 	}
 
-	if (currentSnap.valid && ((currentSnap.snapFlags ^ newSnap.snapFlags) & SNAPFLAG_SERVERCOUNT))
+	if (entityTable) {
+		std::swap(entityTable, parsedEntityTable);
+	}
+
+	if (currentSnap->valid && ((currentSnap->snapFlags ^ newSnap.snapFlags) & SNAPFLAG_SERVERCOUNT))
 	{
 		// server time starts from here
 		clientTime.setStartTime(currentTime);
@@ -87,11 +118,11 @@ void ServerSnapshotManager::parseSnapshot(
 	}
 
 	// set the new snap and calculate the ping
-	setNewSnap(newSnap);
+	setNewSnap(&newSnap);
 
 	Parsing::pvsParm_t parm;
 	parm.clientNum = clGameState.getClientNum();
-	VectorCopy(currentSnap.ps.getOrigin(), parm.origin);
+	VectorCopy(currentSnap->ps.getOrigin(), parm.origin);
 	// FIXME: make the value modifiable as an option?
 	// currently 1 radar unit = 63 world units
 	parm.radarRange = radarInfo_t::getCoordPrecision();
@@ -99,12 +130,12 @@ void ServerSnapshotManager::parseSnapshot(
 
 	// read and unpack radar info if it exists on the server
 	radarUnpacked_t unpacked;
-	if (PVSParser->readNonPVSClient(currentSnap.ps.getRadarInfo(), parm, unpacked))
+	if (PVSParser->readNonPVSClient(currentSnap->ps.getRadarInfo(), parm, unpacked))
 	{
 		handlerList.readNonPVSClientHandler.broadcast(unpacked);
 	}
 
-	getHandlers().snapshotParsedHandler.broadcast(currentSnap);
+	getHandlers().snapshotParsedHandler.broadcast(*currentSnap);
 }
 
 void ServerSnapshotManager::notifySounds(const rawSnapshot_t* newFrame)
@@ -118,7 +149,7 @@ void ServerSnapshotManager::notifySounds(const rawSnapshot_t* newFrame)
 
 bool ServerSnapshotManager::firstSnapshot()
 {
-	if (currentSnap.snapFlags & SNAPFLAG_NOT_ACTIVE) {
+	if (currentSnap->snapFlags & SNAPFLAG_NOT_ACTIVE) {
 		return false;
 	}
 
@@ -127,7 +158,7 @@ bool ServerSnapshotManager::firstSnapshot()
 	snapActive = true;
 
 	// Notify about the snapshot
-	getHandlers().firstSnapshotHandler.broadcast(currentSnap);
+	getHandlers().firstSnapshotHandler.broadcast(*currentSnap);
 
 	return true;
 }
@@ -141,7 +172,7 @@ void ServerSnapshotManager::serverRestarted()
 
 void ServerSnapshotManager::updateSnapFlags()
 {
-	lastSnapFlags = currentSnap.snapFlags;
+	lastSnapFlags = currentSnap->snapFlags;
 }
 
 bool ServerSnapshotManager::checkTime(ClientTime& clientTime)
@@ -156,7 +187,7 @@ bool ServerSnapshotManager::checkTime(ClientTime& clientTime)
 	}
 
 	// Check when server has restarted
-	if ((currentSnap.snapFlags ^ lastSnapFlags) & SNAPFLAG_SERVERCOUNT) {
+	if ((currentSnap->snapFlags ^ lastSnapFlags) & SNAPFLAG_SERVERCOUNT) {
 		serverRestarted();
 	}
 
@@ -182,25 +213,25 @@ const ServerSnapshotManager::HandlerList& ServerSnapshotManager::getHandlers() c
 
 uint32_t ServerSnapshotManager::getCurrentSnapNumber() const
 {
-	return currentSnap.messageNum;
+	return currentSnap->messageNum;
 }
 
 bool ServerSnapshotManager::getSnapshot(uintptr_t snapshotNum, SnapshotInfo& outSnapshot) const
 {
 	// if the frame has fallen out of the circular buffer, we can't return it
-	if (currentSnap.messageNum >= PACKET_BACKUP + snapshotNum) {
+	if (currentSnap->messageNum >= PACKET_BACKUP + snapshotNum) {
 		return false;
 	}
 
 	// if the frame is not valid, we can't return it
-	const rawSnapshot_t* foundSnap = &snapshots[snapshotNum & PACKET_MASK];
+	const rawSnapshot_t* foundSnap = snapshots[snapshotNum & PACKET_MASK];
 	if (!foundSnap->valid) {
 		return false;
 	}
 
 	// if the entities in the frame have fallen out of their
 	// circular buffer, we can't return it
-	if (parseEntitiesNum >= MAX_PARSE_ENTITIES + foundSnap->parseEntitiesNum) {
+	if (parseEntitiesNum >= parseEntities.capacity() + foundSnap->parseEntitiesNum) {
 		return false;
 	}
 
@@ -220,7 +251,7 @@ bool ServerSnapshotManager::getSnapshot(uintptr_t snapshotNum, SnapshotInfo& out
 
 	// Copy entities to snapshot
 	for (uintptr_t i = 0; i < count; i++) {
-		outSnapshot.entities[i] = parseEntities[(foundSnap->parseEntitiesNum + i) & (MAX_PARSE_ENTITIES - 1)];
+		outSnapshot.entities[i] = parseEntities.get(foundSnap->parseEntitiesNum + (uint32_t)i);
 	}
 
 	outSnapshot.numSounds = foundSnap->numSounds;
@@ -238,12 +269,12 @@ bool ServerSnapshotManager::getSnapshot(SnapshotInfo& outSnapshot) const
 
 const rawSnapshot_t& ServerSnapshotManager::getCurrentSnap() const
 {
-	return currentSnap;
+	return *currentSnap;
 }
 
 bool ServerSnapshotManager::isSnapshotValid() const
 {
-	return currentSnap.valid;
+	return currentSnap->valid;
 }
 
 bool ServerSnapshotManager::hasNewSnapshots() const
@@ -251,8 +282,43 @@ bool ServerSnapshotManager::hasNewSnapshots() const
 	return newSnapshots;
 }
 
+void ServerSnapshotManager::setEntityTableEnabled(bool enabled)
+{
+	if (enabled)
+	{
+		if (!entityTable)
+		{
+			entityTable = std::make_unique<EntityTable>();
+			parsedEntityTable = std::make_unique<EntityTable>();
+		}
+		else {
+			entityTable->clear();
+		}
+	}
+	else
+	{
+		entityTable.reset();
+		parsedEntityTable.reset();
+	}
+}
+
+const EntityTable* ServerSnapshotManager::getEntityTable() const
+{
+	return entityTable.get();
+}
+
+const EntityStateRing& ServerSnapshotManager::getParseEntities() const
+{
+	return parseEntities;
+}
+
+uint32_t ServerSnapshotManager::getNumDeltaEntities() const
+{
+	return numDeltaEntities;
+}
+
 netTime_t ServerSnapshotManager::getServerTime() const
 {
-	return currentSnap.serverTime;
+	return currentSnap->serverTime;
 }
 
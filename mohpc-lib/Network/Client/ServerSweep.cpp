@@ -0,0 +1,525 @@
+#include <MOHPC/Network/Client/ServerSweep.h>
+#include <MOHPC/Network/Remote/IPRemoteIdentifier.h>
+#include <MOHPC/Network/Remote/Ops.h>
+#include <MOHPC/Utility/Misc/MSG/Codec.h>
+#include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/Stream.h>
+#include <MOHPC/Utility/TokenParser.h>
+#include <MOHPC/Common/Log.h>
+
+#include <algorithm>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+#define MOHPC_LOG_NAMESPACE "server_sweep"
+
+struct ServerSweep::server_t
+{
+	IRemoteIdentifierPtr identifier;
+	netadr_t address;
+	/** Status received so far, a GameSpy status can be split into multiple datagrams. */
+	str infoStr;
+	time_point sendTime;
+	/** Round-trip time of the server in microseconds, 0 if not measured yet. */
+	uint64_t smoothedRtt;
+	uint64_t rttVariation;
+	/** Number of times the server was queried again. */
+	uint32_t numRetries;
+	/** Queued or waiting for a reply. */
+	bool pending;
+	/** A query was sent and the server didn't reply yet. */
+	bool waiting;
+};
+
+static void updateRtt(uint64_t& smoothedRtt, uint64_t& rttVariation, uint64_t sample)
+{
+	if (!smoothedRtt)
+	{
+		smoothedRtt = sample;
+		rttVariation = sample / 2;
+	}
+	else
+	{
+		const uint64_t delta = smoothedRtt > sample ? smoothedRtt - sample : sample - smoothedRtt;
+		rttVariation = (rttVariation * 3 + delta) / 4;
+		smoothedRtt = (smoothedRtt * 7 + sample) / 8;
+	}
+}
+
+size_t ServerSweep::netadrHash::operator()(const netadr_t& address) const
+{
+	// FNV-1a over the address and the port
+	size_t hash = 2166136261u;
+	const uint8_t* ip = address.getAddress();
+	for (size_t i = 0; i < address.getAddrSize(); ++i) {
+		hash = (hash ^ ip[i]) * 16777619u;
+	}
+
+	const uint16_t port = address.getPort();
+	hash = (hash ^ (port & 0xFF)) * 16777619u;
+	hash = (hash ^ (port >> 8)) * 16777619u;
+	return hash;
+}
+
+MOHPC_OBJECT_DEFINITION(ServerSweep);
+
+ServerSweep::ServerSweep(sweepQuery_e type, const IUdpSocketPtr& inSocket)
+	: socket(inSocket)
+	, queryType(type)
+	, packetsPerSecond(500)
+	, maxRetries(2)
+	, initialTimeout(1000)
+	, minTimeout(100)
+	, maxTimeout(5000)
+	, smoothedRtt(0)
+	, rttVariation(0)
+	, tokens(0)
+	, lastRefill(clock::now())
+	, numPending(0)
+	, sendBatch()
+	, batch()
+{
+	if (!socket) {
+		socket = ISocketFactory::get()->createUdp();
+	}
+
+	if (queryType == sweepQuery_e::Gamespy)
+	{
+		static const char gamespyQuery[] = "\\status\\";
+		queryData.assign(gamespyQuery, gamespyQuery + sizeof(gamespyQuery) - 1);
+	}
+	else
+	{
+		// the query is the same for all servers, so it is only generated once
+		DynamicDataMessageStream stream;
+		{
+			MSG msg(stream, msgMode_e::Writing);
+			msg.SetCodec(MessageCodecs::OOB);
+
+			msg.WriteUInteger(-1);
+			msg.WriteByte((uint8_t)netsrc_e::Server);
+			msg.WriteString(StringMessage(queryType == sweepQuery_e::EngineStatus ? "getstatus" : "getinfo"));
+		}
+
+		queryData.assign(stream.getStorage(), stream.getStorage() + stream.GetLength());
+	}
+}
+
+ServerSweep::~ServerSweep()
+{
+}
+
+void ServerSweep::setCallbacks(Callbacks::SweepResponse&& responseFunc, Callbacks::SweepTimeout&& timeoutFunc)
+{
+	responseCallback = std::move(responseFunc);
+	timeoutCallback = std::move(timeoutFunc);
+}
+
+void ServerSweep::setPacketsPerSecond(size_t value)
+{
+	packetsPerSecond = value;
+}
+
+size_t ServerSweep::getPacketsPerSecond() const
+{
+	return packetsPerSecond;
+}
+
+void ServerSweep::setMaxRetries(uint32_t value)
+{
+	maxRetries = value;
+}
+
+uint32_t ServerSweep::getMaxRetries() const
+{
+	return maxRetries;
+}
+
+void ServerSweep::setTimeouts(uint64_t initialTime, uint64_t minTime, uint64_t maxTime)
+{
+	minTimeout = minTime;
+	maxTimeout = std::max(minTime, maxTime);
+	initialTimeout = std::min(std::max(initialTime, minTimeout), maxTimeout);
+}
+
+bool ServerSweep::addServer(const IRemoteIdentifierPtr& identifier)
+{
+	const IPRemoteIdentifier* ipId = dynamic_cast<const IPRemoteIdentifier*>(identifier.get());
+	if (!ipId || !ipId->getAddress()) {
+		return false;
+	}
+
+	const netadr_t address(*ipId->getAddress());
+
+	server_t* server;
+	auto it = serverMap.find(address);
+	if (it != serverMap.end())
+	{
+		server = it->second;
+		if (server->pending)
+		{
+			// already being queried
+			return true;
+		}
+	}
+	else
+	{
+		servers.push_back(std::make_unique<server_t>());
+		server = servers.back().get();
+		server->identifier = identifier;
+		server->address = address;
+		server->smoothedRtt = 0;
+		server->rttVariation = 0;
+		serverMap.emplace(address, server);
+	}
+
+	server->numRetries = 0;
+	server->pending = true;
+	server->waiting = false;
+	server->infoStr.clear();
+	queryQueue.push_back(server);
+	++numPending;
+
+	return true;
+}
+
+bool ServerSweep::addServer(const IServerPtr& server)
+{
+	return addServer(server->getIdentifier());
+}
+
+size_t ServerSweep::getNumPending() const
+{
+	return numPending;
+}
+
+uint64_t ServerSweep::getAverageRtt() const
+{
+	return smoothedRtt / 1000;
+}
+
+bool ServerSweep::process(uint64_t maxProcessTime)
+{
+	using namespace std::chrono;
+
+	time_point currentTime = clock::now();
+	const time_point maxTime = currentTime + milliseconds(maxProcessTime);
+
+	for (;;)
+	{
+		// replies are handled first, so servers that replied in time are not considered timed out
+		receiveReplies(currentTime);
+		processTimeouts(currentTime);
+		sendQueries(currentTime);
+
+		if (!numPending)
+		{
+			// everything was processed
+			return true;
+		}
+
+		if (maxProcessTime == 0)
+		{
+			// no process time
+			break;
+		}
+
+		uint64_t waitTime = getWaitTime(currentTime);
+		if (maxProcessTime != InfiniteProcessTime)
+		{
+			currentTime = clock::now();
+			if (currentTime >= maxTime)
+			{
+				// reached max process time
+				break;
+			}
+
+			const uint64_t remainingTime = duration_cast<milliseconds>(maxTime - currentTime + milliseconds(1) - nanoseconds(1)).count();
+			waitTime = std::min(waitTime, remainingTime);
+		}
+
+		if (waitTime) {
+			socket->wait(waitTime);
+		}
+
+		currentTime = clock::now();
+	}
+
+	return false;
+}
+
+size_t ServerSweep::refillTokens(time_point now)
+{
+	using namespace std::chrono;
+
+	if (!packetsPerSecond) {
+		return ~size_t(0);
+	}
+
+	// allow bursts of 50ms, so packets can be sent by batch
+	const double maxTokens = std::max(1.0, packetsPerSecond / 20.0);
+	const double elapsed = duration<double>(now - lastRefill).count();
+
+	tokens = std::min(maxTokens, tokens + elapsed * packetsPerSecond);
+	lastRefill = now;
+
+	return (size_t)tokens;
+}
+
+void ServerSweep::sendQueries(time_point now)
+{
+	size_t numTokens = refillTokens(now);
+
+	while (numTokens && (!retryQueue.empty() || !queryQueue.empty()))
+	{
+		size_t count = 0;
+		while (count < BATCH_SIZE && count < numTokens && (!retryQueue.empty() || !queryQueue.empty()))
+		{
+			std::deque<server_t*>& queue = !retryQueue.empty() ? retryQueue : queryQueue;
+			server_t& server = *queue.front();
+			queue.pop_front();
+
+			server.sendTime = now;
+			server.waiting = true;
+			server.infoStr.clear();
+			timers.schedule(&server, now + std::chrono::milliseconds(getTimeout(server)));
+
+			udpMessage_t& message = sendBatch[count++];
+			message.data = queryData.data();
+			message.size = queryData.size();
+			message.address = server.address;
+		}
+
+		// a query that couldn't be sent is handled like a lost one
+		socket->send(sendBatch, count);
+
+		numTokens -= count;
+		if (packetsPerSecond) tokens -= count;
+	}
+}
+
+void ServerSweep::receiveReplies(time_point now)
+{
+	allocateBuffers();
+
+	size_t numReceived;
+	do
+	{
+		numReceived = socket->receive(batch, BATCH_SIZE);
+		for (size_t i = 0; i < numReceived; ++i)
+		{
+			const udpMessage_t& message = batch[i];
+			if (!message.size) {
+				continue;
+			}
+
+			auto it = serverMap.find(message.address);
+			if (it == serverMap.end() || !it->second->waiting)
+			{
+				// not from a queried server, or a duplicate reply
+				continue;
+			}
+
+			handleReply(*it->second, (const uint8_t*)message.data, message.size, now);
+		}
+	} while (numReceived == BATCH_SIZE);
+}
+
+void ServerSweep::processTimeouts(time_point now)
+{
+	expiredServers.clear();
+	timers.advance(now, expiredServers);
+
+	for (server_t* server : expiredServers)
+	{
+		server->waiting = false;
+
+		if (server->numRetries < maxRetries)
+		{
+			server->numRetries++;
+			retryQueue.push_back(server);
+		}
+		else
+		{
+			finish(*server);
+			if (timeoutCallback) timeoutCallback(server->identifier);
+		}
+	}
+}
+
+void ServerSweep::handleReply(server_t& server, const uint8_t* data, size_t size, time_point now)
+{
+	using namespace std::chrono;
+
+	const uint64_t rtt = std::max<uint64_t>(duration_cast<microseconds>(now - server.sendTime).count(), 1);
+
+	if (queryType == sweepQuery_e::Gamespy)
+	{
+		if (server.infoStr.empty() && data[0] != '\\')
+		{
+			// not a status
+			return;
+		}
+
+		server.infoStr.append((const char*)data, size);
+
+		const char* finalPos = strHelpers::find(server.infoStr.c_str(), "\\final\\\\queryid\\");
+		if (!finalPos)
+		{
+			// wait for remaining parts
+			return;
+		}
+
+		const size_t infoLen = finalPos - server.infoStr.c_str();
+		// moved out, as the server can be queried again from the callback
+		const str infoStr = std::move(server.infoStr);
+		sampleRtt(server, rtt);
+		finish(server);
+
+		if (responseCallback)
+		{
+			ReadOnlyInfo info(infoStr.c_str(), infoLen);
+			responseCallback(server.identifier, info, rtt / 1000);
+		}
+	}
+	else
+	{
+		// the marker and the source
+		static constexpr size_t headerSize = sizeof(uint32_t) + 1;
+		if (size <= headerSize) {
+			return;
+		}
+
+		FixedDataMessageStream stream((void*)data, size);
+		MSG msg(stream, msgMode_e::Reading);
+		msg.SetCodec(MessageCodecs::OOB);
+
+		const uint32_t marker = msg.ReadUInteger();
+		if (marker != -1 || (netsrc_e)msg.ReadByte() != netsrc_e::Client)
+		{
+			// must be a connectionless packet targeted at the client
+			return;
+		}
+
+		// the text is not read as a string from the message, it has no terminating character
+		// if the datagram was truncated, only the info line is needed anyway
+		const str text((const char*)data + headerSize, size - headerSize);
+		const size_t len = strHelpers::len(text.c_str());
+		if (!len) {
+			return;
+		}
+
+		TokenParser parser;
+		parser.Parse(text.c_str(), len + 1);
+
+		const char* expected = queryType == sweepQuery_e::EngineStatus ? "statusResponse" : "infoResponse";
+		const char* command = parser.GetToken(false);
+		if (strHelpers::icmp(command, expected))
+		{
+			MOHPC_LOG(Debug, "unexpected reply \"%s\" from %s", command, server.identifier->getString().c_str());
+			return;
+		}
+
+		sampleRtt(server, rtt);
+		finish(server);
+
+		if (responseCallback)
+		{
+			ReadOnlyInfo info(parser.GetLine(true));
+			responseCallback(server.identifier, info, rtt / 1000);
+		}
+	}
+}
+
+void ServerSweep::finish(server_t& server)
+{
+	timers.cancel(&server);
+	server.pending = false;
+	server.waiting = false;
+	--numPending;
+}
+
+uint64_t ServerSweep::getTimeout(const server_t& server) const
+{
+	uint64_t timeout;
+	if (server.smoothedRtt)
+	{
+		// the server replied before
+		timeout = (server.smoothedRtt + server.rttVariation * 4) / 1000;
+	}
+	else if (smoothedRtt)
+	{
+		// use what was measured from other servers
+		timeout = (smoothedRtt + rttVariation * 4) / 1000;
+	}
+	else {
+		timeout = initialTimeout;
+	}
+
+	timeout = std::min(std::max(timeout, minTimeout), maxTimeout);
+
+	// double the timeout on each retry, as the server may be far
+	for (uint32_t i = 0; i < server.numRetries && timeout < maxTimeout; ++i) {
+		timeout *= 2;
+	}
+
+	return std::min(timeout, maxTimeout);
+}
+
+void ServerSweep::sampleRtt(server_t& server, uint64_t rtt)
+{
+	if (server.numRetries)
+	{
+		// the reply could be from any of the sent queries,
+		// so the time is not reliable
+		return;
+	}
+
+	updateRtt(server.smoothedRtt, server.rttVariation, rtt);
+	updateRtt(smoothedRtt, rttVariation, rtt);
+}
+
+uint64_t ServerSweep::getWaitTime(time_point now) const
+{
+	using namespace std::chrono;
+
+	uint64_t waitTime = InfiniteProcessTime;
+
+	if (!retryQueue.empty() || !queryQueue.empty())
+	{
+		if (!packetsPerSecond || tokens >= 1.0) {
+			return 0;
+		}
+
+		// wait until a packet can be sent
+		waitTime = (uint64_t)((1.0 - tokens) * 1000.0 / packetsPerSecond) + 1;
+	}
+
+	time_point nextTime;
+	if (timers.getNextTime(nextTime))
+	{
+		if (nextTime <= now) {
+			return 0;
+		}
+
+		const uint64_t timerTime = duration_cast<milliseconds>(nextTime - now + milliseconds(1) - nanoseconds(1)).count();
+		waitTime = std::min(waitTime, timerTime);
+	}
+
+	return waitTime;
+}
+
+void ServerSweep::allocateBuffers()
+{
+	if (!batchBuffer.empty()) {
+		return;
+	}
+
+	batchBuffer.resize(BATCH_SIZE * MAX_RESPONSE_SIZE);
+	for (size_t i = 0; i < BATCH_SIZE; ++i)
+	{
+		batch[i].data = batchBuffer.data() + i * MAX_RESPONSE_SIZE;
+		batch[i].maxSize = MAX_RESPONSE_SIZE;
+	}
+}
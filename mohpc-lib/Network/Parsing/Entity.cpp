@@ -3,6 +3,7 @@
 #include <MOHPC/Network/Serializable/Entity.h>
 #include <MOHPC/Network/Serializable/EntityField.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
@@ -23,6 +24,12 @@ public:
 		return helper.ReadEntityNum();
 	}
 
+	entityNum_t readEntityNum(MSGBufferReader<MessageCodecs::BitPolicy>& msg) const override
+	{
+		const entityNum_t entNum = msg.ReadNumber<entityNum_t>(GENTITYNUM_BITS);
+		return entNum & (MAX_GENTITIES - 1);
+	}
+
 	void writeEntityNum(MSG& msg, entityNum_t num) const override
 	{
 		MsgTypesEntityHelper helper(msg);
@@ -44,6 +51,21 @@ public:
 		}
 	}
 
+	void readDeltaEntity(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const entityState_t* from, entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const override
+	{
+		SerializableEntityState toSerialize(*to, newNum);
+		if (from)
+		{
+			SerializableEntityState fromSerialize(*const_cast<entityState_t*>(from), newNum);
+			toSerialize.LoadDelta(msg, &fromSerialize);
+		}
+		else
+		{
+			// no delta
+			toSerialize.LoadDelta(msg, nullptr);
+		}
+	}
+
 	void writeDeltaEntity(MSG& msg, const entityState_t* from, const entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const override
 	{
 		SerializableEntityState toSerialize(*const_cast<entityState_t*>(to), newNum);
@@ -75,6 +97,12 @@ public:
 		return helper.ReadEntityNum2();
 	}
 
+	entityNum_t readEntityNum(MSGBufferReader<MessageCodecs::BitPolicy>& msg) const override
+	{
+		const entityNum_t entNum = msg.ReadNumber<entityNum_t>(GENTITYNUM_BITS);
+		return (entNum - 1) & (MAX_GENTITIES - 1);
+	}
+
 	void writeEntityNum(MSG& msg, entityNum_t num) const override
 	{
 		MsgTypesEntityHelper helper(msg);
@@ -96,6 +124,21 @@ public:
 		}
 	}
 
+	void readDeltaEntity(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const entityState_t* from, entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const override
+	{
+		SerializableEntityState_ver15 toSerialize(*to, newNum, deltaTime);
+		if (from)
+		{
+			SerializableEntityState_ver15 fromSerialize(*const_cast<entityState_t*>(from), newNum, deltaTime);
+			toSerialize.LoadDelta(msg, &fromSerialize);
+		}
+		else
+		{
+			// no delta
+			toSerialize.LoadDelta(msg, nullptr);
+		}
+	}
+
 	void writeDeltaEntity(MSG& msg, const entityState_t* from, const entityState_t* to, entityNum_t newNum, deltaTimeFloat_t deltaTime) const override
 	{
 		SerializableEntityState_ver15 toSerialize(*const_cast<entityState_t*>(to), newNum, deltaTime);
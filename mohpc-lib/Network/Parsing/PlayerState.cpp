@@ -2,6 +2,7 @@
 #include <MOHPC/Network/Types/PlayerState.h>
 #include <MOHPC/Network/Serializable/PlayerState.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
@@ -32,6 +33,21 @@ public:
 		}
 	}
 
+	void readDeltaPlayerState(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const playerState_t* from, playerState_t* to) const override
+	{
+		SerializablePlayerState toSerialize(*to);
+		if (from)
+		{
+			SerializablePlayerState fromSerialize(*const_cast<playerState_t*>(from));
+			toSerialize.LoadDelta(msg, &fromSerialize);
+		}
+		else
+		{
+			// no delta
+			toSerialize.LoadDelta(msg, nullptr);
+		}
+	}
+
 	void writeDeltaPlayerState(MSG& msg, const playerState_t* from, const playerState_t* to) const override
 	{
 		SerializablePlayerState toSerialize(*const_cast<playerState_t*>(to));
@@ -72,6 +88,21 @@ public:
 		}
 	}
 
+	void readDeltaPlayerState(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const playerState_t* from, playerState_t* to) const override
+	{
+		SerializablePlayerState_ver15 toSerialize(*to);
+		if (from)
+		{
+			SerializablePlayerState_ver15 fromSerialize(*const_cast<playerState_t*>(from));
+			toSerialize.LoadDelta(msg, &fromSerialize);
+		}
+		else
+		{
+			// no delta
+			toSerialize.LoadDelta(msg, nullptr);
+		}
+	}
+
 	void writeDeltaPlayerState(MSG& msg, const playerState_t* from, const playerState_t* to) const override
 	{
 		SerializablePlayerState_ver15 toSerialize(*const_cast<playerState_t*>(to));
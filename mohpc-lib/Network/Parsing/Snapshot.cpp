@@ -2,12 +2,16 @@
 #include <MOHPC/Network/Parsing/Entity.h>
 #include <MOHPC/Network/Parsing/PlayerState.h>
 #include <MOHPC/Network/Types/Snapshot.h>
+#include <MOHPC/Network/Types/EntityTable.h>
+#include <MOHPC/Network/Types/EntityStateRing.h>
 #include <MOHPC/Network/Types/GameState.h>
 #include <MOHPC/Network/Types/Reliable.h>
 #include <MOHPC/Network/Serializable/Entity.h>
 #include <MOHPC/Network/Serializable/EntityField.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
 #include <MOHPC/Utility/Misc/MSG/MSGCoord.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
+#include <MOHPC/Utility/Misc/MSG/Codec.h>
 #include <MOHPC/Common/Log.h>
 
 using namespace MOHPC;
@@ -33,6 +37,34 @@ public:
 		snapshotParm_t& snapshotParm,
 		uint32_t serverMessageSequence
 	) const override
+	{
+		const uint8_t* data;
+		size_t length;
+		size_t bitPos;
+		if (&msg.codec() != &MessageCodecs::Bit || !msg.GetReadBuffer(data, length, bitPos))
+		{
+			// can't read the message buffer directly
+			parseSnapshotInternal(msg, gameState, serverCommands, rawSnapshot, snapshotParm, serverMessageSequence);
+			return;
+		}
+
+		// the whole snapshot is read from the decoded message buffer without going through the stream
+		MSGBufferReader<MessageCodecs::BitPolicy> reader(data, length, bitPos);
+		parseSnapshotInternal(reader, gameState, serverCommands, rawSnapshot, snapshotParm, serverMessageSequence);
+
+		// continue reading the message after the snapshot
+		msg.SetReadBitPosition(reader.GetBitPosition());
+	}
+
+	template<typename Reader>
+	void parseSnapshotInternal(
+		Reader& msg,
+		const gameState_t& gameState,
+		ICommandSequence* serverCommands,
+		rawSnapshot_t& rawSnapshot,
+		snapshotParm_t& snapshotParm,
+		uint32_t serverMessageSequence
+	) const
 	{
 		rawSnapshot.serverCommandNum = serverCommands->getCommandSequence();
 
@@ -66,7 +98,8 @@ public:
 		}
 	}
 
-	const rawSnapshot_t* readOldSnapshot(MSG& msg, rawSnapshot_t& snap, const snapshotParm_t& snapshotParm) const
+	template<typename Reader>
+	const rawSnapshot_t* readOldSnapshot(Reader& msg, rawSnapshot_t& snap, const snapshotParm_t& snapshotParm) const
 	{
 		const uint8_t deltaNum = msg.ReadByte();
 		if (!deltaNum) {
@@ -83,7 +116,7 @@ public:
 			return nullptr;
 		}
 
-		const rawSnapshot_t* old = &snapshotParm.oldSnapshots[snap.deltaNum % snapshotParm.numOldSnapshots];
+		const rawSnapshot_t* old = snapshotParm.oldSnapshots[snap.deltaNum % snapshotParm.numOldSnapshots];
 		if (!old->valid) {
 			// should never happen
 			// FIXME: throw?
@@ -106,7 +139,8 @@ public:
 		return old;
 	}
 
-	void readAreaMask(MSG& msg, rawSnapshot_t& snap) const
+	template<typename Reader>
+	void readAreaMask(Reader& msg, rawSnapshot_t& snap) const
 	{
 		const uint8_t areaLen = msg.ReadByte();
 
@@ -118,13 +152,20 @@ public:
 		msg.ReadData(snap.areamask, areaLen);
 	}
 
-	void parsePacketEntities(MSG& msg, const rawSnapshot_t* oldFrame, rawSnapshot_t* newFrame, snapshotParm_t& snapshotParm, const gameState_t& gameState) const
+	template<typename Reader>
+	void parsePacketEntities(Reader& msg, const rawSnapshot_t* oldFrame, rawSnapshot_t* newFrame, snapshotParm_t& snapshotParm, const gameState_t& gameState) const
 	{
 		newFrame->parseEntitiesNum = snapshotParm.parseEntitiesNum;
 		newFrame->numEntities = 0;
 
+		if (snapshotParm.entityTable) {
+			snapshotParm.entityTable->clear();
+		}
+
+		const EntityStateRing& parseEntities = *snapshotParm.parseEntities;
+
 		// delta from the entities present in oldframe
-		entityState_t* oldState = NULL;
+		const entityState_t* oldState = NULL;
 		uint32_t oldIndex = 0;
 		uint32_t oldNum = 0;
 		if (!oldFrame) {
@@ -132,7 +173,7 @@ public:
 		}
 		else
 		{
-			oldState = &snapshotParm.parseEntities[oldFrame->parseEntitiesNum % snapshotParm.maxParseEntities];
+			oldState = &parseEntities.get(oldFrame->parseEntitiesNum);
 			oldNum = oldState->number;
 		}
 
@@ -148,7 +189,7 @@ public:
 
 			while (oldNum < newNum)
 			{
-				parseDeltaEntity(msg, newFrame, snapshotParm, oldNum, oldState, true);
+				copyEntity(newFrame, snapshotParm, oldFrame->parseEntitiesNum + oldIndex);
 
 				++oldIndex;
 
@@ -156,7 +197,7 @@ public:
 					oldNum = 99999;
 				}
 				else {
-					oldState = &snapshotParm.parseEntities[(oldFrame->parseEntitiesNum + oldIndex) % snapshotParm.maxParseEntities];
+					oldState = &parseEntities.get(oldFrame->parseEntitiesNum + oldIndex);
 					oldNum = oldState->number;
 				}
 			}
@@ -164,7 +205,7 @@ public:
 			if (oldNum == newNum)
 			{
 				// delta from previous state
-				parseDeltaEntity(msg, newFrame, snapshotParm, newNum, oldState, false);
+				parseDeltaEntity(msg, newFrame, snapshotParm, newNum, oldState);
 
 				++oldIndex;
 
@@ -172,7 +213,7 @@ public:
 					oldNum = 99999;
 				}
 				else {
-					oldState = &snapshotParm.parseEntities[(oldFrame->parseEntitiesNum + oldIndex) % snapshotParm.maxParseEntities];
+					oldState = &parseEntities.get(oldFrame->parseEntitiesNum + oldIndex);
 					oldNum = oldState->number;
 				}
 				continue;
@@ -181,7 +222,7 @@ public:
 			if (oldNum > newNum)
 			{
 				// delta from baseline
-				parseDeltaEntity(msg, newFrame, snapshotParm, newNum, &entityBaselines.getEntity(newNum), false);
+				parseDeltaEntity(msg, newFrame, snapshotParm, newNum, &entityBaselines.getEntity(newNum));
 				continue;
 			}
 		}
@@ -190,7 +231,7 @@ public:
 		while (oldNum != 99999)
 		{
 			// one or more entities from the old packet are unchanged
-			parseDeltaEntity(msg, newFrame, snapshotParm, oldNum, oldState, true);
+			copyEntity(newFrame, snapshotParm, oldFrame->parseEntitiesNum + oldIndex);
 
 			++oldIndex;
 
@@ -199,41 +240,66 @@ public:
 			}
 			else
 			{
-				oldState = &snapshotParm.parseEntities[(oldFrame->parseEntitiesNum + oldIndex) % snapshotParm.maxParseEntities];
+				oldState = &parseEntities.get(oldFrame->parseEntitiesNum + oldIndex);
 				oldNum = oldState->number;
 			}
 		}
 	}
 
-	void parseDeltaEntity(MSG& msg, rawSnapshot_t* frame, snapshotParm_t& snapshotParm, uint32_t newNum, const entityState_t* old, bool unchanged) const
+	template<typename Reader>
+	void parseDeltaEntity(Reader& msg, rawSnapshot_t* frame, snapshotParm_t& snapshotParm, uint32_t newNum, const entityState_t* old) const
 	{
-		entityState_t* state = &snapshotParm.parseEntities[snapshotParm.parseEntitiesNum % snapshotParm.maxParseEntities];
+		EntityStateRing& parseEntities = *snapshotParm.parseEntities;
+		entityState_t* state = parseEntities.acquire();
 
-		if (unchanged) {
-			*state = *old;
-		}
-		else {
-			entityParser->readDeltaEntity(msg, old, state, newNum, snapshotParm.deltaTime);
-		}
+		entityParser->readDeltaEntity(msg, old, state, newNum, snapshotParm.deltaTime);
+		++snapshotParm.numDeltaEntities;
 
 		if (state->number == ENTITYNUM_NONE)
 		{
-			// entity was delta removed
+			// entity was delta removed, the state is reused by the next entity
+			return;
+		}
+
+		parseEntities.store(snapshotParm.parseEntitiesNum);
+		addEntity(frame, snapshotParm, *state);
+	}
+
+	void copyEntity(rawSnapshot_t* frame, snapshotParm_t& snapshotParm, uint32_t oldParseNum) const
+	{
+		EntityStateRing& parseEntities = *snapshotParm.parseEntities;
+		const entityState_t& state = parseEntities.get(oldParseNum);
+
+		if (state.number == ENTITYNUM_NONE) {
 			return;
 		}
 
+		// unchanged, reference the same state instead of copying it
+		parseEntities.share(snapshotParm.parseEntitiesNum, oldParseNum);
+		addEntity(frame, snapshotParm, state);
+	}
+
+	void addEntity(rawSnapshot_t* frame, snapshotParm_t& snapshotParm, const entityState_t& state) const
+	{
 		++snapshotParm.parseEntitiesNum;
 		frame->numEntities++;
+
+		if (snapshotParm.entityTable)
+		{
+			// split the entity while it is still hot in cache
+			snapshotParm.entityTable->add(state);
+		}
 	}
 
-	void parseSounds(MSG& msg, rawSnapshot_t* newFrame, const gameState_t& gameState) const
+	template<typename Reader>
+	void parseSounds(Reader& msg, rawSnapshot_t* newFrame, const gameState_t& gameState) const
 	{
 		const bool hasSounds = msg.ReadBool();
 		if (!hasSounds) {
 			return;
 		}
 
-		const uint8_t numSounds = msg.ReadNumber<uint8_t>(7);
+		const uint8_t numSounds = msg.template ReadNumber<uint8_t>(7);
 		if (numSounds > MAX_SERVER_SOUNDS) {
 			return;
 		}
@@ -242,10 +308,12 @@ public:
 
 		const EntityList& entityBaselines = gameState.getEntityBaselines();
 
-		MsgCoordHelper msgHelper(msg);
+		MsgCoordReader<Reader> msgHelper(msg);
 		for (size_t i = 0; i < numSounds; ++i)
 		{
 			sound_t& sound = newFrame->sounds[i];
+			// the snapshot is reused, don't keep values of a previous sound
+			sound = sound_t();
 			sound.hasStopped = msg.ReadBool();
 
 			if (sound.hasStopped)
@@ -253,7 +321,7 @@ public:
 				const uint16_t entityNum = entityParser->readEntityNum(msg);
 				sound.entity = &entityBaselines.getEntity(entityNum);
 
-				const uint8_t channel = msg.ReadNumber<uint8_t>(7);
+				const uint8_t channel = msg.template ReadNumber<uint8_t>(7);
 				sound.channel = channel;
 			}
 			else
@@ -265,17 +333,17 @@ public:
 					msgHelper.ReadVectorFloat(sound.origin);
 				}
 
-				const uint16_t entityNum = msg.ReadNumber<uint16_t>(11);
+				const uint16_t entityNum = msg.template ReadNumber<uint16_t>(11);
 				sound.entity = &entityBaselines.getEntity(entityNum);
 
 				if (entityNum >= MAX_GENTITIES) {
 					throw SerializableErrors::BadEntityNumberException("sound", entityNum);
 				}
 
-				const uint8_t channel = msg.ReadNumber<uint8_t>(7);
+				const uint8_t channel = msg.template ReadNumber<uint8_t>(7);
 				sound.channel = channel;
 
-				const uint16_t soundIndex = msg.ReadNumber<uint16_t>(9);
+				const uint16_t soundIndex = msg.template ReadNumber<uint16_t>(9);
 
 				if (soundIndex < CS::MAX_SOUNDS)
 				{
@@ -3,6 +3,7 @@
 #include "generic_sockets.h"
 
 #include <type_traits>
+#include <algorithm>
 #include <cstring>
 
 using namespace MOHPC;
@@ -24,6 +25,7 @@ class WindowsUDPSocket : public IUdpSocket
 
 public:
 	WindowsUDPSocket(const NetAddr* bindAddress)
+		: broadcastEnabled(false)
 	{
 		if(bindAddress && bindAddress->getAddrSize() != addressSize)
 		{
@@ -78,16 +80,7 @@ public:
 		const uint8_t* inAddr = to->getAddress();
 
 		// check if the address is a broadcast ip
-		if (std::memcmp(inAddr, broadcastIP, addressSize))
-		{
-			int val = 0;
-			setsockopt(conn, SOL_SOCKET, SO_BROADCAST, (const char*)&val, sizeof(val));
-		}
-		else
-		{
-			int val = 1;
-			setsockopt(conn, SOL_SOCKET, SO_BROADCAST, (const char*)&val, sizeof(val));
-		}
+		setBroadcast(!std::memcmp(inAddr, broadcastIP, addressSize));
 
 		sockaddr_in srvAddr{0};
 		srvAddr.sin_family = family;
@@ -107,6 +100,17 @@ public:
 	}
 
 	size_t receive(void* buf, size_t maxsize, NetAddrPtr& from) override
+	{
+		netadr_t fromAddr;
+		const size_t bytesWritten = receive(buf, maxsize, fromAddr);
+
+		// create the corresponding address and return
+		from = fromAddr.allocate();
+
+		return bytesWritten;
+	}
+
+	size_t receive(void* buf, size_t maxsize, netadr_t& from) override
 	{
 		sockaddr_template fromAddr;
 		socklen_t addrSz = sizeof(fromAddr);
@@ -120,22 +124,125 @@ public:
 			&addrSz
 		);
 
-		// create the corresponding address and return
-		from = createAddress(fromAddr);
+		// fill the address in place
+		setAddress(from, fromAddr);
 
 		return bytesWritten;
 	}
 
+#if defined(__linux__)
+	size_t send(const udpMessage_t* messages, size_t count) override
+	{
+		sockaddr_template addrs[MAX_BATCH];
+		iovec iovs[MAX_BATCH];
+		mmsghdr headers[MAX_BATCH];
+
+		size_t numSent = 0;
+		for (size_t i = 0; i < count;)
+		{
+			size_t num = 0;
+			bool broadcast = false;
+			for (; i < count && num < MAX_BATCH; ++i)
+			{
+				const udpMessage_t& message = messages[i];
+				if (message.address.getAddrSize() != addressSize)
+				{
+					// not the same family
+					continue;
+				}
+
+				broadcast |= !std::memcmp(message.address.getAddress(), broadcastIP, addressSize);
+
+				setSockAddress(addrs[num], message.address);
+				iovs[num].iov_base = message.data;
+				iovs[num].iov_len = message.size;
+
+				headers[num] = mmsghdr();
+				headers[num].msg_hdr.msg_name = &addrs[num];
+				headers[num].msg_hdr.msg_namelen = sizeof(addrs[num]);
+				headers[num].msg_hdr.msg_iov = &iovs[num];
+				headers[num].msg_hdr.msg_iovlen = 1;
+				++num;
+			}
+
+			setBroadcast(broadcast);
+
+			// sendmmsg can return before all messages were sent
+			for (size_t offset = 0; offset < num;)
+			{
+				const int result = sendmmsg(conn, headers + offset, (unsigned int)(num - offset), 0);
+				if (result <= 0) {
+					return numSent;
+				}
+
+				offset += result;
+				numSent += result;
+			}
+		}
+
+		return numSent;
+	}
+
+	size_t receive(udpMessage_t* messages, size_t count) override
+	{
+		sockaddr_template addrs[MAX_BATCH];
+		iovec iovs[MAX_BATCH];
+		mmsghdr headers[MAX_BATCH];
+
+		size_t numReceived = 0;
+		while (numReceived < count)
+		{
+			const size_t num = std::min(count - numReceived, MAX_BATCH);
+			for (size_t i = 0; i < num; ++i)
+			{
+				udpMessage_t& message = messages[numReceived + i];
+				iovs[i].iov_base = message.data;
+				iovs[i].iov_len = message.maxSize;
+
+				headers[i] = mmsghdr();
+				headers[i].msg_hdr.msg_name = &addrs[i];
+				headers[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+				headers[i].msg_hdr.msg_iov = &iovs[i];
+				headers[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			const int result = recvmmsg(conn, headers, (unsigned int)num, MSG_DONTWAIT, nullptr);
+			if (result <= 0)
+			{
+				// nothing pending
+				break;
+			}
+
+			for (int i = 0; i < result; ++i)
+			{
+				udpMessage_t& message = messages[numReceived + i];
+				message.size = headers[i].msg_len;
+				setAddress(message.address, addrs[i]);
+			}
+
+			numReceived += result;
+			if ((size_t)result < num)
+			{
+				// no more pending datagram
+				break;
+			}
+		}
+
+		return numReceived;
+	}
+#endif
+
 	virtual bool wait(uint64_t timeout) override
 	{
 		timeval t{0};
-		t.tv_usec = timeout * 1000;
+		t.tv_sec = (long)(timeout / 1000);
+		t.tv_usec = (long)(timeout % 1000) * 1000;
 
 		fd_set readfds;
 		FD_ZERO(&readfds);
 		FD_SET(conn, &readfds);
 
-		int result = select(1, &readfds, NULL, NULL, timeout != -1 ? &t : NULL);
+		int result = select((int)conn + 1, &readfds, NULL, NULL, timeout != -1 ? &t : NULL);
 		return FD_ISSET(conn, &readfds) || dataCount();
 	}
 
@@ -151,10 +258,29 @@ public:
 		return reinterpret_cast<void*>(conn);
 	}
 
-	NetAddrPtr createAddress(const sockaddr_template& addr) const;
+	void setAddress(netadr_t& address, const sockaddr_template& addr) const;
+	void setSockAddress(sockaddr_template& addr, const netadr_t& address) const;
+
+private:
+	void setBroadcast(bool enabled)
+	{
+		if (enabled == broadcastEnabled)
+		{
+			// avoid a syscall for each datagram
+			return;
+		}
+
+		int val = enabled ? 1 : 0;
+		setsockopt(conn, SOL_SOCKET, SO_BROADCAST, (const char*)&val, sizeof(val));
+		broadcastEnabled = enabled;
+	}
 
 private:
+	/** Maximum number of datagrams per system call. */
+	static constexpr size_t MAX_BATCH = 64;
+
 	socket_t conn;
+	bool broadcastEnabled;
 	static uint8_t broadcastIP[addressSize];
 };
 
@@ -165,23 +291,33 @@ template<>
 uint8_t WindowsUDPSocket<addressType_e::IPv6>::broadcastIP[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
 template <>
-NetAddrPtr WindowsUDPSocket<addressType_e::IPv4>::createAddress(const sockaddr_in& addr) const
+void WindowsUDPSocket<addressType_e::IPv4>::setAddress(netadr_t& address, const sockaddr_in& addr) const
 {
-	const NetAddr4Ptr netAddress = NetAddr4::create();
-	std::memcpy(netAddress->ip, &addr.sin_addr, sizeof(netAddress->ip));
-	netAddress->port = htons(addr.sin_port);
+	address.set(addressType_e::IPv4, (const uint8_t*)&addr.sin_addr, htons(addr.sin_port));
+}
 
-	return netAddress;
+template <>
+void WindowsUDPSocket<addressType_e::IPv6>::setAddress(netadr_t& address, const sockaddr_in6& addr) const
+{
+	address.set(addressType_e::IPv6, (const uint8_t*)&addr.sin6_addr, htons(addr.sin6_port));
 }
 
 template <>
-NetAddrPtr WindowsUDPSocket<addressType_e::IPv6>::createAddress(const sockaddr_in6& addr) const
+void WindowsUDPSocket<addressType_e::IPv4>::setSockAddress(sockaddr_in& addr, const netadr_t& address) const
 {
-	const NetAddr6Ptr netAddress = NetAddr6::create();
-	std::memcpy(netAddress->ip, &addr.sin6_addr, sizeof(netAddress->ip));
-	netAddress->port = htons(addr.sin6_port);
+	addr = sockaddr_in();
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(address.getPort());
+	std::memcpy(&addr.sin_addr, address.getAddress(), sizeof(addr.sin_addr));
+}
 
-	return netAddress;
+template <>
+void WindowsUDPSocket<addressType_e::IPv6>::setSockAddress(sockaddr_in6& addr, const netadr_t& address) const
+{
+	addr = sockaddr_in6();
+	addr.sin6_family = AF_INET6;
+	addr.sin6_port = htons(address.getPort());
+	std::memcpy(&addr.sin6_addr, address.getAddress(), sizeof(addr.sin6_addr));
 }
 
 template<addressType_e type>
@@ -275,14 +411,14 @@ public:
 	virtual bool wait(uint64_t timeout) override
 	{
 		timeval t;
-		t.tv_sec = 0;
-		t.tv_usec = timeout * 1000;
+		t.tv_sec = (long)(timeout / 1000);
+		t.tv_usec = (long)(timeout % 1000) * 1000;
 
 		fd_set readfds;
 		FD_ZERO(&readfds);
 		FD_SET(conn, &readfds);
 
-		int result = select(1, &readfds, NULL, NULL, timeout != -1 ? &t : NULL);
+		int result = select((int)conn + 1, &readfds, NULL, NULL, timeout != -1 ? &t : NULL);
 		if (result != 1) {
 			return false;
 		}
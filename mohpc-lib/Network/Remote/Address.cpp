@@ -133,3 +133,91 @@ str NetAddr6::asString() const
 
 	return adrBuf;
 }
+
+netadr_t::netadr_t()
+	: type(addressType_e::IPv4)
+	, port(0)
+	, ip{ 0 }
+{
+}
+
+netadr_t::netadr_t(const NetAddr& address)
+	: netadr_t()
+{
+	const addressType_e addressType = address.getAddrSize() == sizeof(NetAddr6::ip) ? addressType_e::IPv6 : addressType_e::IPv4;
+	set(addressType, address.getAddress(), address.getPort());
+}
+
+addressType_e netadr_t::getType() const
+{
+	return type;
+}
+
+size_t netadr_t::getAddrSize() const
+{
+	return type == addressType_e::IPv6 ? sizeof(NetAddr6::ip) : sizeof(NetAddr4::ip);
+}
+
+const uint8_t* netadr_t::getAddress() const
+{
+	return ip;
+}
+
+uint16_t netadr_t::getPort() const
+{
+	return port;
+}
+
+str netadr_t::asString() const
+{
+	if (type == addressType_e::IPv6)
+	{
+		NetAddr6 address;
+		std::memcpy(address.ip, ip, sizeof(address.ip));
+		address.port = port;
+		return address.asString();
+	}
+	else
+	{
+		NetAddr4 address;
+		std::memcpy(address.ip, ip, sizeof(address.ip));
+		address.port = port;
+		return address.asString();
+	}
+}
+
+void netadr_t::set(addressType_e typeValue, const uint8_t* data, uint16_t portValue)
+{
+	type = typeValue;
+	port = portValue;
+	std::memset(ip, 0, sizeof(ip));
+	std::memcpy(ip, data, getAddrSize());
+}
+
+NetAddrPtr netadr_t::allocate() const
+{
+	if (type == addressType_e::IPv6)
+	{
+		const NetAddr6Ptr address = NetAddr6::create();
+		std::memcpy(address->ip, ip, sizeof(address->ip));
+		address->port = port;
+		return address;
+	}
+	else
+	{
+		const NetAddr4Ptr address = NetAddr4::create();
+		std::memcpy(address->ip, ip, sizeof(address->ip));
+		address->port = port;
+		return address;
+	}
+}
+
+bool netadr_t::operator==(const netadr_t& other) const
+{
+	return type == other.type && port == other.port && !std::memcmp(ip, other.ip, sizeof(ip));
+}
+
+bool netadr_t::operator!=(const netadr_t& other) const
+{
+	return !(*this == other);
+}
@@ -3,11 +3,13 @@
 #include <MOHPC/Network/Remote/Ops.h>
 #include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 #include <MOHPC/Utility/Misc/MSG/Serializable.h>
 #include <MOHPC/Utility/Misc/MSG/Stream.h>
 #include <MOHPC/Utility/Misc/MSG/Codec.h>
 
 #include <cassert>
+#include <utility>
 
 using namespace MOHPC;
 using namespace Network;
@@ -16,6 +18,8 @@ using namespace Network;
 static constexpr unsigned long MAX_PACKETLEN	= 1400u;
 static constexpr unsigned long FRAGMENT_SIZE	= (MAX_PACKETLEN - 100u);
 static constexpr unsigned long FRAGMENT_BIT		= (1u << 31u);
+// max size of a message, once fragments are reassembled
+static constexpr unsigned long MAX_MSGLEN		= 49152u;
 
 INetchan::INetchan(const ICommunicatorPtr& inSocket)
 	: socket(inSocket)
@@ -48,19 +52,59 @@ ICommunicator* Network::INetchan::getRawSocket() const
 	return socket.get();
 }
 
+bool Network::INetchan::hasIncoming()
+{
+	return socket->getIncomingSize() != 0;
+}
+
 uint16_t Network::INetchan::getOutgoingSequence() const
 {
 	return 0;
 }
 
+void Network::INetchan::setMetrics(const NetMetricsPtr& metricsPtr)
+{
+	metrics = metricsPtr;
+}
+
+NetMetrics* Network::INetchan::getMetrics() const
+{
+	return metrics.get();
+}
+
 bool Network::Netchan::receive(IRemoteIdentifierPtr& from, IMessageStream& stream, uint32_t& outSeqNum)
 {
-	uint8_t data[MAX_UDP_DATA_SIZE];
-	
+	DynamicDataMessageStream* const dynStream = dynamic_cast<DynamicDataMessageStream*>(&stream);
+
 	IRemoteIdentifierPtr socketFrom;
-	size_t len = getSocket()->receive(socketFrom, data, sizeof(data));
-	if (len == -1) {
-		return false;
+	size_t len;
+	uint8_t data[MAX_UDP_DATA_SIZE];
+	// the received packet, the header is read from it directly
+	const uint8_t* packet;
+	if (dynStream)
+	{
+		// receive straight into the stream
+		const size_t incomingSize = getSocket()->getIncomingSize();
+		dynStream->clear(false);
+		dynStream->reserve(incomingSize);
+
+		len = getSocket()->receive(socketFrom, dynStream->getStorage(), incomingSize);
+		if (len == -1) {
+			return false;
+		}
+
+		dynStream->Seek(len);
+		packet = dynStream->getStorage();
+	}
+	else
+	{
+		len = getSocket()->receive(socketFrom, data, sizeof(data));
+		if (len == -1) {
+			return false;
+		}
+
+		stream.Write(data, len);
+		packet = data;
 	}
 
 	if (from && *socketFrom != *from)
@@ -71,12 +115,15 @@ bool Network::Netchan::receive(IRemoteIdentifierPtr& from, IMessageStream& strea
 
 	from = socketFrom;
 
-	stream.Write(data, len);
-	stream.Seek(0);
-
-	MSG msgRead(stream, msgMode_e::Reading);
+	NetMetrics* const metrics = getMetrics();
+	if (metrics)
+	{
+		metrics->add(netMetric_e::PacketsIn);
+		metrics->add(netMetric_e::BytesIn, len);
+	}
 
-	msgRead.SetCodec(MessageCodecs::OOB);
+	// the header is made of raw bytes
+	MSGBufferReader<MessageCodecs::OOBPolicy> msgRead(packet, len);
 
 	// Read the sequence num
 	uint32_t sequenceNum = msgRead.ReadUInteger();
@@ -110,14 +157,18 @@ bool Network::Netchan::receive(IRemoteIdentifierPtr& from, IMessageStream& strea
 	}
 
 	// discard out of order or duplicated packets
-	if (sequenceNum < incomingSequence) {
+	if (sequenceNum < incomingSequence)
+	{
+		if (metrics) metrics->add(netMetric_e::OutOfOrderPackets);
 		return false;
 	}
 
 	dropped = sequenceNum - (incomingSequence + 1);
 	if (fragmented)
 	{
-		if (sequenceNum != fragmentSequence)
+		if (metrics) metrics->add(netMetric_e::FragmentsIn);
+
+		if (sequenceNum != fragmentSequence || !fragmentStream.GetLength())
 		{
 			// received sequence number must match with the current fragment sequence
 			// otherwise it's a new unrelated packet
@@ -125,7 +176,8 @@ bool Network::Netchan::receive(IRemoteIdentifierPtr& from, IMessageStream& strea
 			clearFragment();
 		}
 
-		const size_t currentFragmentLength = fragmentStream.GetLength();
+		// the fragment stream starts with room for the sequence number
+		const size_t currentFragmentLength = fragmentStream.GetLength() - sizeof(uint32_t);
 
 		if (fragmentStart != currentFragmentLength)
 		{
@@ -138,38 +190,45 @@ bool Network::Netchan::receive(IRemoteIdentifierPtr& from, IMessageStream& strea
 			throw BadFragmentLengthException(fragmentLength);
 		}
 
+		// only grows if the message is larger than the maximum message length
+		fragmentStream.reserve(fragmentStream.GetLength() + fragmentLength);
+
+		// copy the fragment from the packet at the end of the message
 		stream.Seek(msgRead.GetPosition());
-		//stream.Read(fragmentBuffer + this->fragmentLength, fragmentLength);
-		fragmentStream.Seek(fragmentLength);
-		fragmentStream.Seek(currentFragmentLength);
-		streamHelpers::Copy<FRAGMENT_SIZE>(fragmentStream, stream, fragmentLength + stream.GetPosition());
+		stream.Read(fragmentStream.getStorage() + fragmentStream.GetLength(), fragmentLength);
+		fragmentStream.Seek(fragmentStream.GetLength() + fragmentLength);
 
 		if (fragmentLength == FRAGMENT_SIZE) {
 			return false;
 		}
 
-		// seek to preallocate
-		stream.Seek(fragmentStream.GetLength());
-		// reset position to create a message
-		stream.Seek(0);
+		// write the sequence number in front of the message, like an unfragmented packet
+		fragmentStream.Seek(0);
+		writePacketServerHeader(fragmentStream, sequenceNum);
 
-		// write all necessary stuff
-		writePacketServerHeader(stream, sequenceNum);
+		if (dynStream)
+		{
+			// give the message to the caller without copying it,
+			// its previous buffer is reused for the next fragmented message
+			std::swap(*dynStream, fragmentStream);
+		}
+		else
+		{
+			stream.Seek(0);
+			stream.Write(fragmentStream.getStorage(), fragmentStream.GetLength());
+			stream.Seek(fragmentStream.GetPosition());
+		}
 
-		// save the initial position
-		const size_t savedPos = stream.GetPosition();
-		// set the fragment to the beginning and copy it to the message stream
-		fragmentStream.Seek(0);
-		streamHelpers::Copy<FRAGMENT_SIZE>(stream, fragmentStream, fragmentStream.GetLength());
-		// return to the beginning of the message
-		stream.Seek(savedPos);
-		// now get rid of the fragment buffer
 		clearFragment();
 	}
 	else {
 		stream.Seek(msgRead.GetPosition());
 	}
 
+	if (metrics && sequenceNum > incomingSequence && dropped) {
+		metrics->add(netMetric_e::DroppedPackets, dropped);
+	}
+
 	if (sequenceNum != -1) incomingSequence = sequenceNum;
 
 	return true;
@@ -216,6 +275,13 @@ bool Network::Netchan::transmit(const IRemoteIdentifier& to, IMessageStream& str
 		// send the packet now
 		getSocket()->send(to, newStream.getStorage(), newStream.GetLength());
 
+		NetMetrics* const metrics = getMetrics();
+		if (metrics)
+		{
+			metrics->add(netMetric_e::PacketsOut);
+			metrics->add(netMetric_e::BytesOut, newStream.GetLength());
+		}
+
 		++outgoingSequence;
 	}
 
@@ -254,6 +320,14 @@ void Netchan::transmitNextFragment(const IRemoteIdentifier& to, IMessageStream&
 	const uint8_t* sendBuf = outputPacket.getStorage();
 	getSocket()->send(to, sendBuf, outputPacket.GetLength());
 
+	NetMetrics* const metrics = getMetrics();
+	if (metrics)
+	{
+		metrics->add(netMetric_e::PacketsOut);
+		metrics->add(netMetric_e::FragmentsOut);
+		metrics->add(netMetric_e::BytesOut, outputPacket.GetLength());
+	}
+
 	unsentFragmentStart += fragmentLength;
 
 	// this exit condition is a little tricky, because a packet
@@ -284,8 +358,11 @@ void Netchan::writePacketServerHeader(IMessageStream& stream, uint32_t sequenceN
 
 void Netchan::clearFragment()
 {
-	// free memory if it's above the max message size
-	fragmentStream.clear(true);
+	// keep the buffer, so fragments are reassembled without reallocating
+	fragmentStream.clear(false);
+	fragmentStream.reserve(sizeof(uint32_t) + MAX_MSGLEN);
+	// leave room for the sequence number, written once the message is complete
+	fragmentStream.Seek(sizeof(uint32_t));
 }
 
 void MOHPC::Network::Netchan::writePacketHeader(IMessageStream& stream, bool fragmented)
@@ -4,57 +4,142 @@
 #include <MOHPC/Utility/Misc/MSG/Codec.h>
 #include <MOHPC/Utility/Misc/MSG/Stream.h>
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOHPC_XOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
 using namespace MOHPC;
 using namespace Network;
 
-uint32_t XORKeyIndex(size_t i, size_t& index, const uint8_t* string)
+/** Number of bytes read from the stream at once. */
+static constexpr size_t XOR_CHUNK_SIZE = 256;
+
+/**
+ * Fill characters of the command string used for each byte, starting at the specified index.
+ * The string is repeated, and characters that are not allowed are replaced with '.'.
+ */
+static void XORFillChars(const uint8_t* string, size_t stringLen, size_t& index, uint8_t* chars, size_t count)
 {
-	if (!string[index]) {
-		index = 0;
+	for (size_t filled = 0; filled < count;)
+	{
+		const size_t num = std::min(stringLen - index, count - filled);
+		std::memcpy(chars + filled, string + index, num);
+
+		filled += num;
+		index += num;
+		if (index == stringLen) index = 0;
 	}
 
-	if (string[index] > 127 || string[index] == '%') {
-		return ('.' << (i & 1));
+	size_t i = 0;
+#if MOHPC_XOR_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i percent = _mm_set1_epi8('%');
+	const __m128i dot = _mm_set1_epi8('.');
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(chars + i));
+		// characters above 127 are negative as signed
+		const __m128i replace = _mm_or_si128(_mm_cmplt_epi8(c, zero), _mm_cmpeq_epi8(c, percent));
+		const __m128i result = _mm_or_si128(_mm_and_si128(replace, dot), _mm_andnot_si128(replace, c));
+		_mm_storeu_si128((__m128i*)(chars + i), result);
 	}
-	else {
-		return (string[index] << (i & 1));
+#endif
+
+	for (; i < count; ++i)
+	{
+		if (chars[i] > 127 || chars[i] == '%') {
+			chars[i] = '.';
+		}
 	}
 }
 
-void XORValues(uint32_t key, const uint8_t* string, size_t len, IMessageStream& in, IMessageStream& out)
+/**
+ * XOR bytes with the key. The key is combined with the character of each byte before it is used,
+ * characters are shifted by one bit on odd positions.
+ *
+ * @param data		Bytes to convert.
+ * @param chars		Character of each byte.
+ * @param count		Number of bytes.
+ * @param position	Position of the first byte in the message.
+ * @param key		The current key, receive the key after the last byte.
+ */
+static void XORBlock(uint8_t* data, const uint8_t* chars, size_t count, size_t position, uint8_t& key)
 {
-	size_t index = 0;
+	size_t i = 0;
+
+#if MOHPC_XOR_SSE2
+	// select bytes at odd positions of the message
+	const __m128i oddMask = (position & 1)
+		? _mm_set1_epi16(0x00FF)
+		: _mm_set1_epi16((short)0xFF00);
 
-	for (size_t i = in.GetPosition(); i < len; ++i, ++index)
+	__m128i carry = _mm_set1_epi8((char)key);
+	for (; i + 16 <= count; i += 16)
 	{
-		key ^= XORKeyIndex(i, index, string);
+		__m128i c = _mm_loadu_si128((const __m128i*)(chars + i));
+		// shift characters on odd positions (c << 1 == c + c)
+		c = _mm_add_epi8(c, _mm_and_si128(c, oddMask));
+
+		// prefix XOR, each byte gets the XOR of all previous characters of the block
+		c = _mm_xor_si128(c, _mm_slli_si128(c, 1));
+		c = _mm_xor_si128(c, _mm_slli_si128(c, 2));
+		c = _mm_xor_si128(c, _mm_slli_si128(c, 4));
+		c = _mm_xor_si128(c, _mm_slli_si128(c, 8));
+
+		// combine with the key from previous blocks
+		const __m128i keys = _mm_xor_si128(c, carry);
+		const __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+		_mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(value, keys));
+
+		// the key of the last byte is used by the next block
+		carry = _mm_srli_si128(keys, 15);
+		carry = _mm_unpacklo_epi8(carry, carry);
+		carry = _mm_unpacklo_epi16(carry, carry);
+		carry = _mm_shuffle_epi32(carry, 0);
+	}
+
+	key = (uint8_t)_mm_cvtsi128_si32(carry);
+#endif
 
-		uint8_t byteValue;
-		in.Read(&byteValue, sizeof(byteValue));
-		// XOR the value with the key
-		byteValue ^= key;
-		out.Write(&byteValue, sizeof(byteValue));
+	for (; i < count; ++i)
+	{
+		key ^= chars[i] << ((position + i) & 1);
+		data[i] ^= key;
 	}
 }
 
-void XORValues(uint32_t key, const uint8_t* string, size_t len, IMessageStream& stream)
+static void XORValues(uint8_t key, const uint8_t* string, size_t start, size_t len, IMessageStream& in, IMessageStream& out)
 {
+	const bool inPlace = &in == &out;
+	// the index is reset when reaching the terminating character, but the first character is always used,
+	// so an empty string continues with what remains in the buffer after it
+	const size_t stringLen = 1 + std::strlen((const char*)string + 1);
 	size_t index = 0;
 
-	for (size_t i = stream.GetPosition(); i < len; ++i, ++index)
+	uint8_t data[XOR_CHUNK_SIZE];
+	uint8_t chars[XOR_CHUNK_SIZE];
+
+	for (size_t pos = start; pos < len;)
 	{
-		key ^= XORKeyIndex(i, index, string);
-
-		uint8_t byteValue;
-		stream.Read(&byteValue, sizeof(byteValue));
-		// XOR the value with the key
-		byteValue ^= key;
-		stream.Seek(i);
-		stream.Write(&byteValue, sizeof(byteValue));
+		const size_t count = std::min(len - pos, XOR_CHUNK_SIZE);
+
+		in.Read(data, count);
+		XORFillChars(string, stringLen, index, chars, count);
+		XORBlock(data, chars, count, pos, key);
+
+		if (inPlace) {
+			out.Seek(pos);
+		}
+		out.Write(data, count);
+
+		pos += count;
 	}
 }
 
-
 XOREncoding::XOREncoding(uint32_t challengeValue, const IAbstractSequence& remoteCommandsValue)
 	: challenge(challengeValue)
 	, remoteCommands(remoteCommandsValue)
@@ -74,15 +159,14 @@ void XOREncoding::convert(IMessageStream& in, IMessageStream& out)
 	// xor the client challenge with the netchan sequence number
 	uint8_t key = challenge ^ secretKey ^ messageAcknowledge;
 	// encode the message
+	XORValues(key, string, savedPos, len, in, out);
+
 	if (&in != &out)
 	{
-		XORValues(key, string, len, in, out);
 		// Seek to the start of the message
 		out.Seek(0);
 	}
-	else
-	{
-		XORValues(key, string, len, out);
+	else {
 		out.Seek(savedPos);
 	}
 }
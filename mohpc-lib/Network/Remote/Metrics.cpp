@@ -0,0 +1,179 @@
+#include <MOHPC/Network/Remote/Metrics.h>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+static const char* metricNames[] =
+{
+	"packets_in",
+	"bytes_in",
+	"packets_out",
+	"bytes_out",
+	"fragments_in",
+	"fragments_out",
+	"dropped_packets",
+	"out_of_order_packets",
+	"messages",
+	"huffman_bytes",
+	"snapshots",
+	"snapshot_parse_time_us",
+	"delta_entities"
+};
+static_assert(sizeof(metricNames) / sizeof(metricNames[0]) == (size_t)netMetric_e::Max, "Missing metric names");
+
+static const char* opNames[] =
+{
+	"bad",
+	"nop",
+	"gamestate",
+	"configstring",
+	"baseline",
+	"servercommand",
+	"download",
+	"snapshot",
+	"centerprint",
+	"locprint",
+	"cgamemessage",
+	"eof"
+};
+static_assert(sizeof(opNames) / sizeof(opNames[0]) == NUM_SVC_OPS, "Missing operation names");
+
+netMetricsSnapshot_t::netMetricsSnapshot_t()
+	: values{ 0 }
+	, dispatchCount{ 0 }
+	, dispatchTime{ 0 }
+{
+}
+
+uint64_t netMetricsSnapshot_t::get(netMetric_e metric) const
+{
+	return values[(size_t)metric];
+}
+
+str netMetricsSnapshot_t::toJSON() const
+{
+	str result = "{";
+
+	for (size_t i = 0; i < (size_t)netMetric_e::Max; ++i)
+	{
+		result += "\"";
+		result += metricNames[i];
+		result += "\":";
+		result += std::to_string(values[i]);
+		result += ",";
+	}
+
+	result += "\"dispatch\":{";
+	for (size_t i = 0; i < NUM_SVC_OPS; ++i)
+	{
+		if (i) result += ",";
+
+		result += "\"";
+		result += opNames[i];
+		result += "\":{\"count\":";
+		result += std::to_string(dispatchCount[i]);
+		result += ",\"time_us\":";
+		result += std::to_string(dispatchTime[i]);
+		result += "}";
+	}
+	result += "}}";
+
+	return result;
+}
+
+static void writePrometheusValue(str& result, const char* prefix, const char* name, const char* labels, const char* extraLabel, uint64_t value)
+{
+	result += prefix;
+	result += name;
+	if ((labels && *labels) || extraLabel)
+	{
+		result += "{";
+		if (labels && *labels)
+		{
+			result += labels;
+			if (extraLabel) result += ",";
+		}
+		if (extraLabel) result += extraLabel;
+		result += "}";
+	}
+	result += " ";
+	result += std::to_string(value);
+	result += "\n";
+}
+
+str netMetricsSnapshot_t::toPrometheus(const char* prefix, const char* labels) const
+{
+	str result;
+
+	for (size_t i = 0; i < (size_t)netMetric_e::Max; ++i)
+	{
+		// counters are suffixed with _total
+		const str name = str(metricNames[i]) + "_total";
+
+		result += "# TYPE ";
+		result += prefix;
+		result += name;
+		result += " counter\n";
+		writePrometheusValue(result, prefix, name.c_str(), labels, nullptr, values[i]);
+	}
+
+	const char* dispatchNames[] = { "dispatch_total", "dispatch_time_us_total" };
+	const uint64_t* dispatchValues[] = { dispatchCount, dispatchTime };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		result += "# TYPE ";
+		result += prefix;
+		result += dispatchNames[i];
+		result += " counter\n";
+
+		for (size_t op = 0; op < NUM_SVC_OPS; ++op)
+		{
+			const str opLabel = str("op=\"") + opNames[op] + "\"";
+			writePrometheusValue(result, prefix, dispatchNames[i], labels, opLabel.c_str(), dispatchValues[i][op]);
+		}
+	}
+
+	return result;
+}
+
+MOHPC_OBJECT_DEFINITION(NetMetrics);
+
+NetMetrics::NetMetrics()
+{
+	reset();
+}
+
+uint64_t NetMetrics::get(netMetric_e metric) const
+{
+	return values[(size_t)metric].load(std::memory_order_relaxed);
+}
+
+netMetricsSnapshot_t NetMetrics::snapshot() const
+{
+	netMetricsSnapshot_t result;
+
+	for (size_t i = 0; i < (size_t)netMetric_e::Max; ++i) {
+		result.values[i] = values[i].load(std::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < NUM_SVC_OPS; ++i)
+	{
+		result.dispatchCount[i] = dispatchCount[i].load(std::memory_order_relaxed);
+		result.dispatchTime[i] = dispatchTime[i].load(std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+void NetMetrics::reset()
+{
+	for (size_t i = 0; i < (size_t)netMetric_e::Max; ++i) {
+		values[i].store(0, std::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < NUM_SVC_OPS; ++i)
+	{
+		dispatchCount[i].store(0, std::memory_order_relaxed);
+		dispatchTime[i].store(0, std::memory_order_relaxed);
+	}
+}
@@ -12,6 +12,48 @@ MOHPC::Network::ISocketFactory* MOHPC::Network::ISocketFactory::get()
 	return socketFactory.lock().get();
 }
 
+size_t MOHPC::Network::IUdpSocket::receive(void* buf, size_t maxsize, netadr_t& from)
+{
+	NetAddrPtr fromPtr;
+	const size_t len = receive(buf, maxsize, fromPtr);
+	from = fromPtr ? netadr_t(*fromPtr) : netadr_t();
+
+	return len;
+}
+
+size_t MOHPC::Network::IUdpSocket::send(const udpMessage_t* messages, size_t count)
+{
+	size_t numSent = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const udpMessage_t& message = messages[i];
+		const NetAddrPtr to = message.address.allocate();
+		if (to && send(to, message.data, message.size) != -1) {
+			++numSent;
+		}
+	}
+
+	return numSent;
+}
+
+size_t MOHPC::Network::IUdpSocket::receive(udpMessage_t* messages, size_t count)
+{
+	size_t numReceived = 0;
+	while (numReceived < count && wait(0))
+	{
+		udpMessage_t& message = messages[numReceived];
+		const size_t len = receive(message.data, message.maxSize, message.address);
+		if (len == -1) {
+			break;
+		}
+
+		message.size = len;
+		++numReceived;
+	}
+
+	return numReceived;
+}
+
 void MOHPC::Network::ISocketFactory::set(const ISocketFactoryWeakPtr& newFactory)
 {
 	if (!newFactory.expired()) {
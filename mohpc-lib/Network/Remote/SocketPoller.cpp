@@ -0,0 +1,186 @@
+#include <MOHPC/Network/Remote/SocketPoller.h>
+#include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
+#include <MOHPC/Network/Remote/TCPMessageDispatcher.h>
+#include "../Platform/generic_sockets.h"
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <climits>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+MOHPC_OBJECT_DEFINITION(SocketPoller);
+
+static ISocketPtr getCommSocket(ICommunicator& comm)
+{
+	if (UDPCommunicator* udpComm = dynamic_cast<UDPCommunicator*>(&comm)) {
+		return udpComm->getSocket();
+	}
+	else if (TCPCommunicator* tcpComm = dynamic_cast<TCPCommunicator*>(&comm)) {
+		return tcpComm->getSocket();
+	}
+
+	return nullptr;
+}
+
+static socket_t getRawSocket(const ISocketPtr& socket)
+{
+	return static_cast<socket_t>(reinterpret_cast<uintptr_t>(socket->getRaw()));
+}
+
+#if defined(__linux__)
+
+SocketPoller::SocketPoller()
+{
+	pollHandle = epoll_create1(EPOLL_CLOEXEC);
+}
+
+SocketPoller::~SocketPoller()
+{
+	if (pollHandle != -1) {
+		close((int)pollHandle);
+	}
+}
+
+bool SocketPoller::add(ICommunicator& comm)
+{
+	const ISocketPtr socket = getCommSocket(comm);
+	if (pollHandle == -1 || !socket || !socket->isPollable()) {
+		return false;
+	}
+
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.ptr = &comm;
+	if (epoll_ctl((int)pollHandle, EPOLL_CTL_ADD, getRawSocket(socket), &ev) == -1) {
+		return false;
+	}
+
+	watched.push_back(watched_t{ &comm, socket });
+	return true;
+}
+
+void SocketPoller::remove(ICommunicator& comm)
+{
+	for (auto it = watched.begin(); it != watched.end(); ++it)
+	{
+		if (it->comm == &comm)
+		{
+			epoll_ctl((int)pollHandle, EPOLL_CTL_DEL, getRawSocket(it->socket), nullptr);
+			watched.erase(it);
+			break;
+		}
+	}
+}
+
+size_t SocketPoller::wait(ICommunicator* ready[], size_t maxReady, uint64_t timeout)
+{
+	static constexpr size_t MAX_EVENTS = 64;
+
+	if (pollHandle == -1 || !maxReady) {
+		return 0;
+	}
+
+	epoll_event events[MAX_EVENTS];
+	const int numEvents = (int)std::min(maxReady, MAX_EVENTS);
+	const int waitTime = timeout != -1 ? (int)std::min<uint64_t>(timeout, INT_MAX) : -1;
+
+	const int result = epoll_wait((int)pollHandle, events, numEvents, waitTime);
+	if (result <= 0)
+	{
+		// timed out or interrupted
+		return 0;
+	}
+
+	for (int i = 0; i < result; ++i) {
+		ready[i] = static_cast<ICommunicator*>(events[i].data.ptr);
+	}
+
+	return result;
+}
+
+#else
+
+SocketPoller::SocketPoller()
+	: pollHandle(-1)
+{
+}
+
+SocketPoller::~SocketPoller()
+{
+}
+
+bool SocketPoller::add(ICommunicator& comm)
+{
+	const ISocketPtr socket = getCommSocket(comm);
+	if (!socket || !socket->isPollable() || watched.size() >= FD_SETSIZE) {
+		return false;
+	}
+
+#ifndef _WIN32
+	if (getRawSocket(socket) >= FD_SETSIZE)
+	{
+		// can't be set in a fd_set
+		return false;
+	}
+#endif
+
+	watched.push_back(watched_t{ &comm, socket });
+	return true;
+}
+
+void SocketPoller::remove(ICommunicator& comm)
+{
+	for (auto it = watched.begin(); it != watched.end(); ++it)
+	{
+		if (it->comm == &comm)
+		{
+			watched.erase(it);
+			break;
+		}
+	}
+}
+
+size_t SocketPoller::wait(ICommunicator* ready[], size_t maxReady, uint64_t timeout)
+{
+	if (watched.empty() || !maxReady) {
+		return 0;
+	}
+
+	timeval t;
+	t.tv_sec = (long)(timeout / 1000);
+	t.tv_usec = (long)(timeout % 1000) * 1000;
+
+	fd_set readfds;
+	FD_ZERO(&readfds);
+
+	socket_t maxSocket = 0;
+	for (const watched_t& entry : watched)
+	{
+		const socket_t conn = getRawSocket(entry.socket);
+		FD_SET(conn, &readfds);
+		maxSocket = std::max(maxSocket, conn);
+	}
+
+	const int result = select((int)maxSocket + 1, &readfds, NULL, NULL, timeout != -1 ? &t : NULL);
+	if (result <= 0) {
+		return 0;
+	}
+
+	size_t numReady = 0;
+	for (size_t i = 0; i < watched.size() && numReady < maxReady; ++i)
+	{
+		if (FD_ISSET(getRawSocket(watched[i].socket), &readfds)) {
+			ready[numReady++] = watched[i].comm;
+		}
+	}
+
+	return numReady;
+}
+
+#endif
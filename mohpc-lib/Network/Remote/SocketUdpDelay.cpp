@@ -212,6 +212,12 @@ void* UdpSocketSimLatency::getRaw()
 	return originalSocket->getRaw();
 }
 
+bool UdpSocketSimLatency::isPollable() const
+{
+	// the original socket is read by the incoming thread
+	return false;
+}
+
 PacketContainer& UdpSocketSimLatency::waitIncoming(std::unique_lock<std::mutex>& lk)
 {
 	if (incomings.empty())
@@ -536,6 +542,12 @@ void* UdpSocketSimLoss::getRaw()
 	return originalSocket->getRaw();
 }
 
+bool UdpSocketSimLoss::isPollable() const
+{
+	// incoming packets may be dropped after the original socket was signaled
+	return false;
+}
+
 void UdpSocketSimLoss::setInboundPacketLossAlpha(float alpha)
 {
 	inboundLossAlpha = alpha;
@@ -63,3 +63,8 @@ const MOHPC::IRemoteIdentifierPtr& TCPCommunicator::getRemoteIdentifier() const
 {
 	return remoteId;
 }
+
+const ITcpSocketPtr& TCPCommunicator::getSocket() const
+{
+	return socket;
+}
@@ -0,0 +1,191 @@
+#include <MOHPC/Network/Remote/ThreadedChannel.h>
+
+#include <utility>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+// the I/O thread blocks on the socket, this is the maximum time to notice the channel is being destroyed
+static constexpr uint64_t IO_WAIT_TIME = 100;
+
+MOHPC_OBJECT_DEFINITION(ThreadedNetchan);
+
+ThreadedNetchan::ThreadedNetchan(const INetchanPtr& inNetchan, const IRemoteIdentifierPtr& inRemote)
+	: INetchan(inNetchan->getSocket())
+	, netchan(inNetchan)
+	, remote(inRemote)
+	, incoming(QUEUE_SIZE)
+	, freeIncoming(QUEUE_SIZE)
+	, spareIncoming(nullptr)
+	, ioWaiting(false)
+	, stopping(false)
+{
+	// all packets are allocated once and move between queues
+	packets.reserve(QUEUE_SIZE);
+	for (size_t i = 0; i < QUEUE_SIZE; ++i)
+	{
+		packets.push_back(std::make_unique<packet_t>());
+		freeIncoming.push(packets.back().get());
+	}
+
+	thread = std::thread(&ThreadedNetchan::ioThread, this);
+}
+
+ThreadedNetchan::~ThreadedNetchan()
+{
+	{
+		std::lock_guard<std::mutex> lock(waitMutex);
+		stopping.store(true, std::memory_order_release);
+	}
+	freeCondition.notify_one();
+
+	thread.join();
+}
+
+bool ThreadedNetchan::receive(IRemoteIdentifierPtr& from, IMessageStream& stream, uint32_t& sequenceNum)
+{
+	packet_t* packet;
+	if (!incoming.pop(packet)) {
+		return false;
+	}
+
+	const std::exception_ptr error = std::move(packet->error);
+	packet->error = nullptr;
+
+	if (!error)
+	{
+		DynamicDataMessageStream* const dynStream = dynamic_cast<DynamicDataMessageStream*>(&stream);
+		if (dynStream)
+		{
+			// exchange buffers instead of copying, the packet gets the previous buffer of the stream
+			std::swap(*dynStream, packet->stream);
+		}
+		else {
+			stream.Write(packet->stream.getStorage(), packet->stream.GetLength());
+		}
+
+		// start after the header, like the channel did
+		stream.Seek(packet->position);
+		sequenceNum = packet->sequenceNum;
+		from = remote;
+	}
+
+	freeIncoming.push(packet);
+
+	// pairs with the fence of waitFreePacket(), so either the I/O thread sees the packet or it is seen waiting
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (ioWaiting.load(std::memory_order_relaxed))
+	{
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+		}
+		freeCondition.notify_one();
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	return true;
+}
+
+bool ThreadedNetchan::transmit(const IRemoteIdentifier& to, IMessageStream& stream)
+{
+	// sending a datagram doesn't block, so it's not worth going through the I/O thread
+	std::lock_guard<std::mutex> lock(channelMutex);
+	return netchan->transmit(to, stream);
+}
+
+bool ThreadedNetchan::hasIncoming()
+{
+	return !incoming.empty();
+}
+
+uint16_t ThreadedNetchan::getOutgoingSequence() const
+{
+	// only changed by transmit(), from the calling thread
+	return netchan->getOutgoingSequence();
+}
+
+void ThreadedNetchan::setMetrics(const NetMetricsPtr& metricsPtr)
+{
+	// packets are counted by the wrapped channel from both threads, counters are atomic
+	INetchan::setMetrics(metricsPtr);
+
+	std::lock_guard<std::mutex> lock(channelMutex);
+	netchan->setMetrics(metricsPtr);
+}
+
+void ThreadedNetchan::ioThread()
+{
+	ICommunicator* const comm = netchan->getRawSocket();
+
+	while (!stopping.load(std::memory_order_acquire))
+	{
+		if (comm->waitIncoming(IO_WAIT_TIME) && !receivePending())
+		{
+			// keep remaining datagrams in the socket until some packets are consumed
+			waitFreePacket();
+		}
+	}
+}
+
+bool ThreadedNetchan::receivePending()
+{
+	ICommunicator* const comm = netchan->getRawSocket();
+
+	packet_t*& packet = spareIncoming;
+	for (;;)
+	{
+		if (!packet && !freeIncoming.pop(packet))
+		{
+			// all packets are waiting to be processed
+			return false;
+		}
+
+		packet->stream.clear(false);
+
+		IRemoteIdentifierPtr from = remote;
+		bool received;
+		{
+			std::lock_guard<std::mutex> lock(channelMutex);
+			if (!comm->getIncomingSize()) {
+				return true;
+			}
+
+			try
+			{
+				received = netchan->receive(from, packet->stream, packet->sequenceNum);
+			}
+			catch (...)
+			{
+				// let the receiver handle it
+				packet->error = std::current_exception();
+				received = true;
+			}
+		}
+
+		if (received)
+		{
+			packet->position = packet->stream.GetPosition();
+			incoming.push(packet);
+			packet = nullptr;
+		}
+	}
+}
+
+void ThreadedNetchan::waitFreePacket()
+{
+	ioWaiting.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	{
+		std::unique_lock<std::mutex> lock(waitMutex);
+		freeCondition.wait(lock, [this]
+		{
+			return !freeIncoming.empty() || stopping.load(std::memory_order_acquire);
+		});
+	}
+
+	ioWaiting.store(false, std::memory_order_relaxed);
+}
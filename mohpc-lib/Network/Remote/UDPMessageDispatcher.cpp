@@ -1,6 +1,9 @@
 #include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
 #include <MOHPC/Network/Remote/Socket.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace MOHPC;
 using namespace MOHPC::Network;
 
@@ -8,6 +11,9 @@ MOHPC_OBJECT_DEFINITION(UDPCommunicator);
 
 UDPCommunicator::UDPCommunicator(const IUdpSocketPtr& inSocket)
 	: socket(inSocket ? inSocket : ISocketFactory::get()->createUdp())
+	, batch()
+	, batchCount(0)
+	, batchIndex(0)
 {
 }
 
@@ -33,23 +39,79 @@ size_t UDPCommunicator::receive(IRemoteIdentifierPtr& remoteAddress, uint8_t* da
 		return 0;
 	}
 
-	NetAddrPtr addressPtr;
-	size_t result = socket->receive(data, size, addressPtr);
-	if(addressPtr)
+	if (batchIndex < batchCount)
+	{
+		// consume the next datagram of the batch
+		const udpMessage_t& message = batch[batchIndex++];
+		const size_t result = std::min(message.size, size);
+		std::memcpy(data, message.data, result);
+
+		remoteAddress = getIdentifier(message.address);
+		return result;
+	}
+
+	netadr_t address;
+	size_t result = socket->receive(data, size, address);
+	if(result != -1)
 	{
 		// set the remote identifier from the ip address and return
-		remoteAddress = makeShared<IPRemoteIdentifier>(addressPtr);
+		remoteAddress = getIdentifier(address);
 	}
 
 	return result != -1 ? result : 0;
 }
 
+const IRemoteIdentifierPtr& UDPCommunicator::getIdentifier(const netadr_t& address)
+{
+	size_t hash = address.getPort();
+	const uint8_t* ip = address.getAddress();
+	for (size_t i = 0; i < address.getAddrSize(); ++i) {
+		hash = hash * 31 + ip[i];
+	}
+
+	cachedIdentifier_t& cached = cachedIdentifiers[hash % NUM_CACHED_IDENTIFIERS];
+	if (!cached.identifier || cached.address != address)
+	{
+		// only allocate for addresses that weren't seen recently
+		cached.address = address;
+		cached.identifier = makeShared<IPRemoteIdentifier>(address.allocate());
+	}
+
+	return cached.identifier;
+}
+
+bool UDPCommunicator::fetchBatch()
+{
+	if (batchIndex < batchCount) {
+		return true;
+	}
+
+	if (batchBuffer.empty())
+	{
+		// the game never sends datagrams larger than this, larger messages are fragmented
+		batchBuffer.resize(BATCH_SIZE * MAX_GAME_DATAGRAM_SIZE);
+		for (size_t i = 0; i < BATCH_SIZE; ++i)
+		{
+			batch[i].data = batchBuffer.data() + i * MAX_GAME_DATAGRAM_SIZE;
+			batch[i].maxSize = MAX_GAME_DATAGRAM_SIZE;
+		}
+	}
+
+	batchIndex = 0;
+	batchCount = socket->receive(batch, BATCH_SIZE);
+	return batchCount > 0;
+}
+
 size_t UDPCommunicator::getIncomingSize()
 {
 	if (!socket) {
 		return 0;
 	}
 
+	if (fetchBatch()) {
+		return batch[batchIndex].size;
+	}
+
 	return socket->dataCount();
 }
 
@@ -59,6 +121,12 @@ bool UDPCommunicator::waitIncoming(uint64_t timeout)
 		return false;
 	}
 
+	if (batchIndex < batchCount)
+	{
+		// datagrams were already received
+		return true;
+	}
+
 	if(timeout)
 	{
 		// call wait if there is a timeout value
@@ -92,14 +160,19 @@ size_t UDPBroadcastCommunicator::send(const IRemoteIdentifier& identifier, const
 	}
 
 	// ignore the identifier and do a broadcast instead
-	NetAddr4Ptr addr = NetAddr4::create();
-	addr->setIp(-1, -1, -1, -1);
+	static const uint8_t broadcastIP[] = { 0xFF, 0xFF, 0xFF, 0xFF };
 
+	std::vector<udpMessage_t> messages(endPort > startPort ? endPort - startPort : 0);
 	for (uint16_t i = startPort; i < endPort; ++i)
 	{
-		addr->setPort(i);
-		socket->send(addr, data, size);
+		udpMessage_t& message = messages[i - startPort];
+		message.data = const_cast<uint8_t*>(data);
+		message.size = size;
+		message.address.set(addressType_e::IPv4, broadcastIP, i);
 	}
 
+	// send to all ports at once
+	socket->send(messages.data(), messages.size());
+
 	return 0;
 }
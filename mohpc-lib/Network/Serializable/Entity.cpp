@@ -5,15 +5,17 @@
 #include <MOHPC/Network/Types/Entity.h>
 
 #include <MOHPC/Utility/Misc/MSG/MSGCoord.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 
+#include <cstddef>
 #include <cstring>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
 
-#define	NETF(x) #x,(uint16_t)(size_t)&((entityState_t*)0)->x,sizeof(entityState_t::x)
+#define	NETF(x) #x,(uint16_t)offsetof(entityState_t, x),sizeof(entityState_t::x)
 
-const netField_template_t<fieldType_ver6_e> entityStateFields[] =
+static constexpr netField_template_t<fieldType_ver6_e> entityStateFields[] =
 {
 { NETF(netorigin[0]), 0, fieldType_ver6_e::coord },
 { NETF(netorigin[1]), 0, fieldType_ver6_e::coord },
@@ -171,7 +173,7 @@ const netField_template_t<fieldType_ver6_e> entityStateFields[] =
 static_assert(sizeof(entityStateFields) == sizeof(netField_t) * 146);
 
 // Fields for SH & BT
-const netField_template_t<fieldType_ver15_e> entityStateFields_ver15[] =
+static constexpr netField_template_t<fieldType_ver15_e> entityStateFields_ver15[] =
 {
 { NETF(netorigin[0]), 0, fieldType_ver15_e::coord },
 { NETF(netorigin[1]), 0, fieldType_ver15_e::coord },
@@ -332,8 +334,6 @@ void SerializableEntityState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 	constexpr size_t numFields = sizeof(entityStateFields) / sizeof(entityStateFields[0]);
 
 	uint8_t lc = 0;
-	uint8_t i = 0;
-	const netField_t* field;
 	bool deltaNeededList[numFields];
 
 	const entityState_t* fromEnt = from ? ((const SerializableEntityState*)from)->GetState() : &nullstate;
@@ -354,17 +354,19 @@ void SerializableEntityState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 	msg.WriteBool(false);
 
 	// build the change vector as bytes so it is endien independent
-	for (i = 0, field = entityStateFields; i < numFields; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), numFields, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromEnt + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_t field = entityStateFields[i];
+		const uint8_t* fromF = (const uint8_t*)fromEnt + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
-		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, field);
+		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, &field);
 		deltaNeededList[i] = deltaNeeded;
 		if (deltaNeeded) {
 			lc = i + 1;
 		}
-	}
+	});
 
 	const bool hasDelta = lc > 0;
 	// write true if it has delta
@@ -382,61 +384,65 @@ void SerializableEntityState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 		throw SerializableErrors::BadEntityFieldCountException(lc);
 	}
 
-	for (i = 0, field = entityStateFields; i < lc; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromEnt + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_template_t<fieldType_ver6_e> field = entityStateFields[i];
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
 		bool isDiff = deltaNeededList[i];
 		msg.WriteBool(isDiff);
 		if (!isDiff) {
-			continue;
+			return;
 		}
 
-		uint32_t packedValue;
-
-		switch (fieldType_ver6_e(field->getType()))
-		{
-		case fieldType_ver6_e::regular:
-			EntityField::WriteNumberEntityField(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver6_e::angle:
-			EntityField::WriteAngleField(msg, field->getBits(), *(float*)toF);
-			break;
-		case fieldType_ver6_e::animTime:
-			packedValue = EntityField::PackAnimTime(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::animWeight:
-			packedValue = EntityField::PackAnimWeight(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::scale:
-			packedValue = EntityField::PackScale(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::alpha:
-			packedValue = EntityField::PackAlpha(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::coord:
+		if constexpr (field.getFieldType() == fieldType_ver6_e::regular) {
+			EntityField::WriteNumberEntityField(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::angle) {
+			EntityField::WriteAngleField(msg, field.getBits(), *(float*)toF);
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::animTime) {
+			msg.WriteNumber(EntityField::PackAnimTime(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::animWeight) {
+			msg.WriteNumber(EntityField::PackAnimWeight(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::scale) {
+			msg.WriteNumber(EntityField::PackScale(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::alpha) {
+			msg.WriteNumber(EntityField::PackAlpha(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::coord) {
 			msgHelper.WriteCoord(*(float*)toF);
-			break;
-		case fieldType_ver6_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::velocity) {
 			msgHelper.WriteCoordSmall(*(float*)toF);
-			break;
-		case fieldType_ver6_e::simple:
-			EntityField::WriteSimple(msg, field->getBits(), toF, field->getSize());
-			break;
-		default:
-			throw SerializableErrors::BadEntityFieldException(field->getType(), field->getName());
 		}
-	}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::simple) {
+			EntityField::WriteSimple(msg, field.getBits(), toF, field.getSize());
+		}
+		else {
+			throw SerializableErrors::BadEntityFieldException(field.getType(), field.getName());
+		}
+	});
 }
 
 void SerializableEntityState::LoadDelta(MSG& msg, const ISerializableMessage* from)
 {
-	MsgCoordHelper msgHelper(msg);
+	LoadDeltaInternal(msg, from);
+}
+
+void SerializableEntityState::LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from)
+{
+	LoadDeltaInternal(msg, from);
+}
+
+template<typename Reader>
+void SerializableEntityState::LoadDeltaInternal(Reader& msg, const ISerializableMessage* from)
+{
+	MsgCoordReader<Reader> msgHelper(msg);
 
 	const entityState_t* fromEnt = from ? ((const SerializableEntityState*)from)->GetState() : &nullstate;
 
@@ -467,61 +473,51 @@ void SerializableEntityState::LoadDelta(MSG& msg, const ISerializableMessage* fr
 		throw SerializableErrors::BadEntityFieldCountException(lc);
 	}
 
-	size_t i;
-	const netField_t* field;
-
-	for (i = 0, field = entityStateFields; i < lc; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromEnt + field->getOffset());
-		uint8_t* toF = (uint8_t*)((uint8_t*)&state + field->getOffset());
+		constexpr netField_template_t<fieldType_ver6_e> field = entityStateFields[decltype(index)::value];
+		const uint8_t* fromF = (const uint8_t*)fromEnt + field.getOffset();
+		uint8_t* toF = (uint8_t*)&state + field.getOffset();
 
 		const bool isDiff = msg.ReadBool();
 		if (!isDiff)
 		{
 			// no changes
-			memcpy(toF, fromF, field->getSize());
-			continue;
+			memcpy(toF, fromF, field.getSize());
+			return;
 		}
 
-		uint32_t packedValue;
-
-		switch (fieldType_ver6_e(field->getType()))
-		{
-		case fieldType_ver6_e::regular:
-			EntityField::ReadRegular(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver6_e::angle:
-			*(float*)toF = EntityField::ReadAngleField(msg, field->getBits());
-			break;
-		case fieldType_ver6_e::animTime:
-			packedValue = msg.ReadNumber<uint32_t>(field->getBits());
-			*(float*)toF = EntityField::UnpackAnimTime(packedValue);
-			break;
-		case fieldType_ver6_e::animWeight:
-			packedValue = msg.ReadByte();
-			*(float*)toF = EntityField::UnpackAnimWeight(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::scale:
-			packedValue = msg.ReadNumber<uint32_t>(field->getBits());
-			*(float*)toF = EntityField::UnpackScale(packedValue);
-			break;
-		case fieldType_ver6_e::alpha:
-			packedValue = msg.ReadByte();
-			*(float*)toF = EntityField::UnpackAlpha(packedValue, field->getBits());
-			break;
-		case fieldType_ver6_e::coord:
+		if constexpr (field.getFieldType() == fieldType_ver6_e::regular) {
+			EntityField::ReadRegular(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::angle) {
+			*(float*)toF = EntityField::ReadAngleField(msg, field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::animTime) {
+			*(float*)toF = EntityField::UnpackAnimTime(msg.template ReadNumber<uint32_t>(field.getBits()));
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::animWeight) {
+			*(float*)toF = EntityField::UnpackAnimWeight(msg.ReadByte(), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::scale) {
+			*(float*)toF = EntityField::UnpackScale(msg.template ReadNumber<uint32_t>(field.getBits()));
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::alpha) {
+			*(float*)toF = EntityField::UnpackAlpha(msg.ReadByte(), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::coord) {
 			*(float*)toF = msgHelper.ReadCoord();
-			break;
-		case fieldType_ver6_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::velocity) {
 			*(float*)toF = msgHelper.ReadCoordSmall();
-			break;
-		case fieldType_ver6_e::simple:
-			EntityField::ReadSimple(msg, field->getBits(), toF, field->getSize());
-			break;
-		default:
-			throw SerializableErrors::BadEntityFieldException(field->getType(), field->getName());
 		}
-	}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::simple) {
+			EntityField::ReadSimple(msg, field.getBits(), toF, field.getSize());
+		}
+		else {
+			throw SerializableErrors::BadEntityFieldException(field.getType(), field.getName());
+		}
+	});
 
 	// assign unchanged fields accordingly
 	CopyFields<entityState_t>(fromEnt, GetState(), lc, numFields, entityStateFields);
@@ -534,8 +530,6 @@ void SerializableEntityState_ver15::SaveDelta(MSG& msg, const ISerializableMessa
 	constexpr size_t numFields = sizeof(entityStateFields_ver15) / sizeof(entityStateFields_ver15[0]);
 
 	uint8_t lc = 0;
-	uint8_t i = 0;
-	const netField_t* field;
 	bool deltaNeededList[numFields];
 
 	const entityState_t* fromEnt = from ? ((const SerializableEntityState*)from)->GetState() : &nullstate;
@@ -556,17 +550,19 @@ void SerializableEntityState_ver15::SaveDelta(MSG& msg, const ISerializableMessa
 	msg.WriteBool(false);
 
 	// build the change vector as bytes so it is endien independent
-	for (i = 0, field = entityStateFields_ver15; i < numFields; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), numFields, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromEnt + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_t field = entityStateFields_ver15[i];
+		const uint8_t* fromF = (const uint8_t*)fromEnt + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
-		const bool deltaNeeded = EntityField::DeltaNeeded_ver15(fromF, toF, field);
+		const bool deltaNeeded = EntityField::DeltaNeeded_ver15(fromF, toF, &field);
 		deltaNeededList[i] = deltaNeeded;
 		if (deltaNeeded) {
 			lc = i + 1;
 		}
-	}
+	});
 
 	const bool hasDelta = lc > 0;
 	// write true if it has delta
@@ -584,81 +580,87 @@ void SerializableEntityState_ver15::SaveDelta(MSG& msg, const ISerializableMessa
 		throw SerializableErrors::BadEntityFieldCountException(lc);
 	}
 
-	for (i = 0, field = entityStateFields_ver15; i < lc; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromEnt + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_template_t<fieldType_ver15_e> field = entityStateFields_ver15[i];
+		const uint8_t* fromF = (const uint8_t*)fromEnt + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
 		bool isDiff = deltaNeededList[i];
 		msg.WriteBool(isDiff);
 		if (!isDiff) {
-			continue;
+			return;
 		}
 
-		uint32_t packedValue;
-
-		switch (fieldType_ver15_e(field->getType()))
+		if constexpr (field.getFieldType() == fieldType_ver15_e::regular) {
+			EntityField::WriteRegular2(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::angle) {
+			msg.WriteNumber<uint32_t>(EntityField::PackAngle2(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::animTime)
 		{
-		case fieldType_ver15_e::regular:
-			EntityField::WriteRegular2(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver15_e::angle:
-			packedValue = EntityField::PackAngle2(*(float*)toF, field->getBits());
-			msg.WriteNumber<uint32_t>(packedValue, field->getBits());
-			break;
-		case fieldType_ver15_e::animTime:
 			if (fabs(*(float*)toF - *(float*)fromF) >= 0.001f)
 			{
 				msg.WriteBool(true);
-
-				packedValue = EntityField::PackAnimTime(*(float*)toF, field->getBits());
-				msg.WriteNumber(packedValue, field->getBits());
+				msg.WriteNumber(EntityField::PackAnimTime(*(float*)toF, field.getBits()), field.getBits());
 			}
 			else
 			{
 				// no changes
 				msg.WriteBool(false);
 			}
-			break;
-		case fieldType_ver15_e::animWeight:
-			packedValue = EntityField::PackAnimWeight(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver15_e::scale:
-			packedValue = EntityField::PackScale(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver15_e::alpha:
-			packedValue = EntityField::PackAlpha(*(float*)toF, field->getBits());
-			msg.WriteNumber(packedValue, field->getBits());
-			break;
-		case fieldType_ver15_e::coord:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::animWeight) {
+			msg.WriteNumber(EntityField::PackAnimWeight(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::scale) {
+			msg.WriteNumber(EntityField::PackScale(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::alpha) {
+			msg.WriteNumber(EntityField::PackAlpha(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coord)
+		{
 			msgHelper.WriteDeltaCoord(
 				EntityField::PackCoord(*(float*)fromF),
 				EntityField::PackCoord(*(float*)toF)
 			);
-			break;
-		case fieldType_ver15_e::coordExtra:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coordExtra)
+		{
 			msgHelper.WriteDeltaCoordExtra(
 				EntityField::PackCoordExtra(*(float*)fromF),
 				EntityField::PackCoordExtra(*(float*)toF)
 			);
-			break;
-		case fieldType_ver15_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::velocity) {
 			msgHelper.WriteCoordSmall(*(float*)toF);
-			break;
-		case fieldType_ver15_e::simple:
-			EntityField::WriteSimple(msg, field->getBits(), toF, field->getSize());
-			break;
-		default:
-			throw SerializableErrors::BadEntityFieldException(field->getType(), field->getName());
 		}
-	}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::simple) {
+			EntityField::WriteSimple(msg, field.getBits(), toF, field.getSize());
+		}
+		else {
+			throw SerializableErrors::BadEntityFieldException(field.getType(), field.getName());
+		}
+	});
 }
 
 void SerializableEntityState_ver15::LoadDelta(MSG& msg, const ISerializableMessage* from)
 {
-	MsgCoordHelper msgHelper(msg);
+	LoadDeltaInternal(msg, from);
+}
+
+void SerializableEntityState_ver15::LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from)
+{
+	LoadDeltaInternal(msg, from);
+}
+
+template<typename Reader>
+void SerializableEntityState_ver15::LoadDeltaInternal(Reader& msg, const ISerializableMessage* from)
+{
+	MsgCoordReader<Reader> msgHelper(msg);
 
 	const entityState_t* fromEnt = from ? ((SerializableEntityState*)from)->GetState() : &nullstate;
 
@@ -689,81 +691,73 @@ void SerializableEntityState_ver15::LoadDelta(MSG& msg, const ISerializableMessa
 		throw SerializableErrors::BadEntityFieldCountException(lc);
 	}
 
-	size_t i;
-	const netField_t* field;
-
-	for (i = 0, field = entityStateFields_ver15; i < lc; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		uint8_t* fromF = (uint8_t*)((uint8_t*)fromEnt + field->getOffset());
-		uint8_t* toF = (uint8_t*)((uint8_t*)&state + field->getOffset());
+		constexpr netField_template_t<fieldType_ver15_e> field = entityStateFields_ver15[decltype(index)::value];
+		const uint8_t* fromF = (const uint8_t*)fromEnt + field.getOffset();
+		uint8_t* toF = (uint8_t*)&state + field.getOffset();
 
 		const bool hasChange = msg.ReadBool();
 		if (!hasChange)
 		{
 			// no change
-			std::memcpy(toF, fromF, field->getSize());
-			continue;
+			std::memcpy(toF, fromF, field.getSize());
+			return;
 		}
 
-		int result;
-		int32_t coordOffset, coordVal;
-
-		switch (fieldType_ver15_e(field->getType()))
+		if constexpr (field.getFieldType() == fieldType_ver15_e::regular) {
+			EntityField::ReadRegular2(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::angle)
+		{
+			const uint32_t result = msg.template ReadNumber<uint32_t>(field.getBits() < 0 ? -field.getBits() : field.getBits());
+			*(float*)toF = EntityField::UnpackAngle2(result, field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::animTime)
 		{
-		case fieldType_ver15_e::regular:
-			EntityField::ReadRegular2(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver15_e::angle:
-			result = msg.ReadNumber<uint32_t>(field->getBits() < 0 ? -field->getBits() : field->getBits());
-			*(float*)toF = EntityField::UnpackAngle2(result, field->getBits());
-			break;
-		case fieldType_ver15_e::animTime: // time
-			result = 0;
 			if (msg.ReadBool())
 			{
-				result = msg.ReadNumber<int>(field->getBits());
-				const float floatTime = EntityField::UnpackAnimTime(result);
+				const int result = msg.template ReadNumber<int>(field.getBits());
 				*(float*)toF = EntityField::UnpackAnimTime(result);
 			}
 			else
 			{
 				// use delta time instead
-				const deltaTimeFloat_t newDelta = *(deltaTimeFloat_t*)fromF + timeDelta;
+				const deltaTimeFloat_t newDelta = *(const deltaTimeFloat_t*)fromF + timeDelta;
 				*(deltaTimeFloat_t*)toF = newDelta;
 			}
-			break;
-		case fieldType_ver15_e::animWeight:
-			result = msg.ReadNumber<int32_t>(field->getBits());
-			*(float*)toF = EntityField::UnpackAnimWeight(result, field->getBits());
-			break;
-		case fieldType_ver15_e::scale:
-			result = msg.ReadNumber<int32_t>(field->getBits());
-			*(float*)toF = EntityField::UnpackScale(result);
-			break;
-		case fieldType_ver15_e::alpha:
-			result = msg.ReadNumber<int32_t>(field->getBits());
-			*(float*)toF = EntityField::UnpackAlpha(result, field->getBits());
-			break;
-		case fieldType_ver15_e::coord:
-			coordOffset = EntityField::PackCoord(*(float*)fromF);
-			coordVal = msgHelper.ReadDeltaCoord(coordOffset);
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::animWeight) {
+			*(float*)toF = EntityField::UnpackAnimWeight(msg.template ReadNumber<int32_t>(field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::scale) {
+			*(float*)toF = EntityField::UnpackScale(msg.template ReadNumber<int32_t>(field.getBits()));
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::alpha) {
+			*(float*)toF = EntityField::UnpackAlpha(msg.template ReadNumber<int32_t>(field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coord)
+		{
+			const int32_t coordOffset = EntityField::PackCoord(*(const float*)fromF);
+			const int32_t coordVal = msgHelper.ReadDeltaCoord(coordOffset);
 			*(float*)toF = EntityField::UnpackCoord(coordVal);
-			break;
-		case fieldType_ver15_e::coordExtra:
-			coordOffset = EntityField::PackCoordExtra(*(float*)fromF);
-			coordVal = msgHelper.ReadDeltaCoordExtra(coordOffset);
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coordExtra)
+		{
+			const int32_t coordOffset = EntityField::PackCoordExtra(*(const float*)fromF);
+			const int32_t coordVal = msgHelper.ReadDeltaCoordExtra(coordOffset);
 			*(float*)toF = EntityField::UnpackCoordExtra(coordVal);
-			break;
-		case fieldType_ver15_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::velocity) {
 			*(float*)toF = msgHelper.ReadCoordSmall();
-			break;
-		case fieldType_ver15_e::simple:
-			EntityField::ReadSimple(msg, field->getBits(), toF, field->getSize());
-			break;
-		default:
-			throw SerializableErrors::BadEntityFieldException(field->getType(), field->getName());
 		}
-	}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::simple) {
+			EntityField::ReadSimple(msg, field.getBits(), toF, field.getSize());
+		}
+		else {
+			throw SerializableErrors::BadEntityFieldException(field.getType(), field.getName());
+		}
+	});
 
 	// assign unchanged fields accordingly
 	CopyFields<entityState_t>(fromEnt, GetState(), lc, numFields, entityStateFields_ver15);
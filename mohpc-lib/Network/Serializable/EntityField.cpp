@@ -5,6 +5,7 @@
 #include <MOHPC/Common/Log.h>
 
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 #include <MOHPC/Utility/Misc/Endian.h>
 
 #include <cmath>
@@ -133,7 +134,8 @@ bool EntityField::DeltaNeeded_ver15(const void* fromField, const void* toField,
 	}
 }
 
-void EntityField::ReadNumberPlayerStateField(MSG& msg, intptr_t bits, void* toF, size_t size)
+template<typename Reader>
+void EntityField::ReadNumberPlayerStateField(Reader& msg, intptr_t bits, void* toF, size_t size)
 {
 	if (bits == 0)
 	{
@@ -142,7 +144,7 @@ void EntityField::ReadNumberPlayerStateField(MSG& msg, intptr_t bits, void* toF,
 		if (!isFullFloat)
 		{
 			// integral float
-			int32_t truncFloat = msg.ReadNumber<int32_t>(FLOAT_INT_BITS);
+			int32_t truncFloat = msg.template ReadNumber<int32_t>(FLOAT_INT_BITS);
 			// bias to allow equal parts positive and negative
 			truncFloat -= FLOAT_INT_BIAS;
 			*(float*)toF = (float)truncFloat;
@@ -199,7 +201,8 @@ void EntityField::WriteNumberPlayerStateField(MSG& msg, intptr_t bits, const voi
 	}
 }
 
-void EntityField::ReadRegular(MSG& msg, intptr_t bits, void* toF, size_t size)
+template<typename Reader>
+void EntityField::ReadRegular(Reader& msg, intptr_t bits, void* toF, size_t size)
 {
 	if (bits == 0)
 	{
@@ -215,7 +218,7 @@ void EntityField::ReadRegular(MSG& msg, intptr_t bits, void* toF, size_t size)
 			if (!isFullFloat)
 			{
 				// integral float
-				int32_t truncFloat = msg.ReadNumber<int32_t>(FLOAT_INT_BITS);
+				int32_t truncFloat = msg.template ReadNumber<int32_t>(FLOAT_INT_BITS);
 				// bias to allow equal parts positive and negative
 				truncFloat -= FLOAT_INT_BIAS;
 				*(float*)toF = (float)truncFloat;
@@ -298,7 +301,8 @@ void EntityField::WriteNumberEntityField(MSG& msg, intptr_t bits, const void* to
 	}
 }
 
-void EntityField::ReadRegular2(MSG& msg, intptr_t bits, void* toF, size_t size)
+template<typename Reader>
+void EntityField::ReadRegular2(Reader& msg, intptr_t bits, void* toF, size_t size)
 {
 	if (bits == 0)
 	{
@@ -314,7 +318,7 @@ void EntityField::ReadRegular2(MSG& msg, intptr_t bits, void* toF, size_t size)
 			if (!isFullFloat)
 			{
 				// integral float
-				int32_t truncFloat = msg.ReadNumber<int32_t>(FLOAT_INT_BITS);
+				int32_t truncFloat = msg.template ReadNumber<int32_t>(FLOAT_INT_BITS);
 				unshiftValue(&truncFloat, sizeof(int32_t));
 
 				*(float*)toF = (float)truncFloat;
@@ -412,17 +416,18 @@ void EntityField::WriteRegular2(MSG& msg, intptr_t bits, const void* toF, size_t
 	}
 }
 
-float EntityField::ReadAngleField(MSG& msg, size_t bits)
+template<typename Reader>
+float EntityField::ReadAngleField(Reader& msg, size_t bits)
 {
 	if (bits < 0)
 	{
 		const bool isNeg = msg.ReadBool();
-		const uint32_t packedValue = msg.ReadNumber<uint32_t>(~bits);
+		const uint32_t packedValue = msg.template ReadNumber<uint32_t>(~bits);
 		return EntityField::UnpackAngle(packedValue, ~bits, isNeg);
 	}
 	else
 	{
-		const uint32_t packedValue = msg.ReadNumber<uint32_t>(bits);
+		const uint32_t packedValue = msg.template ReadNumber<uint32_t>(bits);
 		return EntityField::UnpackAngle(packedValue, bits, false);
 	}
 }
@@ -671,7 +676,8 @@ float EntityField::UnpackAnimTime(int result)
 	return result / 100.f;
 }
 
-void EntityField::ReadSimple(MSG& msg, intptr_t bits, void* toF, size_t size)
+template<typename Reader>
+void EntityField::ReadSimple(Reader& msg, intptr_t bits, void* toF, size_t size)
 {
 	if (msg.ReadBool())
 	{
@@ -700,6 +706,17 @@ void EntityField::WriteSimple(MSG& msg, intptr_t bits, const void* toF, size_t s
 	}
 }
 
+template void EntityField::ReadNumberPlayerStateField(MSG& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadNumberPlayerStateField(MSGBufferReader<MessageCodecs::BitPolicy>& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadRegular(MSG& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadRegular(MSGBufferReader<MessageCodecs::BitPolicy>& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadRegular2(MSG& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadRegular2(MSGBufferReader<MessageCodecs::BitPolicy>& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadSimple(MSG& msg, intptr_t bits, void* toF, size_t size);
+template void EntityField::ReadSimple(MSGBufferReader<MessageCodecs::BitPolicy>& msg, intptr_t bits, void* toF, size_t size);
+template float EntityField::ReadAngleField(MSG& msg, size_t bits);
+template float EntityField::ReadAngleField(MSGBufferReader<MessageCodecs::BitPolicy>& msg, size_t bits);
+
 SerializableErrors::BadEntityNumberException::BadEntityNumberException(const char* inName, size_t inBadNumber)
 	: name(inName)
 	, badNumber(inBadNumber)
@@ -5,15 +5,17 @@
 #include <MOHPC/Network/Types/PlayerState.h>
 
 #include <MOHPC/Utility/Misc/MSG/MSGCoord.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 
+#include <cstddef>
 #include <cstring>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
 
-#define	PSF(x) #x,(uint16_t)(size_t)&((playerState_t*)0)->x,sizeof(playerState_t::x)
+#define	PSF(x) #x,(uint16_t)offsetof(playerState_t, x),sizeof(playerState_t::x)
 
-const netField_template_t<fieldType_ver6_e> playerStateFields[] =
+static constexpr netField_template_t<fieldType_ver6_e> playerStateFields[] =
 {
 { PSF(commandTime), 32, fieldType_ver6_e::regular },
 { PSF(origin[0]), 0, fieldType_ver6_e::coord },
@@ -73,7 +75,7 @@ const netField_template_t<fieldType_ver6_e> playerStateFields[] =
 
 static_assert(sizeof(playerStateFields) == sizeof(netField_template_t<fieldType_ver6_e>) * 54);
 
-const netField_template_t<fieldType_ver15_e> playerStateFields_ver15[] =
+static constexpr netField_template_t<fieldType_ver15_e> playerStateFields_ver15[] =
 {
 { PSF(commandTime), 32, fieldType_ver15_e::regular },
 { PSF(origin[0]), 0, fieldType_ver15_e::coordExtra },
@@ -187,24 +189,25 @@ void SerializablePlayerState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 	constexpr size_t numFields = sizeof(playerStateFields) / sizeof(playerStateFields[0]);
 
 	const playerState_t* fromPS = from ? ((const SerializablePlayerState*)from)->GetState() : &nullPS;
-	const netField_t* field;
 	bool deltaNeededList[numFields];
 
 	uint8_t lc = 0;
 	uint8_t i;
 
 	// Calculate the number of changes
-	for (i = 0, field = playerStateFields; i < numFields; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), numFields, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_t field = playerStateFields[i];
+		const uint8_t* fromF = (const uint8_t*)fromPS + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
-		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, field);
+		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, &field);
 		deltaNeededList[i] = deltaNeeded;
 		if (deltaNeeded) {
 			lc = i + 1;
 		}
-	}
+	});
 
 	const uint32_t pm_flags = GetState()->pm_flags;
 	UnNormalizePlayerState(GetState());
@@ -212,36 +215,32 @@ void SerializablePlayerState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 	// Serialize the number of changes
 	msg.WriteByte(lc);
 
-	for (i = 0, field = playerStateFields; i < lc; ++i, ++field)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)GetState() + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_template_t<fieldType_ver6_e> field = playerStateFields[i];
+		const uint8_t* toF = (const uint8_t*)GetState() + field.getOffset();
 
 		const bool hasChange = deltaNeededList[i];
 
 		msg.WriteBool(hasChange);
 		if (!hasChange) {
-			continue;
+			return;
 		}
 
-		switch (fieldType_ver6_e(field->getType()))
-		{
-		case fieldType_ver6_e::regular:
-			EntityField::WriteNumberPlayerStateField(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver6_e::angle:
-			EntityField::WriteAngleField(msg, field->getBits(), *(float*)toF);
-			break;
-		case fieldType_ver6_e::coord:
+		if constexpr (field.getFieldType() == fieldType_ver6_e::regular) {
+			EntityField::WriteNumberPlayerStateField(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::angle) {
+			EntityField::WriteAngleField(msg, field.getBits(), *(float*)toF);
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::coord) {
 			msgHelper.WriteCoord(*(float*)toF);
-			break;
-		case fieldType_ver6_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::velocity) {
 			msgHelper.WriteCoordSmall(*(float*)toF);
-			break;
-		default:
-			break;
 		}
-	}
+	});
 
 	GetState()->pm_flags = pm_flags;
 
@@ -369,7 +368,18 @@ void SerializablePlayerState::SaveDelta(MSG& msg, const ISerializableMessage* fr
 
 void SerializablePlayerState::LoadDelta(MSG& msg, const ISerializableMessage* from)
 {
-	MsgCoordHelper msgHelper(msg);
+	LoadDeltaInternal(msg, from);
+}
+
+void SerializablePlayerState::LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from)
+{
+	LoadDeltaInternal(msg, from);
+}
+
+template<typename Reader>
+void SerializablePlayerState::LoadDeltaInternal(Reader& msg, const ISerializableMessage* from)
+{
+	MsgCoordReader<Reader> msgHelper(msg);
 
 	constexpr size_t numFields = sizeof(playerStateFields) / sizeof(playerStateFields[0]);
 
@@ -381,40 +391,35 @@ void SerializablePlayerState::LoadDelta(MSG& msg, const ISerializableMessage* fr
 
 	const uint32_t pm_flags = GetState()->pm_flags;
 
-	size_t i;
-	const netField_t* field;
-	for (i = 0, field = playerStateFields; i < lc; ++i, ++field)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->getOffset());
-		bool hasChange;
+		constexpr netField_template_t<fieldType_ver6_e> field = playerStateFields[decltype(index)::value];
+		const uint8_t* fromF = (const uint8_t*)fromPS + field.getOffset();
+		uint8_t* toF = (uint8_t*)GetState() + field.getOffset();
 
-		hasChange = msg.ReadBool();
+		const bool hasChange = msg.ReadBool();
 		if (!hasChange)
 		{
 			// no change
-			std::memcpy(toF, fromF, field->getSize());
-			continue;
+			std::memcpy(toF, fromF, field.getSize());
+			return;
 		}
 
-		switch (fieldType_ver6_e(field->getType()))
-		{
-		case fieldType_ver6_e::regular:
-			EntityField::ReadNumberPlayerStateField(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver6_e::angle:
-			*(float*)toF = EntityField::ReadAngleField(msg, field->getBits());
-			break;
-		case fieldType_ver6_e::coord:
+		if constexpr (field.getFieldType() == fieldType_ver6_e::regular) {
+			EntityField::ReadNumberPlayerStateField(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::angle) {
+			*(float*)toF = EntityField::ReadAngleField(msg, field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::coord) {
 			*(float*)toF = msgHelper.ReadCoord();
-			break;
-		case fieldType_ver6_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver6_e::velocity) {
 			*(float*)toF = msgHelper.ReadCoordSmall();
-			break;
-		default:
-			break;
 		}
-	}
+	});
+
+	size_t i;
 
 	if (GetState()->pm_flags != pm_flags)
 	{
@@ -425,14 +430,7 @@ void SerializablePlayerState::LoadDelta(MSG& msg, const ISerializableMessage* fr
 	if (fromPS)
 	{
 		// assign unchanged fields accordingly
-		for (i = lc, field = &playerStateFields[lc]; i < numFields; i++, field++)
-		{
-			const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-			uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->getOffset());
-
-			// no change
-			std::memcpy(toF, fromF, field->getSize());
-		}
+		CopyFields<playerState_t>(fromPS, GetState(), lc, numFields, playerStateFields);
 
 		// copy all statistics
 		std::copy(fromPS->stats, fromPS->stats + playerState_t::MAX_STATS, state.stats);
@@ -526,70 +524,67 @@ void SerializablePlayerState_ver15::SaveDelta(MSG& msg, const ISerializableMessa
 	constexpr size_t numFields = sizeof(playerStateFields_ver15) / sizeof(playerStateFields_ver15[0]);
 
 	const playerState_t* fromPS = from ? ((SerializablePlayerState*)from)->GetState() : &nullPS;
-	const netField_t* field;
 	bool deltaNeededList[numFields];
 
 	uint8_t lc = 0;
 	uint8_t i;
 
 	// Calculate the number of changes
-	for (i = 0, field = playerStateFields_ver15; i < numFields; i++, field++)
+	UnrollFields(std::make_index_sequence<numFields>(), numFields, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)&state + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_t field = playerStateFields_ver15[i];
+		const uint8_t* fromF = (const uint8_t*)fromPS + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)&state + field.getOffset();
 
-		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, field);
+		const bool deltaNeeded = EntityField::DeltaNeeded(fromF, toF, &field);
 		deltaNeededList[i] = deltaNeeded;
 		if (deltaNeeded) {
 			lc = i + 1;
 		}
-	}
+	});
 
 	// Serialize the number of changes
 	msg.WriteByte(lc);
 
-	for (i = 0, field = playerStateFields_ver15; i < lc; ++i, ++field)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		const uint8_t* toF = (const uint8_t*)((const uint8_t*)GetState() + field->getOffset());
+		constexpr size_t i = decltype(index)::value;
+		constexpr netField_template_t<fieldType_ver15_e> field = playerStateFields_ver15[i];
+		const uint8_t* fromF = (const uint8_t*)fromPS + field.getOffset();
+		const uint8_t* toF = (const uint8_t*)GetState() + field.getOffset();
 
 		const bool hasChange = deltaNeededList[i];
 
 		msg.WriteBool(hasChange);
 		if (!hasChange) {
-			continue;
+			return;
 		}
 
-		uint32_t packedValue;
-
-		switch (fieldType_ver15_e(field->getType()))
+		if constexpr (field.getFieldType() == fieldType_ver15_e::regular) {
+			EntityField::WriteRegular2(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::angle) {
+			msg.WriteNumber<uint32_t>(EntityField::PackAngle2(*(float*)toF, field.getBits()), field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coord)
 		{
-		case fieldType_ver15_e::regular:
-			EntityField::WriteRegular2(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver15_e::angle:
-			packedValue = EntityField::PackAngle2(*(float*)toF, field->getBits());
-			msg.WriteNumber<uint32_t>(packedValue, field->getBits());
-			break;
-		case fieldType_ver15_e::coord:
 			msgHelper.WriteDeltaCoord(
 				EntityField::PackCoord(*(float*)fromF),
 				EntityField::PackCoord(*(float*)toF)
 			);
-			break;
-		case fieldType_ver15_e::coordExtra:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coordExtra)
+		{
 			msgHelper.WriteDeltaCoordExtra(
 				EntityField::PackCoordExtra(*(float*)fromF),
 				EntityField::PackCoordExtra(*(float*)toF)
 			);
-			break;
-		case fieldType_ver15_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::velocity) {
 			msgHelper.WriteCoordSmall(*(float*)toF);
-			break;
-		default:
-			break;
 		}
-	}
+	});
 
 	uint32_t statsBits = 0;
 	uint32_t activeItemsBits = 0;
@@ -715,7 +710,18 @@ void SerializablePlayerState_ver15::SaveDelta(MSG& msg, const ISerializableMessa
 
 void SerializablePlayerState_ver15::LoadDelta(MSG& msg, const ISerializableMessage* from)
 {
-	MsgCoordHelper msgHelper(msg);
+	LoadDeltaInternal(msg, from);
+}
+
+void SerializablePlayerState_ver15::LoadDelta(MSGBufferReader<MessageCodecs::BitPolicy>& msg, const ISerializableMessage* from)
+{
+	LoadDeltaInternal(msg, from);
+}
+
+template<typename Reader>
+void SerializablePlayerState_ver15::LoadDeltaInternal(Reader& msg, const ISerializableMessage* from)
+{
+	MsgCoordReader<Reader> msgHelper(msg);
 
 	constexpr size_t numFields = sizeof(playerStateFields_ver15) / sizeof(playerStateFields_ver15[0]);
 
@@ -728,63 +734,51 @@ void SerializablePlayerState_ver15::LoadDelta(MSG& msg, const ISerializableMessa
 		throw SerializableErrors::BadEntityFieldCountException(lc);
 	}
 	
-	size_t i;
-	const netField_t* field;
-	for (i = 0, field = playerStateFields_ver15; i < lc; ++i, ++field)
+	UnrollFields(std::make_index_sequence<numFields>(), lc, [&](auto index)
 	{
-		const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-		uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->getOffset());
+		constexpr netField_template_t<fieldType_ver15_e> field = playerStateFields_ver15[decltype(index)::value];
+		const uint8_t* fromF = (const uint8_t*)fromPS + field.getOffset();
+		uint8_t* toF = (uint8_t*)GetState() + field.getOffset();
 
 		const bool hasChange = msg.ReadBool();
 		if (!hasChange)
 		{
 			// no change
-			std::memcpy(toF, fromF, field->getSize());
-			continue;
+			std::memcpy(toF, fromF, field.getSize());
+			return;
 		}
 
-		uint32_t result;
-		intptr_t bits = 0;
-		int32_t coordOffset, coordVal;
-
-		switch (fieldType_ver15_e(field->getType()))
+		if constexpr (field.getFieldType() == fieldType_ver15_e::regular) {
+			EntityField::ReadRegular2(msg, field.getBits(), toF, field.getSize());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::angle)
+		{
+			const uint32_t result = msg.template ReadNumber<uint32_t>(field.getBits() < 0 ? -field.getBits() : field.getBits());
+			*(float*)toF = EntityField::UnpackAngle2(result, field.getBits());
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coord)
 		{
-		case fieldType_ver15_e::regular:
-			EntityField::ReadRegular2(msg, field->getBits(), toF, field->getSize());
-			break;
-		case fieldType_ver15_e::angle: // anglestmp = 1.0f;
-			result = msg.ReadNumber<uint32_t>(field->getBits() < 0 ? -field->getBits() : field->getBits());
-			*(float*)toF = EntityField::UnpackAngle2(result, field->getBits());
-			break;
-		case fieldType_ver15_e::coord:
-			coordOffset = EntityField::PackCoord(*(float*)fromF);
-			coordVal = msgHelper.ReadDeltaCoord(coordOffset);
+			const int32_t coordOffset = EntityField::PackCoord(*(const float*)fromF);
+			const int32_t coordVal = msgHelper.ReadDeltaCoord(coordOffset);
 			*(float*)toF = EntityField::UnpackCoord(coordVal);
-			break;
-		case fieldType_ver15_e::coordExtra:
-			coordOffset = EntityField::PackCoordExtra(*(float*)fromF);
-			coordVal = msgHelper.ReadDeltaCoordExtra(coordOffset);
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::coordExtra)
+		{
+			const int32_t coordOffset = EntityField::PackCoordExtra(*(const float*)fromF);
+			const int32_t coordVal = msgHelper.ReadDeltaCoordExtra(coordOffset);
 			*(float*)toF = EntityField::UnpackCoordExtra(coordVal);
-			break;
-		case fieldType_ver15_e::velocity:
+		}
+		else if constexpr (field.getFieldType() == fieldType_ver15_e::velocity) {
 			*(float*)toF = msgHelper.ReadCoordSmall();
-			break;
-		default:
-			break;
 		}
-	}
+	});
+
+	size_t i;
 
 	if (fromPS)
 	{
 		// assign unchanged fields accordingly
-		for (i = lc, field = &playerStateFields_ver15[lc]; i < numFields; i++, field++)
-		{
-			const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->getOffset());
-			uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->getOffset());
-
-			// no change
-			std::memcpy(toF, fromF, field->getSize());
-		}
+		CopyFields<playerState_t>(fromPS, GetState(), lc, numFields, playerStateFields_ver15);
 
 		// copy all statistics
 		std::copy(fromPS->stats, fromPS->stats + playerState_t::MAX_STATS, state.stats);
@@ -0,0 +1,103 @@
+#include <MOHPC/Network/Types/EntityStateRing.h>
+
+#include <cassert>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+EntityStateRing::EntityStateRing(size_t capacity, size_t preallocated)
+	: mask(capacity - 1)
+	, pending(nullptr)
+{
+	assert(capacity && !(capacity & (capacity - 1)));
+
+	nullState.refCount = 0;
+	slots.resize(capacity, &nullState);
+
+	chunks.reserve((capacity + preallocated) / CHUNK_SIZE + 1);
+	while (freeStates.size() < preallocated) {
+		grow();
+	}
+}
+
+EntityStateRing::~EntityStateRing()
+{
+}
+
+entityState_t* EntityStateRing::acquire()
+{
+	if (!pending)
+	{
+		if (freeStates.empty()) {
+			grow();
+		}
+
+		pending = freeStates.back();
+		freeStates.pop_back();
+	}
+
+	return &pending->state;
+}
+
+void EntityStateRing::store(uint32_t parseNum)
+{
+	assert(pending);
+
+	pooledState_t*& slot = slots[parseNum & mask];
+	release(slot);
+
+	pending->refCount = 1;
+	slot = pending;
+	pending = nullptr;
+}
+
+void EntityStateRing::share(uint32_t parseNum, uint32_t fromParseNum)
+{
+	pooledState_t* const pooled = slots[fromParseNum & mask];
+	// referenced first in case both are the same slot
+	++pooled->refCount;
+
+	pooledState_t*& slot = slots[parseNum & mask];
+	release(slot);
+	slot = pooled;
+}
+
+size_t EntityStateRing::capacity() const
+{
+	return slots.size();
+}
+
+size_t EntityStateRing::getNumAllocated() const
+{
+	return chunks.size() * CHUNK_SIZE;
+}
+
+size_t EntityStateRing::getNumFree() const
+{
+	return freeStates.size() + (pending ? 1 : 0);
+}
+
+void EntityStateRing::release(pooledState_t* pooled)
+{
+	if (pooled == &nullState)
+	{
+		// the null state is never released
+		return;
+	}
+
+	if (!--pooled->refCount)
+	{
+		// the state is kept as is, it will be overwritten by the next parse
+		freeStates.push_back(pooled);
+	}
+}
+
+void EntityStateRing::grow()
+{
+	chunks.push_back(std::make_unique<pooledState_t[]>(CHUNK_SIZE));
+
+	pooledState_t* const chunk = chunks.back().get();
+	for (size_t i = CHUNK_SIZE; i > 0; --i) {
+		freeStates.push_back(&chunk[i - 1]);
+	}
+}
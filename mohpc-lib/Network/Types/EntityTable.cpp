@@ -0,0 +1,82 @@
+#include <MOHPC/Network/Types/EntityTable.h>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+EntityTable::EntityTable()
+	: count(0)
+{
+}
+
+void EntityTable::clear()
+{
+	count = 0;
+}
+
+bool EntityTable::add(const entityState_t& state)
+{
+	if (count >= MAX_ENTITIES) {
+		return false;
+	}
+
+	const size_t index = count++;
+	originX[index] = state.netorigin[0];
+	originY[index] = state.netorigin[1];
+	originZ[index] = state.netorigin[2];
+	anglesX[index] = state.netangles[0];
+	anglesY[index] = state.netangles[1];
+	anglesZ[index] = state.netangles[2];
+
+	for (size_t i = 0; i < MAX_FRAMEINFOS; ++i)
+	{
+		frameIndex[i][index] = state.frameInfo[i].index;
+		frameTime[i][index] = state.frameInfo[i].time;
+		frameWeight[i][index] = state.frameInfo[i].weight;
+	}
+
+	solid[index] = state.solid;
+	number[index] = state.number;
+	eFlags[index] = state.eFlags;
+	modelindex[index] = state.modelindex;
+	groundEntityNum[index] = state.groundEntityNum;
+	eType[index] = state.eType;
+
+	return true;
+}
+
+size_t EntityTable::size() const
+{
+	return count;
+}
+
+size_t EntityTable::find(entityNum_t entityNum) const
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (number[i] == entityNum) {
+			return i;
+		}
+	}
+
+	return count;
+}
+
+size_t EntityTable::findSolidEntities(uint16_t* out, size_t maxOut) const
+{
+	size_t numOut = 0;
+	for (size_t i = 0; i < count && numOut < maxOut; ++i)
+	{
+		// Ignore item/triggers, they're always non-solid
+		const entityType_e type = eType[i];
+		const bool isSolid = solid[i] != 0
+			&& type != entityType_e::item
+			&& type != entityType_e::push_trigger
+			&& type != entityType_e::teleport_trigger;
+
+		// branchless append, the slot is overwritten if the entity isn't solid
+		out[numOut] = (uint16_t)i;
+		numOut += isSolid;
+	}
+
+	return numOut;
+}
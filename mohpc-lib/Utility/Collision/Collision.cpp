@@ -1,14 +1,19 @@
 #include <MOHPC/Utility/Collision/Collision.h>
 #include <MOHPC/Assets/Managers/ShaderManager.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstring>
+#include <utility>
 
-using namespace MOHPC;
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COLLISION_USE_SSE
+#include <xmmintrin.h>
+#endif
 
-collisionModel_t box_model;
-collisionPlane_t* box_planes;
-collisionBrush_t* box_brush;
+using namespace MOHPC;
 
 static constexpr float SURFACE_CLIP_EPSILON = 0.125f;
 static constexpr clipHandle_t BOX_MODEL_HANDLE = 1023;
@@ -110,8 +115,7 @@ terrainCollide_t::terrainCollide_t()
 }
 
 collisionTerrain_t::collisionTerrain_t()
-	: checkcount(0)
-	, surfaceFlags(0)
+	: surfaceFlags(0)
 	, contents(0)
 	, shaderNum(0)
 {
@@ -146,7 +150,6 @@ collisionBrush_t::collisionBrush_t()
 	, contents(0)
 	, numsides(0)
 	, sides(nullptr)
-	, checkcount(0)
 {
 }
 
@@ -185,8 +188,7 @@ patchCollide_t::~patchCollide_t()
 }
 
 collisionPatch_t::collisionPatch_t()
-	: checkcount(0)
-	, surfaceFlags(0)
+	: surfaceFlags(0)
 	, contents(0)
 	, shaderNum(0)
 	, subdivisions(0)
@@ -199,6 +201,7 @@ traceWork_t::traceWork_t()
 	, radius(0.f)
 	, contents(0)
 	, isPoint(false)
+	, context(nullptr)
 {
 }
 
@@ -209,6 +212,7 @@ leafList_t::leafList_t()
 	, list(nullptr)
 	, lastLeaf(0)
 	, storeLeafs(nullptr)
+	, context(nullptr)
 {
 }
 
@@ -226,15 +230,50 @@ static void SetPlaneSignbits(collisionPlane_t* out)
 	out->signbits = bits;
 }
 
+traceContext_t::traceContext_t()
+	: checkcount(0)
+	, c_traces(0)
+	, c_patch_traces(0)
+	, c_brush_traces(0)
+	, c_pointcontents(0)
+{
+	// setup the box hull, only the plane distances and the bounds change afterwards
+	boxBrush.numsides = 6;
+	boxBrush.sides = boxSides;
+	boxBrush.contents = ContentFlags::CONTENTS_BBOX;
+
+	boxModel.leaf.numLeafBrushes = 1;
+
+	for (int i = 0; i < 6; i++)
+	{
+		const int side = i & 1;
+
+		// brush sides
+		collisionBrushSide_t* s = &boxSides[i];
+		s->plane = &boxPlanes[i * 2 + side];
+		s->surfaceFlags = 0;
+
+		// planes
+		collisionPlane_t* p = &boxPlanes[i * 2];
+		p->type = i >> 1;
+		p->signbits = 0;
+		VectorClear(p->normal);
+		p->normal[i >> 1] = 1;
+
+		p = &boxPlanes[i * 2 + 1];
+		p->type = 3 + (i >> 1);
+		p->signbits = 0;
+		VectorClear(p->normal);
+		p->normal[i >> 1] = -1;
+
+		SetPlaneSignbits(p);
+	}
+}
+
 MOHPC_OBJECT_DEFINITION(CollisionWorld);
 
 CollisionWorld::CollisionWorld()
 {
-	checkcount = 0;
-	c_traces = 0;
-	c_patch_traces = 0;
-	c_brush_traces = 0;
-	c_pointcontents = 0;
 }
 
 CollisionWorld::~CollisionWorld()
@@ -305,6 +344,7 @@ void CollisionWorld::clearAll()
 {
 	fencemasks.clear();
 	shaders.clear();
+	sideequations.clear();
 	brushsides.clear();
 	planes.clear();
 	nodes.clear();
@@ -339,6 +379,7 @@ void CollisionWorld::reserve(
 {
 	fencemasks.reserve(numFenceMasks);
 	shaders.reserve(numShaders);
+	sideequations.reserve(numSideEquations);
 	brushsides.reserve(numBrushSides);
 	planes.reserve(numPlanes);
 	nodes.reserve(numNodes);
@@ -385,7 +426,7 @@ collisionSideEq_t* CollisionWorld::getSideEquation(uintptr_t num) const
 
 collisionSideEq_t* CollisionWorld::getSideEquations()
 {
-	return sideequations.data();
+	return const_cast<collisionSideEq_t*>(std::as_const(sideequations).data());
 }
 
 size_t CollisionWorld::getNumSideEquations() const
@@ -400,7 +441,7 @@ collisionBrushSide_t* CollisionWorld::getBrushSide(uintptr_t num) const
 
 collisionBrushSide_t* CollisionWorld::getBrushSides()
 {
-	return brushsides.data();
+	return const_cast<collisionBrushSide_t*>(std::as_const(brushsides).data());
 }
 
 size_t CollisionWorld::getNumBrushSides() const
@@ -415,7 +456,7 @@ collisionPlane_t* CollisionWorld::getPlane(uintptr_t num) const
 
 collisionPlane_t* CollisionWorld::getPlanes()
 {
-	return planes.data();
+	return const_cast<collisionPlane_t*>(std::as_const(planes).data());
 }
 
 size_t CollisionWorld::getNumPlanes() const
@@ -480,7 +521,7 @@ collisionPatch_t* CollisionWorld::getPatch(uintptr_t num) const
 
 collisionPatch_t* CollisionWorld::getPatches()
 {
-	return patchList.data();
+	return const_cast<collisionPatch_t*>(std::as_const(patchList).data());
 }
 
 size_t CollisionWorld::getNumPatches() const
@@ -495,7 +536,7 @@ collisionTerrain_t* CollisionWorld::getTerrain(uintptr_t num) const
 
 collisionTerrain_t* CollisionWorld::getTerrains()
 {
-	return terrain.data();
+	return const_cast<collisionTerrain_t*>(std::as_const(terrain).data());
 }
 
 size_t CollisionWorld::getNumTerrains() const
@@ -540,7 +581,7 @@ void CollisionWorld::createSurface(collisionPatch_t* patch)
 
 collisionPatch_t* CollisionWorld::getSurface(uintptr_t num)
 {
-	return surfaces[num];
+	return std::as_const(surfaces)[num];
 }
 
 size_t CollisionWorld::getNumSurfaces() const
@@ -599,7 +640,7 @@ void CreateRotationMatrix(const vec3_t angles, vec3_t matrix[3]) {
 CollisionWorld::ProjectPointOntoVector
 ================
 */
-void CollisionWorld::ProjectPointOntoVector(vec3_t point, vec3_t vStart, vec3_t vDir, vec3_t vProj)
+void CollisionWorld::ProjectPointOntoVector(vec3_t point, vec3_t vStart, vec3_t vDir, vec3_t vProj) const
 {
 	vec3_t pVec;
 
@@ -613,7 +654,7 @@ void CollisionWorld::ProjectPointOntoVector(vec3_t point, vec3_t vStart, vec3_t
 CollisionWorld::DistanceFromLineSquared
 ================
 */
-float CollisionWorld::DistanceFromLineSquared(vec3_t p, vec3_t lp1, vec3_t lp2, vec3_t dir) {
+float CollisionWorld::DistanceFromLineSquared(vec3_t p, vec3_t lp1, vec3_t lp2, vec3_t dir) const {
 	vec3_t proj, t;
 	int j;
 
@@ -638,7 +679,7 @@ float CollisionWorld::DistanceFromLineSquared(vec3_t p, vec3_t lp1, vec3_t lp2,
 CollisionWorld::VectorDistanceSquared
 ================
 */
-float CollisionWorld::VectorDistanceSquared(vec3_t p1, vec3_t p2) {
+float CollisionWorld::VectorDistanceSquared(vec3_t p1, vec3_t p2) const {
 	vec3_t dir;
 
 	VecSubtract(p2, p1, dir);
@@ -731,7 +772,7 @@ float SquareRootFloat(float number) {
 	return number * y;
 }
 
-collisionModel_t* CollisionWorld::ClipHandleToModel(clipHandle_t handle)
+const collisionModel_t* CollisionWorld::ClipHandleToModel(const traceContext_t& context, clipHandle_t handle) const
 {
 	if (handle < 0)
 	{
@@ -743,7 +784,7 @@ collisionModel_t* CollisionWorld::ClipHandleToModel(clipHandle_t handle)
 		return &cmodels[handle];
 	}
 	if (handle == BOX_MODEL_HANDLE) {
-		return &box_model;
+		return &context.boxModel;
 	}
 
 	// FIXME: throw?
@@ -753,63 +794,32 @@ collisionModel_t* CollisionWorld::ClipHandleToModel(clipHandle_t handle)
 
 void CollisionWorld::ModelBounds(clipHandle_t model, vec3r_t mins, vec3r_t maxs)
 {
-	collisionModel_t* cmod;
+	CollisionWorld::ModelBounds(defaultContext, model, mins, maxs);
+}
+
+void CollisionWorld::ModelBounds(const traceContext_t& context, clipHandle_t model, vec3r_t mins, vec3r_t maxs) const
+{
+	const collisionModel_t* cmod;
 
-	cmod = ClipHandleToModel(model);
+	cmod = ClipHandleToModel(context, model);
 	VecCopy(cmod->mins, mins);
 	VecCopy(cmod->maxs, maxs);
 }
 
 void CollisionWorld::InitBoxHull()
 {
-	int			i;
-	int			side;
-	collisionPlane_t* p;
-	collisionBrushSide_t* s;
-
-	planes.resize(12);
-	box_planes = &planes[0];
-
-	// Create 6 sides
-	brushsides.resize(6);
-
-	box_brush = createBrush();
-	box_brush->numsides = 6;
-	box_brush->sides = &this->brushsides[0];
-	box_brush->contents = ContentFlags::CONTENTS_BBOX;
-
-	box_model.leaf.numLeafBrushes = 1;
-	box_model.leaf.firstLeafBrush = (uint32_t)this->leafbrushes.size();
-	createLeafBrush(box_brush - brushes.data());
-
-	for (i = 0; i < 6; i++)
-	{
-		side = i & 1;
-
-		// brush sides
-		s = &brushsides[i];
-		s->plane = &box_planes[i * 2 + side]; // &this->planes[(this->planes.size() + i * 2 + side)];
-		s->surfaceFlags = 0;
-
-		// planes
-		p = &box_planes[i * 2];
-		p->type = i >> 1;
-		p->signbits = 0;
-		VectorClear(p->normal);
-		p->normal[i >> 1] = 1;
-
-		p = &box_planes[i * 2 + 1];
-		p->type = 3 + (i >> 1);
-		p->signbits = 0;
-		VectorClear(p->normal);
-		p->normal[i >> 1] = -1;
-
-		SetPlaneSignbits(p);
-	}
+	// the box hull is part of every trace context
 }
 
 clipHandle_t CollisionWorld::TempBoxModel(const vec3r_t mins, const vec3r_t maxs, int contents)
 {
+	return CollisionWorld::TempBoxModel(defaultContext, mins, maxs, contents);
+}
+
+clipHandle_t CollisionWorld::TempBoxModel(traceContext_t& context, const vec3r_t mins, const vec3r_t maxs, int contents) const
+{
+	collisionPlane_t* box_planes = context.boxPlanes;
+
 	box_planes[0].dist = maxs[0];
 	box_planes[1].dist = -maxs[0];
 	box_planes[2].dist = mins[0];
@@ -823,13 +833,84 @@ clipHandle_t CollisionWorld::TempBoxModel(const vec3r_t mins, const vec3r_t maxs
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
-	VecCopy(mins, box_brush->bounds[0]);
-	VecCopy(maxs, box_brush->bounds[1]);
-	box_brush->contents = contents;
+	VecCopy(mins, context.boxBrush.bounds[0]);
+	VecCopy(maxs, context.boxBrush.bounds[1]);
+	context.boxBrush.contents = contents;
 
 	return BOX_MODEL_HANDLE;
 }
 
+/*
+================
+CollisionWorld::BeginTrace
+
+Start a new check stamp in the context
+================
+*/
+void CollisionWorld::BeginTrace(traceContext_t& context) const
+{
+	// make sure there is a stamp for every object of this world
+	if (context.brushChecks.size() < brushes.size()) {
+		context.brushChecks.resize(brushes.size());
+	}
+	if (context.patchChecks.size() < patchList.size()) {
+		context.patchChecks.resize(patchList.size());
+	}
+	if (context.terrainChecks.size() < terrain.size()) {
+		context.terrainChecks.resize(terrain.size());
+	}
+
+	context.checkcount++;
+	if (!context.checkcount)
+	{
+		// wrapped around, old stamps would match again
+		std::fill(context.brushChecks.begin(), context.brushChecks.end(), 0);
+		std::fill(context.patchChecks.begin(), context.patchChecks.end(), 0);
+		std::fill(context.terrainChecks.begin(), context.terrainChecks.end(), 0);
+		context.checkcount = 1;
+	}
+}
+
+/*
+================
+CollisionWorld::MarkBrush
+
+Return false if the brush was already checked during this trace
+================
+*/
+bool CollisionWorld::MarkBrush(traceContext_t& context, const collisionBrush_t* brush) const
+{
+	uint32_t& check = context.brushChecks[brush - brushes.data()];
+	if (check == context.checkcount) {
+		return false;
+	}
+
+	check = context.checkcount;
+	return true;
+}
+
+bool CollisionWorld::MarkPatch(traceContext_t& context, const collisionPatch_t* patch) const
+{
+	uint32_t& check = context.patchChecks[patch - patchList.data()];
+	if (check == context.checkcount) {
+		return false;
+	}
+
+	check = context.checkcount;
+	return true;
+}
+
+bool CollisionWorld::MarkTerrain(traceContext_t& context, const collisionTerrain_t* terrain) const
+{
+	uint32_t& check = context.terrainChecks[terrain - this->terrain.data()];
+	if (check == context.checkcount) {
+		return false;
+	}
+
+	check = context.checkcount;
+	return true;
+}
+
 /*
 ===============================================================================
 
@@ -843,7 +924,7 @@ POSITION TESTING
 CollisionWorld::TestBoxInBrush
 ================
 */
-void CollisionWorld::TestBoxInBrush(traceWork_t* tw, collisionBrush_t* brush) {
+void CollisionWorld::TestBoxInBrush(traceWork_t* tw, const collisionBrush_t* brush) const {
 	uint32_t	i;
 	const collisionPlane_t* plane;
 	float		dist;
@@ -866,6 +947,7 @@ void CollisionWorld::TestBoxInBrush(traceWork_t* tw, collisionBrush_t* brush) {
 		return;
 	}
 
+	const sphere_t& sphere = tw->context->sphere;
 	if (sphere.use) {
 		// the first six planes are the axial planes, so we only
 		// need to test the remainder
@@ -922,19 +1004,27 @@ void CollisionWorld::TestBoxInBrush(traceWork_t* tw, collisionBrush_t* brush) {
 CollisionWorld::TestInLeaf
 ================
 */
-void CollisionWorld::TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
+void CollisionWorld::TestInLeaf(traceWork_t* tw, const collisionLeaf_t* leaf) const
 {
+	if (leaf == &tw->context->boxModel.leaf)
+	{
+		// the temporary box is not part of the world
+		if (tw->context->boxBrush.contents & tw->contents) {
+			CollisionWorld::TestBoxInBrush(tw, &tw->context->boxBrush);
+		}
+		return;
+	}
+
 	// test box position against all brushes in the leaf
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++)
 	{
 		const uintptr_t brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		collisionBrush_t* b = &this->brushes[brushnum];
-		if (b->checkcount == this->checkcount)
+		const collisionBrush_t* b = &this->brushes[brushnum];
+		if (!MarkBrush(*tw->context, b))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		b->checkcount = this->checkcount;
 
 		if (!(b->contents & tw->contents)) {
 			continue;
@@ -950,16 +1040,15 @@ void CollisionWorld::TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 	for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++)
 	{
 		const uintptr_t patchnum = this->leafsurfaces[leaf->firstLeafSurface + k];
-		collisionPatch_t* patch = this->surfaces[patchnum];
+		const collisionPatch_t* patch = this->surfaces[patchnum];
 		if (!patch) {
 			continue;
 		}
-		if (patch->checkcount == this->checkcount)
+		if (!MarkPatch(*tw->context, patch))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		patch->checkcount = this->checkcount;
 
 		if (!(patch->contents & tw->contents)) {
 			continue;
@@ -975,16 +1064,15 @@ void CollisionWorld::TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 
 	for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++)
 	{
-		collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+		const collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
 		if (!terrain) {
 			continue;
 		}
-		if (terrain->checkcount == this->checkcount)
+		if (!MarkTerrain(*tw->context, terrain))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		terrain->checkcount = this->checkcount;
 
 		if (CollisionWorld::PositionTestInTerrainCollide(tw, &terrain->tc))
 		{
@@ -1002,15 +1090,16 @@ CollisionWorld::TestCapsuleInCapsule
 capsule inside capsule check
 ==================
 */
-void CollisionWorld::TestCapsuleInCapsule(traceWork_t * tw, clipHandle_t model) {
+void CollisionWorld::TestCapsuleInCapsule(traceWork_t * tw, clipHandle_t model) const {
 	int i;
 	vec3_t mins, maxs;
 	vec3_t top, bottom;
 	vec3_t p1, p2, tmp;
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, r;
+	const sphere_t& sphere = tw->context->sphere;
 
-	CollisionWorld::ModelBounds(model, mins, maxs);
+	CollisionWorld::ModelBounds(*tw->context, model, mins, maxs);
 
 	VecAdd(tw->start, sphere.offset, top);
 	VecSubtract(tw->start, sphere.offset, bottom);
@@ -1071,15 +1160,16 @@ CollisionWorld::TestBoundingBoxInCapsule
 bounding box inside capsule check
 ==================
 */
-void CollisionWorld::TestBoundingBoxInCapsule(traceWork_t * tw, clipHandle_t model) {
+void CollisionWorld::TestBoundingBoxInCapsule(traceWork_t * tw, clipHandle_t model) const {
 	vec3_t mins, maxs;
 	vec3_t offset, size[2];
 	clipHandle_t h;
-	collisionModel_t* cmod;
+	const collisionModel_t* cmod;
 	int i;
+	sphere_t& sphere = tw->context->sphere;
 
 	// mins maxs of the capsule
-	CollisionWorld::ModelBounds(model, mins, maxs);
+	CollisionWorld::ModelBounds(*tw->context, model, mins, maxs);
 
 	// offset for capsule center
 	for (i = 0; i < 3; i++) {
@@ -1096,9 +1186,9 @@ void CollisionWorld::TestBoundingBoxInCapsule(traceWork_t * tw, clipHandle_t mod
 	VecSet(sphere.offset, 0, 0, size[1][2] - sphere.radius);
 
 	// replace the capsule with the bounding box
-	h = CollisionWorld::TempBoxModel(tw->size[0], tw->size[1], false);
+	h = CollisionWorld::TempBoxModel(*tw->context, tw->size[0], tw->size[1], false);
 	// calculate collision
-	cmod = CollisionWorld::ClipHandleToModel(h);
+	cmod = CollisionWorld::ClipHandleToModel(*tw->context, h);
 	CollisionWorld::TestInLeaf(tw, &cmod->leaf);
 }
 
@@ -1108,7 +1198,7 @@ CollisionWorld::PositionTest
 ==================
 */
 #define	MAX_POSITION_LEAFS	1024
-void CollisionWorld::PositionTest(traceWork_t * tw) {
+void CollisionWorld::PositionTest(traceWork_t * tw) const {
 	int			leafs[MAX_POSITION_LEAFS];
 	uint32_t	i;
 	leafList_t	ll;
@@ -1128,13 +1218,10 @@ void CollisionWorld::PositionTest(traceWork_t * tw) {
 	ll.storeLeafs = &CollisionWorld::StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
-
-	this->checkcount++;
+	ll.context = tw->context;
 
 	CollisionWorld::BoxLeafnums_r(&ll, 0);
 
-	this->checkcount++;
-
 	// test the contents of the leafs
 	for (i = 0; i < ll.count; i++) {
 		CollisionWorld::TestInLeaf(tw, &this->leafs[leafs[i]]);
@@ -1159,10 +1246,10 @@ CollisionWorld::TraceThroughPatch
 ================
 */
 
-void CollisionWorld::TraceThroughPatch(traceWork_t * tw, const collisionPatch_t * patch) {
+void CollisionWorld::TraceThroughPatch(traceWork_t * tw, const collisionPatch_t * patch) const {
 	float		oldFrac;
 
-	c_patch_traces++;
+	tw->context->c_patch_traces++;
 
 	oldFrac = tw->trace.fraction;
 
@@ -1180,7 +1267,7 @@ void CollisionWorld::TraceThroughPatch(traceWork_t * tw, const collisionPatch_t
 CollisionWorld::TraceThroughTerrain
 ================
 */
-void CollisionWorld::TraceThroughTerrain(traceWork_t * tw, const collisionTerrain_t* terrain) {
+void CollisionWorld::TraceThroughTerrain(traceWork_t * tw, const collisionTerrain_t* terrain) const {
 	float		oldFrac;
 
 	oldFrac = tw->trace.fraction;
@@ -1195,21 +1282,122 @@ void CollisionWorld::TraceThroughTerrain(traceWork_t * tw, const collisionTerrai
 	}
 }
 
+#ifdef COLLISION_USE_SSE
+// offsets are vec3_t, don't read past the last one
+static __m128 LoadVec3(const vec3_t v)
+{
+	return _mm_setr_ps(v[0], v[1], v[2], 0.f);
+}
+#endif
+
+/*
+================
+BrushSideDistances
+
+Distance of the start and end of the trace to the next 4 sides of a brush,
+each plane being pushed out by the size of the trace (or the capsule if specified)
+================
+*/
+static void BrushSideDistances(const traceWork_t* tw, const sphere_t* sphere, const collisionBrushSide_t* sides, uint32_t numSides, float d1[4], float d2[4])
+{
+#ifdef COLLISION_USE_SSE
+	static_assert(offsetof(collisionPlane_t, dist) == sizeof(vec3_t), "the plane distance must follow the normal");
+
+	const collisionPlane_t* planes[4];
+	for (uint32_t i = 0; i < 4; i++) {
+		// repeat the last side when there are less than 4, the extra results are ignored
+		planes[i] = sides[i < numSides ? i : numSides - 1].plane;
+	}
+
+	// each plane is loaded as (normal, dist) then transposed to get one component per register
+	__m128 nx = _mm_loadu_ps(planes[0]->normal);
+	__m128 ny = _mm_loadu_ps(planes[1]->normal);
+	__m128 nz = _mm_loadu_ps(planes[2]->normal);
+	__m128 dist = _mm_loadu_ps(planes[3]->normal);
+	_MM_TRANSPOSE4_PS(nx, ny, nz, dist);
+
+	if (sphere)
+	{
+		// find the closest point on the capsule to the plane
+		__m128 t = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(sphere->offset[0])), _mm_mul_ps(ny, _mm_set1_ps(sphere->offset[1]))),
+			_mm_mul_ps(nz, _mm_set1_ps(sphere->offset[2]))
+		);
+		t = _mm_andnot_ps(_mm_set1_ps(-0.f), t);
+
+		// adjust the plane distance apropriately for radius
+		dist = _mm_add_ps(_mm_add_ps(t, dist), _mm_set1_ps(sphere->radius));
+	}
+	else
+	{
+		// adjust the plane distance apropriately for mins/maxs
+		__m128 ox = LoadVec3(tw->offsets[planes[0]->signbits]);
+		__m128 oy = LoadVec3(tw->offsets[planes[1]->signbits]);
+		__m128 oz = LoadVec3(tw->offsets[planes[2]->signbits]);
+		__m128 ow = LoadVec3(tw->offsets[planes[3]->signbits]);
+		_MM_TRANSPOSE4_PS(ox, oy, oz, ow);
+
+		dist = _mm_sub_ps(dist, _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(ox, nx), _mm_mul_ps(oy, ny)),
+			_mm_mul_ps(oz, nz)
+		));
+	}
+
+	const __m128 startDist = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tw->start[0]), nx), _mm_mul_ps(_mm_set1_ps(tw->start[1]), ny)),
+		_mm_mul_ps(_mm_set1_ps(tw->start[2]), nz)
+	);
+	const __m128 endDist = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tw->end[0]), nx), _mm_mul_ps(_mm_set1_ps(tw->end[1]), ny)),
+		_mm_mul_ps(_mm_set1_ps(tw->end[2]), nz)
+	);
+
+	_mm_storeu_ps(d1, _mm_sub_ps(startDist, dist));
+	_mm_storeu_ps(d2, _mm_sub_ps(endDist, dist));
+#else
+	for (uint32_t i = 0; i < 4 && i < numSides; i++)
+	{
+		const collisionPlane_t* plane = sides[i].plane;
+		float dist;
+
+		if (sphere)
+		{
+			// find the closest point on the capsule to the plane
+			float t = DotProduct(plane->normal, sphere->offset);
+			if (t < 0)
+			{
+				t = -t;
+			}
+
+			// adjust the plane distance apropriately for radius
+			dist = t + plane->dist + sphere->radius;
+		}
+		else
+		{
+			// adjust the plane distance apropriately for mins/maxs
+			dist = plane->dist - DotProduct(tw->offsets[plane->signbits], plane->normal);
+		}
+
+		d1[i] = DotProduct(tw->start, plane->normal) - dist;
+		d2[i] = DotProduct(tw->end, plane->normal) - dist;
+	}
+#endif
+}
+
 /*
 ================
 CollisionWorld::TraceThroughBrush
 ================
 */
-void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t * brush) {
+void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t * brush) const {
 	uint32_t	i;
 	const collisionPlane_t* plane, * clipplane, * clipplane2;
-	float		dist;
 	float		enterFrac, leaveFrac, leaveFrac2;
 	float		d1, d2;
+	float		sideD1[4], sideD2[4];
 	bool	getout, startout;
 	float		f;
 	const collisionBrushSide_t* side, * leadside, * leadside2;
-	float		t;
 
 	if (!brush->numsides) {
 		return;
@@ -1219,8 +1407,9 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 	leaveFrac = 1.0;
 	clipplane = NULL;
 
-	c_brush_traces++;
+	tw->context->c_brush_traces++;
 
+	const sphere_t& sphere = tw->context->sphere;
 	getout = false;
 	startout = false;
 
@@ -1236,18 +1425,12 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 				side = brush->sides + i;
 				plane = side->plane;
 
-				// find the closest point on the capsule to the plane
-				t = DotProduct(plane->normal, sphere.offset);
-				if (t < 0)
-				{
-					t = -t;
+				if (!(i & 3)) {
+					BrushSideDistances(tw, &sphere, side, brush->numsides - i, sideD1, sideD2);
 				}
 
-				// adjust the plane distance apropriately for radius
-				dist = t + plane->dist + sphere.radius;
-
-				d1 = DotProduct(tw->start, plane->normal) - dist;
-				d2 = DotProduct(tw->end, plane->normal) - dist;
+				d1 = sideD1[i & 3];
+				d2 = sideD2[i & 3];
 
 				// if it doesn't cross the plane, the plane isn't relevent
 				if (d1 <= 0 && d2 <= 0) {
@@ -1299,11 +1482,12 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 				side = brush->sides + i;
 				plane = side->plane;
 
-				// adjust the plane distance apropriately for mins/maxs
-				dist = plane->dist - DotProduct(tw->offsets[plane->signbits], plane->normal);
+				if (!(i & 3)) {
+					BrushSideDistances(tw, NULL, side, brush->numsides - i, sideD1, sideD2);
+				}
 
-				d1 = DotProduct(tw->start, plane->normal) - dist;
-				d2 = DotProduct(tw->end, plane->normal) - dist;
+				d1 = sideD1[i & 3];
+				d2 = sideD2[i & 3];
 
 				// if it doesn't cross the plane, the plane isn't relevent
 				if (d1 <= 0 && d2 <= 0) {
@@ -1385,11 +1569,12 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 			side = brush->sides + i;
 			plane = side->plane;
 
-			// adjust the plane distance apropriately for mins/maxs
-			dist = plane->dist - DotProduct(tw->offsets[plane->signbits], plane->normal);
+			if (!(i & 3)) {
+				BrushSideDistances(tw, NULL, side, brush->numsides - i, sideD1, sideD2);
+			}
 
-			d1 = DotProduct(tw->start, plane->normal) - dist;
-			d2 = DotProduct(tw->end, plane->normal) - dist;
+			d1 = sideD1[i & 3];
+			d2 = sideD2[i & 3];
 
 			// if it doesn't cross the plane, the plane isn't relevent
 			if (d1 <= 0 && d2 <= 0) {
@@ -1439,7 +1624,7 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 					enterFrac = 0;
 				}
 
-				if (CollisionWorld::TraceThroughFence(tw, brush, leadside, enterFrac)) {
+				if (CollisionWorld::TraceThroughFence(tw, leadside, enterFrac)) {
 					tw->trace.fraction = enterFrac;
 					tw->trace.plane = *clipplane;
 					tw->trace.surfaceFlags = leadside->surfaceFlags;
@@ -1451,7 +1636,7 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 
 			if ((leaveFrac2 < 1.0) && (leadside2->surfaceFlags & SURF_BACKSIDE)) {
 				if (leaveFrac2 < tw->trace.fraction) {
-					if (CollisionWorld::TraceThroughFence(tw, brush, leadside2, leaveFrac)) {
+					if (CollisionWorld::TraceThroughFence(tw, leadside2, leaveFrac)) {
 						tw->trace.fraction = leaveFrac2;
 						tw->trace.plane = *clipplane2;
 						tw->trace.surfaceFlags = leadside2->surfaceFlags;
@@ -1470,21 +1655,29 @@ void CollisionWorld::TraceThroughBrush(traceWork_t * tw, const collisionBrush_t
 CollisionWorld::TraceToLeaf
 ================
 */
-void CollisionWorld::TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
+void CollisionWorld::TraceToLeaf(traceWork_t * tw, const collisionLeaf_t * leaf) const
 {
+	if (leaf == &tw->context->boxModel.leaf)
+	{
+		// the temporary box is not part of the world
+		if (tw->context->boxBrush.contents & tw->contents) {
+			CollisionWorld::TraceThroughBrush(tw, &tw->context->boxBrush);
+		}
+		return;
+	}
+
 	if(leaf->numLeafBrushes != -1)
 	{
 		// test box position against all brushes in the leaf
 		for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++)
 		{
 			const intptr_t leafNum = leafbrushes[leaf->firstLeafBrush + k];
-			collisionBrush_t* b = &brushes[leafNum];
-			if (b->checkcount == checkcount)
+			const collisionBrush_t* b = &brushes[leafNum];
+			if (!MarkBrush(*tw->context, b))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			b->checkcount = checkcount;
 
 			if (!(b->contents & tw->contents)) {
 				continue;
@@ -1503,16 +1696,15 @@ void CollisionWorld::TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 		for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++)
 		{
 			const intptr_t leafNum = leafsurfaces[leaf->firstLeafSurface + k];
-			collisionPatch_t* patch = surfaces[leafNum];
+			const collisionPatch_t* patch = surfaces[leafNum];
 			if (!patch) {
 				continue;
 			}
-			if (patch->checkcount == checkcount)
+			if (!MarkPatch(*tw->context, patch))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			patch->checkcount = checkcount;
 
 			if (!(patch->contents & tw->contents)) {
 				continue;
@@ -1530,16 +1722,15 @@ void CollisionWorld::TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 		// test against all terrains
 		for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++)
 		{
-			collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+			const collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
 			if (!terrain) {
 				continue;
 			}
-			if (terrain->checkcount == checkcount)
+			if (!MarkTerrain(*tw->context, terrain))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			terrain->checkcount = checkcount;
 
 			CollisionWorld::TraceThroughTerrain(tw, terrain);
 			if (!tw->trace.fraction) {
@@ -1549,6 +1740,118 @@ void CollisionWorld::TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 	}
 }
 
+/*
+================
+BeginObjectTrace
+
+Each object is traced against a fraction right above the closest hit,
+so an object hitting at the exact same fraction is noticed
+================
+*/
+static void BeginObjectTrace(traceWork_t* tw, const trace_t& closest)
+{
+	tw->trace = closest;
+	if (closest.fraction < 1) {
+		tw->trace.fraction = std::nextafter(closest.fraction, 2.f);
+	}
+}
+
+/*
+================
+EndObjectTrace
+
+Return false if the object was hit at the same fraction as the closest hit
+================
+*/
+static bool EndObjectTrace(const traceWork_t* tw, trace_t& closest)
+{
+	if (tw->trace.fraction < closest.fraction)
+	{
+		closest = tw->trace;
+		return true;
+	}
+
+	if (tw->trace.fraction == closest.fraction && closest.fraction < 1)
+	{
+		// the order in which objects are tested decides which one is reported
+		return false;
+	}
+
+	// missed, but the trace may have started inside
+	closest.startsolid = tw->trace.startsolid;
+	return true;
+}
+
+/*
+================
+CollisionWorld::TraceThroughObjects
+
+Same as TraceThroughTree, with the objects gathered by BoxTraceBatch.
+The objects are not in the order the tree would test them,
+return false if two objects were hit at the same fraction
+================
+*/
+bool CollisionWorld::TraceThroughObjects(traceWork_t* tw) const
+{
+	const traceContext_t& context = *tw->context;
+	const trace_t start = tw->trace;
+	trace_t closest = start;
+	vec3_t mins, maxs;
+	int i;
+
+	// brushes further than this can't be reached by the trace
+	for (i = 0; i < 3; i++) {
+		mins[i] = tw->bounds[0][i] - 1;
+		maxs[i] = tw->bounds[1][i] + 1;
+	}
+
+	for (const collisionBrush_t* b : context.batchBrushes)
+	{
+		if (!(b->contents & tw->contents)) {
+			continue;
+		}
+
+		if (!CollisionWorld::BoundsIntersect(b->bounds[0], b->bounds[1], mins, maxs)) {
+			// gathered by another trace of the group
+			continue;
+		}
+
+		BeginObjectTrace(tw, closest);
+		CollisionWorld::TraceThroughBrush(tw, b);
+		if (!EndObjectTrace(tw, closest)) {
+			tw->trace = start;
+			return false;
+		}
+	}
+
+	for (const collisionPatch_t* patch : context.batchPatches)
+	{
+		if (!(patch->contents & tw->contents)) {
+			continue;
+		}
+
+		BeginObjectTrace(tw, closest);
+		CollisionWorld::TraceThroughPatch(tw, patch);
+		if (!EndObjectTrace(tw, closest)) {
+			tw->trace = start;
+			return false;
+		}
+	}
+
+	for (const collisionTerrain_t* terrain : context.batchTerrains)
+	{
+		BeginObjectTrace(tw, closest);
+		CollisionWorld::TraceThroughTerrain(tw, terrain);
+		if (!EndObjectTrace(tw, closest)) {
+			tw->trace = start;
+			return false;
+		}
+	}
+
+	tw->trace = closest;
+	return true;
+}
+
 #define RADIUS_EPSILON		1.0f
 
 /*
@@ -1558,7 +1861,7 @@ CollisionWorld::TraceThroughSphere
 get the first intersection of the ray with the sphere
 ================
 */
-void CollisionWorld::TraceThroughSphere(traceWork_t * tw, vec3_t origin, float radius, vec3_t start, vec3_t end) {
+void CollisionWorld::TraceThroughSphere(traceWork_t * tw, vec3_t origin, float radius, vec3_t start, vec3_t end) const {
 	float l1, l2, length, scale, fraction;
 	float a, b, c, d, sqrtd;
 	vec3_t v1, dir, intersection;
@@ -1645,7 +1948,7 @@ get the first intersection of the ray with the cylinder
 the cylinder extends halfheight above and below the origin
 ================
 */
-void CollisionWorld::TraceThroughVerticalCylinder(traceWork_t * tw, vec3_t origin, float radius, float halfheight, vec3_t start, vec3_t end) {
+void CollisionWorld::TraceThroughVerticalCylinder(traceWork_t * tw, vec3_t origin, float radius, float halfheight, vec3_t start, vec3_t end) const {
 	float length, scale, fraction, l1, l2;
 	float a, b, c, d, sqrtd;
 	vec3_t v1, dir, start2d, end2d, org2d, intersection;
@@ -1747,14 +2050,15 @@ CollisionWorld::TraceCapsuleThroughCapsule
 capsule vs. capsule collision (not rotated)
 ================
 */
-void CollisionWorld::TraceCapsuleThroughCapsule(traceWork_t * tw, clipHandle_t model) {
+void CollisionWorld::TraceCapsuleThroughCapsule(traceWork_t * tw, clipHandle_t model) const {
 	int i;
 	vec3_t mins, maxs;
 	vec3_t top, bottom, starttop, startbottom, endtop, endbottom;
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, h;
+	const sphere_t& sphere = tw->context->sphere;
 
-	CollisionWorld::ModelBounds(model, mins, maxs);
+	CollisionWorld::ModelBounds(*tw->context, model, mins, maxs);
 	// test trace bounds vs. capsule bounds
 	if (tw->bounds[0][0] > maxs[0] + RADIUS_EPSILON
 		|| tw->bounds[0][1] > maxs[1] + RADIUS_EPSILON
@@ -1809,15 +2113,16 @@ CollisionWorld::TraceBoundingBoxThroughCapsule
 bounding box vs. capsule collision
 ================
 */
-void CollisionWorld::TraceBoundingBoxThroughCapsule(traceWork_t * tw, clipHandle_t model) {
+void CollisionWorld::TraceBoundingBoxThroughCapsule(traceWork_t * tw, clipHandle_t model) const {
 	vec3_t mins, maxs;
 	vec3_t offset, size[2];
 	clipHandle_t h;
-	collisionModel_t* cmod;
+	const collisionModel_t* cmod;
 	int i;
+	sphere_t& sphere = tw->context->sphere;
 
 	// mins maxs of the capsule
-	CollisionWorld::ModelBounds(model, mins, maxs);
+	CollisionWorld::ModelBounds(*tw->context, model, mins, maxs);
 
 	// offset for capsule center
 	for (i = 0; i < 3; i++) {
@@ -1834,9 +2139,9 @@ void CollisionWorld::TraceBoundingBoxThroughCapsule(traceWork_t * tw, clipHandle
 	VecSet(sphere.offset, 0, 0, size[1][2] - sphere.radius);
 
 	// replace the capsule with the bounding box
-	h = CollisionWorld::TempBoxModel(tw->size[0], tw->size[1], false);
+	h = CollisionWorld::TempBoxModel(*tw->context, tw->size[0], tw->size[1], false);
 	// calculate collision
-	cmod = CollisionWorld::ClipHandleToModel(h);
+	cmod = CollisionWorld::ClipHandleToModel(*tw->context, h);
 	CollisionWorld::TraceToLeaf(tw, &cmod->leaf);
 }
 
@@ -1852,7 +2157,7 @@ trace volumes it is possible to hit something in a later leaf with
 a smaller intercept fraction.
 ==================
 */
-void CollisionWorld::TraceThroughTree(traceWork_t * tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) {
+void CollisionWorld::TraceThroughTree(traceWork_t * tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) const {
 	const collisionNode_t* node;
 	const collisionPlane_t* plane;
 	float		t1, t2, offset;
@@ -1970,20 +2275,75 @@ CollisionWorld::BoxTrace
 void CollisionWorld::BoxTrace(trace_t * results, const vec3r_t start, const vec3r_t end,
 	const vec3r_t mins, const vec3r_t maxs,
 	clipHandle_t model, uint32_t brushmask, bool cylinder) {
-	int			i;
+	CollisionWorld::BoxTrace(defaultContext, results, start, end, mins, maxs, model, brushmask, cylinder);
+}
+
+void CollisionWorld::BoxTrace(traceContext_t& context, trace_t * results, const vec3r_t start, const vec3r_t end,
+	const vec3r_t mins, const vec3r_t maxs,
+	clipHandle_t model, uint32_t brushmask, bool cylinder) const {
 	traceWork_t	tw;
-	vec3_t		offset;
-	collisionModel_t* cmod;
+	const collisionModel_t* cmod;
+	sphere_t& sphere = context.sphere;
 
-	cmod = CollisionWorld::ClipHandleToModel(model);
+	cmod = CollisionWorld::ClipHandleToModel(context, model);
 
-	this->checkcount++;		// for multi-check avoidance
+	CollisionWorld::BeginTrace(context);	// for multi-check avoidance
 
-	c_traces++;				// for statistics, may be zeroed
+	context.c_traces++;		// for statistics, may be zeroed
+
+	const bool positionTest = CollisionWorld::InitTraceWork(context, tw, start, end, mins, maxs, brushmask);
+
+	if (cylinder && !sphere.use)
+	{
+		sphere.use = true;
+		sphere.radius = (tw.size[1][0] > tw.size[1][2]) ? tw.size[1][2] : tw.size[1][0];
+		VecSet(sphere.offset, 0, 0, tw.size[1][2] - sphere.radius);
+	}
+
+	//
+	// check for position test special case
+	//
+	if (positionTest) {
+		if (model) {
+			CollisionWorld::TestInLeaf(&tw, &cmod->leaf);
+		}
+		else {
+			CollisionWorld::PositionTest(&tw);
+		}
+	}
+	else {
+		//
+		// general sweeping through world
+		//
+		if (model) {
+			CollisionWorld::TraceToLeaf(&tw, &cmod->leaf);
+		}
+		else {
+			CollisionWorld::TraceThroughTree(&tw, 0, 0, 1, tw.start, tw.end);
+		}
+	}
+
+	CollisionWorld::FinishTraceWork(tw, start, end, results);
+	sphere.use = false;
+}
+
+/*
+==================
+CollisionWorld::InitTraceWork
+
+Setup the trace work for sweeping a box from start to end.
+Return true if this is a position test
+==================
+*/
+bool CollisionWorld::InitTraceWork(traceContext_t& context, traceWork_t& tw, const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, uint32_t brushmask) const
+{
+	int			i;
+	vec3_t		offset;
 
 	// fill in a default trace
 	std::memset(&tw, 0, sizeof(tw));
 	tw.trace.fraction = 1;	// assume it goes the entire distance until shown otherwise
+	tw.context = &context;
 
 	// set basic parms
 	tw.trace.location = -1; // clear out unneeded location
@@ -2002,13 +2362,6 @@ void CollisionWorld::BoxTrace(trace_t * results, const vec3r_t start, const vec3
 
 	tw.height = tw.size[1][2];
 	tw.radius = tw.size[1][0];
-
-	if (cylinder && !sphere.use)
-	{
-		sphere.use = true;
-		sphere.radius = (tw.size[1][0] > tw.size[1][2]) ? tw.size[1][2] : tw.size[1][0];
-		VecSet(sphere.offset, 0, 0, tw.size[1][2] - sphere.radius);
-	}
 	tw.maxOffset = tw.size[1][0] + tw.size[1][1] + tw.size[1][2];
 
 	// tw.offsets[signbits] = vector to apropriate corner from origin
@@ -2058,61 +2411,160 @@ void CollisionWorld::BoxTrace(trace_t * results, const vec3r_t start, const vec3
 		}
 	}
 
+	if (start[0] == end[0] && start[1] == end[1] && start[2] == end[2]) {
+		return true;
+	}
+
 	//
-	// check for position test special case
+	// check for point special case
 	//
-	if (start[0] == end[0] && start[1] == end[1] && start[2] == end[2]) {
-		if (cmod) {
-			CollisionWorld::TestInLeaf(&tw, &cmod->leaf);
-		}
-		else {
-			CollisionWorld::PositionTest(&tw);
-		}
+	if (tw.size[0][0] == 0 && tw.size[0][1] == 0 && tw.size[0][2] == 0) {
+		tw.isPoint = true;
+		VectorClear(tw.extents);
 	}
 	else {
-		//
-		// check for point special case
-		//
-		if (tw.size[0][0] == 0 && tw.size[0][1] == 0 && tw.size[0][2] == 0) {
-			tw.isPoint = true;
-			VectorClear(tw.extents);
-		}
-		else {
-			tw.isPoint = false;
-			tw.extents[0] = tw.size[1][0];
-			tw.extents[1] = tw.size[1][1];
-			tw.extents[2] = tw.size[1][2];
-		}
-
-		//
-		// general sweeping through world
-		//
-		if (cmod) {
-			CollisionWorld::TraceToLeaf(&tw, &cmod->leaf);
-		}
-		else {
-			CollisionWorld::TraceThroughTree(&tw, 0, 0, 1, tw.start, tw.end);
-		}
+		tw.isPoint = false;
+		tw.extents[0] = tw.size[1][0];
+		tw.extents[1] = tw.size[1][1];
+		tw.extents[2] = tw.size[1][2];
 	}
 
+	return false;
+}
+
+/*
+==================
+CollisionWorld::FinishTraceWork
+==================
+*/
+void CollisionWorld::FinishTraceWork(const traceWork_t& tw, const vec3r_t start, const vec3r_t end, trace_t* results) const
+{
+	*results = tw.trace;
+
 	// generate endpos from the original, unmodified start/end
-	if (tw.trace.fraction == 1) {
-		VecCopy(end, tw.trace.endpos);
+	if (results->fraction == 1) {
+		VecCopy(end, results->endpos);
 	}
 	else {
-		for (i = 0; i < 3; i++) {
-			tw.trace.endpos[i] = start[i] + tw.trace.fraction * (end[i] - start[i]);
+		for (int i = 0; i < 3; i++) {
+			results->endpos[i] = start[i] + results->fraction * (end[i] - start[i]);
 		}
 	}
 
 	// If allsolid is set (was entirely inside something solid), the plane is not valid.
 	// If fraction == 1.0, we never hit anything, and thus the plane is not valid.
 	// Otherwise, the normal on the plane should have unit length
-	assert(tw.trace.allsolid ||
-		tw.trace.fraction == 1.0 ||
-		VectorLengthSquared(tw.trace.plane.normal) > 0.9999);
-	*results = tw.trace;
-	sphere.use = false;
+	assert(results->allsolid ||
+		results->fraction == 1.0 ||
+		VectorLengthSquared(results->plane.normal) > 0.9999);
+}
+
+/*
+==================
+CollisionWorld::BoxTraceBatch
+
+Consecutive traces which bounds overlap are put in the same group.
+The tree is descended once with the bounds of the whole group to gather the touched objects,
+then each trace of the group is only tested against these objects.
+Position tests and traces hitting two objects at the same fraction use the tree
+so they give the same result as BoxTrace
+==================
+*/
+#define MAX_BATCH_TRACES	32
+void CollisionWorld::BoxTraceBatch(traceContext_t& context, const boxTraceInput_t* traces, trace_t* results, size_t count,
+	clipHandle_t model, uint32_t brushmask, bool cylinder) const {
+	traceWork_t	work[MAX_BATCH_TRACES];
+	bool		positionTests[MAX_BATCH_TRACES];
+	leafList_t	ll;
+	size_t		first, num;
+	size_t		i;
+	int			j;
+	sphere_t& sphere = context.sphere;
+
+	if (model)
+	{
+		// inline models are a single leaf, there is no tree to share
+		for (i = 0; i < count; i++) {
+			CollisionWorld::BoxTrace(context, &results[i], traces[i].start, traces[i].end, traces[i].mins, traces[i].maxs, model, brushmask, cylinder);
+		}
+		return;
+	}
+
+	for (first = 0; first < count; first += num)
+	{
+		positionTests[0] = CollisionWorld::InitTraceWork(context, work[0], traces[first].start, traces[first].end, traces[first].mins, traces[first].maxs, brushmask);
+		VecCopy(work[0].bounds[0], ll.bounds[0]);
+		VecCopy(work[0].bounds[1], ll.bounds[1]);
+
+		// add the next traces as long as they overlap the group
+		for (num = 1; num < MAX_BATCH_TRACES && first + num < count; num++)
+		{
+			const boxTraceInput_t& input = traces[first + num];
+			traceWork_t& tw = work[num];
+
+			positionTests[num] = CollisionWorld::InitTraceWork(context, tw, input.start, input.end, input.mins, input.maxs, brushmask);
+			if (!CollisionWorld::BoundsIntersect(tw.bounds[0], tw.bounds[1], ll.bounds[0], ll.bounds[1])) {
+				break;
+			}
+
+			AddPointToBounds(tw.bounds[0], ll.bounds[0], ll.bounds[1]);
+			AddPointToBounds(tw.bounds[1], ll.bounds[0], ll.bounds[1]);
+		}
+
+		// same margin as the position test
+		for (j = 0; j < 3; j++) {
+			ll.bounds[0][j] -= 1;
+			ll.bounds[1][j] += 1;
+		}
+
+		// gather all objects touched by the group
+		context.batchBrushes.clear();
+		context.batchPatches.clear();
+		context.batchTerrains.clear();
+
+		CollisionWorld::BeginTrace(context);
+
+		ll.count = 0;
+		ll.maxcount = 0;
+		ll.list = NULL;
+		ll.storeLeafs = &CollisionWorld::StoreTraceObjects;
+		ll.lastLeaf = 0;
+		ll.overflowed = false;
+		ll.context = &context;
+
+		CollisionWorld::BoxLeafnums_r(&ll, 0);
+
+		for (i = 0; i < num; i++)
+		{
+			const boxTraceInput_t& input = traces[first + i];
+			traceWork_t& tw = work[i];
+
+			context.c_traces++;		// for statistics, may be zeroed
+
+			if (cylinder && !sphere.use)
+			{
+				sphere.use = true;
+				sphere.radius = (tw.size[1][0] > tw.size[1][2]) ? tw.size[1][2] : tw.size[1][0];
+				VecSet(sphere.offset, 0, 0, tw.size[1][2] - sphere.radius);
+			}
+
+			if (positionTests[i])
+			{
+				// the first solid object sets the contents, test them in the same order as BoxTrace
+				CollisionWorld::BeginTrace(context);
+				CollisionWorld::PositionTest(&tw);
+			}
+			else if (!CollisionWorld::TraceThroughObjects(&tw))
+			{
+				// tie between objects, walk the tree like BoxTrace to report the same one
+				CollisionWorld::BeginTrace(context);
+				CollisionWorld::TraceThroughTree(&tw, 0, 0, 1, tw.start, tw.end);
+			}
+
+			CollisionWorld::FinishTraceWork(tw, input.start, input.end, &results[first + i]);
+			sphere.use = false;
+		}
+	}
 }
 
 /*
@@ -2127,6 +2579,14 @@ void CollisionWorld::TransformedBoxTrace(trace_t * results, const vec3r_t start,
 	const vec3r_t mins, const vec3r_t maxs,
 	clipHandle_t model, uint32_t brushmask,
 	const vec3r_t origin, const vec3r_t angles, bool cylinder) {
+	CollisionWorld::TransformedBoxTrace(defaultContext, results, start, end, mins, maxs, model, brushmask, origin, angles, cylinder);
+}
+
+void CollisionWorld::TransformedBoxTrace(traceContext_t& context, trace_t * results, const vec3r_t start, const vec3r_t end,
+	const vec3r_t mins, const vec3r_t maxs,
+	clipHandle_t model, uint32_t brushmask,
+	const vec3r_t origin, const vec3r_t angles, bool cylinder) const {
+	sphere_t&	sphere = context.sphere;
 	trace_t		trace;
 	vec3_t		start_l, end_l;
 	vec3_t		a;
@@ -2192,7 +2652,7 @@ void CollisionWorld::TransformedBoxTrace(trace_t * results, const vec3r_t start,
 	}
 
 	// sweep the box through the model
-	CollisionWorld::BoxTrace(&trace, start_l, end_l, symetricSize[0], symetricSize[1], model, brushmask, cylinder);
+	CollisionWorld::BoxTrace(context, &trace, start_l, end_l, symetricSize[0], symetricSize[1], model, brushmask, cylinder);
 
 	sphere.use = false;
 
@@ -2222,7 +2682,7 @@ void CollisionWorld::TransformedBoxTrace(trace_t * results, const vec3r_t start,
 CollisionWorld::SightTraceThroughPatch
 ================
 */
-bool CollisionWorld::SightTraceThroughPatch(traceWork_t * tw, collisionPatch_t * patch)
+bool CollisionWorld::SightTraceThroughPatch(traceWork_t * tw, const collisionPatch_t * patch) const
 {
 	CollisionWorld::TraceThroughPatchCollide(tw, &patch->pc);
 
@@ -2237,7 +2697,7 @@ bool CollisionWorld::SightTraceThroughPatch(traceWork_t * tw, collisionPatch_t *
 CollisionWorld::SightTraceThroughTerrain
 ================
 */
-bool CollisionWorld::SightTraceThroughTerrain(traceWork_t * tw, collisionTerrain_t * terrain)
+bool CollisionWorld::SightTraceThroughTerrain(traceWork_t * tw, const collisionTerrain_t * terrain) const
 {
 	CollisionWorld::TraceThroughTerrainCollide(tw, &terrain->tc);
 
@@ -2252,7 +2712,7 @@ bool CollisionWorld::SightTraceThroughTerrain(traceWork_t * tw, collisionTerrain
 CollisionWorld::SightTraceThroughBrush
 ================
 */
-bool CollisionWorld::SightTraceThroughBrush(traceWork_t * tw, collisionBrush_t * brush)
+bool CollisionWorld::SightTraceThroughBrush(traceWork_t * tw, const collisionBrush_t * brush) const
 {
 	// They redid the fonction in mohaa
 	CollisionWorld::TraceThroughBrush(tw, brush);
@@ -2268,18 +2728,26 @@ bool CollisionWorld::SightTraceThroughBrush(traceWork_t * tw, collisionBrush_t *
 CollisionWorld::SightTraceToLeaf
 ================
 */
-bool CollisionWorld::SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf) {
-	collisionBrush_t* b;
-	collisionPatch_t* patch;
-	collisionTerrain_t* terrain;
+bool CollisionWorld::SightTraceToLeaf(traceWork_t* tw, const collisionLeaf_t* leaf) const {
+	const collisionBrush_t* b;
+	const collisionPatch_t* patch;
+	const collisionTerrain_t* terrain;
+
+	if (leaf == &tw->context->boxModel.leaf)
+	{
+		// the temporary box is not part of the world
+		if (!(tw->context->boxBrush.contents & tw->contents)) {
+			return true;
+		}
+		return CollisionWorld::SightTraceThroughBrush(tw, &tw->context->boxBrush);
+	}
 
 	// test box position against all brushes in the leaf
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
 		b = &this->brushes[this->leafbrushes[leaf->firstLeafBrush + k]];
-		if (b->checkcount == this->checkcount) {
+		if (!MarkBrush(*tw->context, b)) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = this->checkcount;
 
 		if (!(b->contents & tw->contents)) {
 			continue;
@@ -2296,10 +2764,9 @@ bool CollisionWorld::SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf) {
 		if (!patch) {
 			continue;
 		}
-		if (patch->checkcount == this->checkcount) {
+		if (!MarkPatch(*tw->context, patch)) {
 			continue;	// already checked this brush in another leaf
 		}
-		patch->checkcount = this->checkcount;
 
 		if (!(patch->contents & tw->contents)) {
 			continue;
@@ -2316,10 +2783,9 @@ bool CollisionWorld::SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf) {
 		if (!terrain) {
 			continue;
 		}
-		if (terrain->checkcount == this->checkcount) {
+		if (!MarkTerrain(*tw->context, terrain)) {
 			continue;
 		}
-		terrain->checkcount = this->checkcount;
 
 		if (!CollisionWorld::SightTraceThroughTerrain(tw, terrain)) {
 			return false;
@@ -2339,7 +2805,7 @@ trace volumes it is possible to hit something in a later leaf with
 a smaller intercept fraction.
 ==================
 */
-bool CollisionWorld::SightTraceThroughTree(traceWork_t * tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) {
+bool CollisionWorld::SightTraceThroughTree(traceWork_t * tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) const {
 	const collisionNode_t* node;
 	const collisionPlane_t* plane;
 	float		t1, t2, offset;
@@ -2448,18 +2914,24 @@ CollisionWorld::BoxSightTrace
 ==================
 */
 bool CollisionWorld::BoxSightTrace(const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, clipHandle_t model, uint32_t brushmask, bool cylinder)
+{
+	return CollisionWorld::BoxSightTrace(defaultContext, start, end, mins, maxs, model, brushmask, cylinder);
+}
+
+bool CollisionWorld::BoxSightTrace(traceContext_t& context, const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, clipHandle_t model, uint32_t brushmask, bool cylinder) const
 {
 	int			i;
 	traceWork_t	tw;
 	vec3_t		offset;
-	collisionModel_t* cmod;
+	const collisionModel_t* cmod;
 	bool	bPassed;
+	sphere_t& sphere = context.sphere;
 
-	cmod = CollisionWorld::ClipHandleToModel(model);
+	cmod = CollisionWorld::ClipHandleToModel(context, model);
 
-	this->checkcount++;		// for multi-check avoidance
+	CollisionWorld::BeginTrace(context);	// for multi-check avoidance
 
-	c_traces++;				// for statistics, may be zeroed
+	context.c_traces++;		// for statistics, may be zeroed
 
 	if (!this->nodes.size()) {
 		return false;
@@ -2468,6 +2940,7 @@ bool CollisionWorld::BoxSightTrace(const vec3r_t start, const vec3r_t end, const
 	// fill in a default trace
 	std::memset(&tw, 0, sizeof(tw));
 	tw.trace.fraction = 1;	// assume it goes the entire distance until shown otherwise
+	tw.context = &context;
 
 	// set basic parms
 	tw.contents = brushmask;
@@ -2591,6 +3064,12 @@ CollisionWorld::TransformedBoxSightTrace
 */
 bool CollisionWorld::TransformedBoxSightTrace(const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, clipHandle_t model, uint32_t brushmask, const vec3r_t origin, const vec3r_t angles, bool cylinder)
 {
+	return CollisionWorld::TransformedBoxSightTrace(defaultContext, start, end, mins, maxs, model, brushmask, origin, angles, cylinder);
+}
+
+bool CollisionWorld::TransformedBoxSightTrace(traceContext_t& context, const vec3r_t start, const vec3r_t end, const vec3r_t mins, const vec3r_t maxs, clipHandle_t model, uint32_t brushmask, const vec3r_t origin, const vec3r_t angles, bool cylinder) const
+{
+	sphere_t&	sphere = context.sphere;
 	vec3_t		start_l, end_l;
 	vec3_t		forward, left, up;
 	vec3_t		temp;
@@ -2654,7 +3133,7 @@ bool CollisionWorld::TransformedBoxSightTrace(const vec3r_t start, const vec3r_t
 	}
 
 	// sweep the box through the model
-	return CollisionWorld::BoxSightTrace(start_l, end_l, symetricSize[0], symetricSize[1], model, brushmask, cylinder);
+	return CollisionWorld::BoxSightTrace(context, start_l, end_l, symetricSize[0], symetricSize[1], model, brushmask, cylinder);
 }
 
 /*
@@ -2663,7 +3142,7 @@ CollisionWorld::PointLeafnum_r
 
 ==================
 */
-int CollisionWorld::PointLeafnum_r(const vec3r_t p, int num) {
+int CollisionWorld::PointLeafnum_r(const vec3r_t p, int num) const {
 	float		d;
 	const collisionNode_t* node;
 	const collisionPlane_t* plane;
@@ -2683,13 +3162,10 @@ int CollisionWorld::PointLeafnum_r(const vec3r_t p, int num) {
 			num = node->children[0];
 	}
 
-	// optimize counter
-	c_pointcontents++;
-
 	return -1 - num;
 }
 
-int CollisionWorld::PointLeafnum(const vec3r_t p)
+int CollisionWorld::PointLeafnum(const vec3r_t p) const
 {
 	if (!this->nodes.size())
 	{
@@ -2709,7 +3185,7 @@ LEAF LISTING
 */
 
 
-void CollisionWorld::StoreLeafs(leafList_t* ll, int nodenum) {
+void CollisionWorld::StoreLeafs(leafList_t* ll, int nodenum) const {
 	int		leafNum;
 
 	leafNum = -1 - nodenum;
@@ -2726,11 +3202,11 @@ void CollisionWorld::StoreLeafs(leafList_t* ll, int nodenum) {
 	ll->list[ll->count++] = leafNum;
 }
 
-void CollisionWorld::StoreBrushes(leafList_t* ll, int nodenum) {
+void CollisionWorld::StoreBrushes(leafList_t* ll, int nodenum) const {
 	uintptr_t leafnum;
 	uintptr_t brushnum;
-	collisionLeaf_t* leaf;
-	collisionBrush_t* b;
+	const collisionLeaf_t* leaf;
+	const collisionBrush_t* b;
 
 	leafnum = -1 - nodenum;
 
@@ -2739,13 +3215,12 @@ void CollisionWorld::StoreBrushes(leafList_t* ll, int nodenum) {
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
 		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
 		b = &this->brushes[brushnum];
-		if (b->checkcount == this->checkcount)
+		if (!MarkBrush(*ll->context, b))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
 
-		b->checkcount = this->checkcount;
 		int i;
 		for (i = 0; i < 3; i++) {
 			if (b->bounds[0][i] >= ll->bounds[1][i] || b->bounds[1][i] <= ll->bounds[0][i]) {
@@ -2760,7 +3235,7 @@ void CollisionWorld::StoreBrushes(leafList_t* ll, int nodenum) {
 			ll->overflowed = true;
 			return;
 		}
-		((collisionBrush_t**)ll->list)[ll->count++] = b;
+		((const collisionBrush_t**)ll->list)[ll->count++] = b;
 	}
 #if 0
 	// store patches?
@@ -2773,6 +3248,73 @@ void CollisionWorld::StoreBrushes(leafList_t* ll, int nodenum) {
 #endif
 }
 
+/*
+==================
+CollisionWorld::StoreTraceObjects
+
+Append the objects of the leaf to the batch lists of the context
+==================
+*/
+void CollisionWorld::StoreTraceObjects(leafList_t* ll, int nodenum) const {
+	traceContext_t& context = *ll->context;
+	const collisionLeaf_t* leaf = &this->leafs[-1 - nodenum];
+
+	if (leaf->numLeafBrushes != -1)
+	{
+		for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++)
+		{
+			const collisionBrush_t* b = &this->brushes[this->leafbrushes[leaf->firstLeafBrush + k]];
+			if (!MarkBrush(context, b))
+			{
+				// already stored from another leaf
+				continue;
+			}
+
+			if (!CollisionWorld::BoundsIntersect(b->bounds[0], b->bounds[1], ll->bounds[0], ll->bounds[1])) {
+				continue;
+			}
+
+			context.batchBrushes.push_back(b);
+		}
+	}
+
+	if (leaf->numLeafSurfaces != -1)
+	{
+		for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++)
+		{
+			const collisionPatch_t* patch = this->surfaces[this->leafsurfaces[leaf->firstLeafSurface + k]];
+			if (!patch) {
+				continue;
+			}
+			if (!MarkPatch(context, patch))
+			{
+				// already stored from another leaf
+				continue;
+			}
+
+			context.batchPatches.push_back(patch);
+		}
+	}
+
+	if (leaf->numLeafTerrains != -1)
+	{
+		for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++)
+		{
+			const collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+			if (!terrain) {
+				continue;
+			}
+			if (!MarkTerrain(context, terrain))
+			{
+				// already stored from another leaf
+				continue;
+			}
+
+			context.batchTerrains.push_back(terrain);
+		}
+	}
+}
+
 /*
 =============
 CollisionWorld::BoxLeafnums
@@ -2780,7 +3322,7 @@ CollisionWorld::BoxLeafnums
 Fills in a list of all the leafs touched
 =============
 */
-void CollisionWorld::BoxLeafnums_r(leafList_t* ll, int nodenum) {
+void CollisionWorld::BoxLeafnums_r(leafList_t* ll, int nodenum) const {
 	const collisionPlane_t* plane;
 	const collisionNode_t* node;
 	int			s;
@@ -2813,11 +3355,9 @@ void CollisionWorld::BoxLeafnums_r(leafList_t* ll, int nodenum) {
 CollisionWorld::BoxLeafnums
 ==================
 */
-size_t	CollisionWorld::BoxLeafnums(const vec3r_t mins, const vec3r_t maxs, int* list, size_t listsize, int* lastLeaf) {
+size_t	CollisionWorld::BoxLeafnums(const vec3r_t mins, const vec3r_t maxs, int* list, size_t listsize, int* lastLeaf) const {
 	leafList_t	ll;
 
-	this->checkcount++;
-
 	VecCopy(mins, ll.bounds[0]);
 	VecCopy(maxs, ll.bounds[1]);
 	ll.count = 0;
@@ -2838,10 +3378,10 @@ size_t	CollisionWorld::BoxLeafnums(const vec3r_t mins, const vec3r_t maxs, int*
 CollisionWorld::BoxBrushes
 ==================
 */
-size_t CollisionWorld::BoxBrushes(const vec3r_t mins, const vec3r_t maxs, collisionBrush_t** list, size_t listsize) {
+size_t CollisionWorld::BoxBrushes(traceContext_t& context, const vec3r_t mins, const vec3r_t maxs, const collisionBrush_t** list, size_t listsize) const {
 	leafList_t	ll;
 
-	this->checkcount++;
+	CollisionWorld::BeginTrace(context);
 
 	VecCopy(mins, ll.bounds[0]);
 	VecCopy(maxs, ll.bounds[1]);
@@ -2851,6 +3391,7 @@ size_t CollisionWorld::BoxBrushes(const vec3r_t mins, const vec3r_t maxs, collis
 	ll.storeLeafs = &CollisionWorld::StoreBrushes;
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
+	ll.context = &context;
 
 	CollisionWorld::BoxLeafnums_r(&ll, 0);
 
@@ -2878,20 +3419,24 @@ CollisionWorld::PointContents
 ==================
 */
 int CollisionWorld::PointContents(const vec3r_t p, clipHandle_t model) {
+	return CollisionWorld::PointContents(defaultContext, p, model);
+}
+
+int CollisionWorld::PointContents(traceContext_t& context, const vec3r_t p, clipHandle_t model) const {
 	uintptr_t leafnum;
 	uintptr_t brushnum;
-	collisionLeaf_t* leaf;
-	collisionBrush_t* b;
+	const collisionLeaf_t* leaf;
+	const collisionBrush_t* b;
 	int			contents;
 	float		d;
-	collisionModel_t* clipm;
+	const collisionModel_t* clipm;
 
 	if (!this->nodes.size()) {	// map not loaded
 		return 0;
 	}
 
 	if (model) {
-		clipm = CollisionWorld::ClipHandleToModel(model);
+		clipm = CollisionWorld::ClipHandleToModel(context, model);
 		leaf = &clipm->leaf;
 	}
 	else {
@@ -2899,10 +3444,19 @@ int CollisionWorld::PointContents(const vec3r_t p, clipHandle_t model) {
 		leaf = &this->leafs[leafnum];
 	}
 
+	// optimize counter
+	context.c_pointcontents++;
+
 	contents = 0;
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		b = &this->brushes[brushnum];
+		if (leaf == &context.boxModel.leaf) {
+			// the temporary box is not part of the world
+			b = &context.boxBrush;
+		}
+		else {
+			brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
+			b = &this->brushes[brushnum];
+		}
 
 		if (!CollisionWorld::BoundsIntersectPoint(b->bounds[0], b->bounds[1], p)) {
 			continue;
@@ -2934,25 +3488,29 @@ CollisionWorld::PointBrushNum
 */
 uintptr_t CollisionWorld::PointBrushNum(const vec3r_t p, clipHandle_t model) {
 	uintptr_t brushnum;
-	collisionLeaf_t* leaf;
-	collisionBrush_t* b;
-	collisionModel_t* clipm;
+	const collisionLeaf_t* leaf;
+	const collisionBrush_t* b;
+	const collisionModel_t* clipm;
 
 	if (!this->nodes.size()) {
 		return 0;
 	}
 
 	if (model) {
-		clipm = CollisionWorld::ClipHandleToModel(model);
+		clipm = CollisionWorld::ClipHandleToModel(defaultContext, model);
+		if (clipm == &defaultContext.boxModel) {
+			// the temporary box has no brush number
+			return -1;
+		}
 		leaf = &clipm->leaf;
 	}
 	else {
-		leaf = &this->leafs[CollisionWorld::PointLeafnum_r(p, 0)];
+		leaf = &std::as_const(leafs)[CollisionWorld::PointLeafnum_r(p, 0)];
 	}
 
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		b = &this->brushes[brushnum];
+		brushnum = std::as_const(leafbrushes)[leaf->firstLeafBrush + k];
+		b = &std::as_const(brushes)[brushnum];
 
 		// see if the point is in the brush
 		uintptr_t i;
@@ -2979,6 +3537,10 @@ rotating entities
 ==================
 */
 int	CollisionWorld::TransformedPointContents(const vec3r_t p, clipHandle_t model, const vec3r_t origin, const vec3r_t angles) {
+	return CollisionWorld::TransformedPointContents(defaultContext, p, model, origin, angles);
+}
+
+int	CollisionWorld::TransformedPointContents(traceContext_t& context, const vec3r_t p, clipHandle_t model, const vec3r_t origin, const vec3r_t angles) const {
 	vec3_t		p_l;
 	vec3_t		temp;
 	vec3_t		forward, right, up;
@@ -2998,7 +3560,7 @@ int	CollisionWorld::TransformedPointContents(const vec3r_t p, clipHandle_t model
 		p_l[2] = DotProduct(temp, up);
 	}
 
-	return CollisionWorld::PointContents(p_l, model);
+	return CollisionWorld::PointContents(context, p_l, model);
 }
 
 /*
@@ -3006,7 +3568,7 @@ int	CollisionWorld::TransformedPointContents(const vec3r_t p, clipHandle_t model
 CollisionWorld::BoundsIntersect
 ====================
 */
-bool CollisionWorld::BoundsIntersect(const vec3r_t mins, const vec3r_t maxs, const vec3r_t mins2, const vec3r_t maxs2)
+bool CollisionWorld::BoundsIntersect(const vec3r_t mins, const vec3r_t maxs, const vec3r_t mins2, const vec3r_t maxs2) const
 {
 	if (maxs[0] < mins2[0] - SURFACE_CLIP_EPSILON ||
 		maxs[1] < mins2[1] - SURFACE_CLIP_EPSILON ||
@@ -3026,7 +3588,7 @@ bool CollisionWorld::BoundsIntersect(const vec3r_t mins, const vec3r_t maxs, con
 CollisionWorld::BoundsIntersectPoint
 ====================
 */
-bool CollisionWorld::BoundsIntersectPoint(const vec3r_t mins, const vec3r_t maxs, const vec3r_t point)
+bool CollisionWorld::BoundsIntersectPoint(const vec3r_t mins, const vec3r_t maxs, const vec3r_t point) const
 {
 	if (maxs[0] < point[0] - SURFACE_CLIP_EPSILON ||
 		maxs[1] < point[1] - SURFACE_CLIP_EPSILON ||
@@ -3046,7 +3608,7 @@ bool CollisionWorld::BoundsIntersectPoint(const vec3r_t mins, const vec3r_t maxs
 TraceThroughFence
 ====================
 */
-bool CollisionWorld::TraceThroughFence(const traceWork_t* tw, const collisionBrush_t* brush, const collisionBrushSide_t* side, float fTraceFraction)
+bool CollisionWorld::TraceThroughFence(const traceWork_t* tw, const collisionBrushSide_t* side, float fTraceFraction) const
 {
 	int				i;
 	int				iMaskPos;
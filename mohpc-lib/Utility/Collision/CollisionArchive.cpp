@@ -1,7 +1,157 @@
 #include <MOHPC/Utility/Collision/CollisionArchive.h>
 
+#include <cstring>
+#include <new>
+#include <vector>
+
 using namespace MOHPC;
 
+namespace
+{
+	enum imageTable_e
+	{
+		IMAGE_SIDEEQUATIONS,
+		IMAGE_PLANES,
+		IMAGE_BRUSHSIDES,
+		IMAGE_NODES,
+		IMAGE_LEAFS,
+		IMAGE_LEAFBRUSHES,
+		IMAGE_LEAFSURFACES,
+		IMAGE_LEAFTERRAINS,
+		IMAGE_MODELS,
+		IMAGE_BRUSHES,
+		IMAGE_SURFACES,
+		IMAGE_TERRAINS,
+		IMAGE_PATCHES,
+		IMAGE_PATCHPLANES,
+		IMAGE_FACETS,
+		// fence masks and shaders, they contain strings so they are serialized
+		IMAGE_SHADERS,
+		IMAGE_NUM_TABLES
+	};
+
+	struct imageTable_t
+	{
+		uint64_t offset;
+		uint64_t count;
+		uint64_t elementSize;
+	};
+
+	struct imageHeader_t
+	{
+		char ident[4];
+		uint32_t version;
+		// written in native order to detect the endianness
+		uint32_t byteOrder;
+		uint32_t pointerSize;
+		imageTable_t tables[IMAGE_NUM_TABLES];
+	};
+
+	constexpr char IMAGE_IDENT[4] = { 'C', 'W', 'I', 'M' };
+	constexpr uint32_t IMAGE_VERSION = 1;
+	constexpr uint32_t IMAGE_BYTEORDER = 0x01020304;
+	constexpr size_t IMAGE_ALIGNMENT = 16;
+
+	// also acts as a layout check, the image is rejected if a structure has a different size
+	constexpr size_t imageElementSizes[IMAGE_NUM_TABLES] =
+	{
+		sizeof(collisionSideEq_t),
+		sizeof(collisionPlane_t),
+		sizeof(collisionBrushSide_t),
+		sizeof(collisionNode_t),
+		sizeof(collisionLeaf_t),
+		sizeof(intptr_t),
+		sizeof(intptr_t),
+		sizeof(OffsetPtr<collisionTerrain_t>),
+		sizeof(collisionModel_t),
+		sizeof(collisionBrush_t),
+		sizeof(OffsetPtr<collisionPatch_t>),
+		sizeof(collisionTerrain_t),
+		sizeof(collisionPatch_t),
+		sizeof(patchPlane_t),
+		sizeof(facet_t),
+		1
+	};
+
+	size_t alignImageOffset(size_t offset)
+	{
+		return (offset + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+	}
+
+	template<typename T>
+	T* getImageTable(std::vector<uint8_t>& image, const imageHeader_t& header, imageTable_e table)
+	{
+		return (T*)(image.data() + header.tables[table].offset);
+	}
+
+	template<typename T>
+	void copyImageTable(std::vector<uint8_t>& image, const imageHeader_t& header, imageTable_e table, const T* elements)
+	{
+		if (header.tables[table].count) {
+			std::memcpy(getImageTable<T>(image, header, table), elements, header.tables[table].count * sizeof(T));
+		}
+	}
+
+	template<typename T>
+	void mapImageTable(CollisionTable<T>& collisionTable, const uint8_t* image, const imageHeader_t& header, imageTable_e table)
+	{
+		collisionTable.map((const T*)(image + header.tables[table].offset), (size_t)header.tables[table].count);
+	}
+
+	// translate a pointer to an element of a world table into the same element of the image table
+	template<typename T>
+	T* remapPointer(const T* ptr, const T* worldTable, T* imageTable)
+	{
+		return ptr ? imageTable + (ptr - worldTable) : nullptr;
+	}
+
+	class BufferArchiveWriter : public IArchiveWriter
+	{
+	public:
+		BufferArchiveWriter(std::vector<uint8_t>& dataRef)
+			: data(dataRef)
+		{}
+
+		void serialize(void* value, size_t size) override
+		{
+			const uint8_t* p = (const uint8_t*)value;
+			data.insert(data.end(), p, p + size);
+		}
+
+	private:
+		std::vector<uint8_t>& data;
+	};
+
+	class BufferArchiveReader : public IArchiveReader
+	{
+	public:
+		BufferArchiveReader(const uint8_t* dataValue, size_t sizeValue)
+			: data(dataValue)
+			, size(sizeValue)
+			, pos(0)
+		{}
+
+		void serialize(void* value, size_t valueSize) override
+		{
+			if (valueSize > size - pos)
+			{
+				// never read past the buffer
+				std::memset(value, 0, valueSize);
+				pos = size;
+				return;
+			}
+
+			std::memcpy(value, data + pos, valueSize);
+			pos += valueSize;
+		}
+
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t pos;
+	};
+}
+
 void CollisionWorldSerializer::save(IArchiveWriter& ar)
 {
 	const size_t numFenceMasks = cm.getNumFenceMasks();
@@ -291,6 +441,231 @@ void CollisionWorldSerializer::load(IArchiveReader& ar)
 	}
 }
 
+void CollisionWorldImage::save(IArchiveWriter& ar)
+{
+	// only read, the tables of a mapped world can't be written to
+	const CollisionWorld& world = cm;
+
+	std::vector<uint8_t> shaderData;
+	BufferArchiveWriter shaderAr(shaderData);
+
+	shaderAr << (uint32_t)world.fencemasks.size();
+	shaderAr << (uint32_t)world.shaders.size();
+
+	// the serializers take mutable objects, fence masks and shaders are never mapped
+	for (size_t i = 0; i < cm.fencemasks.size(); ++i)
+	{
+		CollisionMaskSerializer ser(cm.fencemasks[i]);
+		ser.save(shaderAr);
+	}
+
+	for (size_t i = 0; i < cm.shaders.size(); ++i)
+	{
+		CollisionShaderSerializer ser(cm.shaders[i]);
+		ser.save(shaderAr, cm.fencemasks.data());
+	}
+
+	// planes and facets of all patches are put together
+	size_t numPatchPlanes = 0;
+	size_t numFacets = 0;
+	for (size_t i = 0; i < world.patchList.size(); ++i)
+	{
+		numPatchPlanes += world.patchList[i].pc.numPlanes;
+		numFacets += world.patchList[i].pc.numFacets;
+	}
+
+	const size_t counts[IMAGE_NUM_TABLES] =
+	{
+		world.sideequations.size(),
+		world.planes.size(),
+		world.brushsides.size(),
+		world.nodes.size(),
+		world.leafs.size(),
+		world.leafbrushes.size(),
+		world.leafsurfaces.size(),
+		world.leafterrains.size(),
+		world.cmodels.size(),
+		world.brushes.size(),
+		world.surfaces.size(),
+		world.terrain.size(),
+		world.patchList.size(),
+		numPatchPlanes,
+		numFacets,
+		shaderData.size()
+	};
+
+	imageHeader_t header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.ident, IMAGE_IDENT, sizeof(IMAGE_IDENT));
+	header.version = IMAGE_VERSION;
+	header.byteOrder = IMAGE_BYTEORDER;
+	header.pointerSize = sizeof(void*);
+
+	size_t offset = alignImageOffset(sizeof(imageHeader_t));
+	for (size_t i = 0; i < IMAGE_NUM_TABLES; ++i)
+	{
+		header.tables[i].offset = offset;
+		header.tables[i].count = counts[i];
+		header.tables[i].elementSize = imageElementSizes[i];
+		offset = alignImageOffset(offset + counts[i] * imageElementSizes[i]);
+	}
+
+	std::vector<uint8_t> image(offset);
+	std::memcpy(image.data(), &header, sizeof(header));
+
+	// tables without pointers are copied as they are
+	copyImageTable(image, header, IMAGE_SIDEEQUATIONS, world.sideequations.data());
+	copyImageTable(image, header, IMAGE_PLANES, world.planes.data());
+	copyImageTable(image, header, IMAGE_LEAFS, world.leafs.data());
+	copyImageTable(image, header, IMAGE_LEAFBRUSHES, world.leafbrushes.data());
+	copyImageTable(image, header, IMAGE_LEAFSURFACES, world.leafsurfaces.data());
+	copyImageTable(image, header, IMAGE_MODELS, world.cmodels.data());
+	copyImageTable(image, header, IMAGE_TERRAINS, world.terrain.data());
+	copyImageTable(image, header, IMAGE_SHADERS, shaderData.data());
+
+	// the others are constructed in the image, pointing to elements of the image
+	collisionSideEq_t* sideEquations = getImageTable<collisionSideEq_t>(image, header, IMAGE_SIDEEQUATIONS);
+	collisionPlane_t* planes = getImageTable<collisionPlane_t>(image, header, IMAGE_PLANES);
+	collisionBrushSide_t* brushSides = getImageTable<collisionBrushSide_t>(image, header, IMAGE_BRUSHSIDES);
+	collisionNode_t* nodes = getImageTable<collisionNode_t>(image, header, IMAGE_NODES);
+	OffsetPtr<collisionTerrain_t>* leafTerrains = getImageTable<OffsetPtr<collisionTerrain_t>>(image, header, IMAGE_LEAFTERRAINS);
+	collisionBrush_t* brushes = getImageTable<collisionBrush_t>(image, header, IMAGE_BRUSHES);
+	OffsetPtr<collisionPatch_t>* surfaces = getImageTable<OffsetPtr<collisionPatch_t>>(image, header, IMAGE_SURFACES);
+	collisionTerrain_t* terrains = getImageTable<collisionTerrain_t>(image, header, IMAGE_TERRAINS);
+	collisionPatch_t* patches = getImageTable<collisionPatch_t>(image, header, IMAGE_PATCHES);
+	patchPlane_t* patchPlanes = getImageTable<patchPlane_t>(image, header, IMAGE_PATCHPLANES);
+	facet_t* facets = getImageTable<facet_t>(image, header, IMAGE_FACETS);
+
+	for (size_t i = 0; i < world.brushsides.size(); ++i)
+	{
+		const collisionBrushSide_t& side = world.brushsides[i];
+		collisionBrushSide_t* imageSide = new (&brushSides[i]) collisionBrushSide_t(side);
+		imageSide->plane = remapPointer(side.plane.get(), world.planes.data(), planes);
+		imageSide->pEq = remapPointer(side.pEq.get(), world.sideequations.data(), sideEquations);
+	}
+
+	for (size_t i = 0; i < world.nodes.size(); ++i)
+	{
+		const collisionNode_t& node = world.nodes[i];
+		collisionNode_t* imageNode = new (&nodes[i]) collisionNode_t(node);
+		imageNode->plane = remapPointer(node.plane.get(), world.planes.data(), planes);
+	}
+
+	for (size_t i = 0; i < world.leafterrains.size(); ++i) {
+		new (&leafTerrains[i]) OffsetPtr<collisionTerrain_t>(remapPointer(world.leafterrains[i].get(), world.terrain.data(), terrains));
+	}
+
+	for (size_t i = 0; i < world.brushes.size(); ++i)
+	{
+		const collisionBrush_t& brush = world.brushes[i];
+		collisionBrush_t* imageBrush = new (&brushes[i]) collisionBrush_t(brush);
+		imageBrush->sides = remapPointer(brush.sides.get(), world.brushsides.data(), brushSides);
+	}
+
+	for (size_t i = 0; i < world.surfaces.size(); ++i) {
+		new (&surfaces[i]) OffsetPtr<collisionPatch_t>(remapPointer(world.surfaces[i].get(), world.patchList.data(), patches));
+	}
+
+	size_t patchPlaneNum = 0;
+	size_t facetNum = 0;
+	for (size_t i = 0; i < world.patchList.size(); ++i)
+	{
+		const patchCollide_t& pc = world.patchList[i].pc;
+
+		// never destroyed, it must not free the planes and facets of the image
+		collisionPatch_t* imagePatch = new (&patches[i]) collisionPatch_t(world.patchList[i]);
+		imagePatch->pc.planes = nullptr;
+		imagePatch->pc.facets = nullptr;
+
+		if (pc.numPlanes)
+		{
+			imagePatch->pc.planes = &patchPlanes[patchPlaneNum];
+			std::memcpy(&patchPlanes[patchPlaneNum], pc.planes.get(), pc.numPlanes * sizeof(patchPlane_t));
+			patchPlaneNum += pc.numPlanes;
+		}
+
+		if (pc.numFacets)
+		{
+			imagePatch->pc.facets = &facets[facetNum];
+			std::memcpy(&facets[facetNum], pc.facets.get(), pc.numFacets * sizeof(facet_t));
+			facetNum += pc.numFacets;
+		}
+	}
+
+	ar.serialize(image.data(), image.size());
+}
+
+bool CollisionWorldImage::load(const void* data, size_t size)
+{
+	const uint8_t* image = (const uint8_t*)data;
+	if (size < sizeof(imageHeader_t) || (uintptr_t)image % IMAGE_ALIGNMENT) {
+		return false;
+	}
+
+	const imageHeader_t& header = *(const imageHeader_t*)image;
+	if (std::memcmp(header.ident, IMAGE_IDENT, sizeof(IMAGE_IDENT))
+		|| header.version != IMAGE_VERSION
+		|| header.byteOrder != IMAGE_BYTEORDER
+		|| header.pointerSize != sizeof(void*))
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < IMAGE_NUM_TABLES; ++i)
+	{
+		const imageTable_t& table = header.tables[i];
+		if (table.elementSize != imageElementSizes[i]
+			|| table.offset % IMAGE_ALIGNMENT
+			|| table.offset > size
+			|| table.count > (size - table.offset) / table.elementSize)
+		{
+			return false;
+		}
+	}
+
+	cm.clearAll();
+
+	const imageTable_t& shaderTable = header.tables[IMAGE_SHADERS];
+	BufferArchiveReader shaderAr(image + shaderTable.offset, (size_t)shaderTable.count);
+
+	uint32_t numFenceMasks = 0;
+	uint32_t numShaders = 0;
+	shaderAr >> numFenceMasks;
+	shaderAr >> numShaders;
+
+	if ((uint64_t)numFenceMasks + numShaders > shaderTable.count) {
+		return false;
+	}
+
+	for (size_t i = 0; i < numFenceMasks; ++i)
+	{
+		CollisionMaskSerializer ser(*cm.createFenceMask());
+		ser.load(shaderAr);
+	}
+
+	for (size_t i = 0; i < numShaders; ++i)
+	{
+		CollisionShaderSerializer ser(*cm.createShader());
+		ser.load(shaderAr, cm.getFenceMasks());
+	}
+
+	mapImageTable(cm.sideequations, image, header, IMAGE_SIDEEQUATIONS);
+	mapImageTable(cm.planes, image, header, IMAGE_PLANES);
+	mapImageTable(cm.brushsides, image, header, IMAGE_BRUSHSIDES);
+	mapImageTable(cm.nodes, image, header, IMAGE_NODES);
+	mapImageTable(cm.leafs, image, header, IMAGE_LEAFS);
+	mapImageTable(cm.leafbrushes, image, header, IMAGE_LEAFBRUSHES);
+	mapImageTable(cm.leafsurfaces, image, header, IMAGE_LEAFSURFACES);
+	mapImageTable(cm.leafterrains, image, header, IMAGE_LEAFTERRAINS);
+	mapImageTable(cm.cmodels, image, header, IMAGE_MODELS);
+	mapImageTable(cm.brushes, image, header, IMAGE_BRUSHES);
+	mapImageTable(cm.surfaces, image, header, IMAGE_SURFACES);
+	mapImageTable(cm.terrain, image, header, IMAGE_TERRAINS);
+	mapImageTable(cm.patchList, image, header, IMAGE_PATCHES);
+
+	return true;
+}
+
 void CollisionPlaneSerializer::serialize(IArchive& ar)
 {
 	ar(obj.normal[0]);
@@ -22,7 +22,7 @@ CollisionWorld::TracePointThroughPatchCollide
   special case for point traces because the patch collide "brushes" have no volume
 ====================
 */
-void CollisionWorld::TracePointThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) {
+void CollisionWorld::TracePointThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const {
 	bool frontFacing[MAX_PATCH_PLANES];
 	float intersection[MAX_PATCH_PLANES];
 	float intersect;
@@ -116,7 +116,7 @@ void CollisionWorld::TracePointThroughPatchCollide(traceWork_t* tw, const patchC
 CollisionWorld::CheckFacetPlane
 ====================
 */
-int CollisionWorld::CheckFacetPlane(float* plane, vec3_t start, vec3_t end, float* enterFrac, float* leaveFrac, uint32_t* hit) {
+int CollisionWorld::CheckFacetPlane(float* plane, vec3_t start, vec3_t end, float* enterFrac, float* leaveFrac, uint32_t* hit) const {
 	float d1, d2, f;
 
 	*hit = false;
@@ -167,7 +167,7 @@ int CollisionWorld::CheckFacetPlane(float* plane, vec3_t start, vec3_t end, floa
 CollisionWorld::TraceThroughPatchCollide
 ====================
 */
-void CollisionWorld::TraceThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) {
+void CollisionWorld::TraceThroughPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const {
 	uint32_t i, j, hit, hitnum;
 	float enterFrac, leaveFrac;
 	patchPlane_t* planes;
@@ -258,7 +258,7 @@ CollisionWorld::PositionTestInPatchCollide
 ====================
 */
 // The following code from OpenMOHAA/Quake3 has been slightly modified to adapt to mohaa patch collision
-bool CollisionWorld::PositionTestInPatchCollide(traceWork_t* tw, const patchCollide_t* pc) {
+bool CollisionWorld::PositionTestInPatchCollide(traceWork_t* tw, const patchCollide_t* pc) const {
 	uint32_t i, j;
 	float offset, d;
 	patchPlane_t* planes;
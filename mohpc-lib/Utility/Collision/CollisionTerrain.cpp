@@ -12,13 +12,13 @@ bool ter_usesphere = true;
 CollisionWorld::CheckTerrainPlane
 ====================
 */
-float CollisionWorld::CheckTerrainPlane(const vec4_t plane)
+float CollisionWorld::CheckTerrainPlane(const pointtrace_t& g_trace, const vec4_t plane) const
 {
 	float	d1, d2;
 	float	f;
 
-	d1 = DotProduct(this->g_trace.vStart, plane) - plane[3];
-	d2 = DotProduct(this->g_trace.vEnd, plane) - plane[3];
+	d1 = DotProduct(g_trace.vStart, plane) - plane[3];
+	d2 = DotProduct(g_trace.vEnd, plane) - plane[3];
 
 	// if completely in front of face, no intersection with the entire brush
 	if (d1 > 0 && (d2 >= SURFACE_CLIP_EPSILON || d2 >= d1)) {
@@ -53,7 +53,7 @@ float CollisionWorld::CheckTerrainPlane(const vec4_t plane)
 CollisionWorld::CheckTerrainTriSpherePoint
 ====================
 */
-float CollisionWorld::CheckTerrainTriSpherePoint(const vec3_t v)
+float CollisionWorld::CheckTerrainTriSpherePoint(const pointtrace_t& g_trace, const vec3_t v) const
 {
 	vec3_t	vDelta, vDir;
 	float	fLenSq;
@@ -63,35 +63,36 @@ float CollisionWorld::CheckTerrainTriSpherePoint(const vec3_t v)
 	float	fFrac;
 	float	fSq;
 	float	f;
+	const sphere_t& sphere = g_trace.tw->context->sphere;
 
-	VecSubtract(this->g_trace.vStart, v, vDir);
+	VecSubtract(g_trace.vStart, v, vDir);
 
 	fRadSq = sphere.radius * sphere.radius;
 	fLenSq = VectorLengthSquared(vDir);
 
 	if (fLenSq <= fRadSq) {
-		this->g_trace.tw->trace.startsolid = true;
-		this->g_trace.tw->trace.allsolid = true;
+		g_trace.tw->trace.startsolid = true;
+		g_trace.tw->trace.allsolid = true;
 		return 0;
 	}
 
-	VecSubtract(this->g_trace.vEnd, this->g_trace.vStart, vDelta);
+	VecSubtract(g_trace.vEnd, g_trace.vStart, vDelta);
 
 	fA = VectorLengthSquared(vDelta);
 	fB = DotProduct(vDelta, vDir);
 	fDiscr = fB * fB - (fLenSq - fRadSq) * fA;
 
 	if (fDiscr <= 0.0f) {
-		return this->g_trace.tw->trace.fraction;
+		return g_trace.tw->trace.fraction;
 	}
 
 	fSq = sqrtf(fDiscr);
 
 	if (fA > 0)
 	{
-		fFrac = (-fB - fSq) / fA - this->g_trace.fSurfaceClipEpsilon;
+		fFrac = (-fB - fSq) / fA - g_trace.fSurfaceClipEpsilon;
 
-		if (fFrac >= 0.0f && fFrac <= this->g_trace.tw->trace.fraction) {
+		if (fFrac >= 0.0f && fFrac <= g_trace.tw->trace.fraction) {
 			return fFrac;
 		}
 
@@ -100,18 +101,18 @@ float CollisionWorld::CheckTerrainTriSpherePoint(const vec3_t v)
 	}
 	else
 	{
-		fFrac = (-fB + fSq) / fA - this->g_trace.fSurfaceClipEpsilon;
+		fFrac = (-fB + fSq) / fA - g_trace.fSurfaceClipEpsilon;
 
-		if (fFrac >= 0.0f && fFrac <= this->g_trace.tw->trace.fraction) {
+		if (fFrac >= 0.0f && fFrac <= g_trace.tw->trace.fraction) {
 			return fFrac;
 		}
 
 		fFrac = -fB - fSq;
 	}
 
-	f = fFrac / fA - this->g_trace.fSurfaceClipEpsilon;
-	if (f < 0 || f > this->g_trace.tw->trace.fraction) {
-		f = this->g_trace.tw->trace.fraction;
+	f = fFrac / fA - g_trace.fSurfaceClipEpsilon;
+	if (f < 0 || f > g_trace.tw->trace.fraction) {
+		f = g_trace.tw->trace.fraction;
 	}
 
 	return f;
@@ -122,7 +123,7 @@ float CollisionWorld::CheckTerrainTriSpherePoint(const vec3_t v)
 CollisionWorld::CheckTerrainTriSphereCorner
 ====================
 */
-float CollisionWorld::CheckTerrainTriSphereCorner(const vec4_t plane, float x0, float y0, int i, int j)
+float CollisionWorld::CheckTerrainTriSphereCorner(const pointtrace_t& g_trace, const vec4_t plane, float x0, float y0, int i, int j) const
 {
 	vec3_t	v;
 
@@ -130,7 +131,7 @@ float CollisionWorld::CheckTerrainTriSphereCorner(const vec4_t plane, float x0,
 	v[1] = ((j << 6) + y0);
 	v[2] = (plane[3] - (v[1] * plane[1] + v[0] * plane[0])) / plane[2];
 
-	return CollisionWorld::CheckTerrainTriSpherePoint(v);
+	return CollisionWorld::CheckTerrainTriSpherePoint(g_trace, v);
 }
 
 /*
@@ -138,7 +139,7 @@ float CollisionWorld::CheckTerrainTriSphereCorner(const vec4_t plane, float x0,
 CollisionWorld::CheckTerrainTriSphereEdge
 ====================
 */
-float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, float y0, int i0, int j0, int i1, int j1)
+float CollisionWorld::CheckTerrainTriSphereEdge(const pointtrace_t& g_trace, const float* plane, float x0, float y0, int i0, int j0, int i1, int j1) const
 {
 	vec3_t	v0, v1;
 	float	fScale;
@@ -155,6 +156,7 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 	// junk variable(s) as usual
 	float	fLengthSq, fDot;
 	float	fFrac, fFracClip;
+	const sphere_t& sphere = g_trace.tw->context->sphere;
 
 	fScale = 1.0f / plane[2];
 
@@ -166,9 +168,9 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 	v1[1] = (j1 << 6) + y0;
 	v1[2] = (plane[3] - (v1[0] * plane[0] + v1[1] * plane[1])) * fScale;
 
-	VecSubtract(this->g_trace.vStart, v0, vDirTrace);
+	VecSubtract(g_trace.vStart, v0, vDirTrace);
 	VecSubtract(v1, v0, vDirEdge);
-	VecSubtract(this->g_trace.vEnd, this->g_trace.vStart, vDeltaStart);
+	VecSubtract(g_trace.vEnd, g_trace.vStart, vDeltaStart);
 
 	fScale = 1.0f / VectorLengthSquared(vDirEdge);
 	S = DotProduct(vDirTrace, vDirEdge) * fScale;
@@ -183,11 +185,11 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 	if (fLengthSq <= fRadSq)
 	{
 		if (S < 0 || S > 1) {
-			return CollisionWorld::CheckTerrainTriSpherePoint(v0);
+			return CollisionWorld::CheckTerrainTriSpherePoint(g_trace, v0);
 		}
 
-		this->g_trace.tw->trace.startsolid = true;
-		this->g_trace.tw->trace.allsolid = true;
+		g_trace.tw->trace.startsolid = true;
+		g_trace.tw->trace.allsolid = true;
 		return 1;
 	}
 
@@ -196,7 +198,7 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 	fSFromT_Const = fDot * fDot - (fLengthSq - fRadSq) * fSFromT_Scale;
 
 	if (fSFromT_Const <= 0) {
-		return this->g_trace.tw->trace.fraction;
+		return g_trace.tw->trace.fraction;
 	}
 
 	if (fSFromT_Scale > 0) {
@@ -206,19 +208,19 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 		fFrac = (-fDot + sqrtf(fSFromT_Const)) / fSFromT_Scale;
 	}
 
-	fFracClip = fFrac - this->g_trace.fSurfaceClipEpsilon;
-	if (fFrac <= 0 || fFracClip >= this->g_trace.tw->trace.fraction) {
-		return this->g_trace.tw->trace.fraction;
+	fFracClip = fFrac - g_trace.fSurfaceClipEpsilon;
+	if (fFrac <= 0 || fFracClip >= g_trace.tw->trace.fraction) {
+		return g_trace.tw->trace.fraction;
 	}
 
 	fFrac = fFrac * T + S;
 
 	if (fFrac < 0) {
-		return CollisionWorld::CheckTerrainTriSpherePoint(v0);
+		return CollisionWorld::CheckTerrainTriSpherePoint(g_trace, v0);
 	}
 
 	if (fFrac > 1) {
-		return CollisionWorld::CheckTerrainTriSpherePoint(v1);
+		return CollisionWorld::CheckTerrainTriSpherePoint(g_trace, v1);
 	}
 
 	if (fFracClip < 0) {
@@ -232,7 +234,7 @@ float CollisionWorld::CheckTerrainTriSphereEdge(const float* plane, float x0, fl
 CollisionWorld::CheckTerrainTriSphere
 ====================
 */
-float CollisionWorld::CheckTerrainTriSphere(float x0, float y0, int iPlane)
+float CollisionWorld::CheckTerrainTriSphere(pointtrace_t& g_trace, float x0, float y0, int iPlane) const
 {
 	float	fMaxFraction;
 	float	d1, d2;
@@ -242,50 +244,51 @@ float CollisionWorld::CheckTerrainTriSphere(float x0, float y0, int iPlane)
 	bool	bFitsDiag;
 	int		iX[3];
 	int		iY[3];
+	const sphere_t& sphere = g_trace.tw->context->sphere;
 
-	const float* plane = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[iPlane];
-	d1 = DotProduct(this->g_trace.vStart, plane) - plane[3];
-	d2 = DotProduct(this->g_trace.vEnd, plane) - plane[3];
+	const float* plane = g_trace.tc->squares[g_trace.i][g_trace.j].plane[iPlane];
+	d1 = DotProduct(g_trace.vStart, plane) - plane[3];
+	d2 = DotProduct(g_trace.vEnd, plane) - plane[3];
 
 	if (d1 > sphere.radius)
 	{
 		if (d2 >= sphere.radius + SURFACE_CLIP_EPSILON) {
-			return this->g_trace.tw->trace.fraction;
+			return g_trace.tw->trace.fraction;
 		}
 
 		if (d2 >= d1) {
-			return this->g_trace.tw->trace.fraction;
+			return g_trace.tw->trace.fraction;
 		}
 	}
 
 	if (d1 <= -sphere.radius && d2 <= -sphere.radius) {
-		return this->g_trace.tw->trace.fraction;
+		return g_trace.tw->trace.fraction;
 	}
 
 	if (d1 <= d2) {
-		return this->g_trace.tw->trace.fraction;
+		return g_trace.tw->trace.fraction;
 	}
 
 	fMaxFraction = SURFACE_CLIP_EPSILON / (d1 - d2);
-	this->g_trace.fSurfaceClipEpsilon = fMaxFraction;
+	g_trace.fSurfaceClipEpsilon = fMaxFraction;
 	fSpherePlane = (d1 - sphere.radius) / (d1 - d2) - fMaxFraction;
 
 	if (fSpherePlane < 0) {
 		fSpherePlane = 0;
 	}
 
-	if (fSpherePlane >= this->g_trace.tw->trace.fraction) {
-		return this->g_trace.tw->trace.fraction;
+	if (fSpherePlane >= g_trace.tw->trace.fraction) {
+		return g_trace.tw->trace.fraction;
 	}
 
-	d1 = (this->g_trace.vEnd[0] - this->g_trace.vStart[0]) * fSpherePlane + this->g_trace.vEnd[0] - sphere.radius * plane[0] - x0;
-	d2 = (this->g_trace.vEnd[1] - this->g_trace.vStart[1]) * fSpherePlane + this->g_trace.vEnd[1] - sphere.radius * plane[1] - y0;
+	d1 = (g_trace.vEnd[0] - g_trace.vStart[0]) * fSpherePlane + g_trace.vEnd[0] - sphere.radius * plane[0] - x0;
+	d2 = (g_trace.vEnd[1] - g_trace.vStart[1]) * fSpherePlane + g_trace.vEnd[1] - sphere.radius * plane[1] - y0;
 
-	eMode = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].eMode;
+	eMode = g_trace.tc->squares[g_trace.i][g_trace.j].eMode;
 
 	if (eMode == 1 || eMode == 2)
 	{
-		if ((this->g_trace.i + this->g_trace.j) & 1) {
+		if ((g_trace.i + g_trace.j) & 1) {
 			eMode = iPlane ? 6 : 3;
 		}
 		else {
@@ -352,28 +355,28 @@ float CollisionWorld::CheckTerrainTriSphere(float x0, float y0, int iPlane)
             return fSpherePlane;
         }
 
-        return CheckTerrainTriSphereEdge(plane, x0, y0, iX[1], iY[1], iX[2], iY[2]);
+        return CheckTerrainTriSphereEdge(g_trace, plane, x0, y0, iX[1], iY[1], iX[2], iY[2]);
     }
     
     if (bFitsX && !bFitsY) {
         if (bFitsDiag) {
-            return CheckTerrainTriSphereEdge(plane, x0, y0, iX[0], iY[0], iX[1], iY[1]);
+            return CheckTerrainTriSphereEdge(g_trace, plane, x0, y0, iX[0], iY[0], iX[1], iY[1]);
         }
 
-        return CheckTerrainTriSphereCorner(plane, x0, y0, iX[1], iY[1]);
+        return CheckTerrainTriSphereCorner(g_trace, plane, x0, y0, iX[1], iY[1]);
     }
 
     if (!bFitsX && bFitsY) {
         if (bFitsDiag) {
-            return CheckTerrainTriSphereEdge(plane, x0, y0, iX[0], iY[0], iX[2], iY[2]);
+            return CheckTerrainTriSphereEdge(g_trace, plane, x0, y0, iX[0], iY[0], iX[2], iY[2]);
         }
 
-        return CheckTerrainTriSphereCorner(plane, x0, y0, iX[2], iY[2]);
+        return CheckTerrainTriSphereCorner(g_trace, plane, x0, y0, iX[2], iY[2]);
     }
 
     if (!bFitsX && !bFitsY) {
         if (bFitsDiag) {
-            return CheckTerrainTriSphereCorner(plane, x0, y0, iX[0], iY[0]);
+            return CheckTerrainTriSphereCorner(g_trace, plane, x0, y0, iX[0], iY[0]);
         }
     }
 
@@ -385,17 +388,17 @@ float CollisionWorld::CheckTerrainTriSphere(float x0, float y0, int iPlane)
 CollisionWorld::ValidateTerrainCollidePointSquare
 ====================
 */
-bool CollisionWorld::ValidateTerrainCollidePointSquare(float frac)
+bool CollisionWorld::ValidateTerrainCollidePointSquare(const pointtrace_t& g_trace, float frac) const
 {
 	float f;
 
-	f = this->g_trace.vStart[0] + frac * (this->g_trace.vEnd[0] - this->g_trace.vStart[0])
-		- ((this->g_trace.i << 6) + this->g_trace.tc->vBounds[0][0]);
+	f = g_trace.vStart[0] + frac * (g_trace.vEnd[0] - g_trace.vStart[0])
+		- ((g_trace.i << 6) + g_trace.tc->vBounds[0][0]);
 
 	if (f >= 0 && f <= 64)
 	{
-		f = this->g_trace.vStart[1] + frac * (this->g_trace.vEnd[1] - this->g_trace.vStart[1])
-			- ((this->g_trace.j << 6) + this->g_trace.tc->vBounds[0][1]);
+		f = g_trace.vStart[1] + frac * (g_trace.vEnd[1] - g_trace.vStart[1])
+			- ((g_trace.j << 6) + g_trace.tc->vBounds[0][1]);
 
 		if (f >= 0 && f <= 64) {
 			return true;
@@ -410,14 +413,14 @@ bool CollisionWorld::ValidateTerrainCollidePointSquare(float frac)
 CollisionWorld::ValidateTerrainCollidePointTri
 ====================
 */
-bool CollisionWorld::ValidateTerrainCollidePointTri(int eMode, float frac)
+bool CollisionWorld::ValidateTerrainCollidePointTri(const pointtrace_t& g_trace, int eMode, float frac) const
 {
 	float	x0, y0;
 	float	x, y;
 	float	dx, dy;
 
-	x0 = (this->g_trace.i << 6) + this->g_trace.tc->vBounds[0][0];
-	dx = this->g_trace.vStart[0] + (this->g_trace.vEnd[0] - this->g_trace.vStart[0]) * frac;
+	x0 = (g_trace.i << 6) + g_trace.tc->vBounds[0][0];
+	dx = g_trace.vStart[0] + (g_trace.vEnd[0] - g_trace.vStart[0]) * frac;
 	x = x0 + 64;
 
 	if (x0 > dx) {
@@ -428,8 +431,8 @@ bool CollisionWorld::ValidateTerrainCollidePointTri(int eMode, float frac)
 		return false;
 	}
 
-	y0 = (this->g_trace.j << 6) + this->g_trace.tc->vBounds[0][1];
-	dy = this->g_trace.vStart[1] + (this->g_trace.vEnd[1] - this->g_trace.vStart[1]) * frac;
+	y0 = (g_trace.j << 6) + g_trace.tc->vBounds[0][1];
+	dy = g_trace.vStart[1] + (g_trace.vEnd[1] - g_trace.vStart[1]) * frac;
 	y = y0 + 64;
 
 	if (y0 > dy) {
@@ -460,13 +463,13 @@ bool CollisionWorld::ValidateTerrainCollidePointTri(int eMode, float frac)
 CollisionWorld::TestTerrainCollideSquare
 ====================
 */
-bool CollisionWorld::TestTerrainCollideSquare(void)
+bool CollisionWorld::TestTerrainCollideSquare(const pointtrace_t& g_trace) const
 {
 	float	frac0;
 	float	enterFrac;
 	int		eMode;
 
-	eMode = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].eMode;
+	eMode = g_trace.tc->squares[g_trace.i][g_trace.j].eMode;
 
 	if (!eMode) {
 		return false;
@@ -474,10 +477,10 @@ bool CollisionWorld::TestTerrainCollideSquare(void)
 
 	if (eMode >= 0 && eMode <= 2)
 	{
-		enterFrac = CollisionWorld::CheckTerrainPlane(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0]);
+		enterFrac = CollisionWorld::CheckTerrainPlane(g_trace, g_trace.tc->squares[g_trace.i][g_trace.j].plane[0]);
 
-		const float* plane = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[1];
-		frac0 = CollisionWorld::CheckTerrainPlane(plane);
+		const float* plane = g_trace.tc->squares[g_trace.i][g_trace.j].plane[1];
+		frac0 = CollisionWorld::CheckTerrainPlane(g_trace, plane);
 
 		if (eMode == 2)
 		{
@@ -492,25 +495,25 @@ bool CollisionWorld::TestTerrainCollideSquare(void)
 			}
 		}
 
-		if (enterFrac < this->g_trace.tw->trace.fraction && CollisionWorld::ValidateTerrainCollidePointSquare(enterFrac))
+		if (enterFrac < g_trace.tw->trace.fraction && CollisionWorld::ValidateTerrainCollidePointSquare(g_trace, enterFrac))
 		{
-			this->g_trace.tw->trace.fraction = enterFrac;
-			VecCopy(plane, this->g_trace.tw->trace.plane.normal);
-			this->g_trace.tw->trace.plane.dist = plane[3];
+			g_trace.tw->trace.fraction = enterFrac;
+			VecCopy(plane, g_trace.tw->trace.plane.normal);
+			g_trace.tw->trace.plane.dist = plane[3];
 			return true;
 		}
 	}
 	else
 	{
-		const float* plane = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0];
-		enterFrac = CollisionWorld::CheckTerrainPlane(plane);
+		const float* plane = g_trace.tc->squares[g_trace.i][g_trace.j].plane[0];
+		enterFrac = CollisionWorld::CheckTerrainPlane(g_trace, plane);
 
-		if (enterFrac < this->g_trace.tw->trace.fraction
-			&& CollisionWorld::ValidateTerrainCollidePointTri(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].eMode, enterFrac))
+		if (enterFrac < g_trace.tw->trace.fraction
+			&& CollisionWorld::ValidateTerrainCollidePointTri(g_trace, g_trace.tc->squares[g_trace.i][g_trace.j].eMode, enterFrac))
 		{
-			this->g_trace.tw->trace.fraction = enterFrac;
-			VecCopy(plane, this->g_trace.tw->trace.plane.normal);
-			this->g_trace.tw->trace.plane.dist = plane[3];
+			g_trace.tw->trace.fraction = enterFrac;
+			VecCopy(plane, g_trace.tw->trace.plane.normal);
+			g_trace.tw->trace.plane.dist = plane[3];
 			return true;
 		}
 	}
@@ -523,7 +526,7 @@ bool CollisionWorld::TestTerrainCollideSquare(void)
 CollisionWorld::CheckStartInsideTerrain
 ====================
 */
-bool CollisionWorld::CheckStartInsideTerrain(int i, int j, float fx, float fy)
+bool CollisionWorld::CheckStartInsideTerrain(const pointtrace_t& g_trace, int i, int j, float fx, float fy) const
 {
 	const float* plane;
 	float	fDot;
@@ -535,7 +538,7 @@ bool CollisionWorld::CheckStartInsideTerrain(int i, int j, float fx, float fy)
 		return false;
 	}
 
-	if (!this->g_trace.tc->squares[i][j].eMode) {
+	if (!g_trace.tc->squares[i][j].eMode) {
 		return false;
 	}
 
@@ -543,38 +546,38 @@ bool CollisionWorld::CheckStartInsideTerrain(int i, int j, float fx, float fy)
 	{
 		if (fx + fy >= 1)
 		{
-			if (this->g_trace.tc->squares[i][j].eMode == 6) {
+			if (g_trace.tc->squares[i][j].eMode == 6) {
 				return false;
 			}
-			plane = this->g_trace.tc->squares[i][j].plane[0];
+			plane = g_trace.tc->squares[i][j].plane[0];
 		}
 		else
 		{
-			if (this->g_trace.tc->squares[i][j].eMode == 3) {
+			if (g_trace.tc->squares[i][j].eMode == 3) {
 				return false;
 			}
-			plane = this->g_trace.tc->squares[i][j].plane[1];
+			plane = g_trace.tc->squares[i][j].plane[1];
 		}
 	}
 	else
 	{
 		if (fy >= fx)
 		{
-			if (this->g_trace.tc->squares[i][j].eMode == 5) {
+			if (g_trace.tc->squares[i][j].eMode == 5) {
 				return false;
 			}
-			plane = this->g_trace.tc->squares[i][j].plane[0];
+			plane = g_trace.tc->squares[i][j].plane[0];
 		}
 		else
 		{
-			if (this->g_trace.tc->squares[i][j].eMode == 4) {
+			if (g_trace.tc->squares[i][j].eMode == 4) {
 				return false;
 			}
-			plane = this->g_trace.tc->squares[i][j].plane[1];
+			plane = g_trace.tc->squares[i][j].plane[1];
 		}
 	}
 
-	fDot = DotProduct(this->g_trace.vStart, plane);
+	fDot = DotProduct(g_trace.vStart, plane);
 	if (fDot <= plane[3] && fDot + 32.0f >= plane[3]) {
 		return true;
 	}
@@ -587,18 +590,18 @@ bool CollisionWorld::CheckStartInsideTerrain(int i, int j, float fx, float fy)
 CollisionWorld::PositionTestPointInTerrainCollide
 ====================
 */
-bool CollisionWorld::PositionTestPointInTerrainCollide(void)
+bool CollisionWorld::PositionTestPointInTerrainCollide(pointtrace_t& g_trace) const
 {
 	int		i0, j0;
 	float	fx, fy;
 
-	fx = (this->g_trace.vStart[0] - this->g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
-	fy = (this->g_trace.vStart[1] - this->g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
+	fx = (g_trace.vStart[0] - g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
+	fy = (g_trace.vStart[1] - g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
 
 	i0 = (int)floor(fx);
 	j0 = (int)floor(fy);
 
-	return CollisionWorld::CheckStartInsideTerrain(i0, j0, fx - i0, fy - j0);
+	return CollisionWorld::CheckStartInsideTerrain(g_trace, i0, j0, fx - i0, fy - j0);
 }
 
 /*
@@ -606,7 +609,7 @@ bool CollisionWorld::PositionTestPointInTerrainCollide(void)
 CollisionWorld::TracePointThroughTerrainCollide
 ====================
 */
-void CollisionWorld::TracePointThroughTerrainCollide(void)
+void CollisionWorld::TracePointThroughTerrainCollide(pointtrace_t& g_trace) const
 {
 	int i0, j0, i1, j1;
 	int di, dj;
@@ -614,21 +617,21 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 	float fx, fy;
 	float dx, dy, dx2, dy2;
 
-	fx = (this->g_trace.vStart[0] - this->g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
-	fy = (this->g_trace.vStart[1] - this->g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
+	fx = (g_trace.vStart[0] - g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
+	fy = (g_trace.vStart[1] - g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
 	i0 = (int64_t)floor(fx);
 	j0 = (int64_t)floor(fy);
-	i1 = (int64_t)floor((this->g_trace.vEnd[0] - this->g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8));
-	j1 = (int64_t)floor((this->g_trace.vEnd[1] - this->g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8));
+	i1 = (int64_t)floor((g_trace.vEnd[0] - g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8));
+	j1 = (int64_t)floor((g_trace.vEnd[1] - g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8));
 
 	const float dfx = fx - i0;
 	const float dfy = fy - j0;
 
-	if (CollisionWorld::CheckStartInsideTerrain(i0, j0, dfx, dfy))
+	if (CollisionWorld::CheckStartInsideTerrain(g_trace, i0, j0, dfx, dfy))
 	{
-		this->g_trace.tw->trace.startsolid = true;
-		this->g_trace.tw->trace.allsolid = true;
-		this->g_trace.tw->trace.fraction = 0;
+		g_trace.tw->trace.startsolid = true;
+		g_trace.tw->trace.allsolid = true;
+		g_trace.tw->trace.fraction = 0;
 		return;
 	}
 
@@ -644,9 +647,9 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 				return;
 			}
 
-			this->g_trace.i = i0;
-			this->g_trace.j = j0;
-			CollisionWorld::TestTerrainCollideSquare();
+			g_trace.i = i0;
+			g_trace.j = j0;
+			CollisionWorld::TestTerrainCollideSquare(g_trace);
 		}
 		else if (j0 >= j1)
 		{
@@ -655,9 +658,9 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			if (j1 < 0)
 				j1 = 0;
 
-			this->g_trace.i = i0;
-			for (this->g_trace.j = j0; this->g_trace.j >= j1; this->g_trace.j--) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.i = i0;
+			for (g_trace.j = j0; g_trace.j >= j1; g_trace.j--) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return;
 				}
 			}
@@ -669,9 +672,9 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			if (j1 > 7)
 				j1 = 7;
 
-			this->g_trace.i = i0;
-			for (this->g_trace.j = j0; this->g_trace.j <= j1; this->g_trace.j++) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.i = i0;
+			for (g_trace.j = j0; g_trace.j <= j1; g_trace.j++) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return;
 				}
 			}
@@ -690,9 +693,9 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			if (i1 < 0)
 				i1 = 0;
 
-			this->g_trace.j = j0;
-			for (this->g_trace.i = i0; this->g_trace.i >= i1; this->g_trace.i--) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.j = j0;
+			for (g_trace.i = i0; g_trace.i >= i1; g_trace.i--) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					break;
 				}
 			}
@@ -704,9 +707,9 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			if (i1 > 7)
 				i1 = 7;
 
-			this->g_trace.j = j0;
-			for (this->g_trace.i = i0; this->g_trace.i <= i1; this->g_trace.i++) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.j = j0;
+			for (g_trace.i = i0; g_trace.i <= i1; g_trace.i++) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					break;
 				}
 			}
@@ -714,8 +717,8 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 	}
 	else
 	{
-		dx = this->g_trace.vEnd[0] - this->g_trace.vStart[0];
-		dy = this->g_trace.vEnd[1] - this->g_trace.vStart[1];
+		dx = g_trace.vEnd[0] - g_trace.vStart[0];
+		dy = g_trace.vEnd[1] - g_trace.vStart[1];
 
 		if (i1 > i0)
 		{
@@ -748,14 +751,14 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			dx2 = -dx2;
 		}
 
-		this->g_trace.i = i0;
-		this->g_trace.j = j0;
+		g_trace.i = i0;
+		g_trace.j = j0;
 
 		while (1)
 		{
-			if (this->g_trace.i >= 0 && this->g_trace.i <= 7 && this->g_trace.j >= 0 && this->g_trace.j <= 7)
+			if (g_trace.i >= 0 && g_trace.i <= 7 && g_trace.j >= 0 && g_trace.j <= 7)
 			{
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return;
 				}
 			}
@@ -769,13 +772,13 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 			{
 				dy2 -= dx2;
 				dx2 = dy;
-				this->g_trace.i += d1;
+				g_trace.i += d1;
 			}
 			else
 			{
 				dx2 -= dy2;
 				dy2 = dx;
-				this->g_trace.j += d2;
+				g_trace.j += d2;
 			}
 		}
 	}
@@ -786,7 +789,7 @@ void CollisionWorld::TracePointThroughTerrainCollide(void)
 CollisionWorld::TraceCylinderThroughTerrainCollide
 ====================
 */
-void CollisionWorld::TraceCylinderThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc)
+void CollisionWorld::TraceCylinderThroughTerrainCollide(pointtrace_t& g_trace, traceWork_t* tw, const terrainCollide_t* tc) const
 {
 	int i0, j0, i1, j1;
 	float x0, y0;
@@ -807,56 +810,56 @@ void CollisionWorld::TraceCylinderThroughTerrainCollide(traceWork_t* tw, const t
 		j1 = 7;
 
 	y0 = (j0 << 6) + tc->vBounds[0][1];
-	for (this->g_trace.j = j0; this->g_trace.j <= j1; this->g_trace.j++)
+	for (g_trace.j = j0; g_trace.j <= j1; g_trace.j++)
 	{
 		x0 = (i0 << 6) + tc->vBounds[0][0];
-		for (this->g_trace.i = i0; this->g_trace.i <= i1; this->g_trace.i++)
+		for (g_trace.i = i0; g_trace.i <= i1; g_trace.i++)
 		{
-			switch (tc->squares[this->g_trace.i][this->g_trace.j].eMode)
+			switch (tc->squares[g_trace.i][g_trace.j].eMode)
 			{
 			case 1:
 			case 2:
-				enterFrac = CollisionWorld::CheckTerrainTriSphere(x0, y0, 0);
+				enterFrac = CollisionWorld::CheckTerrainTriSphere(g_trace, x0, y0, 0);
 				if (enterFrac < 0)
 					enterFrac = 0;
-				if (enterFrac < this->g_trace.tw->trace.fraction)
+				if (enterFrac < g_trace.tw->trace.fraction)
 				{
-					this->g_trace.tw->trace.fraction = enterFrac;
-					VecCopy(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0], this->g_trace.tw->trace.plane.normal);
-					this->g_trace.tw->trace.plane.dist = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0][3];
+					g_trace.tw->trace.fraction = enterFrac;
+					VecCopy(g_trace.tc->squares[g_trace.i][g_trace.j].plane[0], g_trace.tw->trace.plane.normal);
+					g_trace.tw->trace.plane.dist = g_trace.tc->squares[g_trace.i][g_trace.j].plane[0][3];
 				}
-				enterFrac = CollisionWorld::CheckTerrainTriSphere(x0, y0, 1);
+				enterFrac = CollisionWorld::CheckTerrainTriSphere(g_trace, x0, y0, 1);
 				if (enterFrac < 0)
 					enterFrac = 0;
-				if (enterFrac < this->g_trace.tw->trace.fraction)
+				if (enterFrac < g_trace.tw->trace.fraction)
 				{
-					this->g_trace.tw->trace.fraction = enterFrac;
-					VecCopy(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[1], this->g_trace.tw->trace.plane.normal);
-					this->g_trace.tw->trace.plane.dist = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[1][3];
+					g_trace.tw->trace.fraction = enterFrac;
+					VecCopy(g_trace.tc->squares[g_trace.i][g_trace.j].plane[1], g_trace.tw->trace.plane.normal);
+					g_trace.tw->trace.plane.dist = g_trace.tc->squares[g_trace.i][g_trace.j].plane[1][3];
 				}
 				break;
 			case 3:
 			case 4:
-				enterFrac = CollisionWorld::CheckTerrainTriSphere(x0, y0, 0);
+				enterFrac = CollisionWorld::CheckTerrainTriSphere(g_trace, x0, y0, 0);
 				if (enterFrac < 0)
 					enterFrac = 0;
-				if (enterFrac < this->g_trace.tw->trace.fraction)
+				if (enterFrac < g_trace.tw->trace.fraction)
 				{
-					this->g_trace.tw->trace.fraction = enterFrac;
-					VecCopy(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0], this->g_trace.tw->trace.plane.normal);
-					this->g_trace.tw->trace.plane.dist = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[0][3];
+					g_trace.tw->trace.fraction = enterFrac;
+					VecCopy(g_trace.tc->squares[g_trace.i][g_trace.j].plane[0], g_trace.tw->trace.plane.normal);
+					g_trace.tw->trace.plane.dist = g_trace.tc->squares[g_trace.i][g_trace.j].plane[0][3];
 				}
 				break;
 			case 5:
 			case 6:
-				enterFrac = CollisionWorld::CheckTerrainTriSphere(x0, y0, 1);
+				enterFrac = CollisionWorld::CheckTerrainTriSphere(g_trace, x0, y0, 1);
 				if (enterFrac < 0)
 					enterFrac = 0;
-				if (enterFrac < this->g_trace.tw->trace.fraction)
+				if (enterFrac < g_trace.tw->trace.fraction)
 				{
-					this->g_trace.tw->trace.fraction = enterFrac;
-					VecCopy(this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[1], this->g_trace.tw->trace.plane.normal);
-					this->g_trace.tw->trace.plane.dist = this->g_trace.tc->squares[this->g_trace.i][this->g_trace.j].plane[1][3];
+					g_trace.tw->trace.fraction = enterFrac;
+					VecCopy(g_trace.tc->squares[g_trace.i][g_trace.j].plane[1], g_trace.tw->trace.plane.normal);
+					g_trace.tw->trace.plane.dist = g_trace.tc->squares[g_trace.i][g_trace.j].plane[1][3];
 				}
 				break;
 			default:
@@ -874,7 +877,8 @@ void CollisionWorld::TraceCylinderThroughTerrainCollide(traceWork_t* tw, const t
 CollisionWorld::TraceThroughTerrainCollide
 ====================
 */
-void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) {
+void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const {
+	pointtrace_t g_trace;
 	int i;
 
 	if (tw->bounds[0][0] >= tc->vBounds[1][0] ||
@@ -887,22 +891,23 @@ void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCo
 		return;
 	}
 
-	this->g_trace.tw = tw;
-	this->g_trace.tc = tc;
-	VecCopy(tw->start, this->g_trace.vStart);
-	VecCopy(tw->end, this->g_trace.vEnd);
+	g_trace.tw = tw;
+	g_trace.tc = tc;
+	VecCopy(tw->start, g_trace.vStart);
+	VecCopy(tw->end, g_trace.vEnd);
 
+	const sphere_t& sphere = tw->context->sphere;
 	if (sphere.use && ter_usesphere)
 	{
-		VecSubtract(tw->start, sphere.offset, this->g_trace.vStart);
-		VecSubtract(tw->end, sphere.offset, this->g_trace.vEnd);
-		CollisionWorld::TraceCylinderThroughTerrainCollide(tw, tc);
+		VecSubtract(tw->start, sphere.offset, g_trace.vStart);
+		VecSubtract(tw->end, sphere.offset, g_trace.vEnd);
+		CollisionWorld::TraceCylinderThroughTerrainCollide(g_trace, tw, tc);
 	}
 	else if (tw->isPoint)
 	{
-		VecCopy(tw->start, this->g_trace.vStart);
-		VecCopy(tw->end, this->g_trace.vEnd);
-		CollisionWorld::TracePointThroughTerrainCollide();
+		VecCopy(tw->start, g_trace.vStart);
+		VecCopy(tw->end, g_trace.vEnd);
+		CollisionWorld::TracePointThroughTerrainCollide(g_trace);
 	}
 	else
 	{
@@ -910,10 +915,10 @@ void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCo
 		{
 			for (i = 0; i < 4; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				CollisionWorld::TracePointThroughTerrainCollide();
+				CollisionWorld::TracePointThroughTerrainCollide(g_trace);
 				if (tw->trace.allsolid) {
 					return;
 				}
@@ -923,10 +928,10 @@ void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCo
 		{
 			for (i = 4; i < 8; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				CollisionWorld::TracePointThroughTerrainCollide();
+				CollisionWorld::TracePointThroughTerrainCollide(g_trace);
 				if (tw->trace.allsolid) {
 					return;
 				}
@@ -940,7 +945,8 @@ void CollisionWorld::TraceThroughTerrainCollide(traceWork_t* tw, const terrainCo
 CollisionWorld::PositionTestInTerrainCollide
 ====================
 */
-bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) {
+bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const {
+	pointtrace_t g_trace;
 	int i;
 
 	if (tw->bounds[0][0] >= tc->vBounds[1][0] ||
@@ -953,23 +959,24 @@ bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrain
 		return false;
 	}
 
-	this->g_trace.tw = tw;
-	this->g_trace.tc = tc;
-	VecCopy(tw->start, this->g_trace.vStart);
-	VecCopy(tw->end, this->g_trace.vEnd);
+	g_trace.tw = tw;
+	g_trace.tc = tc;
+	VecCopy(tw->start, g_trace.vStart);
+	VecCopy(tw->end, g_trace.vEnd);
 
+	const sphere_t& sphere = tw->context->sphere;
 	if (sphere.use && ter_usesphere)
 	{
-		VecSubtract(tw->start, sphere.offset, this->g_trace.vStart);
-		VecSubtract(tw->end, sphere.offset, this->g_trace.vEnd);
-		CollisionWorld::TraceCylinderThroughTerrainCollide(tw, tc);
+		VecSubtract(tw->start, sphere.offset, g_trace.vStart);
+		VecSubtract(tw->end, sphere.offset, g_trace.vEnd);
+		CollisionWorld::TraceCylinderThroughTerrainCollide(g_trace, tw, tc);
 		return tw->trace.startsolid;
 	}
 	else if (tw->isPoint)
 	{
-		VecCopy(tw->start, this->g_trace.vStart);
-		VecCopy(tw->end, this->g_trace.vEnd);
-		return CollisionWorld::PositionTestPointInTerrainCollide();
+		VecCopy(tw->start, g_trace.vStart);
+		VecCopy(tw->end, g_trace.vEnd);
+		return CollisionWorld::PositionTestPointInTerrainCollide(g_trace);
 	}
 	else
 	{
@@ -977,10 +984,10 @@ bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrain
 		{
 			for (i = 0; i < 4; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				if (CollisionWorld::PositionTestPointInTerrainCollide()) {
+				if (CollisionWorld::PositionTestPointInTerrainCollide(g_trace)) {
 					return true;
 				}
 			}
@@ -989,10 +996,10 @@ bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrain
 		{
 			for (i = 4; i < 8; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				if (CollisionWorld::PositionTestPointInTerrainCollide()) {
+				if (CollisionWorld::PositionTestPointInTerrainCollide(g_trace)) {
 					return true;
 				}
 			}
@@ -1007,7 +1014,7 @@ bool CollisionWorld::PositionTestInTerrainCollide(traceWork_t* tw, const terrain
 CollisionWorld::SightTracePointThroughTerrainCollide
 ====================
 */
-bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
+bool CollisionWorld::SightTracePointThroughTerrainCollide(pointtrace_t& g_trace) const
 {
 	int		i0, j0;
 	int		i1, j1;
@@ -1016,14 +1023,14 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 	float	dx, dy, dx2, dy2;
 	float	d1, d2;
 
-	fx = (this->g_trace.vStart[0] - this->g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
-	fy = (this->g_trace.vStart[1] - this->g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
+	fx = (g_trace.vStart[0] - g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8);
+	fy = (g_trace.vStart[1] - g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8);
 	i0 = (int)floor(fx);
 	j0 = (int)floor(fy);
-	i1 = (int)floor((this->g_trace.vEnd[0] - this->g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8));
-	j1 = (int)floor((this->g_trace.vEnd[1] - this->g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8));
+	i1 = (int)floor((g_trace.vEnd[0] - g_trace.tc->vBounds[0][0]) * (SURFACE_CLIP_EPSILON / 8));
+	j1 = (int)floor((g_trace.vEnd[1] - g_trace.tc->vBounds[0][1]) * (SURFACE_CLIP_EPSILON / 8));
 
-	if (CollisionWorld::CheckStartInsideTerrain(i0, j0, fx - i0, fy - j0)) {
+	if (CollisionWorld::CheckStartInsideTerrain(g_trace, i0, j0, fx - i0, fy - j0)) {
 		return false;
 	}
 
@@ -1039,9 +1046,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 				return true;
 			}
 
-			this->g_trace.i = i0;
-			this->g_trace.j = j0;
-			return !CollisionWorld::TestTerrainCollideSquare();
+			g_trace.i = i0;
+			g_trace.j = j0;
+			return !CollisionWorld::TestTerrainCollideSquare(g_trace);
 		}
 		else if (j0 >= j1)
 		{
@@ -1050,9 +1057,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			if (j1 < 0)
 				j1 = 0;
 
-			this->g_trace.i = i0;
-			for (this->g_trace.j = j0; this->g_trace.j >= j1; this->g_trace.j--) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.i = i0;
+			for (g_trace.j = j0; g_trace.j >= j1; g_trace.j--) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return false;
 				}
 			}
@@ -1064,9 +1071,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			if (j1 > 7)
 				j1 = 7;
 
-			this->g_trace.i = i0;
-			for (this->g_trace.j = j0; this->g_trace.j <= j1; this->g_trace.j++) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.i = i0;
+			for (g_trace.j = j0; g_trace.j <= j1; g_trace.j++) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return false;
 				}
 			}
@@ -1085,9 +1092,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			if (i1 < 0)
 				i1 = 0;
 
-			this->g_trace.j = j0;
-			for (this->g_trace.i = i0; this->g_trace.i >= i1; this->g_trace.i--) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.j = j0;
+			for (g_trace.i = i0; g_trace.i >= i1; g_trace.i--) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return false;
 				}
 			}
@@ -1099,9 +1106,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			if (i1 > 7)
 				i1 = 7;
 
-			this->g_trace.j = j0;
-			for (this->g_trace.i = i0; this->g_trace.i <= i1; this->g_trace.i++) {
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+			g_trace.j = j0;
+			for (g_trace.i = i0; g_trace.i <= i1; g_trace.i++) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return false;
 				}
 			}
@@ -1109,8 +1116,8 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 	}
 	else
 	{
-		dx = this->g_trace.vEnd[0] - this->g_trace.vStart[0];
-		dy = this->g_trace.vEnd[1] - this->g_trace.vStart[1];
+		dx = g_trace.vEnd[0] - g_trace.vStart[0];
+		dy = g_trace.vEnd[1] - g_trace.vStart[1];
 
 		if (dx > 0)
 		{
@@ -1141,14 +1148,14 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			dx2 = -dx2;
 		}
 
-		this->g_trace.i = i0;
-		this->g_trace.j = j0;
+		g_trace.i = i0;
+		g_trace.j = j0;
 
 		while (1)
 		{
-			if (this->g_trace.i >= 0 && this->g_trace.i <= 7 && this->g_trace.j >= 0 && this->g_trace.j <= 7)
+			if (g_trace.i >= 0 && g_trace.i <= 7 && g_trace.j >= 0 && g_trace.j <= 7)
 			{
-				if (CollisionWorld::TestTerrainCollideSquare()) {
+				if (CollisionWorld::TestTerrainCollideSquare(g_trace)) {
 					return false;
 				}
 			}
@@ -1162,13 +1169,13 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 			{
 				dy2 -= dx2;
 				dx2 = dy;
-				this->g_trace.i += (int)d1;
+				g_trace.i += (int)d1;
 			}
 			else
 			{
 				dx2 -= dy2;
 				dy2 = dx;
-				this->g_trace.j += (int)d2;
+				g_trace.j += (int)d2;
 			}
 		}
 	}
@@ -1181,8 +1188,9 @@ bool CollisionWorld::SightTracePointThroughTerrainCollide(void)
 CollisionWorld::SightTraceThroughTerrainCollide
 ====================
 */
-bool CollisionWorld::SightTraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc)
+bool CollisionWorld::SightTraceThroughTerrainCollide(traceWork_t* tw, const terrainCollide_t* tc) const
 {
+	pointtrace_t g_trace;
 	int i;
 
 	if (tw->bounds[0][0] >= tc->vBounds[1][0] ||
@@ -1195,16 +1203,16 @@ bool CollisionWorld::SightTraceThroughTerrainCollide(traceWork_t* tw, const terr
 		return true;
 	}
 
-	this->g_trace.tw = tw;
-	this->g_trace.tc = tc;
-	VecCopy(tw->start, this->g_trace.vStart);
-	VecCopy(tw->end, this->g_trace.vEnd);
+	g_trace.tw = tw;
+	g_trace.tc = tc;
+	VecCopy(tw->start, g_trace.vStart);
+	VecCopy(tw->end, g_trace.vEnd);
 
 	if (tw->isPoint)
 	{
-		VecCopy(tw->start, this->g_trace.vStart);
-		VecCopy(tw->end, this->g_trace.vEnd);
-		return CollisionWorld::SightTracePointThroughTerrainCollide();
+		VecCopy(tw->start, g_trace.vStart);
+		VecCopy(tw->end, g_trace.vEnd);
+		return CollisionWorld::SightTracePointThroughTerrainCollide(g_trace);
 	}
 	else
 	{
@@ -1212,10 +1220,10 @@ bool CollisionWorld::SightTraceThroughTerrainCollide(traceWork_t* tw, const terr
 		{
 			for (i = 0; i < 4; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				if (!CollisionWorld::SightTracePointThroughTerrainCollide()) {
+				if (!CollisionWorld::SightTracePointThroughTerrainCollide(g_trace)) {
 					return false;
 				}
 			}
@@ -1224,10 +1232,10 @@ bool CollisionWorld::SightTraceThroughTerrainCollide(traceWork_t* tw, const terr
 		{
 			for (i = 4; i < 8; i++)
 			{
-				VecAdd(tw->start, tw->offsets[i], this->g_trace.vStart);
-				VecAdd(tw->end, tw->offsets[i], this->g_trace.vEnd);
+				VecAdd(tw->start, tw->offsets[i], g_trace.vStart);
+				VecAdd(tw->end, tw->offsets[i], g_trace.vEnd);
 
-				if (!CollisionWorld::SightTracePointThroughTerrainCollide()) {
+				if (!CollisionWorld::SightTracePointThroughTerrainCollide(g_trace)) {
 					return false;
 				}
 			}
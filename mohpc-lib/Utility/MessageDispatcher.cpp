@@ -1,6 +1,7 @@
 #include <MOHPC/Utility/MessageDispatcher.h>
 #include <MOHPC/Utility/RequestHandler.h>
 
+#include <algorithm>
 #include <cassert>
 
 using namespace MOHPC;
@@ -18,6 +19,7 @@ bool IRemoteIdentifier::operator!=(const IRemoteIdentifier& other) const
 MOHPC_OBJECT_DEFINITION(MessageDispatcher);
 
 MessageDispatcher::MessageDispatcher()
+	: numActiveHandlers(0)
 {
 	commList.reserve(1);
 	root = last = nullptr;
@@ -37,9 +39,12 @@ void MessageDispatcher::clearHandlers()
 		p->dispatcher = nullptr;
 		p->prev = nullptr;
 		p->next = nullptr;
+		p->active = false;
+		timers.cancel(p);
 	}
 
 	root = last = nullptr;
+	numActiveHandlers = 0;
 }
 
 void MessageDispatcher::addHandler(IncomingMessageHandler* handler)
@@ -57,59 +62,97 @@ void MessageDispatcher::removeHandler(IncomingMessageHandler* handler)
 	if(handler == last) last = last->prev;
 	if(handler->next) handler->next->prev = handler->prev;
 	if(handler->prev) handler->prev->next = handler->next;
+
+	timers.cancel(handler);
+	if (handler->active)
+	{
+		handler->active = false;
+		--numActiveHandlers;
+	}
+
+	// the handler may be removed while expired handlers are processed
+	for (IncomingMessageHandler*& expired : expiredHandlers)
+	{
+		if (expired == handler) {
+			expired = nullptr;
+		}
+	}
 }
 
-bool MessageDispatcher::needsProcessing() const
+void MessageDispatcher::updateHandler(IncomingMessageHandler* handler)
 {
-	for (const IncomingMessageHandler* p = root; p; p = p->next)
+	const bool active = handler->isRequesting();
+	if (active != handler->active)
 	{
-		if(p->isRequesting()) {
-			return true;
-		}
+		handler->active = active;
+		if (active) ++numActiveHandlers;
+		else --numActiveHandlers;
 	}
 
-	return false;
+	std::chrono::steady_clock::time_point nextTime;
+	if (handler->getNextTime(nextTime)) {
+		timers.schedule(handler, nextTime);
+	}
+	else {
+		timers.cancel(handler);
+	}
+}
+
+bool MessageDispatcher::needsProcessing() const
+{
+	return numActiveHandlers > 0;
 }
 
 uint64_t MessageDispatcher::getWaitTime() const
 {
 	using namespace std::chrono;
 
-	time_point<steady_clock> minDeferredTime;
-	// get the first non-zero deferred time
-	for (IncomingMessageHandler* p = root; p; p = p->next)
+	time_point<steady_clock> nextTime;
+	if (timers.getNextTime(nextTime))
 	{
-		const time_point<steady_clock> deferredTime = p->getDeferredTime();
-		if(deferredTime != time_point<steady_clock>(milliseconds(0)))
+		time_point<steady_clock> currentTime = steady_clock::now();
+		if(currentTime >= nextTime)
 		{
-			minDeferredTime = deferredTime;
-			break;
+			// avoid waiting and process the deferred request now
+			return 0;
 		}
+
+		// round up so the time is reached when the wait is over
+		return ceil<milliseconds>(nextTime - currentTime).count();
 	}
 
-	// get the nearest time to process deferred requests
-	for (IncomingMessageHandler* p = root; p; p = p->next)
+	const size_t numObjects = std::max(commList.size(), size_t(1));
+	return 1000 / numObjects;
+}
+
+void MessageDispatcher::processTimers()
+{
+	expiredHandlers.clear();
+	timers.advance(std::chrono::steady_clock::now(), expiredHandlers);
+
+	for (size_t i = 0; i < expiredHandlers.size(); ++i)
 	{
-		const time_point<steady_clock> deferredTime = p->getDeferredTime();
-		if (deferredTime != time_point<steady_clock>(milliseconds(0)) && deferredTime < minDeferredTime) {
-			minDeferredTime = deferredTime;
+		IncomingMessageHandler* handler = expiredHandlers[i];
+		if (!handler) {
+			continue;
 		}
-	}
 
-	if(minDeferredTime != time_point<steady_clock>(milliseconds(0)))
-	{
-		time_point<steady_clock> currentTime = steady_clock::now();
-		if(currentTime > minDeferredTime)
-		{
-			// avoid waiting and process the deferred request now
-			return 0;
+		// process awaiting request
+		handler->processDeferred();
+		if (!expiredHandlers[i]) {
+			continue;
 		}
 
-		return duration_cast<milliseconds>(minDeferredTime - currentTime).count();
+		// process timed out request
+		handler->processTimeOut();
+		if (!expiredHandlers[i]) {
+			continue;
+		}
+
+		updateHandler(handler);
 	}
 
-	const size_t numObjects = commList.size();
-	return 1000 / numObjects;
+	expiredHandlers.clear();
 }
 
 bool MessageDispatcher::processIncomingMessages(uint64_t maxProcessTime)
@@ -122,32 +165,25 @@ bool MessageDispatcher::processIncomingMessages(uint64_t maxProcessTime)
 	bool processed = false;
 	while (needsProcessing())
 	{
-		IncomingMessageHandler* next;
-
-		const size_t numComms = commList.size();
-		if(numComms)
+		if(commList.size())
 		{
 			const uint64_t waitTime = std::min(getWaitTime(), maxProcessTime);
-			for (size_t i = 0; i < numComms; ++i)
+			if (poller && unpolledComms.size() < commList.size())
 			{
-				// wait for a communicator to receive a message
-				processed |= processComm(*commList[i], waitTime);
+				// wait for all watched communicators at once
+				// don't wait if there are other communicators to wait for
+				processed |= processPolledComms(unpolledComms.empty() ? waitTime : 0);
 			}
-		}
 
-		// process awaiting requests
-		for (IncomingMessageHandler* p = root; p; p = next)
-		{
-			next = p->next;
-			p->processDeferred();
+			for (size_t i = 0; i < unpolledComms.size(); ++i)
+			{
+				// wait for a communicator to receive a message
+				processed |= processComm(*unpolledComms[i], waitTime);
+			}
 		}
 
-		// process timed out requests
-		for (IncomingMessageHandler* p = root; p; p = next)
-		{
-			next = p->next;
-			p->processTimeOut();
-		}
+		// process awaiting and timed out requests
+		processTimers();
 
 		if(maxProcessTime == 0)
 		{
@@ -176,11 +212,43 @@ bool MessageDispatcher::hasMessagesToProcess() const
 void MessageDispatcher::addComm(const ICommunicatorPtr& comm)
 {
 	commList.push_back(comm);
+
+	if (!poller || !poller->add(*comm)) {
+		unpolledComms.push_back(comm.get());
+	}
+}
+
+void MessageDispatcher::setPoller(const ICommunicatorPollerPtr& newPoller)
+{
+	if (poller)
+	{
+		for (const ICommunicatorPtr& comm : commList) {
+			poller->remove(*comm);
+		}
+	}
+
+	poller = newPoller;
+	unpolledComms.clear();
+
+	for (const ICommunicatorPtr& comm : commList)
+	{
+		if (!poller || !poller->add(*comm)) {
+			unpolledComms.push_back(comm.get());
+		}
+	}
 }
 
 void MessageDispatcher::clearComms()
 {
+	if (poller)
+	{
+		for (const ICommunicatorPtr& comm : commList) {
+			poller->remove(*comm);
+		}
+	}
+
 	commList.clear();
+	unpolledComms.clear();
 }
 
 bool MessageDispatcher::processComm(ICommunicator& comm, uint64_t maxWaitTime)
@@ -192,11 +260,40 @@ bool MessageDispatcher::processComm(ICommunicator& comm, uint64_t maxWaitTime)
 		return false;
 	}
 
-	// a message was received
+	receiveMessage(comm);
+	return true;
+}
+
+bool MessageDispatcher::processPolledComms(uint64_t maxWaitTime)
+{
+	readyComms.resize(commList.size());
+
+	const size_t numReady = poller->wait(readyComms.data(), readyComms.size(), maxWaitTime);
+	for (size_t i = 0; i < numReady; ++i)
+	{
+		// only communicators that have something to read are processed
+		ICommunicator& comm = *readyComms[i];
+		do
+		{
+			receiveMessage(comm);
+			// communicators can receive multiple messages at once,
+			// they must be all processed as the poller won't signal them again
+		} while (comm.waitIncoming(0));
+	}
+
+	return numReady > 0;
+}
+
+void MessageDispatcher::receiveMessage(ICommunicator& comm)
+{
 	const size_t messageSize = comm.getIncomingSize();
 	if (messageSize > 0)
 	{
-		uint8_t* buf = new uint8_t[messageSize];
+		if (receiveBuffer.size() < messageSize) {
+			receiveBuffer.resize(messageSize);
+		}
+
+		uint8_t* buf = receiveBuffer.data();
 		IRemoteIdentifierPtr remoteAddress;
 		// receive and get remote address
 		const size_t receivedSize = comm.receive(remoteAddress, buf, messageSize);
@@ -228,6 +325,4 @@ bool MessageDispatcher::processComm(ICommunicator& comm, uint64_t maxWaitTime)
 		IRemoteIdentifierPtr remoteAddress;
 		comm.receive(remoteAddress, &nullBuffer, 1);
 	}
-
-	return true;
 }
@@ -113,7 +113,7 @@ public:
 					assert(p2 <= buf + (bits >> 3));
 					const uint8_t value = (*p1 >> subBitNum) | (*p2 << (8 - subBitNum));
 					//const uint8_t value = (*p >> subBitNum) | ((*p >> 8) << (8 - subBitNum));
-					MessageCodecs::Compression::huff.offsetTransmit(value, bitBuffer, &bit);
+					MessageCodecs::Compression::encoder.offsetTransmit(value, bitBuffer, &bit);
 					MessageCodecs::FlushBits(bit, stream, bitBuffer, bufsize);
 				}
 			}
@@ -124,7 +124,7 @@ public:
 				for (size_t i = 0; i < remainingBits; i += 8, ++p)
 				{
 					const uint8_t value = *p;
-					MessageCodecs::Compression::huff.offsetTransmit(value, bitBuffer, &bit);
+					MessageCodecs::Compression::encoder.offsetTransmit(value, bitBuffer, &bit);
 					MessageCodecs::FlushBits(bit, stream, bitBuffer, bufsize);
 				}
 			}
@@ -171,7 +171,7 @@ public:
 					//assert(p2 <= buf + (bits >> 3));
 
 					MessageCodecs::ReadBits(bit, stream, bitBuffer, bufsize);
-					const uint8_t received = (uint8_t)MessageCodecs::Decompression::huff.offsetReceive(bitBuffer, &bit);
+					const uint8_t received = (uint8_t)MessageCodecs::Decompression::decoder.offsetReceive(bitBuffer, &bit);
 
 					*p1 |= received << subBitNum;
 					*p2 = received >> (8 - subBitNum);
@@ -185,7 +185,7 @@ public:
 				for (size_t i = 0; i < remainingBits; i += 8, ++p)
 				{
 					MessageCodecs::ReadBits(bit, stream, bitBuffer, bufsize);
-					*p = (uint8_t)MessageCodecs::Decompression::huff.offsetReceive(bitBuffer, &bit);
+					*p = (uint8_t)MessageCodecs::Decompression::decoder.offsetReceive(bitBuffer, &bit);
 				}
 			}
 		}
@@ -1,5 +1,6 @@
 #include <MOHPC/Global.h>
 #include <MOHPC/Utility/Misc/MSG/HuffmanTree.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 #include "CodecCompression.h"
 #include <fstream>
 #include <chrono>
@@ -17,12 +18,26 @@ namespace MOHPC
 		{
 			#include "CodecCompressor.h"
 			//Huff huff;
+
+			HuffLookupEncoder encoder(huff);
 		}
 
 		namespace Decompression
 		{
 			#include "CodecDecompressor.h"
 			//Huff huff;
+
+			HuffLookupDecoder<constNode_t> decoder(huff.tree);
+		}
+
+		const HuffLookupEncoder& GetHuffEncoder()
+		{
+			return Compression::encoder;
+		}
+
+		const HuffLookupDecoder<constNode_t>& GetHuffDecoder()
+		{
+			return Decompression::decoder;
 		}
 	}
 }
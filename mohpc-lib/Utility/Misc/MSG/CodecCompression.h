@@ -10,12 +10,18 @@ namespace MOHPC
 		{
 			extern ConstHuff<513> huff;
 			//extern Huff huff;
+
+			/** Code words generated from the static compression tree. */
+			extern HuffLookupEncoder encoder;
 		}
 
 		namespace Decompression
 		{
 			extern ConstHuff<513> huff;
 			//extern Huff huff;
+
+			/** Lookup table generated from the static decompression tree. */
+			extern HuffLookupDecoder<constNode_t> decoder;
 		}
 	}
 }
@@ -221,6 +221,16 @@ void MOHPC::Huff::addRef(uint8_t ch)
 	}
 }
 
+const MOHPC::node_t* MOHPC::Huff::getTree() const
+{
+	return tree;
+}
+
+const MOHPC::node_t* MOHPC::Huff::getNode(uint16_t symbol) const
+{
+	return loc[symbol];
+}
+
 uintptr_t MOHPC::Huff::receive(const uint8_t* fin, size_t& bloc) const
 {
 	node_t* node = tree;
@@ -455,6 +455,63 @@ size_t MSG::GetBitPosition() const
 	return bit;
 }
 
+static const uint8_t* getStreamStorage(const IMessageStream& stream)
+{
+	if (const DynamicDataMessageStream* dynStream = dynamic_cast<const DynamicDataMessageStream*>(&stream)) {
+		return dynStream->getStorage();
+	}
+
+	if (const FixedDataMessageStream* fixedStream = dynamic_cast<const FixedDataMessageStream*>(&stream)) {
+		return fixedStream->getStorage();
+	}
+
+	return nullptr;
+}
+
+bool MSG::GetReadBuffer(const uint8_t*& data, size_t& length, size_t& bitPos) const
+{
+	const size_t pos = stream().GetPosition();
+	if (pos >= stream().GetLength())
+	{
+		// what is left to read is only in the pending bits
+		data = bitData;
+		length = sizeof(bitData);
+		bitPos = bit;
+		return true;
+	}
+
+	data = getStreamStorage(stream());
+	if (!data) {
+		return false;
+	}
+
+	length = stream().GetLength();
+	if (!pos)
+	{
+		// nothing was read yet
+		bitPos = bit;
+		return true;
+	}
+
+	// until the end of the stream is reached, pending bits are the bytes right before the stream position
+	bitPos = ((pos - sizeof(bitData)) << 3) + bit;
+	return true;
+}
+
+void MSG::SetReadBitPosition(size_t bitPos)
+{
+	if (stream().GetPosition() >= stream().GetLength())
+	{
+		// the data was the pending bits
+		bit = bitPos;
+		return;
+	}
+
+	stream().Seek(bitPos >> 3);
+	Reset();
+	bit = bitPos & 7;
+}
+
 bool MSG::IsReading() noexcept
 {
 	return mode == msgMode_e::Reading || mode == msgMode_e::Both;
@@ -10,87 +10,32 @@ MsgCoordHelper::MsgCoordHelper(MSG& inMsg)
 
 float MsgCoordHelper::ReadCoord()
 {
-	uint32_t read = msg.ReadNumber<uint32_t>(19);
-
-	float sign = 1.0f;
-	if (read & 262144)
-	{
-		// the 19th bit is the sign
-		sign = -1.0f;
-	}
-
-	read &= ~262144; //  uint=4294705151
-	return sign * (read / 16.f);
+	return MsgCoordReader<MSG>(msg).ReadCoord();
 }
 
 float MsgCoordHelper::ReadCoordSmall()
 {
-	uint32_t read = msg.ReadNumber<uint32_t>(17);
-
-	float sign = 1.0f;
-	if (read & 65536)
-	{
-		// the 17th bit is the sign
-		sign = -1.0f;
-	}
-
-	read &= ~65536; //  uint=4294705151
-	return sign * (read / 8.f);
+	return MsgCoordReader<MSG>(msg).ReadCoordSmall();
 }
 
 int32_t MsgCoordHelper::ReadDeltaCoord(uint32_t offset)
 {
-	int32_t result = 0;
-
-	const bool isSmall = msg.ReadBool();
-	if (isSmall)
-	{
-		const uint8_t byteValue = msg.ReadNumber<uint8_t>(8);
-		result = (byteValue >> 1) + 1;
-		if (byteValue & 1) result = -result;
-
-		result += offset;
-
-	}
-	else {
-		result = msg.ReadNumber<uint16_t>(16);
-	}
-
-	return result;
+	return MsgCoordReader<MSG>(msg).ReadDeltaCoord(offset);
 }
 
 int32_t MsgCoordHelper::ReadDeltaCoordExtra(uint32_t offset)
 {
-	int32_t result = 0;
-
-	const bool isSmall = msg.ReadBool();
-	if (isSmall)
-	{
-		const uint16_t shortValue = msg.ReadNumber<uint16_t>(10);
-		result = (shortValue >> 1) + 1;
-		if (shortValue & 1) result = -result;
-
-		result += offset;
-	}
-	else {
-		result = msg.ReadNumber<uint32_t>(18);
-	}
-
-	return result;
+	return MsgCoordReader<MSG>(msg).ReadDeltaCoordExtra(offset);
 }
 
 void MsgCoordHelper::ReadVectorCoord(vec3_t& out)
 {
-	out[0] = ReadCoord();
-	out[1] = ReadCoord();
-	out[2] = ReadCoord();
+	MsgCoordReader<MSG>(msg).ReadVectorCoord(out);
 }
 
 void MsgCoordHelper::ReadVectorFloat(vec3_t& out)
 {
-	out[0] = msg.ReadFloat();
-	out[1] = msg.ReadFloat();
-	out[2] = msg.ReadFloat();
+	MsgCoordReader<MSG>(msg).ReadVectorFloat(out);
 }
 
 void MsgCoordHelper::ReadDir(vec3_t& out)
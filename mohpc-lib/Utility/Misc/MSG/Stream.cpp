@@ -80,6 +80,16 @@ size_t FixedDataMessageStream::GetPosition() const noexcept
 	return curPos;
 }
 
+uint8_t* FixedDataMessageStream::getStorage()
+{
+	return storage;
+}
+
+const uint8_t* FixedDataMessageStream::getStorage() const
+{
+	return storage;
+}
+
 DynamicDataMessageStream::DynamicDataMessageStream() noexcept
 	: storage(nullptr)
 	, length(0)
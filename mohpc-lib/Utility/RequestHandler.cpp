@@ -20,6 +20,7 @@ IncomingMessageHandler::IncomingMessageHandler(MessageDispatcher* inDispatcher,
 	, next(nullptr)
 	, prev(nullptr)
 	, remoteId(inRemoteId)
+	, active(false)
 {
 	dispatcher->addHandler(this);
 }
@@ -49,6 +50,8 @@ void IncomingMessageHandler::handleIncoming(IMessageStream& stream, const IRemot
 
 			IRequestPtr newRequest = currentRequest()->process(input);
 			handleNewRequest(std::move(newRequest), false);
+
+			updateDispatcher();
 		}
 	}
 }
@@ -70,8 +73,10 @@ void IncomingMessageHandler::sendRequest(IRequestPtr&& newRequest, uint64_t time
 		request = newRequest;
 	}
 	else {
-		return dequeRequest();
+		dequeRequest();
 	}
+
+	updateDispatcher();
 }
 
 bool IncomingMessageHandler::isRequesting() const
@@ -118,6 +123,35 @@ bool MOHPC::IncomingMessageHandler::processDeferred()
 	return false;
 }
 
+bool IncomingMessageHandler::getNextTime(time_point<steady_clock>& time) const
+{
+	if (!isRequesting()) {
+		return false;
+	}
+
+	if (deferTime != time_point<steady_clock>(milliseconds(0)))
+	{
+		// the request must be started first
+		time = deferTime;
+		return true;
+	}
+
+	if (timeoutTime != startTime)
+	{
+		time = timeoutTime;
+		return true;
+	}
+
+	// no timeout
+	return false;
+}
+
+void IncomingMessageHandler::updateDispatcher()
+{
+	// reschedule the handler as the request or its times have changed
+	if (dispatcher) dispatcher->updateHandler(this);
+}
+
 const ICommunicatorPtr& IncomingMessageHandler::getComm() const
 {
 	return comm;
@@ -0,0 +1,117 @@
+#include <MOHPC/Utility/TaskGraph.h>
+#include <MOHPC/Utility/ThreadPool.h>
+
+#include <cassert>
+
+using namespace MOHPC;
+
+TaskGraph::TaskGraph()
+	: failed(false)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+}
+
+size_t TaskGraph::addTask(TaskFunction&& func, std::initializer_list<size_t> dependencies)
+{
+	const size_t taskNum = tasks.size();
+
+	for (size_t dependency : dependencies)
+	{
+		// this also guarantees the graph has no cycle
+		assert(dependency < taskNum);
+		tasks[dependency].dependents.push_back(taskNum);
+	}
+
+	tasks.push_back(task_t{ std::move(func), {}, dependencies.size() });
+	return taskNum;
+}
+
+size_t TaskGraph::getNumTasks() const
+{
+	return tasks.size();
+}
+
+void TaskGraph::run(ThreadPool* pool)
+{
+	if (!pool)
+	{
+		// dependencies are always added first
+		for (task_t& task : tasks) {
+			task.func();
+		}
+
+		return;
+	}
+
+	pendingDependencies = std::make_unique<std::atomic<size_t>[]>(tasks.size());
+	error = nullptr;
+	failed.store(false, std::memory_order_relaxed);
+
+	std::vector<size_t> ready;
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		pendingDependencies[i].store(tasks[i].numDependencies, std::memory_order_relaxed);
+		if (!tasks[i].numDependencies) {
+			ready.push_back(i);
+		}
+	}
+
+	runBatch(*pool, ready);
+
+	pendingDependencies.reset();
+
+	if (error)
+	{
+		const std::exception_ptr taskError = std::move(error);
+		error = nullptr;
+		std::rethrow_exception(taskError);
+	}
+}
+
+void TaskGraph::runBatch(ThreadPool& pool, const std::vector<size_t>& batch)
+{
+	if (batch.size() == 1)
+	{
+		runTask(pool, batch[0]);
+		return;
+	}
+
+	pool.parallelFor(batch.size(), [this, &pool, &batch](size_t index) { runTask(pool, batch[index]); });
+}
+
+void TaskGraph::runTask(ThreadPool& pool, size_t taskNum)
+{
+	task_t& task = tasks[taskNum];
+
+	if (!failed.load(std::memory_order_acquire))
+	{
+		try
+		{
+			task.func();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error) error = std::current_exception();
+			failed.store(true, std::memory_order_release);
+		}
+	}
+
+	// dependents are still visited after a failure, so the graph always completes
+	std::vector<size_t> ready;
+	for (size_t dependent : task.dependents)
+	{
+		if (pendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			ready.push_back(dependent);
+		}
+	}
+
+	if (!ready.empty())
+	{
+		// the thread that completes the last dependency starts dependents, and helps running them
+		runBatch(pool, ready);
+	}
+}
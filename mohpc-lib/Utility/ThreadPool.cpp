@@ -0,0 +1,152 @@
+#include <MOHPC/Utility/ThreadPool.h>
+
+using namespace MOHPC;
+
+struct ThreadPool::batch_t
+{
+	std::mutex mutex;
+	std::condition_variable doneCondition;
+	size_t remaining;
+};
+
+MOHPC_OBJECT_DEFINITION(ThreadPool);
+
+ThreadPool::ThreadPool(size_t numThreads)
+	: numPending(0)
+	, stopping(false)
+{
+	if (!numThreads)
+	{
+		numThreads = std::thread::hardware_concurrency();
+		if (!numThreads) numThreads = 1;
+	}
+
+	workers.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; ++i) {
+		workers.push_back(std::make_unique<worker_t>());
+	}
+
+	// start threads once all queues exist, as they can be stolen from
+	for (size_t i = 0; i < numThreads; ++i) {
+		workers[i]->thread = std::thread(&ThreadPool::workerThread, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+
+	for (const std::unique_ptr<worker_t>& worker : workers) {
+		worker->thread.join();
+	}
+}
+
+size_t ThreadPool::getNumThreads() const
+{
+	return workers.size();
+}
+
+void ThreadPool::parallelFor(size_t count, const TaskFunction& func)
+{
+	if (!count) {
+		return;
+	}
+
+	batch_t batch;
+	batch.remaining = count;
+
+	{
+		// counted first so it never goes below the number of queued tasks
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		numPending += count;
+	}
+
+	// spread tasks over all workers
+	const size_t numWorkers = workers.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		worker_t& worker = *workers[i % numWorkers];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.tasks.push_back(task_t{ &func, &batch, i });
+	}
+
+	wakeCondition.notify_all();
+
+	// help workers instead of waiting
+	task_t task;
+	while (popTask(0, task)) {
+		runTask(task);
+	}
+
+	std::unique_lock<std::mutex> lock(batch.mutex);
+	batch.doneCondition.wait(lock, [&batch] { return batch.remaining == 0; });
+}
+
+void ThreadPool::workerThread(size_t workerIndex)
+{
+	for (;;)
+	{
+		task_t task;
+		if (popTask(workerIndex, task))
+		{
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeCondition.wait(lock, [this] { return stopping || numPending > 0; });
+
+		if (stopping && !numPending) {
+			return;
+		}
+	}
+}
+
+bool ThreadPool::popTask(size_t workerIndex, task_t& task)
+{
+	const size_t numWorkers = workers.size();
+	for (size_t i = 0; i < numWorkers; ++i)
+	{
+		worker_t& worker = *workers[(workerIndex + i) % numWorkers];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.tasks.empty()) {
+			continue;
+		}
+
+		if (i == 0)
+		{
+			// the worker takes the most recent task from its own queue
+			task = worker.tasks.back();
+			worker.tasks.pop_back();
+		}
+		else
+		{
+			// and steals the oldest task of other queues
+			task = worker.tasks.front();
+			worker.tasks.pop_front();
+		}
+
+		--numPending;
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::runTask(const task_t& task)
+{
+	(*task.func)(task.index);
+
+	batch_t& batch = *task.batch;
+	// notify while locked, the batch is destroyed as soon as the waiter sees it done
+	std::lock_guard<std::mutex> lock(batch.mutex);
+	if (--batch.remaining == 0) {
+		batch.doneCondition.notify_all();
+	}
+}
@@ -13,6 +13,25 @@ bool isOffsetCorrect(float offset)
 	return offset > -1000.f && offset < 1000.f;
 }
 
+void testFrameKeys(const MOHPC::SkeletonAnimationPtr& animation)
+{
+	for (size_t i = 0; i < animation->GetNumAryChannels(); i++)
+	{
+		const MOHPC::SkanChannelHdr* channel = animation->GetAryChannel(i);
+		assert(channel->frameKeys.size() >= animation->GetNumFrames());
+
+		for (size_t frameNum = 0; frameNum < animation->GetNumFrames(); frameNum++)
+		{
+			// the value is the one from the keyframe of the frame, or from the previous keyframe
+			size_t key = 0;
+			while (channel->ary_frames[key].nFrameNum < frameNum) key++;
+			if (channel->ary_frames[key].nFrameNum > frameNum) key = channel->ary_frames[key].nPrevFrameIndex;
+
+			assert(channel->frameKeys[frameNum] == key);
+		}
+	}
+}
+
 int main(int argc, const char* argv[])
 {
 	InitCommon(argc, argv);
@@ -23,6 +42,8 @@ int main(int argc, const char* argv[])
 	MOHPC::TIKIPtr Tiki = AM->readAsset<MOHPC::TIKIReader>("models/player/american_army.tik");
 	MOHPC::SkeletonPtr TikiArms = AM->readAsset<MOHPC::SkeletonReader>("models/player/us_army/USarmyplyr.skd");
 
+	testFrameKeys(Animation);
+
 	if (Tiki)
 	{
 		MOHPC::ModelRendererPtr ModelRenderer = MOHPC::ModelRenderer::create(AM);
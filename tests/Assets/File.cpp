@@ -5,6 +5,7 @@
 #include <MOHPC/Files/Category.h>
 
 #include <cassert>
+#include <cstring>
 #include <string>
 
 using namespace MOHPC;
@@ -57,6 +58,18 @@ void testFiles()
 	assert(FM->OpenFile("/newconfig.cfg"));
 	assert(FM->OpenFile("newconfig.cfg"));
 
+	// the buffer and the stream must give the same content
+	IFilePtr cfgFile = FM->OpenFile("default.cfg");
+	void* cfgBuffer;
+	const uint64_t cfgLength = cfgFile->ReadBuffer(&cfgBuffer);
+	assert(cfgLength > 0);
+	// text parsers rely on the terminator
+	assert(((const char*)cfgBuffer)[cfgLength] == 0);
+
+	std::string cfgStreamed((size_t)cfgLength, 0);
+	cfgFile->GetStream()->read(cfgStreamed.data(), cfgLength);
+	assert(!std::memcmp(cfgStreamed.data(), cfgBuffer, (size_t)cfgLength));
+
 	FileEntryList script1 = FM->ListFilteredFiles("/scripts", "");
 	FileEntryList script2 = FM->ListFilteredFiles("scripts", "");
 	FileEntryList script3 = FM->ListFilteredFiles("scripts/", "");
@@ -11,6 +11,7 @@
 #include "Common/Common.h"
 
 #include <map>
+#include <thread>
 #include <vector>
 #include <cassert>
 #include <cstring>
@@ -86,6 +87,8 @@ void testAsset(const MOHPC::BSPPtr& Asset);
 void traceTest(const MOHPC::BSPPtr& Asset);
 void leafTesting(const MOHPC::BSPPtr& Asset);
 void groupTesting(const MOHPC::BSPPtr& Asset);
+void threadedLoadTest(const MOHPC::AssetManagerPtr& AM, const char* fileName, const MOHPC::BSPPtr& Asset);
+void cacheTest(const MOHPC::AssetManagerPtr& AM, const char* fileName, const MOHPC::BSPPtr& Asset);
 
 int main(int argc, const char* argv[])
 {
@@ -108,6 +111,110 @@ int main(int argc, const char* argv[])
 	Asset = AM->readAsset<MOHPC::BSPReader>("maps/dm/mohdm6.bsp");
 	testAsset(Asset);
 	traceTest(Asset);
+	threadedLoadTest(AM, "maps/dm/mohdm6.bsp", Asset);
+	cacheTest(AM, "maps/dm/mohdm6.bsp", Asset);
+}
+
+void threadedLoadTest(const MOHPC::AssetManagerPtr& AM, const char* fileName, const MOHPC::BSPPtr& Asset)
+{
+	using namespace MOHPC;
+
+	// load the same map with lumps converted in parallel
+	const ThreadPoolPtr pool = ThreadPool::create();
+	const IFilePtr file = AM->GetFileManager()->OpenFile(fileName);
+	assert(file);
+	const BSPPtr threadedAsset = AM->readAsset<BSPReader>(file, pool);
+	assert(threadedAsset);
+
+	assert(threadedAsset->GetNumShaders() == Asset->GetNumShaders());
+	assert(threadedAsset->GetNumLightmaps() == Asset->GetNumLightmaps());
+	for (size_t i = 0; i < Asset->GetNumLightmaps(); ++i) {
+		assert(!memcmp(threadedAsset->GetLightmap(i)->color, Asset->GetLightmap(i)->color, sizeof(BSPData::Lightmap::color)));
+	}
+	assert(threadedAsset->GetLightGridData().length == Asset->GetLightGridData().length);
+	assert(!memcmp(threadedAsset->GetLightGridData().data, Asset->GetLightGridData().data, Asset->GetLightGridData().length));
+	assert(threadedAsset->GetNumPlanes() == Asset->GetNumPlanes());
+	assert(threadedAsset->GetNumBrushSides() == Asset->GetNumBrushSides());
+	assert(threadedAsset->GetNumBrushes() == Asset->GetNumBrushes());
+	assert(threadedAsset->GetNumLeafs() == Asset->GetNumLeafs());
+	assert(threadedAsset->GetNumNodes() == Asset->GetNumNodes());
+	assert(threadedAsset->GetNumSubmodels() == Asset->GetNumSubmodels());
+	assert(threadedAsset->GetNumStaticModels() == Asset->GetNumStaticModels());
+	assert(threadedAsset->GetNumTerrainPatches() == Asset->GetNumTerrainPatches());
+	assert(threadedAsset->GetNumTerrainSurfaces() == Asset->GetNumTerrainSurfaces());
+	assert(threadedAsset->GetNumEntities() == Asset->GetNumEntities());
+
+	assert(threadedAsset->GetNumSurfaces() == Asset->GetNumSurfaces());
+	for (size_t i = 0; i < Asset->GetNumSurfaces(); ++i)
+	{
+		const BSPData::Surface* surface = Asset->GetSurface(i);
+		const BSPData::Surface* threadedSurface = threadedAsset->GetSurface(i);
+		assert(threadedSurface->GetNumVertices() == surface->GetNumVertices());
+		assert(threadedSurface->GetNumIndexes() == surface->GetNumIndexes());
+		assert(threadedSurface->IsPatch() == surface->IsPatch());
+		if (surface->GetPatchCollide())
+		{
+			assert(threadedSurface->GetPatchCollide()->numPlanes == surface->GetPatchCollide()->numPlanes);
+			assert(threadedSurface->GetPatchCollide()->numFacets == surface->GetPatchCollide()->numFacets);
+		}
+	}
+}
+
+void cacheTest(const MOHPC::AssetManagerPtr& AM, const char* fileName, const MOHPC::BSPPtr& Asset)
+{
+	using namespace MOHPC;
+
+	const fs::path cacheDir = fs::temp_directory_path() / "mohpc_bsp_cache_test";
+	std::error_code ec;
+	fs::remove_all(cacheDir, ec);
+
+	// the first load writes the cache, the second one reads it
+	const BSPCachePtr cache = BSPCache::create(cacheDir);
+	const BSPPtr generatedAsset = AM->readAsset<BSPReader>(AM->GetFileManager()->OpenFile(fileName), nullptr, cache);
+	assert(generatedAsset);
+	assert(fs::directory_iterator(cacheDir) != fs::directory_iterator());
+	const BSPPtr cachedAsset = AM->readAsset<BSPReader>(AM->GetFileManager()->OpenFile(fileName), nullptr, cache);
+	assert(cachedAsset);
+
+	assert(cachedAsset->GetNumSurfaces() == Asset->GetNumSurfaces());
+	for (size_t i = 0; i < Asset->GetNumSurfaces(); ++i)
+	{
+		const BSPData::PatchCollide* pc = Asset->GetSurface(i)->GetPatchCollide();
+		const BSPData::PatchCollide* cachedPc = cachedAsset->GetSurface(i)->GetPatchCollide();
+		assert(!pc == !cachedPc);
+		if (pc)
+		{
+			assert(cachedPc->numPlanes == pc->numPlanes);
+			assert(cachedPc->numFacets == pc->numFacets);
+			assert(!memcmp(cachedPc->bounds, pc->bounds, sizeof(pc->bounds)));
+			assert(!memcmp(cachedPc->facets, pc->facets, sizeof(BSPData::Facet) * pc->numFacets));
+		}
+	}
+
+	assert(cachedAsset->GetNumTerrainSurfaces() == Asset->GetNumTerrainSurfaces());
+	for (size_t i = 0; i < Asset->GetNumTerrainSurfaces(); ++i)
+	{
+		const BSPData::Surface* surface = Asset->GetTerrainSurface(i);
+		const BSPData::Surface* cachedSurface = cachedAsset->GetTerrainSurface(i);
+		assert(cachedSurface->GetShader() == surface->GetShader() || cachedSurface->GetShader()->shaderName == surface->GetShader()->shaderName);
+		assert(cachedSurface->GetNumVertices() == surface->GetNumVertices());
+		assert(cachedSurface->GetNumIndexes() == surface->GetNumIndexes());
+		for (size_t j = 0; j < surface->GetNumIndexes(); ++j) {
+			assert(cachedSurface->GetIndice(j) == surface->GetIndice(j));
+		}
+	}
+
+	BSPCollisionPtr bspCollision = BSPCollision::create(Asset);
+	for (size_t i = 0; i < Asset->GetNumTerrainPatches(); ++i)
+	{
+		BSPData::TerrainCollide collision{};
+		bspCollision->GenerateTerrainCollide(Asset->GetTerrainPatch(i), collision);
+
+		assert(!memcmp(generatedAsset->GetTerrainCollide(i), &collision, sizeof(collision)));
+		assert(!memcmp(cachedAsset->GetTerrainCollide(i), &collision, sizeof(collision)));
+	}
+
+	fs::remove_all(cacheDir, ec);
 }
 
 void testAsset(const MOHPC::BSPPtr& Asset)
@@ -181,11 +288,87 @@ void traceTest(const MOHPC::BSPPtr& Asset)
 		assert(results.fraction < 0.01f);
 	}
 
+	// world traces walk the tree, terrain in the leaves must stop them
+	for (size_t i = 0; i < Asset->GetNumTerrainPatches(); ++i)
+	{
+		const BSPData::TerrainPatch* patch = Asset->GetTerrainPatch(i);
+		vec3_t start{ patch->x0 + 256.f, patch->y0 + 256.f, patch->z0 + patch->zmax + 64.f };
+		vec3_t end{ patch->x0 + 256.f, patch->y0 + 256.f, patch->z0 - 64.f };
+
+		cm->BoxTrace(&results, start, end, vec3_zero, vec3_zero, 0, ContentFlags::MASK_PLAYERSOLID, false);
+		assert(results.fraction < 1.f);
+		assert(results.endpos[2] >= patch->z0 - 1.f);
+	}
+
 	vec3_t start{ 0, 0, 0 };
 	vec3_t end{ 0, 0, -500 };
 	cm->BoxTrace(&results, start, end, vec3_zero, vec3_zero, 0, ContentFlags::MASK_PLAYERSOLID, true);
 	assert(results.fraction < 0.35f);
 
+	// concurrent traces through the same world, each thread using its own context
+	{
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&cm, &start, &end, &results]()
+			{
+				traceContext_t context;
+				for (size_t j = 0; j < 1000; ++j)
+				{
+					trace_t threadResults;
+					cm->BoxTrace(context, &threadResults, start, end, vec3_zero, vec3_zero, 0, ContentFlags::MASK_PLAYERSOLID, true);
+					assert(threadResults.fraction == results.fraction);
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	// batched traces must give the same results as individual traces
+	{
+		boxTraceInput_t inputs[16];
+		for (size_t i = 0; i < 16; ++i)
+		{
+			// points and player boxes, with a few position tests
+			const float size = (i & 1) ? 15.f : 0.f;
+			VecSet(inputs[i].start, start[0] + i * 8.f, start[1], start[2]);
+			if (i % 5) {
+				VecSet(inputs[i].end, end[0] + i * 8.f, end[1] + i * 4.f, end[2]);
+			}
+			else {
+				VecCopy(inputs[i].start, inputs[i].end);
+			}
+			VecSet(inputs[i].mins, -size, -size, 0);
+			VecSet(inputs[i].maxs, size, size, size * 6);
+		}
+
+		traceContext_t context;
+		trace_t batchResults[16];
+		cm->BoxTraceBatch(context, inputs, batchResults, 16, 0, ContentFlags::MASK_PLAYERSOLID, true);
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			trace_t singleResults;
+			cm->BoxTrace(context, &singleResults, inputs[i].start, inputs[i].end, inputs[i].mins, inputs[i].maxs, 0, ContentFlags::MASK_PLAYERSOLID, true);
+			assert(batchResults[i].fraction == singleResults.fraction);
+			assert(batchResults[i].allsolid == singleResults.allsolid);
+			assert(batchResults[i].startsolid == singleResults.startsolid);
+			assert(batchResults[i].endpos[0] == singleResults.endpos[0]);
+			assert(batchResults[i].endpos[1] == singleResults.endpos[1]);
+			assert(batchResults[i].endpos[2] == singleResults.endpos[2]);
+			assert(batchResults[i].plane.normal[0] == singleResults.plane.normal[0]);
+			assert(batchResults[i].plane.normal[1] == singleResults.plane.normal[1]);
+			assert(batchResults[i].plane.normal[2] == singleResults.plane.normal[2]);
+			assert(batchResults[i].plane.dist == singleResults.plane.dist);
+			assert(batchResults[i].surfaceFlags == singleResults.surfaceFlags);
+			assert(batchResults[i].shaderNum == singleResults.shaderNum);
+			assert(batchResults[i].contents == singleResults.contents);
+		}
+	}
+
 	ArchiveWriter ar;
 	CollisionWorldSerializer colSer(*cm);
 	colSer.save(ar);
@@ -203,6 +386,30 @@ void traceTest(const MOHPC::BSPPtr& Asset)
 	assert(newResults.endpos[0] == results.endpos[0]);
 	assert(newResults.endpos[1] == results.endpos[1]);
 	assert(newResults.endpos[2] == results.endpos[2]);
+
+	// the image is used in place, the data must remain valid while the world is used
+	ArchiveWriter imageAr;
+	CollisionWorldImage(*cm).save(imageAr);
+
+	const std::vector<uint8_t>& imageData = imageAr.getData();
+
+	CollisionWorldPtr mappedCm = CollisionWorld::create();
+	const bool loaded = CollisionWorldImage(*mappedCm).load(imageData.data(), imageData.size());
+	assert(loaded);
+
+	trace_t mappedResults;
+	mappedCm->BoxTrace(&mappedResults, start, end, vec3_zero, vec3_zero, 0, ContentFlags::MASK_PLAYERSOLID, true);
+	assert(mappedResults.fraction == results.fraction);
+	assert(mappedResults.surfaceFlags == results.surfaceFlags);
+	assert(mappedResults.shaderNum == results.shaderNum);
+	assert(mappedResults.endpos[0] == results.endpos[0]);
+	assert(mappedResults.endpos[1] == results.endpos[1]);
+	assert(mappedResults.endpos[2] == results.endpos[2]);
+
+	// the mapped tables are only read when saving
+	ArchiveWriter mappedAr;
+	CollisionWorldImage(*mappedCm).save(mappedAr);
+	assert(mappedAr.getData().size() == imageData.size());
 }
 
 void leafTesting(const MOHPC::BSPPtr& Asset)
@@ -253,5 +460,5 @@ void groupTesting(const MOHPC::BSPPtr& Asset)
 	const size_t num2 = bspGroup->getNumGroupedSurfaces();
 	assert(num == Asset->GetNumBrushes());
 	MOHPC_LOG(Info, "%zu brushes, %zu grouped surfaces", num, num2);
-	// FIXME: should test against a custom BSP file
+	// the grouping is compared against a reference on generated levels, in LevelGroup.cpp
 }
@@ -0,0 +1,440 @@
+#include <MOHPC/Assets/Formats/BSP.h>
+#include <MOHPC/Assets/Formats/BSP_Group.h>
+#include <MOHPC/Assets/Managers/ShaderManager.h>
+#include <MOHPC/Common/Log.h>
+#include <MOHPC/Common/Math.h>
+#include <MOHPC/Common/str.h>
+
+#include "Common/Common.h"
+
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace MOHPC;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_levelgroup";
+
+static constexpr size_t NO_PARENT = SIZE_MAX;
+
+namespace MOHPC
+{
+	/**
+	 * Gives access to the lumps of a level, to build one without a file.
+	 */
+	class BSPTestBuilder
+	{
+	public:
+		static std::vector<BSPData::Shader>& getShaders(BSP& bsp) { return bsp.shaders; }
+		static std::vector<BSPData::Surface>& getSurfaces(BSP& bsp) { return bsp.surfaces; }
+		static std::vector<BSPData::BrushSide>& getBrushSides(BSP& bsp) { return bsp.brushSides; }
+		static std::vector<BSPData::Brush>& getBrushes(BSP& bsp) { return bsp.brushes; }
+		static std::vector<BSPData::Model>& getBrushModels(BSP& bsp) { return bsp.brushModels; }
+	};
+}
+
+/**
+ * Grouping computed by testing every pair of brushes and patches, like the grouping was first done.
+ */
+struct referenceGroup_t
+{
+	std::string name;
+	std::vector<const BSPData::Surface*> surfaces;
+	std::vector<size_t> brushes;
+};
+
+struct referenceGrouping_t
+{
+	std::vector<size_t> brushParents;
+	std::vector<std::vector<const BSPData::Surface*>> brushSurfaces;
+	std::vector<referenceGroup_t> groups;
+};
+
+struct bounds_t
+{
+	vec3_t mins;
+	vec3_t maxs;
+};
+
+struct levelParams_t
+{
+	uint32_t seed;
+	size_t numBrushes;
+	size_t numSurfaces;
+	size_t numPatches;
+	// half size of the area where things are placed
+	float extent;
+};
+
+bool boundsTouching(const_vec3p_t mins1, const_vec3p_t maxs1, const_vec3p_t mins2, const_vec3p_t maxs2)
+{
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (mins1[i] > maxs2[i] || maxs1[i] < mins2[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool shareDrawnShader(const BSPData::Brush* brush1, const BSPData::Brush* brush2)
+{
+	for (size_t s1 = 0; s1 < brush1->GetNumSides(); ++s1)
+	{
+		const BSPData::BrushSide* side1 = brush1->GetSide(s1);
+		if (side1->surfaceFlags & SURF_NODRAW) {
+			continue;
+		}
+
+		for (size_t s2 = 0; s2 < brush2->GetNumSides(); ++s2)
+		{
+			const BSPData::BrushSide* side2 = brush2->GetSide(s2);
+			if (side2->surfaceFlags & SURF_NODRAW) {
+				continue;
+			}
+
+			if (!strHelpers::icmp(side1->shader->shaderName.c_str(), side2->shader->shaderName.c_str())) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+size_t getRoot(const std::vector<size_t>& parents, size_t num)
+{
+	while (parents[num] != NO_PARENT) {
+		num = parents[num];
+	}
+
+	return num;
+}
+
+bool hasParent(const std::vector<size_t>& parents, size_t num, size_t parentNum)
+{
+	for (size_t p = parents[num]; p != NO_PARENT; p = parents[p])
+	{
+		if (p == parentNum) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void groupReference(const BSP& bsp, referenceGrouping_t& out)
+{
+	const size_t numBrushes = bsp.GetNumBrushes();
+
+	// each brush becomes the parent of touching brushes sharing a drawn shader,
+	// if they don't have a parent and if they're not its root
+	out.brushParents.assign(numBrushes, NO_PARENT);
+	for (size_t b = 0; b < numBrushes; ++b)
+	{
+		const BSPData::Brush* brush = bsp.GetBrush(b);
+		for (size_t i = 0; i < numBrushes; ++i)
+		{
+			const BSPData::Brush* brush2 = bsp.GetBrush(i);
+			if (i == b || out.brushParents[i] != NO_PARENT || getRoot(out.brushParents, b) == i) {
+				continue;
+			}
+
+			if (boundsTouching(brush->bounds[0], brush->bounds[1], brush2->bounds[0], brush2->bounds[1]) && shareDrawnShader(brush, brush2)) {
+				out.brushParents[i] = b;
+			}
+		}
+	}
+
+	const BSPData::Model* worldModel = bsp.GetSubmodel(0);
+	const size_t numSurfaces = worldModel->numSurfaces;
+	std::vector<bool> mappedSurfaces(numSurfaces, false);
+
+	// surfaces go to the group of the root of the first brush containing their centroid with the same shader
+	std::vector<size_t> rootGroups(numBrushes, NO_PARENT);
+	size_t numGroupedSurfaces = 0;
+	out.brushSurfaces.assign(numBrushes, {});
+	for (size_t b = 0; b < numBrushes; ++b)
+	{
+		const BSPData::Brush* brush = bsp.GetBrush(b);
+		const size_t rootNum = getRoot(out.brushParents, b);
+
+		for (size_t k = 0; k < numSurfaces; ++k)
+		{
+			const BSPData::Surface* surf = &worldModel->surface[k];
+			if (mappedSurfaces[k] || surf->IsPatch() || !boundsTouching(surf->centroid, surf->centroid, brush->bounds[0], brush->bounds[1])) {
+				continue;
+			}
+
+			for (size_t s = 0; s < brush->GetNumSides(); ++s)
+			{
+				if (strHelpers::icmp(brush->GetSide(s)->shader->shaderName.c_str(), surf->shader->shaderName.c_str())) {
+					continue;
+				}
+
+				if (rootGroups[rootNum] == NO_PARENT)
+				{
+					rootGroups[rootNum] = out.groups.size();
+					out.groups.push_back(referenceGroup_t{ "groupedsurf" + std::to_string(numGroupedSurfaces++), {}, {} });
+				}
+
+				referenceGroup_t& group = out.groups[rootGroups[rootNum]];
+				group.surfaces.push_back(surf);
+				if (group.brushes.empty() || group.brushes.back() != b) {
+					group.brushes.push_back(b);
+				}
+
+				out.brushSurfaces[b].push_back(surf);
+				mappedSurfaces[k] = true;
+				break;
+			}
+		}
+	}
+
+	referenceGroup_t terrainGroup{ "lod_terrain", {}, {} };
+	for (size_t k = 0; k < bsp.GetNumTerrainSurfaces(); ++k) {
+		terrainGroup.surfaces.push_back(bsp.GetTerrainSurface(k));
+	}
+	out.groups.push_back(terrainGroup);
+
+	// each patch becomes the parent of touching patches, unless they're one of its parents
+	std::vector<size_t> patches;
+	for (size_t k = 0; k < numSurfaces; ++k)
+	{
+		if (worldModel->surface[k].IsPatch()) {
+			patches.push_back(k);
+		}
+	}
+
+	const size_t numPatches = patches.size();
+	std::vector<bounds_t> patchBounds(numPatches);
+	for (size_t k = 0; k < numPatches; ++k)
+	{
+		const BSPData::Surface* surf = &worldModel->surface[patches[k]];
+		ClearBounds(patchBounds[k].mins, patchBounds[k].maxs);
+		for (size_t v = 0; v < surf->GetNumVertices(); ++v) {
+			AddPointToBounds(surf->GetVertice(v)->xyz, patchBounds[k].mins, patchBounds[k].maxs);
+		}
+	}
+
+	std::vector<size_t> patchParents(numPatches, NO_PARENT);
+	for (size_t k = 0; k < numPatches; ++k)
+	{
+		for (size_t l = 0; l < numPatches; ++l)
+		{
+			if (l != k && !hasParent(patchParents, k, l) && boundsTouching(patchBounds[k].mins, patchBounds[k].maxs, patchBounds[l].mins, patchBounds[l].maxs)) {
+				patchParents[l] = k;
+			}
+		}
+	}
+
+	// patches not mapped to a brush go to the group of their root, with their parents
+	std::vector<size_t> patchGroups(numPatches, NO_PARENT);
+	size_t numGroupedPatches = 0;
+	for (size_t k = 0; k < numPatches; ++k)
+	{
+		std::vector<const BSPData::Surface*> surfaces;
+		for (size_t p = k; p != NO_PARENT; p = patchParents[p])
+		{
+			if (!mappedSurfaces[patches[p]])
+			{
+				surfaces.push_back(&worldModel->surface[patches[p]]);
+				mappedSurfaces[patches[p]] = true;
+			}
+		}
+
+		if (surfaces.empty()) {
+			continue;
+		}
+
+		const size_t rootNum = getRoot(patchParents, k);
+		if (patchGroups[rootNum] == NO_PARENT)
+		{
+			patchGroups[rootNum] = out.groups.size();
+			out.groups.push_back(referenceGroup_t{ "meshpatch_grouped" + std::to_string(numGroupedPatches++), {}, {} });
+		}
+
+		std::vector<const BSPData::Surface*>& groupSurfaces = out.groups[patchGroups[rootNum]].surfaces;
+		groupSurfaces.insert(groupSurfaces.end(), surfaces.begin(), surfaces.end());
+	}
+
+	size_t numUnmappedSurfaces = 0;
+	for (size_t k = 0; k < numSurfaces; ++k)
+	{
+		if (!mappedSurfaces[k])
+		{
+			out.groups.push_back(referenceGroup_t{ "GroupedSurfaces_unmapped" + std::to_string(numUnmappedSurfaces++), {}, {} });
+			out.groups.back().surfaces.push_back(&worldModel->surface[k]);
+		}
+	}
+}
+
+float randomFloat(std::mt19937& random, float min, float max)
+{
+	return std::uniform_real_distribution<float>(min, max)(random);
+}
+
+void randomPoint(std::mt19937& random, float extent, vec3r_t out)
+{
+	for (size_t i = 0; i < 3; ++i) {
+		out[i] = randomFloat(random, -extent, extent);
+	}
+}
+
+BSPPtr generateLevel(const levelParams_t& params)
+{
+	static constexpr size_t NUM_SIDES = 6;
+
+	std::mt19937 random(params.seed);
+	const BSPPtr bsp = BSP::create("generated.bsp");
+
+	// the first two only differ by the case, so they're the same shader
+	std::vector<BSPData::Shader>& shaders = BSPTestBuilder::getShaders(*bsp);
+	const char* shaderNames[] = { "textures/wall", "Textures/WALL", "textures/floor", "textures/roof", "textures/metal", "common/caulk" };
+	shaders.resize(sizeof(shaderNames) / sizeof(shaderNames[0]));
+	for (size_t i = 0; i < shaders.size(); ++i) {
+		shaders[i].shaderName = shaderNames[i];
+	}
+
+	std::uniform_int_distribution<size_t> shaderDist(0, shaders.size() - 1);
+
+	std::vector<BSPData::BrushSide>& brushSides = BSPTestBuilder::getBrushSides(*bsp);
+	brushSides.resize(params.numBrushes * NUM_SIDES);
+	for (BSPData::BrushSide& side : brushSides)
+	{
+		side.plane = nullptr;
+		side.Eq = nullptr;
+		side.shader = &shaders[shaderDist(random)];
+		side.surfaceFlags = random() % 4 ? 0 : (int32_t)SURF_NODRAW;
+	}
+
+	std::vector<BSPData::Brush>& brushes = BSPTestBuilder::getBrushes(*bsp);
+	brushes.resize(params.numBrushes);
+	for (size_t b = 0; b < params.numBrushes; ++b)
+	{
+		BSPData::Brush& brush = brushes[b];
+		brush.numsides = NUM_SIDES;
+		brush.sides = &brushSides[b * NUM_SIDES];
+		brush.shader = brush.sides[0].shader;
+		brush.contents = 1;
+
+		randomPoint(random, params.extent, brush.bounds[0]);
+		// some brushes are over many cells, or have no volume
+		const uint32_t kind = random() % 20;
+		const float size = kind == 0 ? params.extent * 4 : kind == 1 ? 0.f : randomFloat(random, 8.f, 300.f);
+		for (size_t i = 0; i < 3; ++i) {
+			brush.bounds[1][i] = brush.bounds[0][i] + size;
+		}
+	}
+
+	std::vector<BSPData::Surface>& surfaces = BSPTestBuilder::getSurfaces(*bsp);
+	surfaces.resize(params.numSurfaces + params.numPatches);
+	for (size_t k = 0; k < surfaces.size(); ++k)
+	{
+		BSPData::Surface& surf = surfaces[k];
+		surf.shader = &shaders[shaderDist(random)];
+
+		// planar surfaces and patches are mixed
+		surf.bIsPatch = random() % (params.numSurfaces + params.numPatches) < params.numPatches;
+		if (surf.bIsPatch)
+		{
+			// small patches close to each other, so they form chains
+			vec3_t origin;
+			randomPoint(random, params.extent / 4, origin);
+			surf.vertices.resize(9);
+			for (BSPData::Vertice& vert : surf.vertices)
+			{
+				for (size_t i = 0; i < 3; ++i) {
+					vert.xyz[i] = origin[i] + randomFloat(random, 0.f, 64.f);
+				}
+			}
+		}
+		else
+		{
+			randomPoint(random, params.extent, surf.centroid);
+			surf.vertices.resize(3);
+			for (BSPData::Vertice& vert : surf.vertices)
+			{
+				for (size_t i = 0; i < 3; ++i) {
+					vert.xyz[i] = surf.centroid[i] + randomFloat(random, -16.f, 16.f);
+				}
+			}
+		}
+	}
+
+	BSPData::Model worldModel{};
+	worldModel.surface = surfaces.data();
+	worldModel.numSurfaces = (int32_t)surfaces.size();
+	BSPTestBuilder::getBrushModels(*bsp).push_back(worldModel);
+
+	return bsp;
+}
+
+void testGrouping(const levelParams_t& params)
+{
+	const BSPPtr bsp = generateLevel(params);
+
+	referenceGrouping_t reference;
+	groupReference(*bsp, reference);
+
+	const BSPGroupPtr bspGroup = BSPGroup::create();
+	bspGroup->groupSurfaces(*bsp);
+
+	// same parent for each brush
+	assert(bspGroup->getNumBrushData() == bsp->GetNumBrushes());
+	for (size_t b = 0; b < bspGroup->getNumBrushData(); ++b)
+	{
+		const BSPData::BrushGroupData* brushData = bspGroup->getBrushData(b);
+		assert(brushData->getBrush() == bsp->GetBrush(b));
+
+		const size_t parentNum = reference.brushParents[b];
+		assert(brushData->getParent() == (parentNum != NO_PARENT ? bspGroup->getBrushData(parentNum) : nullptr));
+
+		const std::vector<const BSPData::Surface*>& surfaces = reference.brushSurfaces[b];
+		assert(brushData->getNumSurfaces() == surfaces.size());
+		for (size_t k = 0; k < surfaces.size(); ++k) {
+			assert(brushData->getSurface(k) == surfaces[k]);
+		}
+	}
+
+	// same groups in the same order
+	assert(bspGroup->getNumGroupedSurfaces() == reference.groups.size());
+	for (size_t i = 0; i < reference.groups.size(); ++i)
+	{
+		const BSPData::GroupedSurfaces* groupedSurfaces = bspGroup->getGroupedSurfaces(i);
+		const referenceGroup_t& group = reference.groups[i];
+
+		assert(group.name == groupedSurfaces->GetGroupName());
+		assert(groupedSurfaces->GetNumSurfaces() == group.surfaces.size());
+		for (size_t k = 0; k < group.surfaces.size(); ++k) {
+			assert(groupedSurfaces->GetSurface(k) == group.surfaces[k]);
+		}
+
+		assert(groupedSurfaces->GetNumBrushesData() == group.brushes.size());
+		for (size_t k = 0; k < group.brushes.size(); ++k) {
+			assert(groupedSurfaces->GetBrushData(k) == group.brushes[k]);
+		}
+	}
+
+	MOHPC_LOG(Info, "seed %u: %zu brushes, %zu grouped surfaces", params.seed, bspGroup->getNumBrushData(), bspGroup->getNumGroupedSurfaces());
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	// nothing to group
+	testGrouping(levelParams_t{ 1, 0, 0, 0, 512.f });
+	// only brushes, only surfaces, only patches
+	testGrouping(levelParams_t{ 2, 200, 0, 0, 512.f });
+	testGrouping(levelParams_t{ 3, 0, 200, 0, 512.f });
+	testGrouping(levelParams_t{ 4, 0, 0, 200, 512.f });
+	// dense, most brushes and patches are connected
+	testGrouping(levelParams_t{ 5, 300, 400, 100, 256.f });
+	// spread over many grid cells
+	testGrouping(levelParams_t{ 6, 1000, 1500, 300, 2048.f });
+	testGrouping(levelParams_t{ 7, 2000, 2000, 500, 1024.f });
+}
@@ -2,14 +2,18 @@
 #include <MOHPC/Utility/Misc/MSG/Codec.h>
 #include <MOHPC/Utility/Misc/MSG/Stream.h>
 #include <MOHPC/Utility/Misc/MSG/Serializable.h>
+#include <MOHPC/Utility/Misc/MSG/HuffmanTree.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 #include <MOHPC/Utility/Misc/Endian.h>
 #include <MOHPC/Network/Types/Entity.h>
 #include <MOHPC/Network/Types/PlayerState.h>
 #include <MOHPC/Network/Serializable/Entity.h>
 #include <MOHPC/Network/Serializable/PlayerState.h>
 #include <MOHPC/Network/Serializable/Angles.h>
+#include <MOHPC/Common/Log.h>
 #include "Common/Common.h"
 
+#include <chrono>
 #include <vector>
 #include <random>
 #include <cassert>
@@ -19,9 +23,14 @@
 using namespace MOHPC;
 using namespace Network;
 
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_msg";
+
 void TestShift();
 void TestMSG();
 void TestCompression();
+void TestHuffmanLookup();
+void TestHuffmanEncoding();
+void TestMSGBuffer();
 void TestPlayerState();
 void TestEntityState();
 void AssertEntity(const entityState_t& to, const entityState_t& from);
@@ -36,9 +45,14 @@ bool approximation(const_vec3r_t a, const_vec3r_t b, float tolerance)
 
 int main(int argc, const char* argv[])
 {
+	InitCommon(argc, argv);
+
 	TestShift();
 	TestMSG();
 	TestCompression();
+	TestHuffmanLookup();
+	TestHuffmanEncoding();
+	TestMSGBuffer();
 
 	for (size_t i = 0; i < 5000; ++i)
 	{
@@ -229,6 +243,216 @@ void TestCompression()
 	}
 }
 
+static void BuildTestHuff(Huff& huff, std::vector<uint8_t>& symbols, size_t numSymbols)
+{
+	std::mt19937 gen(1);
+	// small values are much more frequent, like in network messages
+	std::geometric_distribution<> symbolDistrib(0.05);
+
+	for (size_t i = 0; i < 256; ++i) {
+		huff.addRef(uint8_t(i));
+	}
+
+	for (size_t i = 0; i < 100000; ++i) {
+		huff.addRef(uint8_t(symbolDistrib(gen)));
+	}
+
+	symbols.resize(numSymbols);
+	for (size_t i = 0; i < numSymbols; ++i) {
+		symbols[i] = uint8_t(symbolDistrib(gen));
+	}
+}
+
+void TestHuffmanLookup()
+{
+	using namespace std::chrono;
+
+	const size_t numSymbols = 1 << 20;
+	Huff huff;
+	std::vector<uint8_t> symbols;
+	BuildTestHuff(huff, symbols, numSymbols);
+
+	// each symbol is at most 32 bits, leave room for the lookahead
+	std::vector<uint8_t> encoded(numSymbols * 4 + 4);
+	size_t numBits = 0;
+	for (size_t i = 0; i < numSymbols; ++i) {
+		huff.transmit(symbols[i], encoded.data(), numBits);
+	}
+
+	const HuffLookupDecoder<node_t> decoder(huff.getTree());
+
+	std::vector<uint8_t> treeDecoded(numSymbols);
+	std::vector<uint8_t> tableDecoded(numSymbols);
+
+	const steady_clock::time_point treeStart = steady_clock::now();
+	size_t bloc = 0;
+	for (size_t i = 0; i < numSymbols; ++i) {
+		treeDecoded[i] = (uint8_t)huff.receive(encoded.data(), bloc);
+	}
+	assert(bloc == numBits);
+	const duration<double> treeTime = steady_clock::now() - treeStart;
+
+	const steady_clock::time_point tableStart = steady_clock::now();
+	bloc = 0;
+	for (size_t i = 0; i < numSymbols; ++i) {
+		tableDecoded[i] = (uint8_t)decoder.receive(encoded.data(), bloc);
+	}
+	assert(bloc == numBits);
+	const duration<double> tableTime = steady_clock::now() - tableStart;
+
+	assert(treeDecoded == symbols);
+	assert(tableDecoded == symbols);
+
+	MOHPC_LOG(
+		Info,
+		"huffman decoding: tree %.2f MB/s, table %.2f MB/s (x%.2f)",
+		numSymbols / treeTime.count() / 1e6,
+		numSymbols / tableTime.count() / 1e6,
+		treeTime.count() / tableTime.count()
+	);
+}
+
+void TestHuffmanEncoding()
+{
+	using namespace std::chrono;
+
+	const size_t numSymbols = 1 << 20;
+	Huff huff;
+	std::vector<uint8_t> symbols;
+	BuildTestHuff(huff, symbols, numSymbols);
+
+	const HuffLookupEncoder encoder(huff);
+
+	std::vector<uint8_t> treeEncoded(numSymbols * 4);
+	std::vector<uint8_t> tableEncoded(numSymbols * 4);
+
+	const steady_clock::time_point treeStart = steady_clock::now();
+	size_t treeBits = 0;
+	for (size_t i = 0; i < numSymbols; ++i) {
+		huff.transmit(symbols[i], treeEncoded.data(), treeBits);
+	}
+	const duration<double> treeTime = steady_clock::now() - treeStart;
+
+	const steady_clock::time_point tableStart = steady_clock::now();
+	size_t tableBits = 0;
+	for (size_t i = 0; i < numSymbols; ++i) {
+		encoder.transmit(symbols[i], tableEncoded.data(), tableBits);
+	}
+	const duration<double> tableTime = steady_clock::now() - tableStart;
+
+	assert(treeBits == tableBits);
+	assert(!std::memcmp(treeEncoded.data(), tableEncoded.data(), (treeBits + 7) >> 3));
+
+	MOHPC_LOG(
+		Info,
+		"huffman encoding: tree %.2f MB/s, table %.2f MB/s (x%.2f)",
+		numSymbols / treeTime.count() / 1e6,
+		numSymbols / tableTime.count() / 1e6,
+		treeTime.count() / tableTime.count()
+	);
+}
+
+void TestMSGBuffer()
+{
+	using namespace std::chrono;
+
+	const size_t numValues = 1 << 18;
+	std::vector<uint32_t> values(numValues);
+	std::vector<uint8_t> numBits(numValues);
+
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<uint32_t> bitsDistrib(1, 32);
+	std::geometric_distribution<uint32_t> valueDistrib(0.001);
+	for (size_t i = 0; i < numValues; ++i)
+	{
+		numBits[i] = uint8_t(bitsDistrib(gen));
+		values[i] = valueDistrib(gen) & uint32_t((uint64_t(1) << numBits[i]) - 1);
+	}
+
+	std::vector<uint8_t> msgBuffer(numValues * 8);
+	std::vector<uint8_t> fastBuffer(numValues * 8);
+
+	size_t msgLength = 0;
+	{
+		FixedDataMessageStream stream(msgBuffer.data(), msgBuffer.size());
+		MSG msg(stream, msgMode_e::Writing);
+		for (size_t i = 0; i < numValues; ++i) {
+			msg.WriteNumber(values[i], numBits[i]);
+		}
+		msg.WriteString("testString");
+		msg.WriteFloat(5.f);
+		msg.Flush();
+		msgLength = stream.GetPosition();
+	}
+
+	size_t fastLength = 0;
+	{
+		MSGBufferWriter<> writer(fastBuffer.data(), fastBuffer.size());
+		for (size_t i = 0; i < numValues; ++i) {
+			writer.WriteNumber(values[i], numBits[i]);
+		}
+		writer.WriteString("testString");
+		writer.WriteFloat(5.f);
+		writer.Flush();
+		fastLength = writer.GetPosition();
+	}
+
+	// must be bit-exact with MSG
+	assert(msgLength == fastLength);
+	assert(!std::memcmp(msgBuffer.data(), fastBuffer.data(), msgLength));
+
+	const steady_clock::time_point msgStart = steady_clock::now();
+	{
+		FixedDataMessageStream stream(msgBuffer.data(), msgBuffer.size(), msgLength);
+		MSG msg(stream, msgMode_e::Reading);
+		for (size_t i = 0; i < numValues; ++i)
+		{
+			const uint32_t value = msg.ReadNumber<uint32_t>(numBits[i]);
+			assert(value == values[i]);
+		}
+	}
+	const duration<double> msgTime = steady_clock::now() - msgStart;
+
+	const steady_clock::time_point fastStart = steady_clock::now();
+	{
+		MSGBufferReader<> reader(fastBuffer.data(), fastLength);
+		for (size_t i = 0; i < numValues; ++i)
+		{
+			const uint32_t value = reader.ReadNumber<uint32_t>(numBits[i]);
+			assert(value == values[i]);
+		}
+
+		const StringMessage testString = reader.ReadString();
+		assert(!strcmp(testString, "testString"));
+		const float floatVal = reader.ReadFloat();
+		assert(floatVal == 5.f);
+	}
+	const duration<double> fastTime = steady_clock::now() - fastStart;
+
+	// switching codec in the middle of a message
+	{
+		uint8_t oobBuffer[16];
+		MSGBufferWriter<MessageCodecs::OOBPolicy> oobWriter(oobBuffer, sizeof(oobBuffer));
+		oobWriter.WriteInteger(-1);
+		MSGBufferWriter<> bitWriter(oobWriter.bitWriter());
+		bitWriter.WriteUShort(1234);
+		bitWriter.Flush();
+
+		MSGBufferReader<MessageCodecs::OOBPolicy> oobReader(oobBuffer, bitWriter.GetPosition());
+		assert(oobReader.ReadInteger() == -1);
+		MSGBufferReader<> bitReader(oobReader.bitReader());
+		assert(bitReader.ReadUShort() == 1234);
+	}
+
+	MOHPC_LOG(
+		Info,
+		"message reading: MSG %.2f Mvalues/s, MSGBufferReader %.2f Mvalues/s (x%.2f)",
+		numValues / msgTime.count() / 1e6,
+		numValues / fastTime.count() / 1e6,
+		msgTime.count() / fastTime.count()
+	);
+}
+
 void TestPlayerState()
 {
 	playerState_t ps1, ps2;
@@ -0,0 +1,190 @@
+#include <MOHPC/Network/Client/ClientHost.h>
+#include <MOHPC/Network/Remote/IPRemoteIdentifier.h>
+#include <MOHPC/Network/Remote/Socket.h>
+
+#include "Common/Common.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_clienthost";
+
+static constexpr uint64_t WAIT_TIME = 1000;
+
+/**
+ * Fake server listening on the loopback address.
+ */
+struct loopbackServer_t
+{
+	NetAddr4Ptr address;
+	IRemoteIdentifierPtr identifier;
+	IUdpSocketPtr socket;
+
+	loopbackServer_t(uint16_t port)
+	{
+		address = NetAddr4::create();
+		address->setIp(127, 0, 0, 1);
+		address->setPort(port);
+		identifier = IPRemoteIdentifier::create(address);
+		socket = ISocketFactory::get()->createUdp(address.get());
+	}
+
+	/** Wait for a datagram and return its content, from is the address of the client. */
+	str receive(NetAddrPtr& from)
+	{
+		if (!socket->wait(WAIT_TIME)) {
+			return str();
+		}
+
+		char buf[256];
+		const size_t len = socket->receive(buf, sizeof(buf), from);
+		return str(buf, len);
+	}
+
+	void send(const NetAddrPtr& to, const char* data)
+	{
+		socket->send(to, data, strlen(data));
+	}
+};
+
+void sendToServer(const ICommunicatorPtr& comm, const loopbackServer_t& server, const char* data)
+{
+	const size_t len = strlen(data);
+	assert(comm->send(*server.identifier, (const uint8_t*)data, len) == len);
+}
+
+str receiveFromServer(const ICommunicatorPtr& comm, const loopbackServer_t& server)
+{
+	if (!comm->waitIncoming(WAIT_TIME)) {
+		return str();
+	}
+
+	uint8_t buf[256];
+	IRemoteIdentifierPtr from;
+	const size_t len = comm->receive(from, buf, sizeof(buf));
+	// only the server can be the source
+	assert(from == server.identifier);
+
+	return str((const char*)buf, len);
+}
+
+void testSharedSocket()
+{
+	loopbackServer_t server1(12250);
+	loopbackServer_t server2(12251);
+
+	NetAddr4 bindAddress;
+	bindAddress.setIp(127, 0, 0, 1);
+	ClientHost host(2, &bindAddress);
+
+	// different servers share the same socket
+	const ICommunicatorPtr comm1 = host.createCommunicator(server1.identifier);
+	const ICommunicatorPtr comm2 = host.createCommunicator(server2.identifier);
+	assert(comm1 && comm2);
+	assert(host.getNumSockets() == 1);
+
+	sendToServer(comm1, server1, "hello1");
+	sendToServer(comm2, server2, "hello2");
+
+	NetAddrPtr client1, client2;
+	assert(server1.receive(client1) == "hello1");
+	assert(server2.receive(client2) == "hello2");
+	// sent from the same socket
+	assert(client1->getPort() == client2->getPort());
+
+	server1.send(client1, "reply1");
+	server2.send(client2, "reply2");
+
+	// each datagram is queued in the communicator of its source
+	assert(receiveFromServer(comm2, server2) == "reply2");
+	assert(receiveFromServer(comm1, server1) == "reply1");
+	assert(!comm1->getIncomingSize());
+	assert(!comm2->getIncomingSize());
+
+	// datagrams are also dispatched while ticking
+	server1.send(client1, "tick1");
+	server2.send(client2, "tick2");
+	for (size_t i = 0; i < 100 && (!comm1->getIncomingSize() || !comm2->getIncomingSize()); ++i)
+	{
+		host.tick(deltaTime_t(), tickClock_t::now());
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	assert(comm1->getIncomingSize() == 5);
+	assert(comm2->getIncomingSize() == 5);
+	assert(receiveFromServer(comm1, server1) == "tick1");
+	assert(receiveFromServer(comm2, server2) == "tick2");
+}
+
+void testSameServer()
+{
+	loopbackServer_t server(12252);
+
+	NetAddr4 bindAddress;
+	bindAddress.setIp(127, 0, 0, 1);
+	ClientHost host(2, &bindAddress);
+
+	// the server can't be told apart on the same socket, so another one is opened
+	const ICommunicatorPtr comm1 = host.createCommunicator(server.identifier);
+	const ICommunicatorPtr comm2 = host.createCommunicator(server.identifier);
+	assert(comm1 && comm2);
+	assert(host.getNumSockets() == 2);
+
+	sendToServer(comm1, server, "first");
+	NetAddrPtr client1;
+	assert(server.receive(client1) == "first");
+
+	sendToServer(comm2, server, "second");
+	NetAddrPtr client2;
+	assert(server.receive(client2) == "second");
+	assert(client1->getPort() != client2->getPort());
+
+	server.send(client2, "to2");
+	server.send(client1, "to1");
+	assert(receiveFromServer(comm1, server) == "to1");
+	assert(receiveFromServer(comm2, server) == "to2");
+}
+
+void testUnknownSource()
+{
+	loopbackServer_t server(12253);
+	loopbackServer_t stranger(12254);
+
+	NetAddr4 bindAddress;
+	bindAddress.setIp(127, 0, 0, 1);
+	ClientHost host(1, &bindAddress);
+
+	const ICommunicatorPtr comm = host.createCommunicator(server.identifier);
+	sendToServer(comm, server, "hello");
+
+	NetAddrPtr client;
+	assert(server.receive(client) == "hello");
+
+	// datagrams from other addresses are dropped
+	stranger.send(client, "spoofed");
+	server.send(client, "reply");
+	assert(receiveFromServer(comm, server) == "reply");
+	assert(!comm->waitIncoming(100));
+}
+
+void testUnsupportedAddress()
+{
+	ClientHost host(1);
+	assert(!host.createCommunicator(nullptr));
+	assert(!host.getNumSockets());
+	assert(!host.getNumConnections());
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	testSharedSocket();
+	testSameServer();
+	testUnknownSource();
+	testUnsupportedAddress();
+}
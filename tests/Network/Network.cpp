@@ -4,6 +4,7 @@
 #include <MOHPC/Network/Client/MasterList.h>
 #include <MOHPC/Network/Client/RemoteConsole.h>
 #include <MOHPC/Network/Client/ServerQuery.h>
+#include <MOHPC/Network/Client/ServerSweep.h>
 #include <MOHPC/Network/Client/Protocol.h>
 #include <MOHPC/Network/Client/PingCalculator.h>
 #include <MOHPC/Network/Client/CGame/Prediction.h>
@@ -13,6 +14,7 @@
 #include <MOHPC/Network/Remote/TCPMessageDispatcher.h>
 #include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
 #include <MOHPC/Network/Remote/SocketUdpDelay.h>
+#include <MOHPC/Network/Remote/SocketPoller.h>
 #include <MOHPC/Common/str.h>
 #include <MOHPC/Utility/Misc/MSG/Stream.h>
 #include <MOHPC/Utility/Info.h>
@@ -53,6 +55,7 @@ char buf[512];
 
 void readCommandThread();
 void testMasterServer(const NetAddr4Ptr& bindAddress);
+void testMasterServerSweep(const NetAddr4Ptr& bindAddress);
 ServerListPtr testGame(const NetAddr4Ptr& bindAddress, const NetAddr4Ptr& addr, const MessageDispatcherPtr& dispatcher, const UDPCommunicatorPtr& udpComm, Network::gameListType_e type);
 void testLANQuery(const NetAddr4Ptr& bindAddress);
 void fetchServer(const IServerPtr& ptr, MessageQueuePtr queuePtr, size_t& countAlive, size_t& countTotal);
@@ -96,6 +99,7 @@ int main(int argc, const char* argv[])
 	//bindAdr->setIp(127, 0, 0, 1);
 	bindAdr->setPort(gen() % 65536);
 	//testMasterServer(bindAdr);
+	//testMasterServerSweep(bindAdr);
 	//testLANQuery(bindAdr);
 
 	NetAddr4Ptr adr = NetAddr4::create();
@@ -773,6 +777,8 @@ void testMasterServer(const NetAddr4Ptr& bindAddress)
 
 	const MessageDispatcherPtr& msgDispatcher = queueDispatcher.getDispatcher();
 	const MessageQueuePtr& msgQueue = queueDispatcher.getQueue();
+	// wait on the udp and all master server sockets at once
+	msgDispatcher->setPoller(SocketPoller::create());
 
 	const UDPCommunicatorPtr udpComm = UDPCommunicator::create();
 	msgDispatcher->addComm(udpComm);
@@ -796,6 +802,60 @@ void testMasterServer(const NetAddr4Ptr& bindAddress)
 	MOHPC_LOG(Info, "Done querying, %zu alive(s), %zu total", countAlive, countTotal);
 }
 
+void testMasterServerSweep(const NetAddr4Ptr& bindAddress)
+{
+	NetAddr4Ptr addr = ISocketFactory::get()->getHost("master.x-null.net");
+	addr->setPort(28900);
+
+	const MessageDispatcherPtr msgDispatcher = MessageDispatcher::create();
+	const UDPCommunicatorPtr udpComm = UDPCommunicator::create();
+	msgDispatcher->addComm(udpComm);
+
+	size_t countAlive = 0;
+	size_t countTotal = 0;
+
+	ServerSweepPtr sweep = ServerSweep::create(sweepQuery_e::Gamespy);
+	sweep->setPacketsPerSecond(1000);
+	sweep->setCallbacks(
+		[&countAlive](const IRemoteIdentifierPtr& server, const ReadOnlyInfo& info, uint64_t ping)
+		{
+			++countAlive;
+			MOHPC_LOG(Info, "%s (%llu ms): %s", server->getString().c_str(), (unsigned long long)ping, info.ValueForKey("hostname").c_str());
+		},
+		[](const IRemoteIdentifierPtr& server)
+		{
+			MOHPC_LOG(Info, "%s timed out", server->getString().c_str());
+		}
+	);
+
+	ServerListPtr masters[3];
+	for (size_t i = 0; i < 3; ++i)
+	{
+		ServerListPtr& master = masters[i];
+		master = testGame(bindAddress, addr, msgDispatcher, udpComm, (Network::gameListType_e)((uint32_t)Network::gameListType_e::mohaa + i));
+		master->fetch([&sweep, &countTotal](const IServerPtr& server)
+		{
+			++countTotal;
+			sweep->addServer(server);
+		});
+	}
+
+	MOHPC_LOG(Info, "Requesting master server...");
+
+	// servers are queried while the list is being received
+	for (;;)
+	{
+		msgDispatcher->processIncomingMessages(10);
+
+		const bool sweepDone = sweep->process(10);
+		if (sweepDone && !msgDispatcher->hasMessagesToProcess()) {
+			break;
+		}
+	}
+
+	MOHPC_LOG(Info, "Done sweeping, %zu alive(s), %zu total, average rtt %llu ms", countAlive, countTotal, (unsigned long long)sweep->getAverageRtt());
+}
+
 ServerListPtr testGame(const NetAddr4Ptr& bindAddress, const NetAddr4Ptr& addr, const MessageDispatcherPtr& dispatcher, const UDPCommunicatorPtr& udpComm, Network::gameListType_e type)
 {
 	const TCPCommunicatorPtr tcpComm = TCPCommunicator::create(ISocketFactory::get()->createTcp(addr, bindAddress.get()));
@@ -4,15 +4,22 @@
 #include <MOHPC/Network/Parsing/PlayerState.h>
 #include <MOHPC/Network/Parsing/GameState.h>
 #include <MOHPC/Network/Parsing/PVS.h>
+#include <MOHPC/Network/Parsing/Snapshot.h>
 #include <MOHPC/Network/Types/GameState.h>
+#include <MOHPC/Network/Types/Snapshot.h>
+#include <MOHPC/Network/Types/EntityStateRing.h>
+#include <MOHPC/Network/Types/ReliableTemplate.h>
 
 #include <MOHPC/Utility/Info.h>
 #include <MOHPC/Utility/Misc/MSG/Stream.h>
 #include <MOHPC/Utility/Misc/MSG/MSG.h>
+#include <MOHPC/Utility/Misc/MSG/MSGBuffer.h>
 
 #include "Common/Common.h"
 
 #include <cassert>
+#include <cstring>
+#include <random>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
@@ -170,6 +177,239 @@ void entityTest()
 	testAllVersions(&entityTestInternal);
 }
 
+void randomizeEntity(entityState_t& state, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> coord(-8192.f, 8192.f);
+	std::uniform_real_distribution<float> angle(0.f, 360.f);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::uniform_int_distribution<uint32_t> index(0, 1023);
+	std::uniform_int_distribution<uint32_t> chance(0, 3);
+
+	// change some fields, so some are not part of the delta
+	if (!chance(rng))
+	{
+		state.netorigin[0] = coord(rng);
+		state.netorigin[1] = coord(rng);
+		state.netorigin[2] = (float)(int)coord(rng);
+	}
+	if (!chance(rng))
+	{
+		state.netangles[0] = angle(rng);
+		state.netangles[1] = angle(rng);
+	}
+	if (!chance(rng))
+	{
+		state.actionWeight = unit(rng);
+		state.scale = unit(rng) * 2.f;
+		state.alpha = unit(rng);
+	}
+	if (!chance(rng))
+	{
+		state.modelindex = index(rng);
+		state.eFlags = index(rng);
+		state.solid = index(rng);
+	}
+
+	for (size_t i = 0; i < entityState_t::MAX_FRAMEINFOS; ++i)
+	{
+		if (!chance(rng))
+		{
+			state.frameInfo[i].index = index(rng);
+			state.frameInfo[i].time = unit(rng) * 10.f;
+			state.frameInfo[i].weight = unit(rng);
+		}
+	}
+}
+
+void randomizePlayerState(playerState_t& state, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> coord(-8192.f, 8192.f);
+	std::uniform_real_distribution<float> angle(0.f, 360.f);
+	std::uniform_int_distribution<uint32_t> value(0, 255);
+	std::uniform_int_distribution<uint32_t> chance(0, 3);
+
+	if (!chance(rng))
+	{
+		state.origin[0] = coord(rng);
+		state.origin[1] = coord(rng);
+		state.origin[2] = (float)(int)coord(rng);
+	}
+	if (!chance(rng))
+	{
+		state.velocity[0] = coord(rng) / 16.f;
+		state.velocity[2] = coord(rng) / 16.f;
+	}
+	if (!chance(rng))
+	{
+		state.viewangles[0] = angle(rng);
+		state.viewangles[1] = angle(rng);
+		state.fLeanAngle = angle(rng) / 8.f;
+	}
+	if (!chance(rng))
+	{
+		state.speed = value(rng) * 2;
+		state.gravity = value(rng) * 4;
+		state.bobCycle = value(rng);
+		state.iViewModelAnim = value(rng) & 15;
+	}
+
+	for (size_t i = 0; i < sizeof(state.stats) / sizeof(state.stats[0]); ++i)
+	{
+		if (!chance(rng)) {
+			state.stats[i] = value(rng);
+		}
+	}
+}
+
+bool isSameEntity(const entityState_t& a, const entityState_t& b)
+{
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (a.netorigin[i] != b.netorigin[i] || a.netangles[i] != b.netangles[i]) {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < entityState_t::MAX_FRAMEINFOS; ++i)
+	{
+		if (a.frameInfo[i].index != b.frameInfo[i].index
+			|| a.frameInfo[i].time != b.frameInfo[i].time
+			|| a.frameInfo[i].weight != b.frameInfo[i].weight)
+		{
+			return false;
+		}
+	}
+
+	return a.number == b.number
+		&& a.actionWeight == b.actionWeight
+		&& a.scale == b.scale
+		&& a.alpha == b.alpha
+		&& a.modelindex == b.modelindex
+		&& a.eFlags == b.eFlags
+		&& a.solid == b.solid;
+}
+
+bool isSamePlayerState(const playerState_t& a, const playerState_t& b)
+{
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (a.origin[i] != b.origin[i] || a.velocity[i] != b.velocity[i] || a.viewangles[i] != b.viewangles[i]) {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(a.stats) / sizeof(a.stats[0]); ++i)
+	{
+		if (a.stats[i] != b.stats[i]) {
+			return false;
+		}
+	}
+
+	return a.fLeanAngle == b.fLeanAngle
+		&& a.speed == b.speed
+		&& a.gravity == b.gravity
+		&& a.bobCycle == b.bobCycle
+		&& a.iViewModelAnim == b.iViewModelAnim;
+}
+
+void roundTripEntity(const Parsing::IEntity* entity, const entityState_t& from, const entityState_t& to, entityState_t& out)
+{
+	const deltaTimeFloat_t deltaTime = deltaTimeFloat_t(0.05f);
+
+	uint8_t data[4096];
+	FixedDataMessageStream stream(data, sizeof(data));
+	{
+		MSG msg(stream, msgMode_e::Writing);
+		entity->writeDeltaEntity(msg, &from, &to, to.number, deltaTime);
+	}
+
+	stream.Seek(0);
+	{
+		MSG msg(stream, msgMode_e::Reading);
+		entity->readDeltaEntity(msg, &from, &out, to.number, deltaTime);
+	}
+
+	// reading from the buffer directly must give the same result
+	MSGBufferReader<MessageCodecs::BitPolicy> reader(data, sizeof(data));
+	entityState_t bufferOut;
+	entity->readDeltaEntity(reader, &from, &bufferOut, to.number, deltaTime);
+	assert(isSameEntity(out, bufferOut));
+}
+
+void roundTripPlayerState(const Parsing::IPlayerState* playerState, const playerState_t& from, const playerState_t& to, playerState_t& out)
+{
+	uint8_t data[4096];
+	FixedDataMessageStream stream(data, sizeof(data));
+	{
+		MSG msg(stream, msgMode_e::Writing);
+		playerState->writeDeltaPlayerState(msg, &from, &to);
+	}
+
+	stream.Seek(0);
+	{
+		MSG msg(stream, msgMode_e::Reading);
+		playerState->readDeltaPlayerState(msg, &from, &out);
+	}
+
+	// reading from the buffer directly must give the same result
+	MSGBufferReader<MessageCodecs::BitPolicy> reader(data, sizeof(data));
+	playerState_t bufferOut;
+	playerState->readDeltaPlayerState(reader, &from, &bufferOut);
+	assert(isSamePlayerState(out, bufferOut));
+}
+
+void randomDeltaTestInternal(uint32_t version)
+{
+	const Parsing::IEntity* entity = Parsing::IEntity::get(version);
+	const Parsing::IPlayerState* playerState = Parsing::IPlayerState::get(version);
+
+	std::mt19937 rng(version);
+
+	for (size_t i = 0; i < 2000; ++i)
+	{
+		// some fields are quantized, so the first round trip may change values,
+		// but sending what was decoded must give back exactly the same state
+		{
+			entityState_t from;
+			from.number = 5;
+			randomizeEntity(from, rng);
+
+			entityState_t to = from;
+			randomizeEntity(to, rng);
+
+			entityState_t decoded;
+			roundTripEntity(entity, from, to, decoded);
+			assert(decoded.number == to.number);
+			assert(decoded.modelindex == to.modelindex);
+
+			entityState_t decoded2;
+			roundTripEntity(entity, from, decoded, decoded2);
+			assert(isSameEntity(decoded, decoded2));
+		}
+
+		{
+			playerState_t from;
+			randomizePlayerState(from, rng);
+
+			playerState_t to = from;
+			randomizePlayerState(to, rng);
+
+			playerState_t decoded;
+			roundTripPlayerState(playerState, from, to, decoded);
+			assert(decoded.speed == to.speed);
+
+			playerState_t decoded2;
+			roundTripPlayerState(playerState, from, decoded, decoded2);
+			assert(isSamePlayerState(decoded, decoded2));
+		}
+	}
+}
+
+void randomDeltaTest()
+{
+	testAllVersions(&randomDeltaTestInternal);
+}
+
 void gameStateTestInternal(uint32_t version)
 {
 	const Parsing::IGameState* gameStateParsing = Parsing::IGameState::get(version);
@@ -314,6 +554,187 @@ void PVSTest()
 	testAllVersions(&PVSTestInternal);
 }
 
+void writeSnapshotHeader(MSG& msg, uint32_t serverTime, uint8_t deltaNum)
+{
+	msg.WriteUInteger(serverTime);
+	// residual
+	msg.WriteByte(0);
+	msg.WriteByte(deltaNum);
+	// flags
+	msg.WriteByte(0);
+	// area mask
+	msg.WriteByte(1);
+	msg.WriteByte(0xFF);
+}
+
+void snapshotTestInternal(uint32_t version)
+{
+	const Parsing::ISnapshot* snapshotParser = Parsing::ISnapshot::get(version);
+	const Parsing::IEntity* entity = Parsing::IEntity::get(version);
+	const Parsing::IPlayerState* playerState = Parsing::IPlayerState::get(version);
+	const Parsing::IGameState* gameStateParsing = Parsing::IGameState::get(version);
+	assert(snapshotParser);
+
+	gameState_t gs = gameStateParsing->create();
+	const EntityList& baselines = gs.getEntityBaselines();
+	RemoteCommandSequenceTemplate<64, 2048> serverCommands;
+	const deltaTimeFloat_t deltaTime = deltaTimeFloat_t(0.05f);
+
+	// small enough to wrap around
+	EntityStateRing parseEntities(64, 64);
+	rawSnapshot_t storage[4];
+	const rawSnapshot_t* snapshots[4] = { &storage[0], &storage[1], &storage[2], &storage[3] };
+
+	Parsing::snapshotParm_t parm;
+	parm.oldSnapshots = snapshots;
+	parm.numOldSnapshots = 4;
+	parm.parseEntities = &parseEntities;
+	parm.maxParseEntities = parseEntities.capacity();
+	parm.maxSnapshotEntities = 16;
+	parm.parseEntitiesNum = 0;
+	parm.deltaTime = deltaTime;
+	parm.entityTable = nullptr;
+
+	entityState_t states[10];
+	for (entityNum_t i = 0; i < 10; ++i)
+	{
+		states[i].number = i;
+		states[i].netorigin[0] = i * 10.f;
+	}
+
+	playerState_t ps;
+	ps.origin[0] = 15.f;
+
+	uint8_t streamData[4096];
+	{
+		// first snapshot, without delta
+		FixedDataMessageStream stream(streamData, sizeof(streamData));
+		{
+			MSG msg(stream, msgMode_e::Writing);
+			writeSnapshotHeader(msg, 1000, 0);
+			playerState->writeDeltaPlayerState(msg, nullptr, &ps);
+			for (entityNum_t num : { 3, 5, 7 })
+			{
+				entity->writeEntityNum(msg, num);
+				entity->writeDeltaEntity(msg, &baselines.getEntity(num), &states[num], num, deltaTime);
+			}
+			entity->writeEntityNum(msg, ENTITYNUM_NONE);
+			// no sound
+			msg.WriteBool(false);
+			// what follows the snapshot in the message
+			msg.WriteByte(0x5A);
+		}
+
+		stream.Seek(0);
+		MSG msg(stream, msgMode_e::Reading);
+		rawSnapshot_t& snap = storage[1];
+		parm.numDeltaEntities = 0;
+		snapshotParser->parseSnapshot(msg, gs, &serverCommands, snap, parm, 1);
+		// the message must continue right after the snapshot
+		assert(msg.ReadByte() == 0x5A);
+
+		assert(snap.valid);
+		assert(snap.messageNum == 1);
+		assert(snap.numEntities == 3);
+		assert(parm.numDeltaEntities == 3);
+		assert(snap.ps.origin[0] == 15.f);
+		assert(parseEntities.get(snap.parseEntitiesNum + 1).number == 5);
+		assert(parseEntities.get(snap.parseEntitiesNum + 2).netorigin[0] == 70.f);
+	}
+
+	for (uint32_t messageNum = 2; messageNum < 60; ++messageNum)
+	{
+		const rawSnapshot_t& old = storage[(messageNum - 1) % 4];
+
+		// 3 is unchanged, 5 moves, 7 is removed then added again
+		const bool has7 = !!(messageNum & 1);
+		entityState_t moved = states[5];
+		moved.netorigin[0] = (float)messageNum;
+
+		FixedDataMessageStream stream(streamData, sizeof(streamData));
+		{
+			MSG msg(stream, msgMode_e::Writing);
+			writeSnapshotHeader(msg, 1000 + messageNum * 50, 1);
+			playerState->writeDeltaPlayerState(msg, &old.ps, &ps);
+
+			entity->writeEntityNum(msg, 5);
+			entity->writeDeltaEntity(msg, &parseEntities.get(old.parseEntitiesNum + 1), &moved, 5, deltaTime);
+			entity->writeEntityNum(msg, 7);
+			if (has7) {
+				entity->writeDeltaEntity(msg, &baselines.getEntity(7), &states[7], 7, deltaTime);
+			}
+			else
+			{
+				// removed
+				msg.WriteBool(true);
+			}
+			entity->writeEntityNum(msg, ENTITYNUM_NONE);
+			msg.WriteBool(false);
+			msg.WriteByte(uint8_t(messageNum));
+		}
+
+		stream.Seek(0);
+		MSG msg(stream, msgMode_e::Reading);
+		rawSnapshot_t& snap = storage[messageNum % 4];
+		snap = rawSnapshot_t();
+		parm.numDeltaEntities = 0;
+		snapshotParser->parseSnapshot(msg, gs, &serverCommands, snap, parm, messageNum);
+		assert(msg.ReadByte() == uint8_t(messageNum));
+
+		assert(snap.valid);
+		assert(snap.numEntities == (has7 ? 3u : 2u));
+		assert(parm.numDeltaEntities == 2);
+
+		const entityState_t& ent3 = parseEntities.get(snap.parseEntitiesNum);
+		const entityState_t& ent5 = parseEntities.get(snap.parseEntitiesNum + 1);
+		assert(ent3.number == 3);
+		assert(ent3.netorigin[0] == 30.f);
+		// unchanged entities share the state of the previous snapshot
+		assert(&ent3 == &parseEntities.get(old.parseEntitiesNum));
+		assert(ent5.number == 5);
+		assert(ent5.netorigin[0] == (float)messageNum);
+		if (has7) {
+			assert(parseEntities.get(snap.parseEntitiesNum + 2).number == 7);
+		}
+	}
+
+	// states are reused once they're not referenced anymore
+	assert(parseEntities.getNumAllocated() == 64);
+
+	{
+		// snapshot without entities, small enough to be entirely read by MSG when it starts reading
+		size_t writtenLength;
+		{
+			FixedDataMessageStream stream(streamData, sizeof(streamData));
+			{
+				MSG msg(stream, msgMode_e::Writing);
+				writeSnapshotHeader(msg, 5000, 0);
+				playerState->writeDeltaPlayerState(msg, nullptr, &ps);
+				entity->writeEntityNum(msg, ENTITYNUM_NONE);
+				msg.WriteBool(false);
+				msg.WriteByte(0xA5);
+			}
+			writtenLength = stream.GetPosition();
+		}
+
+		FixedDataMessageStream stream(streamData, sizeof(streamData), writtenLength);
+		MSG msg(stream, msgMode_e::Reading);
+		rawSnapshot_t& snap = storage[0];
+		snap = rawSnapshot_t();
+		snapshotParser->parseSnapshot(msg, gs, &serverCommands, snap, parm, 100);
+
+		assert(snap.valid);
+		assert(snap.numEntities == 0);
+		assert(snap.ps.origin[0] == 15.f);
+		assert(msg.ReadByte() == 0xA5);
+	}
+}
+
+void snapshotTest()
+{
+	testAllVersions(&snapshotTestInternal);
+}
+
 int main(int argc, const char* argv[])
 {
 	InitCommon(argc, argv);
@@ -321,6 +742,8 @@ int main(int argc, const char* argv[])
 	hashTest();
 	stringTest();
 	entityTest();
+	randomDeltaTest();
 	gameStateTest();
 	PVSTest();
+	snapshotTest();
 }
\ No newline at end of file
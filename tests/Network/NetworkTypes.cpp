@@ -1,8 +1,17 @@
 #include <MOHPC/Network/Types/GameState.h>
+#include <MOHPC/Network/Types/EntityTable.h>
+#include <MOHPC/Network/Remote/Address.h>
+#include <MOHPC/Network/Remote/Encoding.h>
+#include <MOHPC/Network/Remote/Metrics.h>
+#include <MOHPC/Network/Types/ReliableTemplate.h>
+#include <MOHPC/Utility/Misc/MSG/Stream.h>
 
 #include "Common/Common.h"
 
+#include <algorithm>
 #include <cassert>
+#include <random>
+#include <vector>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
@@ -73,9 +82,190 @@ void testGameState()
 	testConfigstring(gs);
 }
 
+void testEntityTable()
+{
+	EntityTable* table = new EntityTable();
+
+	for (uint16_t i = 0; i < 10; ++i)
+	{
+		entityState_t state;
+		state.number = i * 2;
+		state.netorigin[0] = i * 10.f;
+		state.netorigin[2] = -(i * 10.f);
+		state.frameInfo[3].index = i;
+		state.solid = i % 3;
+		state.eType = i == 4 ? entityType_e::item : entityType_e::general;
+		const bool added = table->add(state);
+		assert(added);
+	}
+
+	assert(table->size() == 10);
+	assert(table->find(8) == 4);
+	assert(table->find(9) == table->size());
+	assert(table->originX[5] == 50.f);
+	assert(table->originZ[5] == -50.f);
+	assert(table->frameIndex[3][7] == 7);
+
+	uint16_t solidIndexes[EntityTable::MAX_ENTITIES];
+	const size_t numSolid = table->findSolidEntities(solidIndexes, EntityTable::MAX_ENTITIES);
+	// 0, 3, 6 and 9 are not solid, 4 is an item
+	assert(numSolid == 5);
+	assert(solidIndexes[0] == 1);
+	assert(solidIndexes[1] == 2);
+	assert(solidIndexes[2] == 5);
+	assert(solidIndexes[4] == 8);
+
+	table->clear();
+	assert(!table->size());
+
+	delete table;
+}
+
+void testAddress()
+{
+	NetAddr4Ptr addr = NetAddr4::create();
+	addr->setIp(192, 168, 1, 2);
+	addr->setPort(12203);
+
+	const netadr_t value(*addr);
+	assert(value.getType() == addressType_e::IPv4);
+	assert(value.getAddrSize() == 4);
+	assert(value.getPort() == 12203);
+	assert(value.asString() == addr->asString());
+
+	const NetAddrPtr allocated = value.allocate();
+	assert(*allocated == *addr);
+	assert(allocated->getPort() == addr->getPort());
+
+	netadr_t other = value;
+	assert(other == value);
+	// the port is part of the comparison
+	other.set(addressType_e::IPv4, addr->getAddress(), 12204);
+	assert(other != value);
+}
+
+/**
+ * Byte per byte XOR, as done by the game.
+ */
+void xorReference(uint8_t* data, size_t start, size_t len, uint8_t key, const char* string)
+{
+	size_t index = 0;
+	for (size_t i = start; i < len; ++i, ++index)
+	{
+		if (!string[index]) index = 0;
+
+		uint8_t c = string[index];
+		if (c > 127 || c == '%') c = '.';
+
+		key ^= c << (i & 1);
+		data[i] ^= key;
+	}
+}
+
+void testEncoding()
+{
+	SequenceTemplate<64, 2048> commands;
+	const char* strings[] =
+	{
+		"",
+		"a",
+		"%",
+		"stufftext \"disconnect\" 100% \xe9\xff",
+		"cs 5 \"\\sv_hostname\\Some server with a long name, longer than a block of 16 bytes\\g_gametype\\2\""
+	};
+	const size_t numStrings = sizeof(strings) / sizeof(strings[0]);
+	for (size_t i = 0; i < numStrings; ++i) {
+		commands.set((rsequence_t)i, strings[i]);
+	}
+	// an empty command after a longer one
+	commands.set((rsequence_t)numStrings, strings[numStrings - 1]);
+	commands.set((rsequence_t)numStrings, "");
+
+	std::mt19937 rng(1234);
+	const size_t sizes[] = { 0, 1, 15, 16, 17, 31, 33, 255, 256, 257, 1000, 1400 };
+	for (size_t size : sizes)
+	{
+		for (size_t start = 0; start < 19 && start <= size; start += 3)
+		{
+			for (size_t s = 0; s <= numStrings; ++s)
+			{
+				const char* string = commands.get((rsequence_t)s);
+
+				const uint32_t challenge = rng();
+				const uint32_t ack = rng();
+
+				std::vector<uint8_t> data(size);
+				for (uint8_t& b : data) b = (uint8_t)rng();
+
+				std::vector<uint8_t> expected = data;
+				xorReference(expected.data(), start, size, (uint8_t)(challenge ^ 7 ^ ack), string);
+
+				XOREncoding encoding(challenge, commands);
+				encoding.setSecretKey(7);
+				encoding.setMessageAcknowledge(ack);
+				encoding.setReliableAcknowledge((uint32_t)(s + commands.getMaxElements()));
+
+				// same stream
+				FixedDataMessageStream stream(data.data(), size);
+				stream.Seek(start);
+				encoding.convert(stream, stream);
+				assert(stream.GetPosition() == start);
+				assert(data == expected);
+
+				// bytes before the start are not converted
+				std::vector<uint8_t> source(size);
+				for (uint8_t& b : source) b = (uint8_t)rng();
+				expected = source;
+				xorReference(expected.data(), start, size, (uint8_t)(challenge ^ 7 ^ ack), string);
+
+				FixedDataMessageStream input(source.data(), size);
+				input.Seek(start);
+				DynamicDataMessageStream output;
+				encoding.convert(input, output);
+				assert(output.GetLength() == size - start);
+				assert(std::equal(expected.begin() + start, expected.end(), output.getStorage()));
+			}
+		}
+	}
+}
+
+void testMetrics()
+{
+	const NetMetricsPtr metrics = NetMetrics::create();
+	metrics->add(netMetric_e::PacketsIn);
+	metrics->add(netMetric_e::PacketsIn);
+	metrics->add(netMetric_e::BytesIn, 1400);
+	metrics->addDispatch(svc_ops_e::Snapshot, 25);
+	metrics->addDispatch(svc_ops_e::Snapshot, 15);
+
+	const netMetricsSnapshot_t snap = metrics->snapshot();
+	assert(snap.get(netMetric_e::PacketsIn) == 2);
+	assert(snap.get(netMetric_e::BytesIn) == 1400);
+	assert(snap.get(netMetric_e::PacketsOut) == 0);
+	assert(snap.dispatchCount[(size_t)svc_ops_e::Snapshot] == 2);
+	assert(snap.dispatchTime[(size_t)svc_ops_e::Snapshot] == 40);
+
+	const str json = snap.toJSON();
+	assert(json.find("\"packets_in\":2,") != str::npos);
+	assert(json.find("\"snapshot\":{\"count\":2,\"time_us\":40}") != str::npos);
+
+	const str text = snap.toPrometheus("mohpc_", "server=\"local\"");
+	assert(text.find("# TYPE mohpc_bytes_in_total counter\nmohpc_bytes_in_total{server=\"local\"} 1400\n") != str::npos);
+	assert(text.find("mohpc_dispatch_total{server=\"local\",op=\"snapshot\"} 2\n") != str::npos);
+
+	// the snapshot is a copy
+	metrics->reset();
+	assert(!metrics->get(netMetric_e::PacketsIn));
+	assert(snap.get(netMetric_e::PacketsIn) == 2);
+}
+
 int main(int argc, const char* argv[])
 {
 	InitCommon(argc, argv);
 
 	testGameState();
+	testEntityTable();
+	testAddress();
+	testEncoding();
+	testMetrics();
 }
@@ -0,0 +1,293 @@
+#include <MOHPC/Network/Remote/ThreadedChannel.h>
+#include <MOHPC/Network/Remote/UDPMessageDispatcher.h>
+#include <MOHPC/Network/Remote/IPRemoteIdentifier.h>
+#include <MOHPC/Network/Remote/Socket.h>
+#include <MOHPC/Utility/Misc/MSG/Stream.h>
+
+#include "Common/Common.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_threadedchannel";
+
+static constexpr uint64_t WAIT_TIME = 1000;
+static constexpr uint16_t QPORT = 1234;
+// from the channel implementation
+static constexpr uint32_t FRAGMENT_SIZE = 1300;
+static constexpr uint32_t FRAGMENT_BIT = 1u << 31;
+
+void writeInteger(std::vector<uint8_t>& packet, uint32_t value)
+{
+	for (size_t i = 0; i < sizeof(value); ++i) packet.push_back((uint8_t)(value >> (i * 8)));
+}
+
+void writeShort(std::vector<uint8_t>& packet, uint16_t value)
+{
+	for (size_t i = 0; i < sizeof(value); ++i) packet.push_back((uint8_t)(value >> (i * 8)));
+}
+
+uint32_t readInteger(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/**
+ * Fake server on the loopback address, sending sequenced packets to the client.
+ */
+struct loopbackServer_t
+{
+	NetAddr4Ptr address;
+	IRemoteIdentifierPtr identifier;
+	IUdpSocketPtr socket;
+	NetAddrPtr client;
+
+	loopbackServer_t(uint16_t port)
+	{
+		address = NetAddr4::create();
+		address->setIp(127, 0, 0, 1);
+		address->setPort(port);
+		identifier = IPRemoteIdentifier::create(address);
+		socket = ISocketFactory::get()->createUdp(address.get());
+	}
+
+	/** Wait for a datagram of the client, the client address is kept to reply. */
+	std::vector<uint8_t> receive()
+	{
+		std::vector<uint8_t> packet;
+		if (!socket->wait(WAIT_TIME)) {
+			return packet;
+		}
+
+		packet.resize(MAX_UDP_DATA_SIZE);
+		packet.resize(socket->receive(packet.data(), packet.size(), client));
+		return packet;
+	}
+
+	void send(const std::vector<uint8_t>& packet)
+	{
+		socket->send(client, packet.data(), packet.size());
+	}
+
+	void sendSequenced(uint32_t sequenceNum, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> packet;
+		writeInteger(packet, sequenceNum);
+		packet.insert(packet.end(), data.begin(), data.end());
+		send(packet);
+	}
+
+	void sendFragment(uint32_t sequenceNum, uint32_t start, const uint8_t* data, uint16_t length)
+	{
+		std::vector<uint8_t> packet;
+		writeInteger(packet, sequenceNum | FRAGMENT_BIT);
+		writeInteger(packet, start);
+		writeShort(packet, length);
+		packet.insert(packet.end(), data, data + length);
+		send(packet);
+	}
+};
+
+ThreadedNetchanPtr createChannel(const loopbackServer_t& server)
+{
+	NetAddr4 bindAddress;
+	bindAddress.setIp(127, 0, 0, 1);
+
+	const UDPCommunicatorPtr comm = UDPCommunicator::create(ISocketFactory::get()->createUdp(&bindAddress));
+	return ThreadedNetchan::create(Netchan::create(comm, QPORT), server.identifier);
+}
+
+/** Wait for a packet from the I/O thread. */
+bool receivePacket(INetchan& channel, DynamicDataMessageStream& stream, uint32_t& sequenceNum)
+{
+	using namespace std::chrono;
+
+	const steady_clock::time_point endTime = steady_clock::now() + milliseconds(WAIT_TIME);
+	while (steady_clock::now() < endTime)
+	{
+		IRemoteIdentifierPtr from;
+		if (channel.receive(from, stream, sequenceNum)) {
+			return true;
+		}
+
+		std::this_thread::sleep_for(milliseconds(1));
+	}
+
+	return false;
+}
+
+void connect(loopbackServer_t& server, INetchan& channel)
+{
+	// the server replies to the address of the first packet
+	const char hello[] = "hello";
+	FixedDataMessageStream stream((void*)hello, sizeof(hello) - 1, sizeof(hello) - 1);
+
+	const uint16_t sequence = channel.getOutgoingSequence();
+	assert(channel.transmit(*server.identifier, stream));
+	assert(channel.getOutgoingSequence() == sequence + 1);
+
+	const std::vector<uint8_t> packet = server.receive();
+	// sequence, qport, then the data
+	assert(packet.size() == 6 + sizeof(hello) - 1);
+	assert(readInteger(packet.data()) == sequence);
+	assert((packet[4] | (packet[5] << 8)) == QPORT);
+	assert(!memcmp(packet.data() + 6, hello, sizeof(hello) - 1));
+}
+
+void testTransmit()
+{
+	loopbackServer_t server(12270);
+	const ThreadedNetchanPtr channel = createChannel(server);
+	connect(server, *channel);
+
+	// transmitted packets are sent right away, in order
+	for (uint32_t i = 0; i < 10; ++i)
+	{
+		uint8_t data[4] = { (uint8_t)i };
+		FixedDataMessageStream stream(data, sizeof(data), sizeof(data));
+		channel->transmit(*server.identifier, stream);
+	}
+
+	for (uint32_t i = 0; i < 10; ++i)
+	{
+		const std::vector<uint8_t> packet = server.receive();
+		assert(packet.size() == 6 + 4);
+		assert(packet[6] == i);
+	}
+}
+
+void testOrdering()
+{
+	static constexpr uint32_t NUM_PACKETS = 200;
+
+	loopbackServer_t server(12271);
+	const ThreadedNetchanPtr channel = createChannel(server);
+	connect(server, *channel);
+
+	assert(!channel->hasIncoming());
+
+	for (uint32_t i = 1; i <= NUM_PACKETS; ++i)
+	{
+		std::vector<uint8_t> data;
+		writeInteger(data, i * 10);
+		server.sendSequenced(i, data);
+	}
+
+	// more packets than the queue can hold,
+	// the I/O thread must wait for packets to be consumed without losing any
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	assert(channel->hasIncoming());
+
+	DynamicDataMessageStream stream;
+	for (uint32_t i = 1; i <= NUM_PACKETS; ++i)
+	{
+		uint32_t sequenceNum = 0;
+		assert(receivePacket(*channel, stream, sequenceNum));
+		assert(sequenceNum == i);
+
+		// the stream starts after the header
+		uint8_t data[4];
+		assert(stream.GetPosition() == 4);
+		stream.Read(data, sizeof(data));
+		assert(readInteger(data) == i * 10);
+	}
+
+	assert(!channel->hasIncoming());
+}
+
+void testFragments()
+{
+	loopbackServer_t server(12272);
+	const ThreadedNetchanPtr channel = createChannel(server);
+	connect(server, *channel);
+
+	std::vector<uint8_t> message(FRAGMENT_SIZE * 2 + 100);
+	for (size_t i = 0; i < message.size(); ++i) {
+		message[i] = (uint8_t)(i * 7);
+	}
+
+	// a fragment shorter than the fragment size is the last one
+	server.sendFragment(5, 0, message.data(), FRAGMENT_SIZE);
+	server.sendFragment(5, FRAGMENT_SIZE, message.data() + FRAGMENT_SIZE, FRAGMENT_SIZE);
+	server.sendFragment(5, FRAGMENT_SIZE * 2, message.data() + FRAGMENT_SIZE * 2, 100);
+
+	DynamicDataMessageStream stream;
+	uint32_t sequenceNum = 0;
+	assert(receivePacket(*channel, stream, sequenceNum));
+	assert(sequenceNum == 5);
+	assert(stream.GetLength() == 4 + message.size());
+	assert(stream.GetPosition() == 4);
+	assert(!memcmp(stream.getStorage() + 4, message.data(), message.size()));
+}
+
+void testError()
+{
+	loopbackServer_t server(12273);
+	const ThreadedNetchanPtr channel = createChannel(server);
+	connect(server, *channel);
+
+	// the fragment length is larger than the datagram
+	std::vector<uint8_t> packet;
+	writeInteger(packet, 1 | FRAGMENT_BIT);
+	writeInteger(packet, 0);
+	writeShort(packet, 1000);
+	packet.resize(packet.size() + 10);
+	server.send(packet);
+
+	server.sendSequenced(2, std::vector<uint8_t>(4));
+
+	// the exception is thrown from the thread receiving packets
+	DynamicDataMessageStream stream;
+	uint32_t sequenceNum = 0;
+	bool thrown = false;
+	try
+	{
+		receivePacket(*channel, stream, sequenceNum);
+	}
+	catch (BadFragmentLengthException& e)
+	{
+		assert(e.getLength() == 1000);
+		thrown = true;
+	}
+	assert(thrown);
+
+	// and the channel still works
+	assert(receivePacket(*channel, stream, sequenceNum));
+	assert(sequenceNum == 2);
+}
+
+void testStop()
+{
+	using namespace std::chrono;
+
+	loopbackServer_t server(12274);
+	ThreadedNetchanPtr channel = createChannel(server);
+	connect(server, *channel);
+
+	// stop with queued packets, while the I/O thread waits for packets to be consumed
+	for (uint32_t i = 1; i <= 100; ++i) {
+		server.sendSequenced(i, std::vector<uint8_t>(4));
+	}
+	std::this_thread::sleep_for(milliseconds(100));
+
+	const steady_clock::time_point startTime = steady_clock::now();
+	channel = nullptr;
+	assert(steady_clock::now() - startTime < milliseconds(WAIT_TIME));
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	testTransmit();
+	testOrdering();
+	testFragments();
+	testError();
+	testStop();
+}
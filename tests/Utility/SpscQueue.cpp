@@ -0,0 +1,132 @@
+#include <MOHPC/Utility/SpscQueue.h>
+
+#include "Common/Common.h"
+
+#include <cassert>
+#include <memory>
+#include <thread>
+
+using namespace MOHPC;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_spscqueue";
+
+void testCapacity()
+{
+	SpscQueue<int> queue1(1);
+	assert(queue1.capacity() == 1);
+
+	SpscQueue<int> queue5(5);
+	assert(queue5.capacity() == 8);
+
+	SpscQueue<int> queue64(64);
+	assert(queue64.capacity() == 64);
+}
+
+void testFull()
+{
+	SpscQueue<int> queue(4);
+	assert(queue.empty());
+
+	int value;
+	assert(!queue.pop(value));
+
+	for (int i = 0; i < 4; ++i) {
+		assert(queue.push(i));
+	}
+
+	// nothing is overwritten once full
+	assert(!queue.push(4));
+	assert(!queue.empty());
+
+	assert(queue.pop(value) && value == 0);
+	assert(queue.push(4));
+	assert(!queue.push(5));
+
+	for (int i = 1; i <= 4; ++i) {
+		assert(queue.pop(value) && value == i);
+	}
+
+	assert(queue.empty());
+	assert(!queue.pop(value));
+}
+
+void testWrapAround()
+{
+	SpscQueue<int> queue(4);
+
+	// indexes go around the buffer many times
+	int next = 0;
+	int expected = 0;
+	for (int round = 0; round < 1000; ++round)
+	{
+		const int numPushed = round % 4 + 1;
+		for (int i = 0; i < numPushed; ++i) {
+			assert(queue.push(next++));
+		}
+
+		int value;
+		while (queue.pop(value)) {
+			assert(value == expected++);
+		}
+	}
+
+	assert(expected == next);
+}
+
+void testMoveOnly()
+{
+	SpscQueue<std::unique_ptr<int>> queue(2);
+	assert(queue.push(std::make_unique<int>(1)));
+	assert(queue.push(std::make_unique<int>(2)));
+
+	std::unique_ptr<int> value;
+	assert(queue.pop(value) && *value == 1);
+	assert(queue.pop(value) && *value == 2);
+}
+
+void testTwoThreads()
+{
+	static constexpr size_t COUNT = 1000000;
+
+	// small, so both threads often see the queue full or empty
+	SpscQueue<size_t> queue(16);
+
+	std::thread producer([&queue]
+	{
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			while (!queue.push(i)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	// every value is received once, in order
+	size_t expected = 0;
+	while (expected < COUNT)
+	{
+		size_t value;
+		if (!queue.pop(value))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		assert(value == expected);
+		++expected;
+	}
+
+	producer.join();
+	assert(queue.empty());
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	testCapacity();
+	testFull();
+	testWrapAround();
+	testMoveOnly();
+	testTwoThreads();
+}
@@ -0,0 +1,196 @@
+#include <MOHPC/Utility/TaskGraph.h>
+#include <MOHPC/Utility/ThreadPool.h>
+
+#include "Common/Common.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace MOHPC;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_taskgraph";
+
+/**
+ * Record when each task runs, and check its dependencies were done before.
+ */
+struct taskTracker_t
+{
+	std::unique_ptr<std::atomic<size_t>[]> runCount;
+	std::unique_ptr<std::atomic<bool>[]> done;
+	size_t numTasks;
+
+	taskTracker_t(size_t count)
+		: runCount(new std::atomic<size_t>[count])
+		, done(new std::atomic<bool>[count])
+		, numTasks(count)
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		for (size_t i = 0; i < numTasks; ++i)
+		{
+			runCount[i] = 0;
+			done[i] = false;
+		}
+	}
+
+	TaskGraph::TaskFunction makeTask(size_t taskNum, std::vector<size_t> dependencies)
+	{
+		return [this, taskNum, dependencies]
+		{
+			for (size_t dependency : dependencies) {
+				assert(done[dependency]);
+			}
+
+			++runCount[taskNum];
+			done[taskNum] = true;
+		};
+	}
+
+	void assertAllRunOnce() const
+	{
+		for (size_t i = 0; i < numTasks; ++i) {
+			assert(runCount[i] == 1);
+		}
+	}
+};
+
+void testDiamond(ThreadPool* pool)
+{
+	// 1 and 2 depend on 0, 3 depends on 1 and 2
+	taskTracker_t tracker(4);
+
+	TaskGraph graph;
+	const size_t a = graph.addTask(tracker.makeTask(0, {}));
+	const size_t b = graph.addTask(tracker.makeTask(1, { a }), { a });
+	const size_t c = graph.addTask(tracker.makeTask(2, { a }), { a });
+	const size_t d = graph.addTask(tracker.makeTask(3, { b, c }), { b, c });
+	assert(a == 0 && b == 1 && c == 2 && d == 3);
+	assert(graph.getNumTasks() == 4);
+
+	graph.run(pool);
+	tracker.assertAllRunOnce();
+
+	// the graph can be run again
+	tracker.reset();
+	graph.run(pool);
+	tracker.assertAllRunOnce();
+}
+
+void testWide(ThreadPool* pool)
+{
+	static constexpr size_t NUM_LAYERS = 8;
+	static constexpr size_t LAYER_SIZE = 32;
+
+	// each task depends on two tasks of the previous layer
+	taskTracker_t tracker(NUM_LAYERS * LAYER_SIZE);
+
+	TaskGraph graph;
+	for (size_t layer = 0; layer < NUM_LAYERS; ++layer)
+	{
+		for (size_t i = 0; i < LAYER_SIZE; ++i)
+		{
+			const size_t taskNum = layer * LAYER_SIZE + i;
+			if (!layer)
+			{
+				graph.addTask(tracker.makeTask(taskNum, {}));
+				continue;
+			}
+
+			const size_t dep1 = (layer - 1) * LAYER_SIZE + i;
+			const size_t dep2 = (layer - 1) * LAYER_SIZE + (i + 1) % LAYER_SIZE;
+			graph.addTask(tracker.makeTask(taskNum, { dep1, dep2 }), { dep1, dep2 });
+		}
+	}
+
+	graph.run(pool);
+	tracker.assertAllRunOnce();
+}
+
+void testSequentialOrder()
+{
+	// without a pool, tasks run in the order they were added
+	std::vector<size_t> order;
+
+	TaskGraph graph;
+	const size_t a = graph.addTask([&order] { order.push_back(0); });
+	const size_t b = graph.addTask([&order] { order.push_back(1); });
+	graph.addTask([&order] { order.push_back(2); }, { a, b });
+	graph.addTask([&order] { order.push_back(3); }, { a });
+
+	graph.run(nullptr);
+	assert((order == std::vector<size_t>{ 0, 1, 2, 3 }));
+}
+
+void testThrow(ThreadPool* pool)
+{
+	std::atomic<bool> dependentRan(false);
+
+	TaskGraph graph;
+	const size_t a = graph.addTask([] {});
+	const size_t failing = graph.addTask([] { throw std::runtime_error("task failed"); }, { a });
+	graph.addTask([&dependentRan] { dependentRan = true; }, { failing });
+
+	bool thrown = false;
+	try
+	{
+		graph.run(pool);
+	}
+	catch (std::runtime_error& e)
+	{
+		assert(!strcmp(e.what(), "task failed"));
+		thrown = true;
+	}
+
+	assert(thrown);
+	// dependents of a failed task are skipped
+	assert(!dependentRan);
+}
+
+void testNestedPool(ThreadPool& pool)
+{
+	static constexpr size_t COUNT = 100;
+
+	std::vector<std::atomic<size_t>> visits(COUNT * 2);
+	for (std::atomic<size_t>& visit : visits) {
+		visit = 0;
+	}
+
+	// tasks can use the pool that runs them
+	TaskGraph graph;
+	const size_t a = graph.addTask([&] { pool.parallelFor(COUNT, [&](size_t i) { ++visits[i]; }); });
+	graph.addTask([&] { pool.parallelFor(COUNT, [&](size_t i) { ++visits[COUNT + i]; }); }, { a });
+
+	graph.run(&pool);
+	for (const std::atomic<size_t>& visit : visits) {
+		assert(visit == 1);
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	ThreadPool pool(4);
+
+	testDiamond(nullptr);
+	testDiamond(&pool);
+	testWide(nullptr);
+	testWide(&pool);
+	testSequentialOrder();
+	testThrow(nullptr);
+	testThrow(&pool);
+	testNestedPool(pool);
+
+	// the graph doesn't depend on the number of threads
+	ThreadPool singlePool(1);
+	testDiamond(&singlePool);
+	testWide(&singlePool);
+	testThrow(&singlePool);
+}
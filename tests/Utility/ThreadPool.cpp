@@ -0,0 +1,122 @@
+#include <MOHPC/Utility/ThreadPool.h>
+
+#include "Common/Common.h"
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MOHPC;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_threadpool";
+
+void testEmpty(ThreadPool& pool)
+{
+	bool called = false;
+	pool.parallelFor(0, [&](size_t) { called = true; });
+	assert(!called);
+}
+
+void testEachIndexOnce(ThreadPool& pool, size_t count)
+{
+	std::unique_ptr<std::atomic<size_t>[]> visits(new std::atomic<size_t>[count]);
+	for (size_t i = 0; i < count; ++i) {
+		visits[i] = 0;
+	}
+
+	pool.parallelFor(count, [&](size_t index)
+	{
+		assert(index < count);
+		++visits[index];
+	});
+
+	// every call is done when parallelFor returns
+	for (size_t i = 0; i < count; ++i) {
+		assert(visits[i] == 1);
+	}
+}
+
+void testNested(ThreadPool& pool)
+{
+	static constexpr size_t NUM_OUTER = 16;
+	static constexpr size_t NUM_INNER = 64;
+
+	std::vector<std::atomic<size_t>> visits(NUM_OUTER * NUM_INNER);
+	for (std::atomic<size_t>& visit : visits) {
+		visit = 0;
+	}
+
+	pool.parallelFor(NUM_OUTER, [&](size_t outer)
+	{
+		// called from a pool thread or from the waiting thread, must not deadlock
+		pool.parallelFor(NUM_INNER, [&](size_t inner)
+		{
+			++visits[outer * NUM_INNER + inner];
+		});
+
+		// the inner loop is complete before the outer task ends
+		for (size_t inner = 0; inner < NUM_INNER; ++inner) {
+			assert(visits[outer * NUM_INNER + inner] == 1);
+		}
+	});
+
+	for (const std::atomic<size_t>& visit : visits) {
+		assert(visit == 1);
+	}
+}
+
+void testConcurrentCallers(ThreadPool& pool)
+{
+	static constexpr size_t NUM_CALLERS = 4;
+	static constexpr size_t COUNT = 500;
+
+	std::vector<std::atomic<size_t>> visits(NUM_CALLERS * COUNT);
+	for (std::atomic<size_t>& visit : visits) {
+		visit = 0;
+	}
+
+	std::vector<std::thread> callers;
+	for (size_t c = 0; c < NUM_CALLERS; ++c)
+	{
+		callers.emplace_back([&pool, &visits, c]
+		{
+			pool.parallelFor(COUNT, [&visits, c](size_t index) { ++visits[c * COUNT + index]; });
+		});
+	}
+
+	for (std::thread& caller : callers) {
+		caller.join();
+	}
+
+	for (const std::atomic<size_t>& visit : visits) {
+		assert(visit == 1);
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	ThreadPool singlePool(1);
+	assert(singlePool.getNumThreads() == 1);
+	testEmpty(singlePool);
+	testEachIndexOnce(singlePool, 1);
+	testEachIndexOnce(singlePool, 100);
+	testNested(singlePool);
+
+	ThreadPool pool(4);
+	assert(pool.getNumThreads() == 4);
+	testEmpty(pool);
+	// fewer, as many and more tasks than threads
+	testEachIndexOnce(pool, 3);
+	testEachIndexOnce(pool, 4);
+	testEachIndexOnce(pool, 10000);
+	testNested(pool);
+	testConcurrentCallers(pool);
+
+	ThreadPool defaultPool;
+	assert(defaultPool.getNumThreads() >= 1);
+	testEachIndexOnce(defaultPool, 1000);
+}
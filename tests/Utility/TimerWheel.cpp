@@ -0,0 +1,175 @@
+#include <MOHPC/Utility/TimerWheel.h>
+
+#include "Common/Common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace MOHPC;
+
+static constexpr char MOHPC_LOG_NAMESPACE[] = "test_timerwheel";
+
+struct timedObject_t
+{
+	int id;
+};
+
+using wheel_t = TimerWheel<timedObject_t>;
+
+bool contains(const std::vector<timedObject_t*>& list, const timedObject_t* object)
+{
+	return std::find(list.begin(), list.end(), object) != list.end();
+}
+
+void testSchedule()
+{
+	using namespace std::chrono;
+
+	// 8 ms ticks, 16 slots: one turn is 128 ms
+	wheel_t wheel(milliseconds(8), 16);
+	const wheel_t::time_point base = wheel_t::clock::now();
+
+	timedObject_t a{ 1 }, b{ 2 }, c{ 3 };
+	assert(wheel.empty());
+	assert(!wheel.cancel(&a));
+
+	wheel.schedule(&a, base + milliseconds(10));
+	wheel.schedule(&b, base + milliseconds(50));
+	// more than one turn ahead, shares its slot with objects of the current turn
+	wheel.schedule(&c, base + milliseconds(500));
+	assert(!wheel.empty());
+	assert(wheel.isScheduled(&a) && wheel.isScheduled(&b) && wheel.isScheduled(&c));
+
+	wheel_t::time_point next;
+	assert(wheel.getNextTime(next));
+	assert(next == base + milliseconds(10));
+
+	std::vector<timedObject_t*> expired;
+	wheel.advance(base + milliseconds(5), expired);
+	assert(expired.empty());
+
+	wheel.advance(base + milliseconds(20), expired);
+	assert(expired.size() == 1 && expired[0] == &a);
+	assert(!wheel.isScheduled(&a));
+
+	// moving an object only keeps the last time
+	wheel.schedule(&b, base + milliseconds(100));
+	wheel.schedule(&b, base + milliseconds(90));
+	assert(wheel.getNextTime(next));
+	assert(next == base + milliseconds(90));
+
+	expired.clear();
+	wheel.advance(base + milliseconds(60), expired);
+	assert(expired.empty());
+
+	expired.clear();
+	wheel.advance(base + milliseconds(95), expired);
+	assert(expired.size() == 1 && expired[0] == &b);
+
+	// only c remains, one turn later
+	assert(wheel.getNextTime(next));
+	assert(next == base + milliseconds(500));
+
+	expired.clear();
+	wheel.advance(base + milliseconds(400), expired);
+	assert(expired.empty());
+	assert(wheel.isScheduled(&c));
+
+	expired.clear();
+	wheel.advance(base + milliseconds(500), expired);
+	assert(expired.size() == 1 && expired[0] == &c);
+	assert(wheel.empty());
+	assert(!wheel.getNextTime(next));
+}
+
+void testCancel()
+{
+	using namespace std::chrono;
+
+	wheel_t wheel(milliseconds(8), 16);
+	const wheel_t::time_point base = wheel_t::clock::now();
+
+	timedObject_t a{ 1 }, b{ 2 };
+	wheel.schedule(&a, base + milliseconds(30));
+	wheel.schedule(&b, base + milliseconds(30));
+	assert(wheel.cancel(&a));
+	assert(!wheel.cancel(&a));
+	assert(!wheel.isScheduled(&a));
+
+	std::vector<timedObject_t*> expired;
+	wheel.advance(base + milliseconds(40), expired);
+	assert(expired.size() == 1 && expired[0] == &b);
+	assert(wheel.empty());
+}
+
+void testExpiredSchedule()
+{
+	using namespace std::chrono;
+
+	wheel_t wheel(milliseconds(8), 16);
+	const wheel_t::time_point base = wheel_t::clock::now();
+
+	std::vector<timedObject_t*> expired;
+	wheel.advance(base + milliseconds(200), expired);
+	assert(expired.empty());
+
+	// scheduled before the current time of the wheel, returned on the next advance
+	timedObject_t a{ 1 };
+	wheel.schedule(&a, base + milliseconds(100));
+	wheel.advance(base + milliseconds(200), expired);
+	assert(expired.size() == 1 && expired[0] == &a);
+
+	// the wheel never goes back in time
+	timedObject_t b{ 2 };
+	expired.clear();
+	wheel.schedule(&b, base + milliseconds(210));
+	wheel.advance(base + milliseconds(100), expired);
+	assert(expired.empty());
+	assert(wheel.isScheduled(&b));
+}
+
+void testManyObjects()
+{
+	using namespace std::chrono;
+
+	wheel_t wheel(milliseconds(8), 16);
+	const wheel_t::time_point base = wheel_t::clock::now();
+
+	// spread over several turns, every object must expire exactly once
+	std::vector<timedObject_t> objects(200);
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		objects[i].id = (int)i;
+		wheel.schedule(&objects[i], base + milliseconds(i * 7));
+	}
+
+	std::vector<timedObject_t*> expired;
+	for (size_t t = 0; t <= 200 * 7; t += 13)
+	{
+		const size_t previous = expired.size();
+		wheel.advance(base + milliseconds(t), expired);
+
+		for (size_t i = previous; i < expired.size(); ++i) {
+			assert((size_t)expired[i]->id * 7 <= t);
+		}
+	}
+
+	wheel.advance(base + milliseconds(200 * 7), expired);
+	assert(expired.size() == objects.size());
+	for (const timedObject_t& object : objects) {
+		assert(contains(expired, &object));
+	}
+	assert(wheel.empty());
+}
+
+int main(int argc, const char* argv[])
+{
+	InitCommon(argc, argv);
+
+	testSchedule();
+	testCancel();
+	testExpiredSchedule();
+	testManyObjects();
+}